@@ -1,6 +1,7 @@
 #ifndef __sharedptr_h_
 #define __sharedptr_h_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
 
@@ -278,7 +279,9 @@ namespace qtl
 		struct ref_count
 		{
 			T* pointer = nullptr;
-			std::size_t refs = 0;
+
+			// atomic so that copies may be released on different threads
+			std::atomic<std::size_t> refs{ 0 };
 		};
 
 		ref_count * ref = nullptr;
@@ -352,22 +355,22 @@ namespace qtl
 	template<typename T>
 	inline shared_ptr<T>::~shared_ptr()
 	{
-		if (ref)
+		if (ref && --ref->refs == 0)
 		{
-			ref->refs--;
-			if (ref->refs == 0)
-			{
-				if (ref->pointer) delete ref->pointer;
-				delete ref;
-				ref = nullptr;
-			}
+			if (ref->pointer) delete ref->pointer;
+			delete ref;
+			ref = nullptr;
 		}
 	}
 
 	template<typename T>
 	inline shared_ptr<T>& shared_ptr<T>::operator=(const shared_ptr& other) noexcept
 	{
-		if (ref && ref->refs == 1)
+		if (ref == other.ref)
+		{
+			return *this;
+		}
+		if (ref && --ref->refs == 0)
 		{
 			if (ref->pointer) delete ref->pointer;
 			delete ref;
@@ -380,7 +383,11 @@ namespace qtl
 	template<typename T>
 	inline shared_ptr<T>& shared_ptr<T>::operator=(shared_ptr&& other) noexcept
 	{
-		if (ref && ref->refs == 1)
+		if (ref == other.ref)
+		{
+			return *this;
+		}
+		if (ref && --ref->refs == 0)
 		{
 			delete ref->pointer;
 			delete ref;
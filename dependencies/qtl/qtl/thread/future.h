@@ -2,10 +2,15 @@
 #define __future_h_
 
 #include "qtl/shared_ptr.h"
+#include "qtl/type_traits.h"
 #include "qtl/utility.h"
+#include "qtl/vector.h"
 #include "qtl/thread/condition_variable.h"
 #include "qtl/thread/mutex.h"
 
+#include <atomic>
+#include <cstddef>
+
 namespace qtl
 {
 	template <typename T>
@@ -14,26 +19,125 @@ namespace qtl
 	template <typename T>
 	class future;
 
+	class thread_pool;
+
+	template <typename T>
+	struct when_any_result;
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 	namespace qinternal
 	{
-		template <typename T>
-		struct future_implementation
+		/// <summary>
+		/// Work to run once a future's value is set.  invoke() is called exactly once,
+		/// on the thread that sets the value, and takes ownership of the callback.
+		/// </summary>
+		class future_callback
+		{
+		public:
+			virtual ~future_callback() = default;
+			virtual void invoke() = 0;
+
+			future_callback* __next = nullptr;
+		};
+
+		struct future_state
 		{
-			T __value;
 			condition_variable __cond;
 			mutex __mutex;
-			bool __set;
+			bool __set = false;
+
+			// attached while the value is not set, newest first
+			future_callback* __callbacks = nullptr;
+
+			future_state() = default;
+			future_state(const future_state&) = delete;
+			~future_state();
+
+			future_state& operator=(const future_state&) = delete;
+
+			void attach(future_callback* callback);
+			void complete();
 		};
 
+		template <typename T>
+		struct future_implementation : future_state
+		{
+			T __value;
+		};
+
+		// Shared state of future<void> and promise<void>, whose members are defined
+		// in the prebuilt qtl library, so it keeps that layout and has no callbacks
 		struct future_implementation_void
 		{
 			condition_variable __cond;
 			mutex __mutex;
 			bool __set;
 		};
+
+		struct future_access
+		{
+			template <typename T>
+			static shared_ptr<future_implementation<T>>& state(future<T>& value)
+			{
+				return value.__future_impl;
+			}
+		};
+
+		inline future_state::~future_state()
+		{
+			// the value was never set, the callbacks never run
+			while (__callbacks)
+			{
+				future_callback* next = __callbacks->__next;
+				delete __callbacks;
+				__callbacks = next;
+			}
+		}
+
+		inline void future_state::attach(future_callback* callback)
+		{
+			__mutex.lock();
+			if (!__set)
+			{
+				callback->__next = __callbacks;
+				__callbacks = callback;
+				__mutex.unlock();
+				return;
+			}
+			__mutex.unlock();
+			callback->invoke();
+		}
+
+		// Called with __mutex held once the value is stored, releases it
+		inline void future_state::complete()
+		{
+			__set = true;
+			future_callback* callbacks = __callbacks;
+			__callbacks = nullptr;
+			__mutex.unlock();
+			__cond.notify_all();
+
+			// run in the order they were attached
+			future_callback* ordered = nullptr;
+			while (callbacks)
+			{
+				future_callback* next = callbacks->__next;
+				callbacks->__next = ordered;
+				ordered = callbacks;
+				callbacks = next;
+			}
+			while (ordered)
+			{
+				future_callback* next = ordered->__next;
+				ordered->invoke();
+				ordered = next;
+			}
+		}
 	}
 #endif
+	// future<void> and promise<void> are part of the prebuilt qtl library and
+	// have no room for continuations, so then(), when_all() and when_any() do
+	// not take a future<void>.  Submit a task returning a value to chain on it.
 	template <>
 	class future<void>
 	{
@@ -65,6 +169,7 @@ namespace qtl
 	class future
 	{
 		friend class promise<T>;
+		friend struct qinternal::future_access;
 	public:
 		/// <summary>
 		/// Constructs a default future from no promise.  Calling get() and wait()
@@ -119,10 +224,38 @@ namespace qtl
 		/// </returns>
 		T get();
 
+		/// <summary>
+		/// Call to move the value out of the future.  If the value is not ready,
+		/// blocks until ready.  Values that cannot be copied, such as the results
+		/// of when_all() and when_any(), are read this way.  The future is left
+		/// empty like a default future.
+		/// </summary>
+		/// <returns>
+		/// Value captured by future
+		/// </returns>
+		T take();
+
 		/// <summary>
 		/// Blocks calling thread until value is ready to fetch
 		/// </summary>
 		void wait();
+
+		/// <summary>
+		/// Schedules func on pool once the value is set, instead of blocking a thread
+		/// until then.  func is called with the value.  The future is left empty, the
+		/// value is only available to func.
+		/// </summary>
+		/// <param name="pool">
+		/// Pool to run func on
+		/// </param>
+		/// <param name="func">
+		/// Callable taking the value
+		/// </param>
+		/// <returns>
+		/// Future holding the result of func once it has run
+		/// </returns>
+		template<typename Func>
+		future<typename result_of<typename decay<Func>::type(T)>::type> then(thread_pool& pool, Func&& func);
 	private:
 		shared_ptr<qinternal::future_implementation<T>> __future_impl;
 	};
@@ -155,16 +288,23 @@ namespace qtl
 	{
 		unique_lock<mutex> lock(__future_impl->__mutex);
 		__future_impl->__cond.wait(lock, [=]() { return __future_impl->__set; });
-		T res = __future_impl->__value;
-		return res;
+		return __future_impl->__value;
+	}
+
+	template<typename T>
+	inline T future<T>::take()
+	{
+		shared_ptr<qinternal::future_implementation<T>> state = qtl::move(__future_impl);
+		unique_lock<mutex> lock(state->__mutex);
+		state->__cond.wait(lock, [&]() { return state->__set; });
+		return qtl::move(state->__value);
 	}
 
 	template<typename T>
 	inline void future<T>::wait()
 	{
-		__future_impl->__mutex.lock();
-		__future_impl->__cond.wait(__future_impl->__mutex, [=]() { return __future_impl->__set; });
-		__future_impl->__mutex.unlock();
+		unique_lock<mutex> lock(__future_impl->__mutex);
+		__future_impl->__cond.wait(lock, [=]() { return __future_impl->__set; });
 	}
 
 	template <>
@@ -304,14 +444,189 @@ namespace qtl
 	{
 		__future_impl->__mutex.lock();
 		__future_impl->__value = qtl::move(other);
-		__future_impl->__mutex.unlock();
-		__future_impl->__cond.notify_one();
+		__future_impl->complete();
 	}
 
 	template<typename T>
 	inline void promise<T>::set_value(const T& other)
 	{
-		__future_impl->__value = qtl::move(other);
+		__future_impl->__mutex.lock();
+		__future_impl->__value = other;
+		__future_impl->complete();
+	}
+
+	/// <summary>
+	/// Result of when_any()
+	/// </summary>
+	/// <typeparam name="T">
+	/// Type of value of the futures
+	/// </typeparam>
+	template <typename T>
+	struct when_any_result
+	{
+		/// <summary>
+		/// Index of the first future found ready
+		/// </summary>
+		size_t index;
+
+		/// <summary>
+		/// The futures passed to when_any(), in the same order
+		/// </summary>
+		vector<future<T>> futures;
+	};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	namespace qinternal
+	{
+		template <typename T>
+		struct when_all_state
+		{
+			vector<future<T>> futures;
+			std::atomic<size_t> remaining;
+			promise<vector<future<T>>> result;
+		};
+
+		template <typename T>
+		class when_all_callback : public future_callback
+		{
+		public:
+			explicit when_all_callback(const shared_ptr<when_all_state<T>>& state)
+				: __state(state)
+			{
+			}
+
+			void invoke() override
+			{
+				if (__state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					__state->result.set_value(qtl::move(__state->futures));
+				}
+				delete this;
+			}
+		private:
+			shared_ptr<when_all_state<T>> __state;
+		};
+
+		template <typename T>
+		struct when_any_state
+		{
+			vector<future<T>> futures;
+			std::atomic<bool> done;
+			promise<when_any_result<T>> result;
+		};
+
+		template <typename T>
+		class when_any_callback : public future_callback
+		{
+		public:
+			when_any_callback(const shared_ptr<when_any_state<T>>& state, const size_t index)
+				: __state(state), __index(index)
+			{
+			}
+
+			void invoke() override
+			{
+				if (!__state->done.exchange(true, std::memory_order_acq_rel))
+				{
+					when_any_result<T> ready;
+					ready.index = __index;
+					ready.futures = qtl::move(__state->futures);
+					__state->result.set_value(qtl::move(ready));
+				}
+				delete this;
+			}
+		private:
+			shared_ptr<when_any_state<T>> __state;
+			size_t __index;
+		};
+	}
+#endif
+
+	/// <summary>
+	/// Combines futures into one that is ready once all of them are, without
+	/// blocking a thread until then.  The futures are handed back through the
+	/// result, all of them ready, which is read with take().  T must not be void.
+	/// </summary>
+	/// <typeparam name="T">
+	/// Type of value of the futures
+	/// </typeparam>
+	/// <param name="futures">
+	/// Futures to wait for, left empty
+	/// </param>
+	/// <returns>
+	/// Future holding the futures once all are ready
+	/// </returns>
+	template <typename T>
+	future<vector<future<T>>> when_all(vector<future<T>>&& futures)
+	{
+		shared_ptr<qinternal::when_all_state<T>> state = make_shared<qinternal::when_all_state<T>>();
+		future<vector<future<T>>> result = state->result.get_future();
+		const size_t count = futures.size();
+		if (count == 0)
+		{
+			state->result.set_value(vector<future<T>>());
+			return qtl::move(result);
+		}
+
+		// the last callback hands the futures over, so their states are held
+		// here until every callback is attached
+		vector<shared_ptr<qinternal::future_implementation<T>>> sources;
+		for (size_t i = 0; i < count; i++)
+		{
+			sources.push_back(qinternal::future_access::state(futures[i]));
+		}
+		state->remaining.store(count, std::memory_order_relaxed);
+		state->futures = qtl::move(futures);
+		for (size_t i = 0; i < count; i++)
+		{
+			sources[i]->attach(new qinternal::when_all_callback<T>(state));
+		}
+		return qtl::move(result);
+	}
+
+	/// <summary>
+	/// Combines futures into one that is ready once any of them is, without
+	/// blocking a thread until then.  The futures are handed back through the
+	/// result along with the index of the one found ready, which is read with
+	/// take().  With no futures the result is ready at once and its index is
+	/// size_t(-1).  T must not be void.
+	/// </summary>
+	/// <typeparam name="T">
+	/// Type of value of the futures
+	/// </typeparam>
+	/// <param name="futures">
+	/// Futures to wait for, left empty
+	/// </param>
+	/// <returns>
+	/// Future holding the futures once one is ready
+	/// </returns>
+	template <typename T>
+	future<when_any_result<T>> when_any(vector<future<T>>&& futures)
+	{
+		shared_ptr<qinternal::when_any_state<T>> state = make_shared<qinternal::when_any_state<T>>();
+		future<when_any_result<T>> result = state->result.get_future();
+		const size_t count = futures.size();
+		if (count == 0)
+		{
+			when_any_result<T> none;
+			none.index = static_cast<size_t>(-1);
+			state->result.set_value(qtl::move(none));
+			return qtl::move(result);
+		}
+
+		// the first callback hands the futures over, possibly while others are attached
+		vector<shared_ptr<qinternal::future_implementation<T>>> sources;
+		for (size_t i = 0; i < count; i++)
+		{
+			sources.push_back(qinternal::future_access::state(futures[i]));
+		}
+		state->done.store(false, std::memory_order_relaxed);
+		state->futures = qtl::move(futures);
+		for (size_t i = 0; i < count; i++)
+		{
+			sources[i]->attach(new qinternal::when_any_callback<T>(state, i));
+		}
+		return qtl::move(result);
 	}
 }
 
@@ -0,0 +1,245 @@
+#ifndef __mpmcqueue_h_
+#define __mpmcqueue_h_
+
+#include "qtl/type_traits.h"
+#include "qtl/utility.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace qtl
+{
+	/// <summary>
+	/// Bounded queue any number of threads may push to and pop from at the same
+	/// time without locking.  Elements live in a ring of slots, each with a
+	/// sequence number telling whether it is free for the producer or filled for
+	/// the consumer at the current position, so a push or pop claims its slot
+	/// with a single compare and swap.  The head and tail are kept on separate
+	/// cache lines so that producers and consumers do not contend on them.
+	/// </summary>
+	/// <typeparam name="T">
+	/// Type of element stored
+	/// </typeparam>
+	template <typename T>
+	class mpmc_queue
+	{
+	public:
+		/// <summary>
+		/// Creates an empty queue
+		/// </summary>
+		/// <param name="capacity">
+		/// Number of elements the queue holds at most, rounded up to a power of 2
+		/// of at least 2, as a slot's sequence could not tell a full queue of one
+		/// element from an empty one
+		/// </param>
+		explicit mpmc_queue(const size_t capacity);
+
+		/// <summary>
+		/// Deleted copy constructor
+		/// </summary>
+		mpmc_queue(const mpmc_queue&) = delete;
+
+		/// <summary>
+		/// Destroys the queue and the elements left in it.  No other thread may
+		/// use the queue at this point.
+		/// </summary>
+		~mpmc_queue();
+
+		/// <summary>
+		/// Deleted copy assignment
+		/// </summary>
+		/// <returns>
+		/// Reference to this
+		/// </returns>
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		/// <summary>
+		/// Adds an element at the back of the queue, unless it is full
+		/// </summary>
+		/// <param name="value">
+		/// Element to copy into the queue
+		/// </param>
+		/// <returns>
+		/// False if the queue is full
+		/// </returns>
+		bool try_push(const T& value);
+
+		/// <summary>
+		/// Adds an element at the back of the queue, unless it is full
+		/// </summary>
+		/// <param name="value">
+		/// Element to move into the queue, left untouched if the queue is full
+		/// </param>
+		/// <returns>
+		/// False if the queue is full
+		/// </returns>
+		bool try_push(T&& value);
+
+		/// <summary>
+		/// Removes the element at the front of the queue, unless it is empty
+		/// </summary>
+		/// <param name="value">
+		/// Set to the element removed
+		/// </param>
+		/// <returns>
+		/// False if the queue is empty
+		/// </returns>
+		bool try_pop(T& value);
+
+		/// <summary>
+		/// Whether the front of the queue holds no element.  Other threads may
+		/// change this as soon as it is returned.
+		/// </summary>
+		/// <returns>
+		/// True if the queue was empty
+		/// </returns>
+		bool empty() const;
+
+		/// <summary>
+		/// Number of elements the queue holds at most
+		/// </summary>
+		/// <returns>
+		/// Capacity of the queue
+		/// </returns>
+		size_t capacity() const;
+	private:
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+
+		struct slot
+		{
+			// position + 1 once filled, position + capacity once free for the next lap
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		slot* __slots;
+		size_t __mask;
+
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> __tail;
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> __head;
+		char __padding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+		template <typename U>
+		bool __push(U&& value);
+	};
+
+	template <typename T>
+	inline mpmc_queue<T>::mpmc_queue(const size_t capacity)
+		: __tail(0), __head(0)
+	{
+		size_t rounded = 2;
+		while (rounded < capacity)
+		{
+			rounded <<= 1;
+		}
+		__slots = new slot[rounded];
+		__mask = rounded - 1;
+		for (size_t i = 0; i < rounded; i++)
+		{
+			__slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	template <typename T>
+	inline mpmc_queue<T>::~mpmc_queue()
+	{
+		const size_t tail = __tail.load(std::memory_order_relaxed);
+		for (size_t position = __head.load(std::memory_order_relaxed); position != tail; position++)
+		{
+			reinterpret_cast<T*>(__slots[position & __mask].storage)->~T();
+		}
+		delete[] __slots;
+	}
+
+	template <typename T>
+	inline bool mpmc_queue<T>::try_push(const T& value)
+	{
+		return __push(value);
+	}
+
+	template <typename T>
+	inline bool mpmc_queue<T>::try_push(T&& value)
+	{
+		return __push(qtl::move(value));
+	}
+
+	template <typename T>
+	template <typename U>
+	inline bool mpmc_queue<T>::__push(U&& value)
+	{
+		size_t position = __tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			slot& target = __slots[position & __mask];
+			const size_t sequence = target.sequence.load(std::memory_order_acquire);
+			const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (difference == 0)
+			{
+				if (__tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					::new (target.storage) T(qtl::forward<U>(value));
+					target.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// the slot still holds the element pushed a lap ago
+				return false;
+			}
+			else
+			{
+				position = __tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template <typename T>
+	inline bool mpmc_queue<T>::try_pop(T& value)
+	{
+		size_t position = __head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			slot& source = __slots[position & __mask];
+			const size_t sequence = source.sequence.load(std::memory_order_acquire);
+			const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+			if (difference == 0)
+			{
+				if (__head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					T* element = reinterpret_cast<T*>(source.storage);
+					value = qtl::move(*element);
+					element->~T();
+					source.sequence.store(position + __mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// the slot has not been filled yet
+				return false;
+			}
+			else
+			{
+				position = __head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template <typename T>
+	inline bool mpmc_queue<T>::empty() const
+	{
+		const size_t position = __head.load(std::memory_order_acquire);
+		return __slots[position & __mask].sequence.load(std::memory_order_acquire) != position + 1;
+	}
+
+	template <typename T>
+	inline size_t mpmc_queue<T>::capacity() const
+	{
+		return __mask + 1;
+	}
+}
+
+#endif
@@ -326,6 +326,15 @@ namespace qtl
 			delete call;
 			return NULL;
 		}
+#elif defined ( __linux__ )
+		template<typename Call>
+		static void* threadfunc(void* args)
+		{
+			Call* call = new Call(*static_cast<Call*>(args));
+			call->callFunc();
+			delete call;
+			return nullptr;
+		}
 #endif
 	};
 
@@ -366,6 +375,26 @@ namespace qtl
 		}
 		__callable = call;
 	}
+#elif defined ( __linux__ )
+	template<typename Func, typename ... Arguments>
+	inline thread::thread(Func && fn, Arguments && ... args)
+	{
+		qinternal::ICallable * call = new qinternal::ThreadFunctionCall<Func, Arguments...>(qtl::forward<Func>(fn), qtl::forward<Arguments>(args)...);
+		pthread_t * handle = new pthread_t;
+
+		if (pthread_create(handle, NULL, threadfunc<qinternal::ThreadFunctionCall<Func, Arguments...>>, static_cast<void*>(call)) != 0)
+		{
+			__id.__handle = nullptr;
+			delete handle;
+			delete call;
+			call = nullptr;
+		}
+		else
+		{
+			__id.__handle = handle;
+		}
+		__callable = call;
+	}
 #endif
 }
 
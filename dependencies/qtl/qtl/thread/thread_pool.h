@@ -0,0 +1,517 @@
+#ifndef __threadpool_h_
+#define __threadpool_h_
+
+#include "qtl/type_traits.h"
+#include "qtl/utility.h"
+#include "qtl/vector.h"
+#include "qtl/thread/condition_variable.h"
+#include "qtl/thread/future.h"
+#include "qtl/thread/mutex.h"
+#include "qtl/thread/thread.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace qtl
+{
+	class thread_pool;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	namespace qinternal
+	{
+		class pool_task
+		{
+		public:
+			virtual ~pool_task() = default;
+			virtual void run() = 0;
+		};
+
+		// Calls func and sets the promise to its result
+		template<typename T>
+		struct pool_result
+		{
+			template<typename Func, typename ... Args>
+			static void set(promise<T>& result, Func& func, Args&& ... args)
+			{
+				result.set_value(func(qtl::forward<Args>(args)...));
+			}
+		};
+
+		template<>
+		struct pool_result<void>
+		{
+			template<typename Func, typename ... Args>
+			static void set(promise<void>& result, Func& func, Args&& ... args)
+			{
+				func(qtl::forward<Args>(args)...);
+				result.set_value();
+			}
+		};
+
+		template<typename T, typename Func>
+		class pool_call : public pool_task
+		{
+		public:
+			explicit pool_call(Func&& func)
+				: __func(qtl::forward<Func>(func))
+			{
+			}
+
+			future<T> get_future()
+			{
+				return __promise.get_future();
+			}
+
+			void run() override
+			{
+				pool_result<T>::set(__promise, __func);
+			}
+		private:
+			typename decay<Func>::type __func;
+			promise<T> __promise;
+		};
+
+		/// <summary>
+		/// Continuation attached by future::then().  Once the source value is set it
+		/// is moved into the continuation, which is then scheduled on the pool.
+		/// </summary>
+		template<typename T, typename U, typename Func>
+		class pool_continuation : public future_callback, public pool_task
+		{
+		public:
+			pool_continuation(thread_pool& pool, future_implementation<T>* source, Func&& func)
+				: __pool(pool), __source(source), __func(qtl::forward<Func>(func))
+			{
+			}
+
+			future<U> get_future()
+			{
+				return __promise.get_future();
+			}
+
+			void invoke() override;
+
+			void run() override
+			{
+				pool_result<U>::set(__promise, __func, qtl::move(__value));
+			}
+		private:
+			thread_pool& __pool;
+			future_implementation<T>* __source;
+			T __value;
+			typename decay<Func>::type __func;
+			promise<U> __promise;
+		};
+
+		/// <summary>
+		/// Chase-Lev deque of tasks.  The owning worker pushes and pops at the bottom,
+		/// other workers steal from the top.  The ring grows when full; rings it
+		/// replaced are kept until the deque is destroyed, since a thief may still
+		/// be reading one.
+		/// </summary>
+		class work_stealing_deque
+		{
+		public:
+			work_stealing_deque();
+			work_stealing_deque(const work_stealing_deque&) = delete;
+			~work_stealing_deque();
+
+			work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+			void push(pool_task* task);
+			pool_task* pop();
+			pool_task* steal();
+			bool empty() const;
+		private:
+			struct ring
+			{
+				int64_t mask;
+				std::atomic<pool_task*>* slots;
+			};
+
+			static constexpr int64_t INITIAL_CAPACITY = 256;
+
+			std::atomic<int64_t> __top;
+			std::atomic<int64_t> __bottom;
+			std::atomic<ring*> __ring;
+			vector<ring*> __retired;
+
+			static ring* allocate(const int64_t capacity);
+		};
+
+		inline work_stealing_deque::work_stealing_deque()
+			: __top(0), __bottom(0), __ring(allocate(INITIAL_CAPACITY))
+		{
+		}
+
+		inline work_stealing_deque::~work_stealing_deque()
+		{
+			__retired.push_back(__ring.load(std::memory_order_relaxed));
+			for (size_t i = 0; i < __retired.size(); i++)
+			{
+				delete[] __retired[i]->slots;
+				delete __retired[i];
+			}
+		}
+
+		inline work_stealing_deque::ring* work_stealing_deque::allocate(const int64_t capacity)
+		{
+			ring* result = new ring;
+			result->mask = capacity - 1;
+			result->slots = new std::atomic<pool_task*>[static_cast<size_t>(capacity)];
+			return result;
+		}
+
+		inline void work_stealing_deque::push(pool_task* task)
+		{
+			const int64_t bottom = __bottom.load(std::memory_order_relaxed);
+			const int64_t top = __top.load(std::memory_order_acquire);
+			ring* current = __ring.load(std::memory_order_relaxed);
+			if (bottom - top > current->mask)
+			{
+				ring* grown = allocate((current->mask + 1) * 2);
+				for (int64_t i = top; i < bottom; i++)
+				{
+					grown->slots[i & grown->mask].store(current->slots[i & current->mask].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				}
+				__retired.push_back(current);
+				__ring.store(grown, std::memory_order_release);
+				current = grown;
+			}
+			current->slots[bottom & current->mask].store(task, std::memory_order_relaxed);
+			__bottom.store(bottom + 1, std::memory_order_release);
+		}
+
+		inline pool_task* work_stealing_deque::pop()
+		{
+			const int64_t bottom = __bottom.load(std::memory_order_relaxed) - 1;
+			ring* current = __ring.load(std::memory_order_relaxed);
+			__bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = __top.load(std::memory_order_relaxed);
+			if (top > bottom)
+			{
+				__bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			pool_task* task = current->slots[bottom & current->mask].load(std::memory_order_relaxed);
+			if (top == bottom)
+			{
+				// the last task, a thief may be taking it at the same time
+				if (!__top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					task = nullptr;
+				}
+				__bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return task;
+		}
+
+		inline pool_task* work_stealing_deque::steal()
+		{
+			int64_t top = __top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = __bottom.load(std::memory_order_acquire);
+			if (top >= bottom)
+			{
+				return nullptr;
+			}
+
+			ring* current = __ring.load(std::memory_order_acquire);
+			pool_task* task = current->slots[top & current->mask].load(std::memory_order_relaxed);
+			if (!__top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return task;
+		}
+
+		inline bool work_stealing_deque::empty() const
+		{
+			return __top.load(std::memory_order_acquire) >= __bottom.load(std::memory_order_acquire);
+		}
+
+		/// <summary>
+		/// Pool and index of the worker running on the calling thread
+		/// </summary>
+		struct pool_worker
+		{
+			thread_pool* pool;
+			size_t index;
+		};
+
+		inline pool_worker& current_pool_worker()
+		{
+			static thread_local pool_worker worker = { nullptr, 0 };
+			return worker;
+		}
+	}
+#endif
+
+	/// <summary>
+	/// Fixed set of worker threads that run submitted tasks.  Each worker keeps its
+	/// own deque of tasks: tasks submitted by a worker go to the bottom of its deque
+	/// and it runs them newest first, while idle workers steal the oldest tasks of
+	/// others.  Tasks submitted from other threads are queued for whichever worker
+	/// is free first.  Workers with nothing to run or steal sleep until a task is
+	/// submitted.  A task must not wait on the future of another task of the same
+	/// pool, as every worker could end up waiting.
+	/// </summary>
+	class thread_pool
+	{
+	public:
+		/// <summary>
+		/// Starts a pool of workers
+		/// </summary>
+		/// <param name="threads">
+		/// Number of worker threads, at least 1
+		/// </param>
+		explicit thread_pool(const size_t threads);
+
+		/// <summary>
+		/// Deleted copy constructor
+		/// </summary>
+		thread_pool(const thread_pool&) = delete;
+
+		/// <summary>
+		/// Runs every task submitted so far, then joins the workers
+		/// </summary>
+		~thread_pool();
+
+		/// <summary>
+		/// Deleted copy assignment
+		/// </summary>
+		/// <returns>
+		/// Reference to this
+		/// </returns>
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/// <summary>
+		/// Number of worker threads
+		/// </summary>
+		/// <returns>
+		/// Number of worker threads
+		/// </returns>
+		size_t size() const;
+
+		/// <summary>
+		/// Schedules a call of func on one of the workers
+		/// </summary>
+		/// <param name="func">
+		/// Callable taking no arguments
+		/// </param>
+		/// <returns>
+		/// Future holding the result of the call once it has run
+		/// </returns>
+		template<typename Func>
+		future<typename result_of<typename decay<Func>::type()>::type> submit(Func&& func);
+	private:
+		template<typename T, typename U, typename Func>
+		friend class qinternal::pool_continuation;
+
+		struct worker
+		{
+			qinternal::work_stealing_deque deque;
+			thread* handle;
+		};
+
+		vector<worker*> __workers;
+
+		// tasks submitted from outside the pool, taken oldest first
+		mutex __mutex;
+		condition_variable __wake;
+		vector<qinternal::pool_task*> __injected;
+		size_t __injectedHead;
+		std::atomic<size_t> __injectedCount;
+
+		std::atomic<size_t> __sleeping;
+		bool __stopping;
+
+		void __schedule(qinternal::pool_task* task);
+		qinternal::pool_task* __find(const size_t index);
+		void __run(const size_t index);
+	};
+
+	inline thread_pool::thread_pool(const size_t threads)
+		: __injectedHead(0), __injectedCount(0), __sleeping(0), __stopping(false)
+	{
+		const size_t count = threads > 0 ? threads : 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			worker* created = new worker;
+			created->handle = nullptr;
+			__workers.push_back(created);
+		}
+
+		// the workers steal from each other, so all of them exist before the first starts
+		for (size_t i = 0; i < count; i++)
+		{
+			__workers[i]->handle = new thread([this, i]() { __run(i); });
+		}
+	}
+
+	inline thread_pool::~thread_pool()
+	{
+		__mutex.lock();
+		__stopping = true;
+		__mutex.unlock();
+		__wake.notify_all();
+		for (size_t i = 0; i < __workers.size(); i++)
+		{
+			__workers[i]->handle->join();
+			delete __workers[i]->handle;
+		}
+		for (size_t i = 0; i < __workers.size(); i++)
+		{
+			delete __workers[i];
+		}
+	}
+
+	inline size_t thread_pool::size() const
+	{
+		return __workers.size();
+	}
+
+	template<typename Func>
+	inline future<typename result_of<typename decay<Func>::type()>::type> thread_pool::submit(Func&& func)
+	{
+		typedef typename result_of<typename decay<Func>::type()>::type result_type;
+		qinternal::pool_call<result_type, Func>* call = new qinternal::pool_call<result_type, Func>(qtl::forward<Func>(func));
+		future<result_type> result = call->get_future();
+		__schedule(call);
+		return qtl::move(result);
+	}
+
+	inline void thread_pool::__schedule(qinternal::pool_task* task)
+	{
+		const qinternal::pool_worker& current = qinternal::current_pool_worker();
+		if (current.pool == this)
+		{
+			__workers[current.index]->deque.push(task);
+
+			// a worker about to sleep counts itself before it looks for work one last time
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (__sleeping.load(std::memory_order_seq_cst) == 0)
+			{
+				return;
+			}
+			__mutex.lock();
+			__mutex.unlock();
+			__wake.notify_one();
+			return;
+		}
+
+		__mutex.lock();
+		__injected.push_back(task);
+		__injectedCount.fetch_add(1, std::memory_order_seq_cst);
+		__mutex.unlock();
+		__wake.notify_one();
+	}
+
+	inline qinternal::pool_task* thread_pool::__find(const size_t index)
+	{
+		qinternal::pool_task* task = __workers[index]->deque.pop();
+		if (task)
+		{
+			return task;
+		}
+
+		if (__injectedCount.load(std::memory_order_seq_cst) > 0)
+		{
+			__mutex.lock();
+			if (__injectedHead < __injected.size())
+			{
+				task = __injected[__injectedHead++];
+				__injectedCount.fetch_sub(1, std::memory_order_seq_cst);
+				if (__injectedHead == __injected.size())
+				{
+					__injected.clear();
+					__injectedHead = 0;
+				}
+			}
+			__mutex.unlock();
+			if (task)
+			{
+				return task;
+			}
+		}
+
+		// victims are tried starting after this worker so that thieves spread out
+		for (size_t i = 1; i < __workers.size(); i++)
+		{
+			task = __workers[(index + i) % __workers.size()]->deque.steal();
+			if (task)
+			{
+				return task;
+			}
+		}
+		return nullptr;
+	}
+
+	inline void thread_pool::__run(const size_t index)
+	{
+		qinternal::pool_worker& current = qinternal::current_pool_worker();
+		current.pool = this;
+		current.index = index;
+
+		for (;;)
+		{
+			qinternal::pool_task* task = __find(index);
+			if (task)
+			{
+				task->run();
+				delete task;
+				continue;
+			}
+
+			unique_lock<mutex> lock(__mutex);
+			__sleeping.fetch_add(1, std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			bool found = __injectedCount.load(std::memory_order_seq_cst) > 0;
+			for (size_t i = 0; i < __workers.size() && !found; i++)
+			{
+				found = !__workers[i]->deque.empty();
+			}
+			if (!found)
+			{
+				if (__stopping)
+				{
+					__sleeping.fetch_sub(1, std::memory_order_seq_cst);
+					break;
+				}
+				__wake.wait(lock);
+			}
+			__sleeping.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+		current.pool = nullptr;
+	}
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+	namespace qinternal
+	{
+		template<typename T, typename U, typename Func>
+		inline void pool_continuation<T, U, Func>::invoke()
+		{
+			__value = qtl::move(__source->__value);
+			__pool.__schedule(this);
+		}
+	}
+#endif
+
+	template<typename T>
+	template<typename Func>
+	inline future<typename result_of<typename decay<Func>::type(T)>::type> future<T>::then(thread_pool& pool, Func&& func)
+	{
+		typedef typename result_of<typename decay<Func>::type(T)>::type result_type;
+		shared_ptr<qinternal::future_implementation<T>> state = qtl::move(__future_impl);
+		qinternal::pool_continuation<T, result_type, Func>* continuation =
+			new qinternal::pool_continuation<T, result_type, Func>(pool, state.get(), qtl::forward<Func>(func));
+		future<result_type> result = continuation->get_future();
+		state->attach(continuation);
+		return qtl::move(result);
+	}
+}
+
+#endif
\ No newline at end of file
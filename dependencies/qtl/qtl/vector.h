@@ -470,6 +470,16 @@ namespace qtl
 	template <typename T>
 	inline vector<T>& vector<T>::operator=(vector<T>&& vec) noexcept
 	{
+		if (this == &vec)
+		{
+			return *this;
+		}
+		if (__data)
+		{
+			clear();
+			free(__data);
+		}
+
 		__size = vec.__size;
 		__capacity = vec.__capacity;
 		__data = vec.__data;
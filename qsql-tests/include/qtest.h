@@ -0,0 +1,47 @@
+#ifndef qtest_h__
+#define qtest_h__
+
+#include <cstddef>
+
+namespace qsql
+{
+	class QDatabase;
+	class QStatement;
+
+	namespace test
+	{
+		typedef void (*QTestFunction)();
+
+		// Adds a test to the ones main() runs, called by QSQL_TEST while the
+		// program starts
+		bool addTest(const char* name, QTestFunction function);
+
+		// Records a failed check of the running test
+		void fail(const char* file, const int line, const char* expression);
+
+		// Executes statement and counts the rows it produces, 0 if it fails
+		std::size_t countRows(QStatement& statement);
+
+		// Prepares text on database and counts the rows it produces, 0 if it
+		// does not prepare or fails
+		std::size_t countRows(QDatabase& database, const char* text);
+	}
+}
+
+// Defines a test, the body follows the macro
+#define QSQL_TEST(name) \
+	static void name(); \
+	static const bool name##Added = qsql::test::addTest(#name, &name); \
+	static void name()
+
+// Fails the running test if expression is false, the test carries on
+#define QSQL_CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			qsql::test::fail(__FILE__, __LINE__, #expression); \
+		} \
+	} while (false)
+
+#endif // qtest_h__
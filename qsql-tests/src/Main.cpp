@@ -1,6 +1,78 @@
 #include <qsql/qsql.h>
 
+#include "qtest.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	namespace test
+	{
+		namespace
+		{
+			struct QTest
+			{
+				const char* name;
+				QTestFunction function;
+			};
+
+			// constructed on first use, tests are added from static initializers
+			qtl::vector<QTest>& getTests()
+			{
+				static qtl::vector<QTest> tests;
+				return tests;
+			}
+
+			std::size_t failures = 0;
+		}
+
+		bool addTest(const char* name, QTestFunction function)
+		{
+			const QTest test = { name, function };
+			getTests().push_back(test);
+			return true;
+		}
+
+		void fail(const char* file, const int line, const char* expression)
+		{
+			failures++;
+			printf("    %s(%d): check failed: %s\n", file, line, expression);
+		}
+
+		std::size_t countRows(QStatement& statement)
+		{
+			std::size_t count = 0;
+			if (statement.execute())
+			{
+				while (QBatch* batch = statement.next())
+				{
+					count += batch->getActiveCount();
+				}
+			}
+			return count;
+		}
+
+		std::size_t countRows(QDatabase& database, const char* text)
+		{
+			QStatement statement = database.prepare(text);
+			return statement.isValid() ? countRows(statement) : 0;
+		}
+	}
+}
+
 int main()
 {
-	return 0;
-}
\ No newline at end of file
+	using namespace qsql::test;
+	qtl::vector<QTest>& tests = getTests();
+	std::size_t failed = 0;
+	for (std::size_t i = 0; i < tests.size(); i++)
+	{
+		const std::size_t before = failures;
+		tests[i].function();
+		const bool passed = failures == before;
+		failed += passed ? 0 : 1;
+		printf("[%s] %s\n", passed ? "  ok  " : "FAILED", tests[i].name);
+	}
+	printf("%zu of %zu tests failed\n", failed, tests.size());
+	return failed == 0 ? 0 : 1;
+}
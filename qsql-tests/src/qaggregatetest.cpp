@@ -0,0 +1,221 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <qtl/thread/thread_pool.h>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr int64_t ROWS = 50000;
+		constexpr int64_t GROUPS = 37;
+
+		// g is i % GROUPS and NULL on every eleventh row, v is i % 1000 and NULL
+		// on every seventh row
+		QTable* createTable(QDatabase& database)
+		{
+			QSchema schema;
+			schema.addColumn("g", QDataType::LONG, true);
+			schema.addColumn("v", QDataType::INT, true);
+			schema.addColumn("k", QDataType::LONG);
+			QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+			for (int64_t i = 0; i < ROWS; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(i % 11 == 0 ? QValue() : QValue(i % GROUPS));
+				values.push_back(i % 7 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 1000)));
+				values.push_back(QValue(i));
+				table->insert(values);
+			}
+			return table;
+		}
+
+		int64_t toLong(const QValue& value)
+		{
+			return value.getType() == QDataType::INT ? value.getInt() : value.getLong();
+		}
+
+		struct QGroup
+		{
+			int64_t count;
+			int64_t values;
+			int64_t sum;
+			int64_t min;
+			int64_t max;
+		};
+
+		// groups by g, the NULL group last
+		void expectGroups(QGroup (&groups)[GROUPS + 1])
+		{
+			for (int64_t g = 0; g <= GROUPS; g++)
+			{
+				groups[g] = { 0, 0, 0, INT64_MAX, INT64_MIN };
+			}
+			for (int64_t i = 0; i < ROWS; i++)
+			{
+				QGroup& group = groups[i % 11 == 0 ? GROUPS : i % GROUPS];
+				group.count++;
+				if (i % 7 != 0)
+				{
+					const int64_t v = i % 1000;
+					group.values++;
+					group.sum += v;
+					group.min = v < group.min ? v : group.min;
+					group.max = v > group.max ? v : group.max;
+				}
+			}
+		}
+
+		// checks every row of SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v)
+		// against the expected groups, returns the number of groups
+		std::size_t checkGroups(QDatabase& database, const char* text)
+		{
+			QGroup groups[GROUPS + 1];
+			expectGroups(groups);
+			QStatement statement = database.prepare(text);
+			QSQL_CHECK(statement.isValid() && statement.execute());
+			std::size_t count = 0;
+			bool matching = true;
+			while (QBatch* batch = statement.next())
+			{
+				for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+				{
+					const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+					const QValue key = batch->getColumn(0).getValue(index);
+					const QGroup& group = groups[key.isNull() ? GROUPS : key.getLong()];
+					matching = matching && toLong(batch->getColumn(1).getValue(index)) == group.count
+						&& toLong(batch->getColumn(2).getValue(index)) == group.sum
+						&& toLong(batch->getColumn(3).getValue(index)) == group.min
+						&& toLong(batch->getColumn(4).getValue(index)) == group.max
+						&& toLong(batch->getColumn(5).getValue(index)) == group.sum / group.values;
+					count++;
+				}
+			}
+			QSQL_CHECK(matching);
+			return count;
+		}
+	}
+
+	// NULL keys form a group of their own and NULL arguments are skipped
+	QSQL_TEST(aggregateGroupsRows)
+	{
+		QDatabase database;
+		createTable(database);
+		QSQL_CHECK(checkGroups(database, "SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v) FROM t GROUP BY g") == GROUPS + 1);
+
+		QGroup groups[GROUPS + 1];
+		expectGroups(groups);
+		std::size_t expected = 0;
+		for (int64_t g = 0; g <= GROUPS; g++)
+		{
+			expected += groups[g].sum > 600000;
+		}
+		QSQL_CHECK(test::countRows(database, "SELECT g FROM t GROUP BY g HAVING SUM(v) > 600000") == expected);
+
+		// without keys a single row is produced, even for an empty input
+		QSQL_CHECK(test::countRows(database, "SELECT COUNT(*) FROM t WHERE k < 0") == 1);
+	}
+
+	QSQL_TEST(aggregateRunsInParallel)
+	{
+		qtl::thread_pool pool(4);
+		QDatabase database;
+		database.setThreadPool(&pool);
+		createTable(database);
+		for (int run = 0; run < 3; run++)
+		{
+			QSQL_CHECK(checkGroups(database, "SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v) FROM t GROUP BY g") == GROUPS + 1);
+		}
+	}
+
+	// a group per row outgrows a small budget and spills to disk
+	QSQL_TEST(aggregateSpillsGroups)
+	{
+		QDatabase database;
+		QTable* table = createTable(database);
+		qtl::vector<std::size_t> columns;
+		columns.push_back(2);
+		columns.push_back(1);
+		const uint64_t snapshot = table->getClock().now();
+		QOperator* scan = new QScanOperator(*table, columns, snapshot);
+		qtl::vector<QExpression*> keys;
+		keys.push_back(new QColumnExpression(0, QDataType::LONG));
+		qtl::vector<QAggregate> aggregates;
+		aggregates.push_back({ QAggregateFunction::COUNT, nullptr });
+		aggregates.push_back({ QAggregateFunction::SUM, new QColumnExpression(1, QDataType::INT) });
+		QHashAggregateOperator aggregate(scan, keys, aggregates, QAggregateMode::COMPLETE, 64 << 10);
+
+		for (int run = 0; run < 2; run++)
+		{
+			qtl::vector<bool> seen;
+			seen.resize(ROWS);
+			std::size_t groups = 0;
+			bool matching = true;
+			while (QBatch* batch = aggregate.next())
+			{
+				for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+				{
+					const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+					const int64_t k = batch->getColumn(0).getValue(index).getLong();
+					const QValue sum = batch->getColumn(2).getValue(index);
+					matching = matching && k >= 0 && k < ROWS && !seen[k] && batch->getColumn(1).getValue(index).getLong() == 1
+						&& (k % 7 == 0 ? sum.isNull() : sum.getLong() == k % 1000);
+					if (k >= 0 && k < ROWS)
+					{
+						seen[k] = true;
+					}
+					groups++;
+				}
+			}
+			QSQL_CHECK(matching);
+			QSQL_CHECK(groups == ROWS);
+
+			// a reset aggregation reads its input again
+			aggregate.reset();
+		}
+	}
+
+	// sums past the range of LONG wrap around like LONG arithmetic, also when
+	// partial sums of parallel workers are merged
+	QSQL_TEST(aggregateSumWrapsAround)
+	{
+		QSchema schema;
+		schema.addColumn("g", QDataType::LONG);
+		schema.addColumn("v", QDataType::LONG);
+		QDatabase database;
+		QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+		const int64_t rows = static_cast<int64_t>(QColumn::CHUNK_SIZE) * 3;
+		uint64_t sums[2] = { 0, 0 };
+		for (int64_t i = 0; i < rows; i++)
+		{
+			const int64_t v = INT64_MAX - i % 1000;
+			qtl::vector<QValue> values;
+			values.push_back(QValue(i % 3 == 0 ? static_cast<int64_t>(0) : static_cast<int64_t>(1)));
+			values.push_back(QValue(v));
+			table->insert(values);
+			sums[i % 3 != 0] += static_cast<uint64_t>(v);
+		}
+
+		qtl::thread_pool pool(4);
+		for (int run = 0; run < 2; run++)
+		{
+			database.setThreadPool(run == 0 ? nullptr : &pool);
+			QStatement statement = database.prepare("SELECT g, SUM(v) FROM t GROUP BY g");
+			QSQL_CHECK(statement.isValid() && statement.execute());
+			std::size_t groups = 0;
+			bool matching = true;
+			while (QBatch* batch = statement.next())
+			{
+				for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+				{
+					const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+					const int64_t g = batch->getColumn(0).getValue(index).getLong();
+					matching = matching && (g == 0 || g == 1) && batch->getColumn(1).getValue(index).getLong() == static_cast<int64_t>(sums[g == 1]);
+					groups++;
+				}
+			}
+			QSQL_CHECK(matching && groups == 2);
+		}
+	}
+}
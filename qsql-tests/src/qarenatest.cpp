@@ -0,0 +1,61 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstring>
+
+namespace qsql
+{
+	QSQL_TEST(arenaAlignsAndCopies)
+	{
+		QArena arena(256);
+		bool aligned = true;
+		for (std::size_t i = 1; i < 200; i++)
+		{
+			void* memory = arena.allocate(i, i % 2 ? 8 : 64);
+			aligned = aligned && reinterpret_cast<std::size_t>(memory) % (i % 2 ? 8 : 64) == 0;
+			memset(memory, 0xAB, i);
+		}
+		QSQL_CHECK(aligned);
+
+		// larger than a chunk
+		char* large = static_cast<char*>(arena.allocate(1000));
+		memset(large, 1, 1000);
+		QSQL_CHECK(large[999] == 1);
+
+		const char* copy = arena.copy("table name", 5);
+		QSQL_CHECK(strcmp(copy, "table") == 0);
+
+		struct QPoint
+		{
+			int64_t x;
+			int64_t y;
+
+			QPoint(const int64_t x, const int64_t y)
+				: x(x), y(y)
+			{
+			}
+		};
+		const QPoint* point = arena.create<QPoint>(3, -4);
+		QSQL_CHECK(point->x == 3 && point->y == -4);
+		QSQL_CHECK(reinterpret_cast<std::size_t>(point) % alignof(QPoint) == 0);
+	}
+
+	QSQL_TEST(arenaResetAndRewind)
+	{
+		QArena arena(128);
+		arena.allocate(100);
+		arena.allocate(100);
+		QSQL_CHECK(arena.getUsed() >= 200);
+		arena.reset();
+		QSQL_CHECK(arena.getUsed() == 0);
+
+		// a rewound arena hands out the same memory again
+		void* first = arena.allocate(64);
+		void* second = arena.allocate(100);
+		arena.rewind();
+		QSQL_CHECK(arena.getUsed() == 0);
+		QSQL_CHECK(arena.allocate(64) == first);
+		QSQL_CHECK(arena.allocate(100) == second);
+	}
+}
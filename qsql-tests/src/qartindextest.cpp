@@ -0,0 +1,294 @@
+#include <qsql/qsql.h>
+#include <qsql/qartindex.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t ROWS = 30000;
+		constexpr std::size_t KEY_LENGTH = 12;
+
+		// Keys of KEY_LENGTH bytes sharing a prefix longer than a node keeps, with
+		// the last bytes spread so that nodes of every size are needed
+		void makeKey(const std::size_t index, uint8_t* key)
+		{
+			memcpy(key, "prefix-bytes", KEY_LENGTH);
+			key[9] = static_cast<uint8_t>(index >> 16);
+			key[10] = static_cast<uint8_t>(index >> 8);
+			key[11] = static_cast<uint8_t>(index);
+		}
+
+		// Collects the keys visited, checking they come in order, until limit
+		struct QCollector
+		{
+			std::size_t count;
+			std::size_t limit;
+			bool descending;
+			bool ordered;
+			uint8_t previous[KEY_LENGTH];
+
+			bool operator()(const uint8_t* key, const std::size_t length, const std::size_t row)
+			{
+				const int order = memcmp(previous, key, KEY_LENGTH);
+				ordered = ordered && length == KEY_LENGTH && (count == 0 || (descending ? order > 0 : order < 0));
+				ordered = ordered && row == (static_cast<std::size_t>(key[9]) << 16 | static_cast<std::size_t>(key[10]) << 8 | key[11]);
+				memcpy(previous, key, KEY_LENGTH);
+				return ++count < limit;
+			}
+		};
+
+		// k is an integer with duplicates and NULL on every hundredth row, s is
+		// a string of varying length, some a prefix of others
+		QTable* createTable(QDatabase& database, qtl::vector<int64_t>& keys)
+		{
+			QSchema schema;
+			schema.addColumn("k", QDataType::LONG, true);
+			schema.addColumn("s", QDataType::STRING);
+			QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+			srand(23);
+			char text[32];
+			table->beginWrite();
+			for (std::size_t i = 0; i < ROWS; i++)
+			{
+				const int64_t key = static_cast<int64_t>(rand() % 20000) - 10000;
+				keys.push_back(key);
+				snprintf(text, sizeof(text), "%.*s", static_cast<int>(i % 7), "abcdefg");
+				qtl::vector<QValue> values;
+				values.push_back(i % 100 == 0 ? QValue() : QValue(key * 1000003));
+				values.push_back(QValue(text));
+				table->insert(values);
+			}
+			table->commit();
+			return table;
+		}
+
+		// Reads a whole range, checking it is ordered by value and then row
+		std::size_t drain(QArtRange& range, const qtl::vector<int64_t>& keys, const bool descending, bool& ordered)
+		{
+			std::size_t rows[64];
+			std::size_t total = 0;
+			std::size_t previous = 0;
+			while (const std::size_t count = range.next(rows, 64))
+			{
+				for (std::size_t i = 0; i < count; i++)
+				{
+					if (total + i > 0)
+					{
+						const int64_t left = keys[previous];
+						const int64_t right = keys[rows[i]];
+						ordered = ordered && (descending ? left > right || (left == right && previous > rows[i]) : left < right || (left == right && previous < rows[i]));
+					}
+					previous = rows[i];
+				}
+				total += count;
+			}
+			return total;
+		}
+	}
+
+	QSQL_TEST(artStoresKeys)
+	{
+		QArt tree;
+		uint8_t key[KEY_LENGTH];
+		const std::size_t keys = 70000;
+		for (std::size_t i = 0; i < keys; i++)
+		{
+			makeKey(i * 11 % keys, key);
+			tree.insert(key, KEY_LENGTH, i * 11 % keys);
+		}
+		QSQL_CHECK(tree.size() == keys);
+
+		bool found = true;
+		std::size_t row = 0;
+		for (std::size_t i = 0; i < keys; i++)
+		{
+			makeKey(i, key);
+			found = found && tree.find(key, KEY_LENGTH, row) && row == i;
+		}
+		QSQL_CHECK(found);
+		makeKey(keys, key);
+		QSQL_CHECK(!tree.find(key, KEY_LENGTH, row) && !tree.find(key, 9, row));
+
+		// inserting a key again replaces its row
+		makeKey(5, key);
+		tree.insert(key, KEY_LENGTH, 99);
+		QSQL_CHECK(tree.size() == keys && tree.find(key, KEY_LENGTH, row) && row == 99);
+		tree.insert(key, KEY_LENGTH, 5);
+
+		// walks in either direction, from a key on or after it, and stopped early
+		QCollector all = { 0, SIZE_MAX, false, true, {} };
+		QSQL_CHECK(tree.visit(nullptr, 0, true, false, all) && all.ordered && all.count == keys);
+		makeKey(1000, key);
+		QCollector after = { 0, SIZE_MAX, false, true, {} };
+		QSQL_CHECK(tree.visit(key, KEY_LENGTH, false, false, after) && after.ordered && after.count == keys - 1001);
+		QCollector before = { 0, SIZE_MAX, true, true, {} };
+		QSQL_CHECK(tree.visit(key, KEY_LENGTH, true, true, before) && before.ordered && before.count == 1001);
+		QCollector stopped = { 0, 10, false, true, {} };
+		QSQL_CHECK(!tree.visit(key, KEY_LENGTH, true, false, stopped) && stopped.ordered && stopped.count == 10);
+
+		// erasing every other key shrinks the nodes, then the rest empties the tree
+		bool erased = true;
+		for (std::size_t i = 0; i < keys; i += 2)
+		{
+			makeKey(i, key);
+			erased = erased && tree.erase(key, KEY_LENGTH);
+		}
+		QSQL_CHECK(erased && tree.size() == keys / 2);
+		makeKey(0, key);
+		QSQL_CHECK(!tree.erase(key, KEY_LENGTH) && !tree.find(key, KEY_LENGTH, row));
+		makeKey(1, key);
+		QSQL_CHECK(tree.find(key, KEY_LENGTH, row) && row == 1);
+		QCollector odd = { 0, SIZE_MAX, false, true, {} };
+		QSQL_CHECK(tree.visit(nullptr, 0, true, false, odd) && odd.ordered && odd.count == keys / 2);
+		tree.clear();
+		QSQL_CHECK(tree.size() == 0 && !tree.find(key, KEY_LENGTH, row));
+	}
+
+	QSQL_TEST(artIndexRangesAreOrdered)
+	{
+		QDatabase database;
+		qtl::vector<int64_t> keys;
+		QTable* table = createTable(database, keys);
+		QSQL_CHECK(table->createArtIndex(0) && table->createArtIndex(1));
+		const QArtIndex* index = table->getArtIndex(0);
+		QSQL_CHECK(index && index->size() == ROWS - ROWS / 100);
+		if (index == nullptr)
+		{
+			return;
+		}
+
+		// scaled keys cover negative values and several bytes
+		const QValue low(static_cast<int64_t>(-2000) * 1000003);
+		const QValue high(static_cast<int64_t>(4000) * 1000003);
+		std::size_t inclusive = 0;
+		std::size_t exclusive = 0;
+		std::size_t below = 0;
+		for (std::size_t i = 0; i < ROWS; i++)
+		{
+			if (i % 100 != 0)
+			{
+				inclusive += keys[i] >= -2000 && keys[i] <= 4000;
+				exclusive += keys[i] > -2000 && keys[i] < 4000;
+				below += keys[i] < -2000;
+			}
+		}
+
+		for (int descending = 0; descending < 2; descending++)
+		{
+			bool ordered = true;
+			QArtRange range;
+			index->open(range, &low, true, &high, true, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == inclusive);
+			index->open(range, &low, false, &high, false, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == exclusive);
+			index->open(range, nullptr, false, &low, false, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == below);
+			index->open(range, nullptr, false, nullptr, false, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == index->size());
+			QSQL_CHECK(ordered);
+		}
+
+		// equal values come out by row
+		qtl::vector<std::size_t> rows;
+		const int64_t value = keys[1];
+		std::size_t expected = 0;
+		for (std::size_t i = 0; i < ROWS; i++)
+		{
+			expected += i % 100 != 0 && keys[i] == value;
+		}
+		QSQL_CHECK(index->find(QValue(value * 1000003), rows) == expected && rows.size() == expected);
+		bool ascending = true;
+		for (std::size_t i = 1; i < rows.size(); i++)
+		{
+			ascending = ascending && rows[i - 1] < rows[i];
+		}
+		QSQL_CHECK(ascending);
+
+		// a string sorts after the strings it starts with
+		const QArtIndex* strings = table->getArtIndex(1);
+		const QValue abc("abc");
+		QArtRange range;
+		strings->open(range, &abc, true, &abc, true, false);
+		std::size_t found[64];
+		QSQL_CHECK(range.next(found, 64) > 0 && found[0] == 3);
+		rows.clear();
+		QSQL_CHECK(strings->find(QValue("abc"), rows) == ROWS / 7 + (ROWS % 7 > 3) && strings->find(QValue(""), rows) == ROWS / 7 + 1);
+		strings->open(range, &abc, false, nullptr, false, false);
+		std::size_t count = 0;
+		std::size_t next;
+		while ((next = range.next(found, 64)) > 0)
+		{
+			for (std::size_t i = 0; i < next; i++)
+			{
+				count++;
+				ascending = ascending && found[i] % 7 > 3;
+			}
+		}
+		QSQL_CHECK(ascending && count == ROWS / 7 * 3 + (ROWS % 7 > 4) + (ROWS % 7 > 5));
+	}
+
+	// range scans and queries read the index, and follow changes to the table
+	QSQL_TEST(artIndexServesQueries)
+	{
+		QDatabase database;
+		qtl::vector<int64_t> keys;
+		QTable* table = createTable(database, keys);
+		QSQL_CHECK(table->createArtIndex(0));
+		const QArtIndex* index = table->getArtIndex(0);
+		if (index == nullptr)
+		{
+			return;
+		}
+
+		std::size_t expected = 0;
+		for (std::size_t i = 0; i < ROWS; i++)
+		{
+			expected += i % 100 != 0 && keys[i] >= 9000;
+		}
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		const uint64_t snapshot = table->getClock().now();
+		QIndexRangeScanOperator scan(*table, columns, *index, new QConstantExpression(QValue(static_cast<int64_t>(9000) * 1000003)), true, nullptr, false, true, snapshot);
+		std::size_t count = 0;
+		int64_t previous = INT64_MAX;
+		bool ordered = true;
+		while (QBatch* batch = scan.next())
+		{
+			for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+			{
+				const int64_t key = batch->getColumn(0).getValue(batch->hasSelection() ? batch->getSelection()[i] : i).getLong();
+				ordered = ordered && key <= previous && key >= static_cast<int64_t>(9000) * 1000003;
+				previous = key;
+				count++;
+			}
+		}
+		QSQL_CHECK(ordered && count == expected);
+
+		QStatement select = database.prepare("SELECT k FROM t WHERE k >= ? ORDER BY k DESC");
+		select.setLong(0, static_cast<int64_t>(9000) * 1000003);
+		QSQL_CHECK(select.execute());
+		count = 0;
+		while (QBatch* batch = select.next())
+		{
+			count += batch->getActiveCount();
+		}
+		QSQL_CHECK(count == expected);
+
+		// updated and erased rows move in or out of the ranges
+		QStatement erase = database.prepare("DELETE FROM t WHERE k >= ?");
+		erase.setLong(0, static_cast<int64_t>(9000) * 1000003);
+		QSQL_CHECK(erase.execute() && erase.getAffectedRows() == expected);
+		table->beginWrite();
+		const std::size_t updated = table->update(1, 0, QValue(static_cast<int64_t>(9500) * 1000003));
+		table->commit();
+		QSQL_CHECK(select.execute());
+		QBatch* batch = select.next();
+		QSQL_CHECK(batch && batch->getActiveCount() == 1 && updated == ROWS);
+	}
+}
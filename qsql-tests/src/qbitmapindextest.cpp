@@ -0,0 +1,290 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t ROWS = 300000;
+
+		// a bitmap and the same rows flagged in a plain array
+		struct QRows
+		{
+			QRoaringBitmap bitmap;
+			qtl::vector<char> flags;
+
+			QRows()
+			{
+				flags.resize(ROWS);
+			}
+
+			void add(const std::size_t row)
+			{
+				bitmap.add(row);
+				flags[row] = 1;
+			}
+		};
+
+		// Dense rows go to bitmap containers, a long range to runs once
+		// optimized, and scattered rows to arrays
+		void fill(QRows& dense, QRows& ranged, QRows& sparse)
+		{
+			for (std::size_t row = 0; row < ROWS; row += 3)
+			{
+				dense.add(row);
+			}
+			for (std::size_t row = 100000; row < 170000; row++)
+			{
+				ranged.add(row);
+			}
+			ranged.bitmap.optimize();
+			for (std::size_t row = 7; row < ROWS; row += 997)
+			{
+				sparse.add(row);
+			}
+		}
+
+		// Compares the bitmap with the flags through every way of reading it
+		bool matches(const QRoaringBitmap& bitmap, const qtl::vector<char>& flags)
+		{
+			std::size_t count = 0;
+			bool matching = true;
+			for (std::size_t row = 0; row < ROWS; row++)
+			{
+				count += flags[row];
+				matching = matching && bitmap.contains(row) == static_cast<bool>(flags[row]);
+			}
+			matching = matching && bitmap.getCardinality() == count && bitmap.isEmpty() == (count == 0);
+
+			// rows come out ascending a few at a time
+			std::size_t position = 0;
+			std::size_t rows[1000];
+			std::size_t extracted = 0;
+			std::size_t previous = 0;
+			std::size_t written;
+			while ((written = bitmap.extract(position, rows, 1000)) > 0)
+			{
+				for (std::size_t i = 0; i < written; i++)
+				{
+					matching = matching && rows[i] < ROWS && flags[rows[i]] && (extracted + i == 0 || rows[i] > previous);
+					previous = rows[i];
+				}
+				extracted += written;
+			}
+			return matching && extracted == count;
+		}
+
+		QTable* createTable(QDatabase& database)
+		{
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			schema.addColumn("flag", QDataType::BOOL);
+			schema.addColumn("size", QDataType::CHAR, true);
+			schema.addColumn("color", QDataType::STRING, true);
+			QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+			const char* colors[] = { "red", "green", "blue", "black" };
+			table->beginWrite();
+			for (int64_t i = 0; i < 50000; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(QValue(i % 2 == 0));
+				values.push_back(i % 10 == 0 ? QValue() : QValue("SML"[i % 3]));
+				values.push_back(i % 13 == 0 ? QValue() : QValue(colors[i % 4]));
+				table->insert(values);
+			}
+			table->commit();
+			return table;
+		}
+
+		bool isRed(const int64_t i)
+		{
+			return i % 13 != 0 && i % 4 == 0;
+		}
+
+		std::size_t drain(QOperator& root)
+		{
+			std::size_t count = 0;
+			while (QBatch* batch = root.next())
+			{
+				count += batch->getActiveCount();
+			}
+			return count;
+		}
+	}
+
+	QSQL_TEST(roaringBitmapCombinesSets)
+	{
+		QRows dense;
+		QRows ranged;
+		QRows sparse;
+		fill(dense, ranged, sparse);
+		QSQL_CHECK(matches(dense.bitmap, dense.flags) && matches(ranged.bitmap, ranged.flags) && matches(sparse.bitmap, sparse.flags));
+		QSQL_CHECK(ranged.bitmap.getBytes() < dense.bitmap.getBytes() / 10);
+
+		// every pair of container forms, combined either way round
+		QRows* sets[] = { &dense, &ranged, &sparse };
+		bool matching = true;
+		for (QRows* left : sets)
+		{
+			for (QRows* right : sets)
+			{
+				QRoaringBitmap both = left->bitmap;
+				QRoaringBitmap either = left->bitmap;
+				QRoaringBitmap only = left->bitmap;
+				both.intersect(right->bitmap);
+				either.unite(right->bitmap);
+				only.subtract(right->bitmap);
+				qtl::vector<char> bothFlags;
+				qtl::vector<char> eitherFlags;
+				qtl::vector<char> onlyFlags;
+				bothFlags.resize(ROWS);
+				eitherFlags.resize(ROWS);
+				onlyFlags.resize(ROWS);
+				for (std::size_t row = 0; row < ROWS; row++)
+				{
+					bothFlags[row] = left->flags[row] && right->flags[row];
+					eitherFlags[row] = left->flags[row] || right->flags[row];
+					onlyFlags[row] = left->flags[row] && !right->flags[row];
+				}
+				matching = matching && matches(both, bothFlags) && matches(either, eitherFlags) && matches(only, onlyFlags);
+			}
+		}
+		QSQL_CHECK(matching);
+
+		// a changed run container still holds the right rows
+		ranged.bitmap.remove(120000);
+		ranged.flags[120000] = 0;
+		ranged.add(ROWS - 1);
+		QSQL_CHECK(matches(ranged.bitmap, ranged.flags));
+
+		// removing every row leaves the bitmap empty
+		QRoaringBitmap emptied = sparse.bitmap;
+		for (std::size_t row = 7; row < ROWS; row += 997)
+		{
+			emptied.remove(row);
+		}
+		QSQL_CHECK(emptied.isEmpty() && emptied.getCardinality() == 0);
+	}
+
+	// setBits() writes no further than the words it is given
+	QSQL_TEST(roaringBitmapSetsBits)
+	{
+		QRows dense;
+		QRows ranged;
+		QRows sparse;
+		fill(dense, ranged, sparse);
+		QRows* sets[] = { &dense, &ranged, &sparse };
+		const std::size_t sizes[] = { 1, 1000, 1500, 1024 * 2, ROWS / 64 + 1 };
+		bool matching = true;
+		for (QRows* set : sets)
+		{
+			for (const std::size_t words : sizes)
+			{
+				uint64_t* bitmap = new uint64_t[words + 1];
+				memset(bitmap, 0, (words + 1) * sizeof(uint64_t));
+				bitmap[words] = 0x5555;
+				set->bitmap.setBits(bitmap, words);
+				for (std::size_t row = 0; row < words * 64 && row < ROWS; row++)
+				{
+					matching = matching && static_cast<bool>((bitmap[row >> 6] >> (row & 63)) & 1) == static_cast<bool>(set->flags[row]);
+				}
+				matching = matching && bitmap[words] == 0x5555;
+				delete[] bitmap;
+			}
+		}
+		QSQL_CHECK(matching);
+
+		QRoaringContainer container;
+		for (uint32_t value = 0; value < QRoaringContainer::ARRAY_LIMIT + 1; value++)
+		{
+			container.add(static_cast<uint16_t>(value * 2));
+		}
+		QSQL_CHECK(container.getType() == QRoaringContainer::QType::BITMAP);
+		uint64_t words[3] = { 0, 0, 0x77 };
+		container.setBits(words, 2);
+		QSQL_CHECK(words[0] == 0x5555555555555555ull && words[1] == 0x5555555555555555ull && words[2] == 0x77);
+	}
+
+	QSQL_TEST(bitmapIndexAnswersConditions)
+	{
+		QDatabase database;
+		QTable* table = createTable(database);
+		QSQL_CHECK(table->createBitmapIndex(1) && table->createBitmapIndex(2) && table->createBitmapIndex(3));
+		QSQL_CHECK(!table->createBitmapIndex(0));
+		const QBitmapIndex* flags = table->getBitmapIndex(1);
+		const QBitmapIndex* sizes = table->getBitmapIndex(2);
+		const QBitmapIndex* colors = table->getBitmapIndex(3);
+		QSQL_CHECK(flags && sizes && colors && table->getBitmapIndex(0) == nullptr);
+		if (!flags || !sizes || !colors)
+		{
+			return;
+		}
+
+		// NULL is not indexed
+		QSQL_CHECK(flags->getKeyCount() == 2 && sizes->getKeyCount() == 3 && colors->getKeyCount() == 4);
+		QSQL_CHECK(sizes->size() == 45000 && colors->getRows().getCardinality() == 50000 - 3847);
+		std::size_t red = 0;
+		for (int64_t i = 0; i < 50000; i++)
+		{
+			red += isRed(i);
+		}
+		const QRoaringBitmap* found = colors->find(QValue("red"));
+		QSQL_CHECK(found && found->getCardinality() == red && found->contains(4) && !found->contains(52));
+		QSQL_CHECK(colors->find(QValue("white")) == nullptr && colors->canFind(QValue("white")) && !sizes->canFind(QValue("SM")));
+
+		// (color = 'red' AND flag) OR size <> 'S'
+		std::size_t expected = 0;
+		for (int64_t i = 0; i < 50000; i++)
+		{
+			expected += (isRed(i) && i % 2 == 0) || (i % 10 != 0 && i % 3 != 0);
+		}
+		QBitmapCondition* condition = new QBitmapCondition(QLogical::OR,
+			new QBitmapCondition(QLogical::AND, new QBitmapCondition(*colors, new QConstantExpression(QValue("red")), false), new QBitmapCondition(*flags, new QConstantExpression(QValue(true)), false)),
+			new QBitmapCondition(*sizes, new QConstantExpression(QValue('S')), true));
+		QRoaringBitmap rows;
+		QSQL_CHECK(condition->evaluate(rows) && rows.getCardinality() == expected);
+
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		const uint64_t snapshot = table->getClock().now();
+		QBitmapScanOperator scan(*table, columns, condition, snapshot);
+		QSQL_CHECK(drain(scan) == expected);
+
+		// a key that cannot be looked up produces every row
+		QBitmapScanOperator every(*table, columns, new QBitmapCondition(*sizes, new QConstantExpression(QValue(static_cast<int64_t>(1))), false), snapshot);
+		QSQL_CHECK(drain(every) == 50000);
+
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE (color = 'red' AND flag = TRUE) OR size <> 'S'") == expected);
+		std::size_t listed = 0;
+		for (int64_t i = 0; i < 50000; i++)
+		{
+			listed += i % 13 != 0 && i % 2 == 0 && i % 10 != 0 && i % 3 == 2;
+		}
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE color IN ('red', 'blue') AND size = 'L'") == listed);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE color IS NULL") == 3847);
+	}
+
+	// the indexes follow updates and erases once they commit
+	QSQL_TEST(bitmapIndexFollowsWrites)
+	{
+		QDatabase database;
+		QTable* table = createTable(database);
+		QSQL_CHECK(table->createBitmapIndex(3));
+		const QBitmapIndex* colors = table->getBitmapIndex(3);
+		const std::size_t red = colors->find(QValue("red"))->getCardinality();
+
+		table->beginWrite();
+		const std::size_t updated = table->update(1, 3, QValue("red"));
+		QSQL_CHECK(table->erase(4));
+		table->commit();
+		table->collect();
+		const QRoaringBitmap* found = colors->find(QValue("red"));
+		QSQL_CHECK(found && found->contains(updated) && !found->contains(4) && found->getCardinality() == red);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE color = 'red'") == red);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE color = 'red' AND id = 1") == 1);
+	}
+}
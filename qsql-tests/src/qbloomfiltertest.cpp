@@ -0,0 +1,189 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr int64_t PAGE = static_cast<int64_t>(QTable::PAGE_ROWS);
+		constexpr int64_t ROWS = PAGE * 3 + 100;
+
+		// id is the row index, name is one of 50 strings per page
+		QTable* createTable(QDatabase& database, const char* name)
+		{
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG, true);
+			schema.addColumn("name", QDataType::STRING);
+			QTable* table = database.createTable(name, schema, QTableLayout::COLUMN);
+			table->beginWrite();
+			char text[32];
+			for (int64_t i = 0; i < ROWS; i++)
+			{
+				snprintf(text, sizeof(text), "p%d-%d", static_cast<int>(i / PAGE), static_cast<int>(i % 50));
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(QValue(text));
+				table->insert(values);
+			}
+			table->commit();
+			return table;
+		}
+
+		uint64_t hashOf(const QValue& value)
+		{
+			uint64_t hash = 0;
+			QBloomFilter::hashValue(value, hash);
+			return hash;
+		}
+
+		std::size_t drain(QOperator& root)
+		{
+			std::size_t count = 0;
+			while (QBatch* batch = root.next())
+			{
+				count += batch->getActiveCount();
+			}
+			return count;
+		}
+	}
+
+	// every key inserted is found, about 1% of the others are at 10 bits per key
+	QSQL_TEST(bloomFilterHasNoFalseNegatives)
+	{
+		const int64_t keys = 10000;
+		QBloomFilter filter(keys);
+		for (int64_t key = 0; key < keys; key++)
+		{
+			filter.insert(QBloomFilter::hashKey(key * 3));
+		}
+		bool found = true;
+		for (int64_t key = 0; key < keys; key++)
+		{
+			found = found && filter.contains(QBloomFilter::hashKey(key * 3));
+		}
+		QSQL_CHECK(found);
+
+		std::size_t positives = 0;
+		for (int64_t key = 0; key < keys * 10; key++)
+		{
+			positives += filter.contains(QBloomFilter::hashKey(key * 3 + 1));
+		}
+		QSQL_CHECK(positives < static_cast<std::size_t>(keys * 10 / 50));
+
+		// a batch of probes agrees with probing one at a time
+		uint64_t hashes[300];
+		uint64_t bitmap[5] = {};
+		std::size_t expected = 0;
+		bool agreeing = true;
+		for (std::size_t i = 0; i < 300; i++)
+		{
+			hashes[i] = QBloomFilter::hashKey(static_cast<int64_t>(i));
+			expected += filter.contains(hashes[i]);
+		}
+		QSQL_CHECK(filter.filter(hashes, 300, bitmap) == expected);
+		for (std::size_t i = 0; i < 300; i++)
+		{
+			agreeing = agreeing && filter.contains(hashes[i]) == static_cast<bool>((bitmap[i >> 6] >> (i & 63)) & 1);
+		}
+		QSQL_CHECK(agreeing);
+
+		// equal integers hash alike whatever their type, BOOL is not hashed
+		uint64_t hash = 0;
+		QSQL_CHECK(QBloomFilter::hashValue(QValue(static_cast<int32_t>(42)), hash) && hash == QBloomFilter::hashKey(42));
+		QSQL_CHECK(QBloomFilter::hashValue(QValue("42"), hash) && hash == QBloomFilter::hashString("42"));
+		QSQL_CHECK(!QBloomFilter::hashValue(QValue(true), hash));
+
+		// without blocks a filter may contain every key
+		filter.clear();
+		QSQL_CHECK(filter.getBlockCount() == 0 && filter.contains(QBloomFilter::hashKey(1)));
+		QBloomFilter empty;
+		QSQL_CHECK(empty.contains(QBloomFilter::hashKey(1)));
+		filter.resize(100);
+		QSQL_CHECK(filter.getBlockCount() > 0 && filter.getBytes() == filter.getBlockCount() * QBloomFilter::BLOCK_BYTES);
+	}
+
+	QSQL_TEST(bloomFilterSkipsPages)
+	{
+		QDatabase database;
+		QTable* table = createTable(database, "t");
+		QSQL_CHECK(!table->hasBloomFilter(0) && !table->isAbsent(0, 0, hashOf(QValue(static_cast<int64_t>(-1)))));
+		QSQL_CHECK(table->createBloomFilter(0) && table->createBloomFilter(1));
+		QSQL_CHECK(!table->createBloomFilter(0) && table->hasBloomFilter(1));
+
+		// a page never rules out its own keys, and rules out most others
+		const std::size_t pages = static_cast<std::size_t>((ROWS + PAGE - 1) / PAGE);
+		bool kept = true;
+		std::size_t absent = 0;
+		for (int64_t i = 0; i < ROWS; i += 7)
+		{
+			const std::size_t page = static_cast<std::size_t>(i / PAGE);
+			kept = kept && !table->isAbsent(page, 0, hashOf(QValue(i)));
+			absent += table->isAbsent((page + 1) % pages, 0, hashOf(QValue(i)));
+		}
+		QSQL_CHECK(kept);
+		QSQL_CHECK(absent > static_cast<std::size_t>(ROWS / 7 * 95 / 100));
+		QSQL_CHECK(!table->isAbsent(1, 1, hashOf(QValue("p1-7"))) && table->isAbsent(0, 1, hashOf(QValue("p1-7"))));
+
+		// rows written after the filters were built are added to them
+		const int64_t late = ROWS * 10;
+		QSQL_CHECK(table->isAbsent(pages - 1, 0, hashOf(QValue(late))));
+		qtl::vector<QValue> values;
+		values.push_back(QValue(late));
+		values.push_back(QValue("late"));
+		table->insert(values);
+		QSQL_CHECK(!table->isAbsent(pages - 1, 0, hashOf(QValue(late))) && !table->isAbsent(pages - 1, 1, hashOf(QValue("late"))));
+
+		// a key on its own drops no rows, so the scan produces the rows of the
+		// pages it does not skip
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		const uint64_t snapshot = table->getClock().now();
+		QScanOperator scan(*table, columns, snapshot);
+		scan.addKey(1, new QConstantExpression(QValue("p2-13")));
+		QSQL_CHECK(drain(scan) == static_cast<std::size_t>(PAGE));
+
+		// skipping pages never changes what a query returns
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE id = 20000") == 1);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE name = 'p1-7'") == static_cast<std::size_t>(PAGE / 50 + (PAGE % 50 > 7)));
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE name = 'late' OR id = 3") == 2);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE name = 'none'") == 0);
+	}
+
+	// the filter of a join's build keys drops probe rows before the join
+	QSQL_TEST(bloomFilterPrunesJoinProbes)
+	{
+		QDatabase database;
+		QTable* build = createTable(database, "b");
+		QTable* probe = createTable(database, "p");
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		const uint64_t snapshot = build->getClock().now();
+
+		// every tenth build row is kept, by a filter on its scan
+		QOperator* input = new QScanOperator(*build, columns, snapshot);
+		QExpression* tenth = new QComparisonExpression(QComparison::EQUAL,
+			new QArithmeticExpression(QArithmetic::MODULO, new QColumnExpression(0, QDataType::LONG), new QConstantExpression(QValue(static_cast<int64_t>(10)))),
+			new QConstantExpression(QValue(static_cast<int64_t>(0))));
+		QJoinHashTable table(new QFilterOperator(input, tenth), new QColumnExpression(0, QDataType::LONG), columns);
+		table.build();
+		QSQL_CHECK(table.size() == static_cast<std::size_t>((ROWS + 9) / 10));
+
+		const QBloomFilter& filter = table.getFilter();
+		bool found = true;
+		for (int64_t i = 0; i < ROWS; i += 10)
+		{
+			found = found && filter.contains(QJoinHashTable::hashKey(i));
+		}
+		QSQL_CHECK(found);
+
+		QScanOperator scan(*probe, columns, snapshot);
+		scan.addRuntimeFilter(0, filter);
+		const std::size_t passed = drain(scan);
+		QSQL_CHECK(passed >= table.size() && passed < table.size() + static_cast<std::size_t>(ROWS / 20));
+
+		QSQL_CHECK(test::countRows(database, "SELECT p.id FROM p JOIN b ON p.id = b.id WHERE b.id < 1000") == 1000);
+	}
+}
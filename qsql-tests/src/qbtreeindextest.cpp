@@ -0,0 +1,149 @@
+#include <qsql/qsql.h>
+#include <qsql/qbtreeindex.h>
+
+#include "qtest.h"
+
+#include <cstdlib>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t ROWS = 30000;
+
+		QTable* createTable(QDatabase& database, qtl::vector<int64_t>& keys)
+		{
+			QSchema schema;
+			schema.addColumn("k", QDataType::LONG, true);
+			QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+			srand(11);
+			for (std::size_t i = 0; i < ROWS; i++)
+			{
+				const int64_t key = rand() % 5000 - 2500;
+				keys.push_back(key);
+				qtl::vector<QValue> values;
+				values.push_back(i % 100 == 0 ? QValue() : QValue(key));
+				table->insert(values);
+			}
+			return table;
+		}
+
+		// Reads a whole range, checking it is ordered by value and then row
+		std::size_t drain(QBTreeRange& range, const qtl::vector<int64_t>& keys, const bool descending, bool& ordered)
+		{
+			std::size_t rows[64];
+			std::size_t total = 0;
+			std::size_t previous = 0;
+			while (const std::size_t count = range.next(rows, 64))
+			{
+				for (std::size_t i = 0; i < count; i++)
+				{
+					if (total + i > 0)
+					{
+						const int64_t left = keys[previous];
+						const int64_t right = keys[rows[i]];
+						ordered = ordered && (descending ? left > right || (left == right && previous > rows[i]) : left < right || (left == right && previous < rows[i]));
+					}
+					previous = rows[i];
+				}
+				total += count;
+			}
+			return total;
+		}
+	}
+
+	QSQL_TEST(btreeIndexRangesAreOrdered)
+	{
+		QDatabase database;
+		qtl::vector<int64_t> keys;
+		QTable* table = createTable(database, keys);
+		QSQL_CHECK(table->createBTreeIndex(0));
+		const QBTreeIndex* index = table->getBTreeIndex(0);
+		QSQL_CHECK(index->size() == ROWS - ROWS / 100);
+
+		const QValue low(static_cast<int64_t>(-100));
+		const QValue high(static_cast<int64_t>(250));
+		std::size_t inclusive = 0;
+		std::size_t exclusive = 0;
+		std::size_t below = 0;
+		for (std::size_t i = 0; i < ROWS; i++)
+		{
+			if (i % 100 != 0)
+			{
+				inclusive += keys[i] >= -100 && keys[i] <= 250;
+				exclusive += keys[i] > -100 && keys[i] < 250;
+				below += keys[i] < -100;
+			}
+		}
+
+		for (int descending = 0; descending < 2; descending++)
+		{
+			bool ordered = true;
+			QBTreeRange range;
+			index->open(range, &low, true, &high, true, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == inclusive);
+			index->open(range, &low, false, &high, false, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == exclusive);
+			index->open(range, nullptr, true, &low, false, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == below);
+			index->open(range, nullptr, true, nullptr, true, descending != 0);
+			QSQL_CHECK(drain(range, keys, descending != 0, ordered) == ROWS - ROWS / 100);
+			QSQL_CHECK(ordered);
+		}
+
+		// a NULL bound gives an empty range
+		const QValue null;
+		QBTreeRange range;
+		index->open(range, &null, true, nullptr, true, false);
+		std::size_t rows[4];
+		QSQL_CHECK(range.next(rows, 4) == 0);
+	}
+
+	// range predicates and ORDER BY read through the index agree with a scan
+	QSQL_TEST(btreeIndexServesQueries)
+	{
+		QDatabase database;
+		qtl::vector<int64_t> keys;
+		QTable* table = createTable(database, keys);
+		qtl::vector<uint64_t> scanned;
+		const std::size_t expected = table->filterBetween(0, QValue(static_cast<int64_t>(10)), QValue(static_cast<int64_t>(900)), scanned);
+		table->createBTreeIndex(0);
+		qtl::vector<uint64_t> indexed;
+		QSQL_CHECK(table->filterBetween(0, QValue(static_cast<int64_t>(10)), QValue(static_cast<int64_t>(900)), indexed) == expected);
+		bool same = indexed.size() >= scanned.size();
+		for (std::size_t i = 0; i < scanned.size() && same; i++)
+		{
+			same = scanned[i] == indexed[i];
+		}
+		QSQL_CHECK(same);
+
+		QStatement select = database.prepare("SELECT k FROM t WHERE k >= ? ORDER BY k DESC");
+		select.setLong(0, 2000);
+		QSQL_CHECK(select.execute());
+		std::size_t count = 0;
+		int64_t previous = 2500;
+		bool ordered = true;
+		while (QBatch* batch = select.next())
+		{
+			for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+			{
+				const int64_t key = batch->getColumn(0).getValue(batch->hasSelection() ? batch->getSelection()[i] : i).getLong();
+				ordered = ordered && key <= previous && key >= 2000;
+				previous = key;
+				count++;
+			}
+		}
+		QSQL_CHECK(ordered);
+		std::size_t matching = 0;
+		for (std::size_t i = 0; i < ROWS; i++)
+		{
+			matching += i % 100 != 0 && keys[i] >= 2000;
+		}
+		QSQL_CHECK(count == matching);
+
+		// erased rows leave the ranges
+		QStatement erase = database.prepare("DELETE FROM t WHERE k >= 2000");
+		QSQL_CHECK(erase.execute() && erase.getAffectedRows() == matching);
+		QSQL_CHECK(select.execute() && select.next() == nullptr);
+	}
+}
@@ -0,0 +1,304 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include <qtl/thread/thread.h>
+
+namespace qsql
+{
+	namespace
+	{
+		const char* const POOL_PATH = "qsql-tests-pool.dat";
+		const char* const TABLE_PATH = "qsql-tests-pool.qtf";
+		constexpr uint64_t PAGES = 16;
+
+		// Writes PAGES pages, every byte of page p holds p
+		void writePages()
+		{
+			FILE* file = fopen(POOL_PATH, "wb");
+			char* page = new char[QBufferPool::PAGE_SIZE];
+			for (uint64_t p = 0; p < PAGES; p++)
+			{
+				memset(page, static_cast<int>(p), QBufferPool::PAGE_SIZE);
+				fwrite(page, 1, QBufferPool::PAGE_SIZE, file);
+			}
+			delete[] page;
+			fclose(file);
+		}
+
+		int readByte(const char* path, const uint64_t offset)
+		{
+			FILE* file = fopen(path, "rb");
+			fseek(file, static_cast<long>(offset), SEEK_SET);
+			const int byte = fgetc(file);
+			fclose(file);
+			return byte;
+		}
+
+		// Saves rows of (id, score) to TABLE_PATH, score is NULL for every ninth row
+		void saveScores(const std::size_t rows)
+		{
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			schema.addColumn("score", QDataType::INT, true);
+			QTable source(schema, QTableLayout::COLUMN);
+			for (std::size_t i = 0; i < rows; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(static_cast<int64_t>(i)));
+				values.push_back(i % 9 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 500)));
+				source.insert(values);
+			}
+			QTableFile tableFile;
+			QSQL_CHECK(tableFile.save(source, TABLE_PATH));
+		}
+
+		qtl::vector<char> readFile(const char* path)
+		{
+			qtl::vector<char> data;
+			FILE* file = fopen(path, "rb");
+			if (file != nullptr)
+			{
+				fseek(file, 0, SEEK_END);
+				data.resize(static_cast<std::size_t>(ftell(file)));
+				fseek(file, 0, SEEK_SET);
+				if (data.size() > 0 && fread(&data[0], 1, data.size(), file) != data.size())
+				{
+					data.clear();
+				}
+				fclose(file);
+			}
+			return data;
+		}
+	}
+
+	QSQL_TEST(bufferPoolEvictsAndWritesBack)
+	{
+		writePages();
+		{
+			QBufferPool pool(4);
+			const uint32_t file = pool.addFile(POOL_PATH);
+			QSQL_CHECK(file != QBufferPool::NONE);
+			QSQL_CHECK(pool.getFileSize(file) == PAGES * QBufferPool::PAGE_SIZE);
+
+			bool read = true;
+			for (uint64_t p = 0; p < PAGES; p++)
+			{
+				char* page = pool.pin(file, p);
+				read = read && page != nullptr && page[0] == static_cast<char>(p) && page[QBufferPool::PAGE_SIZE - 1] == static_cast<char>(p);
+				if (page != nullptr)
+				{
+					page[1] = p == 3 ? 'x' : page[1];
+					pool.unpin(page, p == 3);
+				}
+			}
+			QSQL_CHECK(read);
+			QSQL_CHECK(pool.getMisses() == PAGES && pool.getEvictions() == PAGES - 4);
+
+			// the modified page was written back when its frame was reused
+			QSQL_CHECK(pool.getWrites() == 1);
+			QSQL_CHECK(readByte(POOL_PATH, 3 * QBufferPool::PAGE_SIZE + 1) == 'x');
+
+			char* last = pool.pin(file, PAGES - 1);
+			QSQL_CHECK(pool.getHits() == 1);
+			pool.unpin(last, false);
+
+			// a page past the end reads as zeroes and grows the file once written
+			char* past = pool.pin(file, PAGES);
+			QSQL_CHECK(past != nullptr && past[0] == 0 && past[QBufferPool::PAGE_SIZE - 1] == 0);
+			past[0] = 'y';
+			pool.unpin(past, true);
+			QSQL_CHECK(pool.flush());
+			QSQL_CHECK(pool.getFileSize(file) == (PAGES + 1) * QBufferPool::PAGE_SIZE);
+			QSQL_CHECK(readByte(POOL_PATH, PAGES * QBufferPool::PAGE_SIZE) == 'y');
+			pool.removeFile(file);
+		}
+		remove(POOL_PATH);
+	}
+
+	QSQL_TEST(bufferPoolKeepsPinnedPages)
+	{
+		writePages();
+		QBufferPool pool(2);
+		const uint32_t file = pool.addFile(POOL_PATH);
+		char* first = pool.pin(file, 0);
+		char* second = pool.pin(file, 1);
+		QSQL_CHECK(first != nullptr && second != nullptr);
+
+		// both frames are pinned
+		QSQL_CHECK(pool.pin(file, 2) == nullptr);
+		QSQL_CHECK(pool.getError()[0] != '\0');
+
+		pool.unpin(second, false);
+		char* third = pool.pin(file, 2);
+		QSQL_CHECK(third == second && third[0] == 2);
+		QSQL_CHECK(first[0] == 0);
+		pool.unpin(first, false);
+		pool.unpin(third, false);
+		pool.removeFile(file);
+		remove(POOL_PATH);
+	}
+
+	// threads pinning more pages than there are frames each see their page,
+	// and every write reaches the file
+	QSQL_TEST(bufferPoolSharesFramesBetweenThreads)
+	{
+		writePages();
+		const std::size_t threads = 4;
+		std::atomic<int> counts[PAGES];
+		std::atomic<bool> correct(true);
+		{
+			QBufferPool pool(8);
+			const uint32_t file = pool.addFile(POOL_PATH);
+			for (uint64_t p = 0; p < PAGES; p++)
+			{
+				counts[p] = 0;
+			}
+			qtl::thread* workers[threads];
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers[t] = new qtl::thread([&pool, &counts, &correct, file, t]()
+				{
+					uint32_t seed = static_cast<uint32_t>(t) * 7919 + 1;
+					for (int i = 0; i < 2000; i++)
+					{
+						seed = seed * 1103515245 + 12345;
+						const uint64_t p = (seed >> 16) % PAGES;
+						char* page = pool.pin(file, p);
+						if (page == nullptr || page[0] != static_cast<char>(p))
+						{
+							correct = false;
+							continue;
+						}
+
+						// only one thread writes each page
+						const bool dirty = p % threads == t;
+						if (dirty)
+						{
+							page[1] = static_cast<char>(page[1] + 1);
+							counts[p]++;
+						}
+						pool.unpin(page, dirty);
+					}
+				});
+			}
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers[t]->join();
+				delete workers[t];
+			}
+			QSQL_CHECK(pool.flush());
+			pool.removeFile(file);
+		}
+		QSQL_CHECK(correct);
+		bool written = true;
+		for (uint64_t p = 0; p < PAGES; p++)
+		{
+			written = written && readByte(POOL_PATH, p * QBufferPool::PAGE_SIZE + 1) == ((static_cast<int>(p) + counts[p]) & 0xFF);
+		}
+		QSQL_CHECK(written);
+		remove(POOL_PATH);
+	}
+
+	// a table read through a pool smaller than the file matches the source,
+	// and changing it never writes the file
+	QSQL_TEST(bufferPoolReadsTableFiles)
+	{
+		const std::size_t rows = QColumn::CHUNK_SIZE * 20 + 77;
+		saveScores(rows);
+		QTableFile tableFile;
+		const qtl::vector<char> saved = readFile(TABLE_PATH);
+
+		// the pool outlives the table, which the database destroys
+		QBufferPool pool(4);
+		QDatabase database;
+		QTable* opened = tableFile.open(TABLE_PATH, pool);
+		QSQL_CHECK(opened != nullptr && opened->getBufferPool() == &pool);
+		if (opened == nullptr || !database.addTable("t", opened))
+		{
+			return;
+		}
+
+		QStatement select = database.prepare("SELECT id FROM t WHERE score = 7");
+		QSQL_CHECK(select.execute());
+		std::size_t count = 0;
+		while (QBatch* batch = select.next())
+		{
+			count += batch->getActiveCount();
+		}
+		std::size_t expected = 0;
+		for (std::size_t i = 0; i < rows; i++)
+		{
+			expected += i % 9 != 0 && i % 500 == 7;
+		}
+		QSQL_CHECK(count == expected);
+		QSQL_CHECK(pool.getEvictions() > 0);
+
+		QStatement insert = database.prepare("INSERT INTO t VALUES (-1, NULL)");
+		QSQL_CHECK(insert.execute());
+		QStatement update = database.prepare("UPDATE t SET score = 9999 WHERE id = 3");
+		QSQL_CHECK(update.execute() && update.getAffectedRows() == 1);
+		QSQL_CHECK(pool.flush());
+		QSQL_CHECK(pool.getWrites() == 0);
+		QSQL_CHECK(readFile(TABLE_PATH) == saved);
+		QSQL_CHECK(opened->getRow(rows).get(1).isNull() && opened->getRow(rows).get(0).get<int64_t>() == -1);
+
+		database.dropTable("t");
+		remove(TABLE_PATH);
+	}
+
+	// a pool too small for a chunk of every scanned column fails the statement
+	// rather than the scan, and values read through it are copied out
+	QSQL_TEST(bufferPoolFailsScansItCannotPin)
+	{
+		const std::size_t rows = QColumn::CHUNK_SIZE * 4 + 77;
+		saveScores(rows);
+		QTableFile tableFile;
+		QBufferPool pool(2);
+		QDatabase database;
+		QTable* opened = tableFile.open(TABLE_PATH, pool);
+		QSQL_CHECK(opened != nullptr);
+		if (opened == nullptr || !database.addTable("t", opened))
+		{
+			remove(TABLE_PATH);
+			return;
+		}
+
+		// id and the values and nulls of score need three frames
+		QStatement sum = database.prepare("SELECT SUM(id), COUNT(*) FROM t WHERE score = 7");
+		QSQL_CHECK(!sum.isValid() && sum.getError()[0] != '\0');
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t WHERE id < 10") == 10);
+
+		// a field keeps its value once the pool has read other pages into its frame
+		QField field = opened->getRow(3).get(0);
+		QSQL_CHECK(test::countRows(database, "SELECT id FROM t") == rows);
+		QSQL_CHECK(field.get<int64_t>() == 3);
+
+		// a scan of score pins both frames, leaving none for a scan of id
+		QStatement scores = database.prepare("SELECT score FROM t");
+		QSQL_CHECK(scores.execute() && scores.next() != nullptr);
+		QStatement ids = database.prepare("SELECT SUM(id) FROM t");
+		QSQL_CHECK(ids.execute());
+		QSQL_CHECK(ids.next() == nullptr && ids.getError()[0] != '\0');
+		QStatement erase = database.prepare("DELETE FROM t WHERE id > 5");
+		QSQL_CHECK(!erase.execute() && erase.getError()[0] != '\0');
+		QSQL_CHECK(opened->getErasedCount() == 0);
+
+		// once the first scan is done the others run again
+		while (scores.next())
+		{
+		}
+		QSQL_CHECK(ids.execute());
+		QBatch* total = ids.next();
+		QSQL_CHECK(total != nullptr && total->getColumn(0).getValue(0).getLong() == static_cast<int64_t>(rows * (rows - 1) / 2));
+		QSQL_CHECK(ids.next() == nullptr);
+		QSQL_CHECK(erase.execute() && erase.getAffectedRows() == rows - 6);
+
+		database.dropTable("t");
+		remove(TABLE_PATH);
+	}
+}
@@ -0,0 +1,80 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	QSQL_TEST(columnAppendsAcrossChunks)
+	{
+		QColumn column(QDataType::LONG, true);
+		const std::size_t rows = QColumn::CHUNK_SIZE * 2 + 5;
+		for (std::size_t i = 0; i < rows; i++)
+		{
+			*static_cast<int64_t*>(column.append()) = static_cast<int64_t>(i) * 3;
+			if (i % 5 == 0)
+			{
+				column.setNull(i, true);
+			}
+		}
+		QSQL_CHECK(column.size() == rows);
+		QSQL_CHECK(column.getChunkCount() == 3);
+		QSQL_CHECK(column.getChunkSize(0) == QColumn::CHUNK_SIZE);
+		QSQL_CHECK(column.getChunkSize(2) == 5);
+
+		bool matches = true;
+		for (std::size_t i = 0; i < rows; i++)
+		{
+			matches = matches && *static_cast<const int64_t*>(column.at(i)) == static_cast<int64_t>(i) * 3;
+			matches = matches && column.isNull(i) == (i % 5 == 0);
+		}
+		QSQL_CHECK(matches);
+
+		// chunks are contiguous arrays of the native type
+		const int64_t* chunk = column.getChunk<int64_t>(1);
+		QSQL_CHECK(chunk[0] == static_cast<int64_t>(QColumn::CHUNK_SIZE) * 3);
+		QSQL_CHECK(chunk[QColumn::CHUNK_SIZE - 1] == static_cast<int64_t>(QColumn::CHUNK_SIZE * 2 - 1) * 3);
+	}
+
+	// both layouts return the same values for the same inserts
+	QSQL_TEST(columnLayoutMatchesRowLayout)
+	{
+		QSchema schema;
+		schema.addColumn("c", QDataType::CHAR);
+		schema.addColumn("i", QDataType::INT, true);
+		schema.addColumn("l", QDataType::LONG);
+		schema.addColumn("b", QDataType::BOOL);
+		schema.addColumn("s", QDataType::STRING, true);
+		QTable rowTable(schema, QTableLayout::ROW);
+		QTable columnTable(schema, QTableLayout::COLUMN);
+		const std::size_t rows = QColumn::CHUNK_SIZE + 100;
+		for (std::size_t i = 0; i < rows; i++)
+		{
+			qtl::vector<QValue> values;
+			values.push_back(QValue(static_cast<char>('a' + i % 26)));
+			values.push_back(i % 3 == 0 ? QValue() : QValue(static_cast<int32_t>(i)));
+			values.push_back(QValue(static_cast<int64_t>(i) << 33));
+			values.push_back(QValue(i % 2 == 0));
+			values.push_back(i % 4 == 0 ? QValue() : QValue(i % 8 == 1 ? "odd" : "other"));
+			rowTable.insert(values);
+			columnTable.insert(values);
+		}
+		QSQL_CHECK(rowTable.getRowCount() == rows && columnTable.getRowCount() == rows);
+		QSQL_CHECK(columnTable.getColumn(2).size() == rows);
+
+		bool matches = true;
+		for (std::size_t i = 0; i < rows; i++)
+		{
+			const QRow left = rowTable.getRow(i);
+			const QRow right = columnTable.getRow(i);
+			matches = matches && left.get(0).get<char>() == right.get(0).get<char>();
+			matches = matches && left.get(1).isNull() == right.get(1).isNull();
+			matches = matches && (left.get(1).isNull() || left.get(1).get<int32_t>() == right.get(1).get<int32_t>());
+			matches = matches && left.get(2).get<int64_t>() == right.get(2).get<int64_t>();
+			matches = matches && left.get(3).get<bool>() == right.get(3).get<bool>();
+			matches = matches && left.get(4).isNull() == right.get(4).isNull();
+			matches = matches && (left.get(4).isNull() || left.get(4).get<qtl::string>() == right.get(4).get<qtl::string>());
+		}
+		QSQL_CHECK(matches);
+		QSQL_CHECK(columnTable.getRow(9).get(4).get<qtl::string>() == qtl::string("odd"));
+	}
+}
@@ -0,0 +1,83 @@
+#include <qsql/qsql.h>
+#include <qsql/qdictionary.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	QSQL_TEST(dictionaryAssignsStableCodes)
+	{
+		QDictionary dictionary;
+		char text[16];
+		const std::size_t strings = QDictionary::CHUNK_SIZE * 3;
+		for (std::size_t i = 0; i < strings; i++)
+		{
+			snprintf(text, sizeof(text), "value%zu", i);
+			QSQL_CHECK(dictionary.encode(text) == i);
+		}
+		const qtl::string& first = dictionary.decode(0);
+
+		// encoding again returns the same code and adds nothing
+		bool stable = true;
+		for (std::size_t i = 0; i < strings; i += 7)
+		{
+			snprintf(text, sizeof(text), "value%zu", i);
+			stable = stable && dictionary.encode(text) == i && dictionary.find(text) == i;
+			stable = stable && dictionary.decode(static_cast<uint32_t>(i)) == qtl::string(text);
+		}
+		QSQL_CHECK(stable);
+		QSQL_CHECK(dictionary.size() == strings);
+		QSQL_CHECK(dictionary.find("missing") == QDictionary::NONE);
+
+		// references stay valid while the dictionary grows
+		QSQL_CHECK(&first == &dictionary.decode(0) && first == qtl::string("value0"));
+	}
+
+	QSQL_TEST(dictionaryColumnAnswersQueries)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("id", QDataType::INT);
+		schema.addColumn("city", QDataType::STRING, true, QEncoding::DICTIONARY);
+		const char* cities[4] = { "Oslo", "Lima", "Pune", "Kyiv" };
+		for (int layout = 0; layout < 2; layout++)
+		{
+			QTable* table = database.createTable(layout ? "columns" : "rows", schema, layout ? QTableLayout::COLUMN : QTableLayout::ROW);
+			QSQL_CHECK(table->getDictionary(1) != nullptr && table->getDictionary(0) == nullptr);
+			for (int32_t i = 0; i < 10000; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(i % 5 == 4 ? QValue() : QValue(cities[i % 5]));
+				table->insert(values);
+			}
+			QSQL_CHECK(table->getDictionary(1)->size() == 4);
+			QSQL_CHECK(table->getRow(2).get(1).get<qtl::string>() == qtl::string("Pune"));
+			QSQL_CHECK(table->getRow(4).get(1).isNull());
+			QSQL_CHECK(table->getDictionary(1)->decode(table->getCode(3, 1)) == qtl::string("Kyiv"));
+		}
+
+		QStatement select = database.prepare("SELECT city FROM columns WHERE city = 'Lima' OR city IN ('Kyiv', 'Rome')");
+		QSQL_CHECK(select.execute());
+		std::size_t count = 0;
+		bool decoded = true;
+		while (QBatch* batch = select.next())
+		{
+			for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+			{
+				const QValue value = batch->getColumn(0).getValue(batch->hasSelection() ? batch->getSelection()[i] : i);
+				decoded = decoded && (value.getString() == qtl::string("Lima") || value.getString() == qtl::string("Kyiv"));
+				count++;
+			}
+		}
+		QSQL_CHECK(count == 4000);
+		QSQL_CHECK(decoded);
+
+		// a string that was never stored matches nothing, and is not added
+		QStatement missing = database.prepare("SELECT id FROM rows WHERE city = 'Rome'");
+		QSQL_CHECK(missing.execute() && missing.next() == nullptr);
+		QSQL_CHECK(database.getTable("rows")->getDictionary(1)->size() == 4);
+	}
+}
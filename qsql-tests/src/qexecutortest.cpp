@@ -0,0 +1,95 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	namespace
+	{
+		// k is the row index, v is k % 100 and NULL on every seventh row
+		QTable* createTable(QDatabase& database, const QTableLayout layout, const int64_t rows)
+		{
+			QSchema schema;
+			schema.addColumn("k", QDataType::LONG);
+			schema.addColumn("v", QDataType::INT, true);
+			QTable* table = database.createTable("t", schema, layout);
+			for (int64_t i = 0; i < rows; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(i % 7 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 100)));
+				table->insert(values);
+			}
+			return table;
+		}
+
+		// Sums the first column of the active rows of every batch, counting them
+		int64_t drain(QOperator& root, std::size_t& count)
+		{
+			int64_t sum = 0;
+			count = 0;
+			while (QBatch* batch = root.next())
+			{
+				for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+				{
+					const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+					sum += batch->getColumn(0).getValue(index).getLong();
+				}
+				count += batch->getActiveCount();
+			}
+			return sum;
+		}
+	}
+
+	// scan, filter and projection over rows spanning several batches and chunks
+	QSQL_TEST(executorFiltersAndProjectsBatches)
+	{
+		const int64_t rows = 40000;
+		for (int layout = 0; layout < 2; layout++)
+		{
+			QDatabase database;
+			QTable* table = createTable(database, layout ? QTableLayout::COLUMN : QTableLayout::ROW, rows);
+
+			int64_t expectedSum = 0;
+			std::size_t expectedCount = 0;
+			for (int64_t i = 0; i < rows; i++)
+			{
+				if (i % 7 != 0 && i % 100 > 50)
+				{
+					expectedSum += i * 2;
+					expectedCount++;
+				}
+			}
+
+			qtl::vector<std::size_t> columns;
+			columns.push_back(0);
+			columns.push_back(1);
+			const uint64_t snapshot = table->getClock().now();
+			QOperator* scan = new QScanOperator(*table, columns, snapshot);
+			QExpression* predicate = new QComparisonExpression(QComparison::GREATER, new QColumnExpression(1, QDataType::INT), new QConstantExpression(QValue(static_cast<int32_t>(50))));
+			QOperator* filter = new QFilterOperator(scan, predicate);
+			qtl::vector<QExpression*> expressions;
+			expressions.push_back(new QArithmeticExpression(QArithmetic::MULTIPLY, new QColumnExpression(0, QDataType::LONG), new QConstantExpression(QValue(static_cast<int64_t>(2)))));
+			QProjectionOperator projection(filter, expressions);
+
+			std::size_t count = 0;
+			QSQL_CHECK(drain(projection, count) == expectedSum);
+			QSQL_CHECK(count == expectedCount);
+
+			// a reset operator produces the same rows again
+			projection.reset();
+			QSQL_CHECK(drain(projection, count) == expectedSum);
+			QSQL_CHECK(count == expectedCount);
+		}
+	}
+
+	QSQL_TEST(executorMatchesSql)
+	{
+		QDatabase database;
+		createTable(database, QTableLayout::COLUMN, 20000);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE v IS NULL") == 2858);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k >= 19000 AND v < 10") == 86);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k BETWEEN 100 AND 199") == 100);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k < 0") == 0);
+	}
+}
@@ -0,0 +1,88 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <atomic>
+
+#include <qtl/thread/future.h>
+#include <qtl/thread/thread_pool.h>
+
+namespace qsql
+{
+	// get() copies the value and can be called again, take() moves it out
+	QSQL_TEST(futureGetCopiesTheValue)
+	{
+		qtl::promise<qtl::string> promise;
+		qtl::future<qtl::string> future = promise.get_future();
+		promise.set_value(qtl::string("value"));
+		QSQL_CHECK(future.get() == qtl::string("value"));
+		QSQL_CHECK(future.get() == qtl::string("value"));
+		QSQL_CHECK(future.take() == qtl::string("value"));
+	}
+
+	// a continuation runs whether it is attached before or after the value is set
+	QSQL_TEST(futureContinuationsChain)
+	{
+		qtl::thread_pool pool(2);
+
+		qtl::promise<int> early;
+		qtl::future<int> doubled = early.get_future().then(pool, [](int value) { return value * 2; });
+		qtl::future<qtl::string> text = doubled.then(pool, [](int value) { return value == 42 ? qtl::string("42") : qtl::string("?"); });
+		early.set_value(21);
+		QSQL_CHECK(text.get() == qtl::string("42"));
+
+		qtl::promise<int> late;
+		qtl::future<int> ready = late.get_future();
+		late.set_value(5);
+		QSQL_CHECK(ready.then(pool, [](int value) { return value + 1; }).get() == 6);
+
+		// a continuation of a pool task, ending in a future<void>
+		std::atomic<int> seen(0);
+		pool.submit([]() { return 7; }).then(pool, [&seen](int value) { seen = value; }).get();
+		QSQL_CHECK(seen == 7);
+	}
+
+	QSQL_TEST(futureWhenAllWaitsForEvery)
+	{
+		qtl::thread_pool pool(4);
+		qtl::vector<qtl::future<int>> futures;
+		for (int i = 0; i < 50; i++)
+		{
+			futures.push_back(pool.submit([i]() { return i; }));
+		}
+		qtl::vector<qtl::future<int>> ready = qtl::when_all(qtl::move(futures)).take();
+		QSQL_CHECK(ready.size() == 50);
+		int sum = 0;
+		for (std::size_t i = 0; i < ready.size(); i++)
+		{
+			sum += ready[i].get();
+		}
+		QSQL_CHECK(sum == 49 * 50 / 2);
+
+		// no futures are all ready at once
+		QSQL_CHECK(qtl::when_all(qtl::vector<qtl::future<int>>()).take().size() == 0);
+	}
+
+	QSQL_TEST(futureWhenAnyReturnsTheReadyOne)
+	{
+		qtl::promise<int> first;
+		qtl::promise<int> second;
+		qtl::promise<int> third;
+		qtl::vector<qtl::future<int>> futures;
+		futures.push_back(first.get_future());
+		futures.push_back(second.get_future());
+		futures.push_back(third.get_future());
+		qtl::future<qtl::when_any_result<int>> any = qtl::when_any(qtl::move(futures));
+		second.set_value(2);
+		qtl::when_any_result<int> result = any.take();
+		QSQL_CHECK(result.index == 1 && result.futures.size() == 3);
+		QSQL_CHECK(result.futures[1].get() == 2);
+
+		// the others still complete afterwards
+		first.set_value(1);
+		third.set_value(3);
+		QSQL_CHECK(result.futures[0].get() == 1 && result.futures[2].get() == 3);
+
+		QSQL_CHECK(qtl::when_any(qtl::vector<qtl::future<int>>()).take().index == static_cast<std::size_t>(-1));
+	}
+}
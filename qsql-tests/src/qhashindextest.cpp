@@ -0,0 +1,118 @@
+#include <qsql/qsql.h>
+#include <qsql/qhashindex.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	namespace
+	{
+		void insertRows(QTable& table, const int64_t first, const int64_t last)
+		{
+			char name[16];
+			for (int64_t i = first; i < last; i++)
+			{
+				snprintf(name, sizeof(name), "n%d", static_cast<int>(i % 50));
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i % 1000));
+				values.push_back(QValue(name));
+				table.insert(values);
+			}
+		}
+	}
+
+	// rows inserted before and after the index is built are both found
+	QSQL_TEST(hashIndexFindsEveryRow)
+	{
+		for (int layout = 0; layout < 2; layout++)
+		{
+			QSchema schema;
+			schema.addColumn("k", QDataType::LONG);
+			schema.addColumn("s", QDataType::STRING);
+			QTable table(schema, layout ? QTableLayout::COLUMN : QTableLayout::ROW);
+			insertRows(table, 0, 10000);
+			QSQL_CHECK(table.createHashIndex(0));
+			QSQL_CHECK(table.createHashIndex(1));
+			QSQL_CHECK(!table.createHashIndex(0));
+			insertRows(table, 10000, 20000);
+
+			const QHashIndex* index = table.getHashIndex(0);
+			QSQL_CHECK(index != nullptr && index->size() == 20000 && index->getKeyCount() == 1000);
+			qtl::vector<std::size_t> rows;
+			QSQL_CHECK(index->find(QValue(static_cast<int64_t>(42)), rows) == 20);
+			bool matches = true;
+			for (std::size_t i = 0; i < rows.size(); i++)
+			{
+				matches = matches && rows[i] % 1000 == 42;
+			}
+			QSQL_CHECK(matches);
+
+			rows.clear();
+			QSQL_CHECK(table.getHashIndex(1)->find(QValue("n7"), rows) == 400);
+			rows.clear();
+			QSQL_CHECK(index->find(QValue(static_cast<int64_t>(1000)), rows) == 0);
+		}
+	}
+
+	QSQL_TEST(hashIndexScanProducesRowsInOrder)
+	{
+		QSchema schema;
+		schema.addColumn("k", QDataType::LONG);
+		schema.addColumn("s", QDataType::STRING);
+		QTable table(schema, QTableLayout::COLUMN);
+		insertRows(table, 0, 20000);
+		table.createHashIndex(0);
+
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		const uint64_t snapshot = table.getClock().now();
+		QIndexScanOperator scan(table, columns, *table.getHashIndex(0), new QConstantExpression(QValue(static_cast<int64_t>(7))), snapshot);
+		scan.reset();
+		std::size_t count = 0;
+		std::size_t previous = 0;
+		bool ordered = true;
+		while (QBatch* batch = scan.next())
+		{
+			for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+			{
+				const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+				const std::size_t row = batch->getRowId(index);
+				ordered = ordered && (count == 0 || row > previous) && row % 1000 == 7;
+				ordered = ordered && batch->getColumn(0).getValue(index).getLong() == 7;
+				previous = row;
+				count++;
+			}
+		}
+		QSQL_CHECK(count == 20);
+		QSQL_CHECK(ordered);
+	}
+
+	// the index follows updates and erases made through SQL
+	QSQL_TEST(hashIndexFollowsChanges)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("k", QDataType::LONG);
+		schema.addColumn("s", QDataType::STRING);
+		QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+		insertRows(*table, 0, 5000);
+		table->createHashIndex(0);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k = 3") == 5);
+
+		QStatement update = database.prepare("UPDATE t SET k = 3 WHERE k = 4");
+		QSQL_CHECK(update.execute() && update.getAffectedRows() == 5);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k = 3") == 10);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k = 4") == 0);
+
+		QStatement erase = database.prepare("DELETE FROM t WHERE k = 3 AND s = 'n3'");
+		QSQL_CHECK(erase.execute() && erase.getAffectedRows() == 5);
+		QSQL_CHECK(test::countRows(database, "SELECT k FROM t WHERE k = 3") == 5);
+
+		// versions nobody can see leave the index
+		database.collectGarbage();
+		qtl::vector<std::size_t> rows;
+		QSQL_CHECK(table->getHashIndex(0)->find(QValue(static_cast<int64_t>(3)), rows) == 5);
+	}
+}
@@ -0,0 +1,102 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+#include <qtl/thread/thread_pool.h>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr int64_t CUSTOMERS = 5000;
+		constexpr int64_t ORDERS = 60000;
+
+		// orders reference customers by id, and every tenth order by no one
+		void createTables(QDatabase& database)
+		{
+			QSchema customers;
+			customers.addColumn("id", QDataType::LONG);
+			customers.addColumn("name", QDataType::STRING);
+			QTable* customerTable = database.createTable("customers", customers, QTableLayout::COLUMN);
+			char name[16];
+			for (int64_t i = 0; i < CUSTOMERS; i++)
+			{
+				snprintf(name, sizeof(name), "c%d", static_cast<int>(i % 100));
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(QValue(name));
+				customerTable->insert(values);
+			}
+
+			QSchema orders;
+			orders.addColumn("customer", QDataType::LONG, true);
+			orders.addColumn("amount", QDataType::INT);
+			orders.addColumn("tag", QDataType::STRING);
+			QTable* orderTable = database.createTable("orders", orders, QTableLayout::COLUMN);
+			for (int64_t i = 0; i < ORDERS; i++)
+			{
+				snprintf(name, sizeof(name), "c%d", static_cast<int>(i % 250));
+				qtl::vector<QValue> values;
+				values.push_back(i % 10 == 0 ? QValue() : QValue(i % (CUSTOMERS * 2)));
+				values.push_back(QValue(static_cast<int32_t>(i % 7)));
+				values.push_back(QValue(name));
+				orderTable->insert(values);
+			}
+		}
+
+		std::size_t expectedMatches(const bool filtered)
+		{
+			std::size_t count = 0;
+			for (int64_t i = 0; i < ORDERS; i++)
+			{
+				count += i % 10 != 0 && i % (CUSTOMERS * 2) < CUSTOMERS && (!filtered || i % 7 == 3);
+			}
+			return count;
+		}
+	}
+
+	// NULL keys and keys missing from the build side never match
+	QSQL_TEST(hashJoinMatchesKeys)
+	{
+		QDatabase database;
+		createTables(database);
+		QSQL_CHECK(test::countRows(database, "SELECT orders.amount, customers.name FROM orders JOIN customers ON orders.customer = customers.id") == expectedMatches(false));
+		QSQL_CHECK(test::countRows(database, "SELECT orders.amount FROM orders JOIN customers ON orders.customer = customers.id WHERE orders.amount = 3") == expectedMatches(true));
+
+		// string keys, where each of the 100 names is held by 50 customers
+		std::size_t expected = 0;
+		for (int64_t i = 0; i < ORDERS; i++)
+		{
+			expected += i % 250 < 100 ? 50 : 0;
+		}
+		QSQL_CHECK(test::countRows(database, "SELECT orders.amount FROM orders JOIN customers ON orders.tag = customers.name") == expected);
+
+		// the joined columns come from the matching rows
+		QStatement select = database.prepare("SELECT orders.customer, customers.id FROM orders JOIN customers ON orders.customer = customers.id WHERE orders.amount = 1");
+		QSQL_CHECK(select.execute());
+		bool matching = true;
+		while (QBatch* batch = select.next())
+		{
+			for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+			{
+				const std::size_t index = batch->hasSelection() ? batch->getSelection()[i] : i;
+				matching = matching && batch->getColumn(0).getValue(index).getLong() == batch->getColumn(1).getValue(index).getLong();
+			}
+		}
+		QSQL_CHECK(matching);
+	}
+
+	QSQL_TEST(hashJoinRunsInParallel)
+	{
+		qtl::thread_pool pool(4);
+		QDatabase database;
+		database.setThreadPool(&pool);
+		createTables(database);
+		for (int run = 0; run < 3; run++)
+		{
+			QSQL_CHECK(test::countRows(database, "SELECT orders.amount FROM orders JOIN customers ON orders.customer = customers.id") == expectedMatches(false));
+		}
+	}
+}
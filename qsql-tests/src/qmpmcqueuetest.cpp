@@ -0,0 +1,109 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <atomic>
+
+#include <qtl/thread/mpmc_queue.h>
+#include <qtl/thread/thread.h>
+
+namespace qsql
+{
+	QSQL_TEST(mpmcQueueIsBoundedAndOrdered)
+	{
+		qtl::mpmc_queue<int> queue(5);
+		QSQL_CHECK(queue.capacity() == 8);
+		QSQL_CHECK(queue.empty());
+
+		bool pushed = true;
+		for (int i = 0; i < 8; i++)
+		{
+			pushed = queue.try_push(i) && pushed;
+		}
+		QSQL_CHECK(pushed);
+		QSQL_CHECK(!queue.try_push(8));
+
+		// a single thread pops in push order, across several laps of the ring
+		int value = -1;
+		bool ordered = true;
+		for (int lap = 0; lap < 3; lap++)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				ordered = queue.try_pop(value) && value == lap * 8 + i && ordered;
+				ordered = queue.try_push(lap * 8 + i + 8) && ordered;
+			}
+		}
+		QSQL_CHECK(ordered);
+		for (int i = 0; i < 8; i++)
+		{
+			queue.try_pop(value);
+		}
+		QSQL_CHECK(queue.empty() && !queue.try_pop(value));
+
+		// the smallest queue still tells full from empty
+		qtl::mpmc_queue<int> smallest(1);
+		QSQL_CHECK(smallest.capacity() == 2);
+		QSQL_CHECK(smallest.try_push(1) && smallest.try_push(2) && !smallest.try_push(3));
+		QSQL_CHECK(smallest.try_pop(value) && value == 1 && smallest.try_pop(value) && value == 2 && !smallest.try_pop(value));
+	}
+
+	QSQL_TEST(mpmcQueueDestroysLeftElements)
+	{
+		qtl::shared_ptr<int> shared = qtl::make_shared<int>(3);
+		{
+			qtl::mpmc_queue<qtl::shared_ptr<int>> queue(4);
+			queue.try_push(shared);
+			queue.try_push(shared);
+			QSQL_CHECK(shared.use_count() == 3);
+		}
+		QSQL_CHECK(shared.use_count() == 1);
+	}
+
+	// every element pushed by several producers is popped exactly once
+	QSQL_TEST(mpmcQueueHandsEachElementToOneConsumer)
+	{
+		const std::size_t threads = 4;
+		const int elements = 5000;
+		qtl::mpmc_queue<int> queue(64);
+		std::atomic<int64_t> sum(0);
+		std::atomic<int> popped(0);
+		qtl::thread* producers[threads];
+		qtl::thread* consumers[threads];
+		for (std::size_t t = 0; t < threads; t++)
+		{
+			producers[t] = new qtl::thread([&queue, t, elements]()
+			{
+				for (int i = 0; i < elements; i++)
+				{
+					while (!queue.try_push(static_cast<int>(t) * elements + i))
+					{
+					}
+				}
+			});
+			consumers[t] = new qtl::thread([&queue, &sum, &popped, threads, elements]()
+			{
+				int value = 0;
+				while (popped.load() < static_cast<int>(threads) * elements)
+				{
+					if (queue.try_pop(value))
+					{
+						sum += value;
+						popped++;
+					}
+				}
+			});
+		}
+		for (std::size_t t = 0; t < threads; t++)
+		{
+			producers[t]->join();
+			consumers[t]->join();
+			delete producers[t];
+			delete consumers[t];
+		}
+		const int64_t count = static_cast<int64_t>(threads) * elements;
+		QSQL_CHECK(popped == count);
+		QSQL_CHECK(sum == count * (count - 1) / 2);
+		QSQL_CHECK(queue.empty());
+	}
+}
@@ -0,0 +1,103 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <qtl/thread/thread_pool.h>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr int64_t ROWS = 300000;
+
+		QTable* createTable(QDatabase& database, const QTableLayout layout)
+		{
+			QSchema schema;
+			schema.addColumn("k", QDataType::LONG);
+			QTable* table = database.createTable("t", schema, layout);
+			for (int64_t i = 0; i < ROWS; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				table->insert(values);
+			}
+			return table;
+		}
+
+		int64_t sum(QStatement& statement, std::size_t& count)
+		{
+			int64_t total = 0;
+			count = 0;
+			if (statement.execute())
+			{
+				while (QBatch* batch = statement.next())
+				{
+					for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+					{
+						total += batch->getColumn(0).getValue(batch->hasSelection() ? batch->getSelection()[i] : i).getLong();
+					}
+					count += batch->getActiveCount();
+				}
+			}
+			return total;
+		}
+	}
+
+	// the morsels cover every row exactly once, however the workers share them
+	QSQL_TEST(parallelScanReadsEveryRowOnce)
+	{
+		QMorselCursor cursor;
+		cursor.reset(QMorselCursor::MORSEL_SIZE * 3 + 10);
+		std::size_t first = 0;
+		std::size_t end = 0;
+		std::size_t covered = 0;
+		std::size_t morsels = 0;
+		while (cursor.next(first, end))
+		{
+			QSQL_CHECK(first == covered && end > first);
+			covered = end;
+			morsels++;
+		}
+		QSQL_CHECK(covered == QMorselCursor::MORSEL_SIZE * 3 + 10 && morsels == 4);
+
+		qtl::thread_pool pool(4);
+		for (int layout = 0; layout < 2; layout++)
+		{
+			QDatabase database;
+			database.setThreadPool(&pool);
+			createTable(database, layout ? QTableLayout::COLUMN : QTableLayout::ROW);
+			QStatement select = database.prepare("SELECT k FROM t WHERE k % 3 = 0");
+			int64_t expected = 0;
+			for (int64_t i = 0; i < ROWS; i += 3)
+			{
+				expected += i;
+			}
+
+			// repeated executions reuse the plan and its pipelines
+			for (int run = 0; run < 5; run++)
+			{
+				std::size_t count = 0;
+				QSQL_CHECK(sum(select, count) == expected);
+				QSQL_CHECK(count == static_cast<std::size_t>(ROWS / 3));
+			}
+		}
+	}
+
+	// a statement abandoned before its last batch leaves no task behind
+	QSQL_TEST(parallelScanCanBeAbandoned)
+	{
+		qtl::thread_pool pool(4);
+		QDatabase database;
+		database.setThreadPool(&pool);
+		createTable(database, QTableLayout::COLUMN);
+		for (int run = 0; run < 20; run++)
+		{
+			QStatement select = database.prepare("SELECT k FROM t WHERE k > 10");
+			QSQL_CHECK(select.execute() && select.next() != nullptr);
+		}
+		QStatement select = database.prepare("SELECT k FROM t WHERE k > 10");
+		std::size_t count = 0;
+		sum(select, count);
+		QSQL_CHECK(count == static_cast<std::size_t>(ROWS - 11));
+	}
+}
@@ -0,0 +1,119 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		// the syntax tree points into the text, which is a literal here
+		const QAstStatement* parse(QParser& parser, const char* text)
+		{
+			return parser.parse(text, strlen(text));
+		}
+	}
+
+	QSQL_TEST(parserBuildsSelect)
+	{
+		QArena arena;
+		QParser parser(arena);
+		const QAstStatement* statement = parse(parser, "SELECT a, b + 1 AS c FROM t WHERE a >= ? AND b NOT BETWEEN 1 AND 5 ORDER BY a DESC LIMIT 10;");
+		QSQL_CHECK(statement != nullptr);
+		if (statement == nullptr)
+		{
+			return;
+		}
+		QSQL_CHECK(statement->type == QAstStatementType::SELECT_STATEMENT);
+		QSQL_CHECK(equalsIgnoreCase(statement->table, "T"));
+		QSQL_CHECK(statement->parameterCount == 1);
+
+		const QAstSelectItem* first = statement->items;
+		QSQL_CHECK(first->expression->type == QAstExpressionType::COLUMN && equalsIgnoreCase(first->expression->name, "a"));
+		QSQL_CHECK(first->next->expression->type == QAstExpressionType::ARITHMETIC);
+		QSQL_CHECK(equalsIgnoreCase(first->next->alias, "c"));
+		QSQL_CHECK(first->next->next == nullptr);
+
+		// AND binds the comparison and the BETWEEN
+		const QAstExpression* where = statement->where;
+		QSQL_CHECK(where->type == QAstExpressionType::LOGICAL && where->logical == QLogical::AND);
+		QSQL_CHECK(where->left->type == QAstExpressionType::COMPARISON && where->left->comparison == QComparison::GREATER_EQUAL);
+		QSQL_CHECK(where->left->right->type == QAstExpressionType::PARAMETER && where->left->right->parameter == 0);
+		QSQL_CHECK(where->right->type == QAstExpressionType::BETWEEN && where->right->negated);
+
+		QSQL_CHECK(statement->orderBy != nullptr && statement->orderBy->descending);
+		QSQL_CHECK(statement->limit != nullptr && statement->limit->literal.integer == 10);
+	}
+
+	QSQL_TEST(parserBuildsChanges)
+	{
+		QArena arena;
+		QParser parser(arena);
+		const QAstStatement* insert = parse(parser, "INSERT INTO t (a, b) VALUES (1, 'it''s'), (-2, NULL)");
+		QSQL_CHECK(insert != nullptr && insert->type == QAstStatementType::INSERT_STATEMENT);
+		if (insert != nullptr)
+		{
+			QSQL_CHECK(equalsIgnoreCase(insert->columns->next->name, "b"));
+			const QAstExpression* text = insert->rows->values->next;
+			QSQL_CHECK(text->type == QAstExpressionType::LITERAL && text->literal.string.length == 4);
+			QSQL_CHECK(qtl::string(text->literal.string.text, text->literal.string.length) == qtl::string("it's"));
+			QSQL_CHECK(insert->rows->next != nullptr && insert->rows->next->values->next->literal.isNull);
+		}
+
+		const QAstStatement* update = parse(parser, "UPDATE t SET a = a * 2, b = 'x' WHERE a IN (1, 2, 3)");
+		QSQL_CHECK(update != nullptr && update->type == QAstStatementType::UPDATE_STATEMENT);
+		if (update != nullptr)
+		{
+			QSQL_CHECK(update->assignments->next != nullptr && update->assignments->next->next == nullptr);
+			QSQL_CHECK(update->where->type == QAstExpressionType::IN_LIST);
+		}
+
+		const QAstStatement* erase = parse(parser, "DELETE FROM t WHERE b IS NOT NULL");
+		QSQL_CHECK(erase != nullptr && erase->type == QAstStatementType::DELETE_STATEMENT);
+		if (erase != nullptr)
+		{
+			QSQL_CHECK(erase->where->type == QAstExpressionType::IS_NULL && erase->where->negated);
+		}
+	}
+
+	QSQL_TEST(parserReportsErrors)
+	{
+		QArena arena;
+		QParser parser(arena);
+		QSQL_CHECK(parse(parser, "SELECT FROM t") == nullptr);
+		QSQL_CHECK(parser.getError()[0] != '\0');
+		QSQL_CHECK(parse(parser, "SELECT a FROM t WHERE") == nullptr);
+		QSQL_CHECK(parser.getErrorPosition() > 0);
+		QSQL_CHECK(parse(parser, "DROP TABLE t") == nullptr);
+		QSQL_CHECK(parse(parser, "SELECT a FROM t extra garbage") == nullptr);
+	}
+
+	// expressions deeper than MAX_DEPTH are an error instead of exhausting the
+	// stack, whether nested or chained
+	QSQL_TEST(parserLimitsDepth)
+	{
+		QArena arena;
+		QParser parser(arena);
+		const char* prefixes[] = { "(", "NOT ", "- ", "+", "" };
+		for (const char* prefix : prefixes)
+		{
+			for (const std::size_t depth : { QParser::MAX_DEPTH - 1, static_cast<std::size_t>(100000) })
+			{
+				qtl::string text("SELECT a FROM t WHERE ");
+				for (std::size_t i = 0; i < depth; i++)
+				{
+					text += prefix;
+				}
+				text += "a";
+				for (std::size_t i = 0; i < depth; i++)
+				{
+					text += prefix[0] == '(' ? ")" : prefix[0] == '\0' ? " OR a" : "";
+				}
+				const QAstStatement* statement = parser.parse(text);
+				QSQL_CHECK((statement != nullptr) == (depth < QParser::MAX_DEPTH));
+				QSQL_CHECK(statement != nullptr || strstr(parser.getError(), "nested too deeply") != nullptr);
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	QSQL_TEST(schemaPacksColumnsByAlignment)
+	{
+		QSchema schema;
+		const std::size_t flag = schema.addColumn("flag", QDataType::BOOL);
+		const std::size_t id = schema.addColumn("id", QDataType::LONG);
+		const std::size_t count = schema.addColumn("count", QDataType::INT, true);
+		const std::size_t grade = schema.addColumn("grade", QDataType::CHAR);
+		QSQL_CHECK(schema.getColumnCount() == 4);
+		QSQL_CHECK(schema.findColumn("count") == count);
+		QSQL_CHECK(schema.findColumn("missing") == QSchema::npos);
+		QSQL_CHECK(schema.hasNullable());
+
+		// the null bitmap comes first, then the widest values
+		QSQL_CHECK(schema.getColumnOffset(id) == 8);
+		QSQL_CHECK(schema.getColumnOffset(count) == 16);
+		QSQL_CHECK(schema.getColumnOffset(flag) >= 20 && schema.getColumnOffset(grade) >= 20);
+		QSQL_CHECK(schema.getColumnOffset(flag) != schema.getColumnOffset(grade));
+		QSQL_CHECK(schema.getRowAlignment() == 8);
+		QSQL_CHECK(schema.getRowSize() == 24);
+	}
+
+	QSQL_TEST(schemaWithoutNullsHasNoBitmap)
+	{
+		QSchema schema;
+		schema.addColumn("a", QDataType::INT);
+		schema.addColumn("b", QDataType::CHAR);
+		QSQL_CHECK(!schema.hasNullable());
+		QSQL_CHECK(schema.getColumnOffset(0) == 0);
+		QSQL_CHECK(schema.getColumnOffset(1) == 4);
+		QSQL_CHECK(schema.getRowAlignment() == 4);
+		QSQL_CHECK(schema.getRowSize() == 8);
+	}
+}
@@ -0,0 +1,169 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t COUNT = 10000;
+
+		// Decodes the segment in uneven ranges, which cross checkpoints and runs,
+		// and compares every value and get() with the originals
+		bool decodes(const QSegment& segment, const int64_t* values)
+		{
+			bool matching = segment.size() == COUNT;
+			int64_t decoded[COUNT];
+			for (std::size_t first = 0; first < COUNT; first += 777)
+			{
+				const std::size_t count = COUNT - first < 777 ? COUNT - first : 777;
+				segment.decode(first, count, decoded + first);
+			}
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				matching = matching && decoded[i] == values[i] && segment.get(i) == values[i];
+			}
+			return matching;
+		}
+
+		// Matches a range against the segment and counts the rows directly
+		bool selects(const QSegment& segment, const int64_t* values, const int64_t low, const int64_t high)
+		{
+			uint64_t bits[COUNT / 64 + 1] = {};
+			const std::size_t count = segment.select(low, high, bits);
+			std::size_t expected = 0;
+			bool matching = true;
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				const bool inside = values[i] >= low && values[i] <= high;
+				expected += inside;
+				matching = matching && inside == static_cast<bool>((bits[i >> 6] >> (i & 63)) & 1);
+			}
+			return matching && count == expected;
+		}
+	}
+
+	QSQL_TEST(segmentPicksEncodings)
+	{
+		static int64_t values[COUNT];
+
+		// a narrow range of values is packed by its offsets
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			values[i] = 1000000 + static_cast<int64_t>((i * 7919) % 200);
+		}
+		QSegment* segment = QSegment::encode(QDataType::LONG, values, nullptr, COUNT);
+		QSQL_CHECK(segment && segment->getEncoding() == QSegmentEncoding::FRAME_OF_REFERENCE);
+		QSQL_CHECK(segment && segment->getBytes() < COUNT * sizeof(int64_t) / 4);
+		QSQL_CHECK(segment && decodes(*segment, values));
+		QSQL_CHECK(segment && selects(*segment, values, 1000050, 1000099) && selects(*segment, values, 0, 10));
+		delete segment;
+
+		// steadily growing values by their differences
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			values[i] = -5000000000 + static_cast<int64_t>(i) * 1000 + static_cast<int64_t>(i % 3);
+		}
+		segment = QSegment::encode(QDataType::LONG, values, nullptr, COUNT);
+		QSQL_CHECK(segment && segment->getEncoding() == QSegmentEncoding::DELTA);
+		QSQL_CHECK(segment && decodes(*segment, values));
+		QSQL_CHECK(segment && selects(*segment, values, values[300], values[5000]));
+		delete segment;
+
+		// long runs of equal values by their runs
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			values[i] = static_cast<int64_t>(i / 500) * 3 - 20;
+		}
+		segment = QSegment::encode(QDataType::LONG, values, nullptr, COUNT);
+		QSQL_CHECK(segment && segment->getEncoding() == QSegmentEncoding::RUN_LENGTH);
+		QSQL_CHECK(segment && decodes(*segment, values));
+		QSQL_CHECK(segment && selects(*segment, values, -14, 1) && selects(*segment, values, 100, 200));
+		delete segment;
+
+		// values spread over the whole range are left alone
+		uint64_t state = 88172645463325252ull;
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			values[i] = static_cast<int64_t>(state);
+		}
+		QSQL_CHECK(QSegment::encode(QDataType::LONG, values, nullptr, COUNT) == nullptr);
+	}
+
+	// NULL rows take the value before them and do not widen the range
+	QSQL_TEST(segmentSkipsNulls)
+	{
+		int32_t values[COUNT];
+		uint64_t nulls[COUNT / 64 + 1] = {};
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			const bool null = i % 9 == 0;
+			values[i] = null ? INT32_MIN : static_cast<int32_t>(i % 16);
+			nulls[i >> 6] |= static_cast<uint64_t>(null) << (i & 63);
+		}
+		QSegment* segment = QSegment::encode(QDataType::INT, values, nulls, COUNT);
+		QSQL_CHECK(segment && segment->getType() == QDataType::INT && segment->getBytes() <= COUNT / 2 + sizeof(uint64_t));
+		if (segment)
+		{
+			int32_t decoded[COUNT];
+			segment->decode(0, COUNT, decoded);
+			bool matching = true;
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				matching = matching && (i % 9 == 0 || (decoded[i] == values[i] && segment->get(i) == values[i]));
+			}
+			QSQL_CHECK(matching);
+		}
+		delete segment;
+	}
+
+	// committed full chunks of a COMPRESSED column read the same as before
+	QSQL_TEST(segmentCompressesTables)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("ts", QDataType::LONG, false, QEncoding::COMPRESSED);
+		schema.addColumn("v", QDataType::INT, true, QEncoding::COMPRESSED);
+		QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+		const int64_t rows = static_cast<int64_t>(QColumn::CHUNK_SIZE) * 3 + 100;
+		int64_t sum = 0;
+		std::size_t equal = 0;
+		table->beginWrite();
+		for (int64_t i = 0; i < rows; i++)
+		{
+			qtl::vector<QValue> values;
+			values.push_back(QValue(1600000000000 + i * 10));
+			values.push_back(i % 5 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 100)));
+			sum += i % 5 == 0 ? 0 : i % 100;
+			equal += i % 100 == 42;
+			table->insert(values);
+		}
+		table->commit();
+
+		const QColumn& column = table->getColumn(0);
+		QSQL_CHECK(column.isCompressed(0) && column.isCompressed(2) && !column.isCompressed(3));
+		QSQL_CHECK(table->getColumn(1).isCompressed(1));
+
+		bool matching = true;
+		for (int64_t i = 0; i < rows; i += 97)
+		{
+			QField ts = table->getRow(i).get(0);
+			QField v = table->getRow(i).get(1);
+			matching = matching && ts.get<int64_t>() == 1600000000000 + i * 10 && v.isNull() == (i % 5 == 0);
+			matching = matching && (v.isNull() || v.get<int32_t>() == i % 100);
+		}
+		QSQL_CHECK(matching);
+
+		qtl::vector<uint64_t> bitmap;
+		QSQL_CHECK(table->filterBetween(0, QValue(static_cast<int64_t>(1600000000000 + 1000)), QValue(static_cast<int64_t>(1600000000000 + 400000)), bitmap) == 39901);
+		QSQL_CHECK(table->filter(1, QComparison::EQUAL, QValue(static_cast<int32_t>(42)), bitmap) == equal);
+
+		QStatement statement = database.prepare("SELECT SUM(v) FROM t WHERE ts >= 1600000000000");
+		QSQL_CHECK(statement.execute());
+		QBatch* batch = statement.next();
+		QSQL_CHECK(batch && batch->getColumn(0).getValue(0).getLong() == sum);
+	}
+}
@@ -0,0 +1,155 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <climits>
+#include <cstdlib>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t COUNT = 1000;
+		constexpr std::size_t WORDS = (COUNT + 63) / 64;
+
+		template<typename T>
+		bool compare(const QComparison op, const T value, const T constant)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				return value == constant;
+			case QComparison::NOT_EQUAL:
+				return value != constant;
+			case QComparison::LESS:
+				return value < constant;
+			case QComparison::LESS_EQUAL:
+				return value <= constant;
+			case QComparison::GREATER:
+				return value > constant;
+			default:
+				return value >= constant;
+			}
+		}
+
+		// True if bitmap holds exactly the bits of expected, unused bits clear
+		bool equals(const uint64_t* bitmap, const bool* expected)
+		{
+			for (std::size_t i = 0; i < WORDS * 64; i++)
+			{
+				const bool bit = (bitmap[i >> 6] >> (i & 63)) & 1;
+				if (bit != (i < COUNT && expected[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	// every level the processor has matches a plain loop, including at the
+	// extremes of each type where emulated 64-bit compares could go wrong
+	QSQL_TEST(simdKernelsMatchAtEveryLevel)
+	{
+		int32_t ints[COUNT];
+		int64_t longs[COUNT];
+		bool bools[COUNT];
+		srand(3);
+		for (std::size_t i = 0; i < COUNT; i++)
+		{
+			ints[i] = i % 97 == 0 ? (i % 2 ? INT_MIN : INT_MAX) : rand() % 21 - 10;
+			longs[i] = i % 89 == 0 ? (i % 2 ? LLONG_MIN : LLONG_MAX) : static_cast<int64_t>(rand() % 21 - 10) * (i % 3 ? 1 : 0x100000001ll);
+			bools[i] = rand() % 2 == 0;
+		}
+		const int32_t intList[3] = { -3, 0, 7 };
+		const int64_t longList[3] = { -3, 0x100000001ll * 7, 7 };
+
+		const QSimdLevel detected = getSimdLevel();
+		const QSimdLevel levels[3] = { QSimdLevel::SCALAR, QSimdLevel::SSE2, QSimdLevel::AVX2 };
+		for (int level = 0; level < 3 && levels[level] <= detected; level++)
+		{
+			setSimdLevel(levels[level]);
+			QSQL_CHECK(getSimdLevel() == levels[level]);
+
+			uint64_t bitmap[WORDS];
+			bool expected[COUNT];
+			bool matches = true;
+			for (int op = 0; op < 6; op++)
+			{
+				const QComparison comparison = static_cast<QComparison>(op);
+				const int64_t constants[3] = { -3, 0, 5 * 0x100000001ll };
+				for (const int64_t constant : constants)
+				{
+					filterCompare(comparison, ints, COUNT, static_cast<int32_t>(constant), bitmap);
+					for (std::size_t i = 0; i < COUNT; i++)
+					{
+						expected[i] = compare(comparison, ints[i], static_cast<int32_t>(constant));
+					}
+					matches = matches && equals(bitmap, expected);
+
+					filterCompare(comparison, longs, COUNT, constant, bitmap);
+					for (std::size_t i = 0; i < COUNT; i++)
+					{
+						expected[i] = compare(comparison, longs[i], constant);
+					}
+					matches = matches && equals(bitmap, expected);
+				}
+			}
+			QSQL_CHECK(matches);
+
+			filterBetween(ints, COUNT, -2, 4, bitmap);
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				expected[i] = ints[i] >= -2 && ints[i] <= 4;
+			}
+			QSQL_CHECK(equals(bitmap, expected));
+
+			filterBetween(longs, COUNT, -0x300000003ll, 4, bitmap);
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				expected[i] = longs[i] >= -0x300000003ll && longs[i] <= 4;
+			}
+			QSQL_CHECK(equals(bitmap, expected));
+
+			filterIn(ints, COUNT, intList, 3, bitmap);
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				expected[i] = ints[i] == intList[0] || ints[i] == intList[1] || ints[i] == intList[2];
+			}
+			QSQL_CHECK(equals(bitmap, expected));
+
+			filterIn(longs, COUNT, longList, 3, bitmap);
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				expected[i] = longs[i] == longList[0] || longs[i] == longList[1] || longs[i] == longList[2];
+			}
+			QSQL_CHECK(equals(bitmap, expected));
+
+			filterBool(bools, COUNT, false, bitmap);
+			for (std::size_t i = 0; i < COUNT; i++)
+			{
+				expected[i] = !bools[i];
+			}
+			QSQL_CHECK(equals(bitmap, expected));
+		}
+		setSimdLevel(detected);
+	}
+
+	QSQL_TEST(simdBitmapHelpers)
+	{
+		uint64_t left[2] = { 0xF0F0ull, 1ull << 63 };
+		const uint64_t right[2] = { 0xFF00ull, 1ull << 63 };
+		QSQL_CHECK(bitmapCount(left, 2) == 9);
+		bitmapAnd(left, right, 2);
+		QSQL_CHECK(left[0] == 0xF000ull && left[1] == 1ull << 63);
+		bitmapOr(left, right, 2);
+		QSQL_CHECK(left[0] == 0xFF00ull);
+		bitmapAndNot(left, right, 2);
+		QSQL_CHECK(left[0] == 0 && left[1] == 0);
+
+		const uint64_t bits[2] = { 0x5ull, 1ull };
+		uint16_t selection[4];
+		QSQL_CHECK(bitmapToSelection(bits, 65, selection) == 3);
+		QSQL_CHECK(selection[0] == 0 && selection[1] == 2 && selection[2] == 64);
+	}
+}
@@ -0,0 +1,70 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	QSQL_TEST(statementRebindsParameters)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("id", QDataType::LONG);
+		schema.addColumn("name", QDataType::STRING);
+		database.createTable("people", schema, QTableLayout::COLUMN);
+
+		QStatement insert = database.prepare("INSERT INTO people VALUES (?, ?)");
+		QSQL_CHECK(insert.isValid() && insert.getParameterCount() == 2);
+		QSQL_CHECK(insert.getParameterType(0) == QDataType::LONG);
+		for (int64_t id = 0; id < 100; id++)
+		{
+			insert.setLong(0, id);
+			insert.setString(1, id % 2 ? "odd" : "even");
+			QSQL_CHECK(insert.execute() && insert.getAffectedRows() == 1);
+		}
+
+		QStatement select = database.prepare("SELECT id FROM people WHERE id < ? AND name = ?");
+		QSQL_CHECK(select.getColumnCount() == 1 && select.getColumnType(0) == QDataType::LONG);
+		select.setLong(0, 10);
+		select.setString(1, "odd");
+		QSQL_CHECK(test::countRows(select) == 5);
+
+		// a parameter keeps its value until it is set again
+		select.setLong(0, 50);
+		QSQL_CHECK(test::countRows(select) == 25);
+
+		// an unbound parameter fails the execution
+		select.clearParameters();
+		QSQL_CHECK(!select.execute());
+
+		// a value of the wrong type is refused
+		QSQL_CHECK(!select.setString(0, "ten"));
+		QSQL_CHECK(!select.setLong(7, 1));
+	}
+
+	QSQL_TEST(statementPlansAreCached)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("a", QDataType::INT);
+		database.createTable("t", schema);
+		QPlanCache& cache = database.getPlanCache();
+		{
+			QStatement first = database.prepare("SELECT a FROM t WHERE a = 1");
+			QSQL_CHECK(first.isValid());
+		}
+		const std::size_t hits = cache.getHits();
+		{
+			// only whitespace and keyword case differ
+			QStatement second = database.prepare("select  a  from t where a = 1");
+			QSQL_CHECK(second.isValid());
+		}
+		QSQL_CHECK(cache.getHits() == hits + 1);
+		QSQL_CHECK(QPlanCache::normalize("select  a\nFROM t") == QPlanCache::normalize("SELECT a FROM t"));
+
+		// dropping a table invalidates the plans built against it
+		QSQL_CHECK(database.dropTable("t"));
+		QStatement stale = database.prepare("SELECT a FROM t WHERE a = 1");
+		QSQL_CHECK(!stale.isValid());
+		QSQL_CHECK(cache.getHits() == hits + 1);
+	}
+}
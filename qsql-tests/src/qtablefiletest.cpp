@@ -0,0 +1,159 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	namespace
+	{
+		const char* const TABLE_PATH = "qsql-tests-table.qtf";
+
+		// Enough rows for a partial last chunk after full ones
+		constexpr std::size_t ROWS = QColumn::CHUNK_SIZE * 2 + 123;
+
+		QTable* createTable(const QTableLayout layout)
+		{
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			schema.addColumn("score", QDataType::INT, true);
+			schema.addColumn("flag", QDataType::BOOL);
+			schema.addColumn("name", QDataType::STRING, true);
+			QTable* table = new QTable(schema, layout);
+			char name[16];
+			for (std::size_t i = 0; i < ROWS; i++)
+			{
+				snprintf(name, sizeof(name), "name%d", static_cast<int>(i % 37));
+				qtl::vector<QValue> values;
+				values.push_back(QValue(static_cast<int64_t>(i) * 7));
+				values.push_back(i % 11 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 1000)));
+				values.push_back(QValue(i % 3 == 0));
+				values.push_back(i % 13 == 0 ? QValue() : QValue(name));
+				table->insert(values);
+			}
+			return table;
+		}
+
+		bool sameRows(const QTable& left, const QTable& right, const std::size_t rows)
+		{
+			for (std::size_t i = 0; i < rows; i++)
+			{
+				const QRow a = left.getRow(i);
+				const QRow b = right.getRow(i);
+				if (a.get(0).get<int64_t>() != b.get(0).get<int64_t>() || a.get(1).isNull() != b.get(1).isNull()
+					|| (!a.get(1).isNull() && a.get(1).get<int32_t>() != b.get(1).get<int32_t>())
+					|| a.get(2).get<bool>() != b.get(2).get<bool>() || a.get(3).isNull() != b.get(3).isNull()
+					|| (!a.get(3).isNull() && a.get(3).get<qtl::string>() != b.get(3).get<qtl::string>()))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		qtl::vector<char> readFile(const char* path)
+		{
+			qtl::vector<char> data;
+			FILE* file = fopen(path, "rb");
+			if (file != nullptr)
+			{
+				fseek(file, 0, SEEK_END);
+				data.resize(static_cast<std::size_t>(ftell(file)));
+				fseek(file, 0, SEEK_SET);
+				if (data.size() > 0 && fread(&data[0], 1, data.size(), file) != data.size())
+				{
+					data.clear();
+				}
+				fclose(file);
+			}
+			return data;
+		}
+	}
+
+	QSQL_TEST(tableFileRoundTrips)
+	{
+		for (int layout = 0; layout < 2; layout++)
+		{
+			QTable* source = createTable(layout ? QTableLayout::COLUMN : QTableLayout::ROW);
+			QTableFile file;
+			QSQL_CHECK(file.save(*source, TABLE_PATH));
+
+			QTable* opened = file.open(TABLE_PATH);
+			QSQL_CHECK(opened != nullptr);
+			if (opened != nullptr)
+			{
+				QSQL_CHECK(opened->isMapped() && opened->getLayout() == QTableLayout::COLUMN);
+				QSQL_CHECK(opened->getRowCount() == ROWS);
+				QSQL_CHECK(opened->getSchema().getColumnName(3) == qtl::string("name"));
+				QSQL_CHECK(sameRows(*source, *opened, ROWS));
+				delete opened;
+			}
+			delete source;
+		}
+		remove(TABLE_PATH);
+	}
+
+	// changes to a mapped table stay in memory
+	QSQL_TEST(tableFileIsNotModified)
+	{
+		QTable* source = createTable(QTableLayout::COLUMN);
+		QTableFile file;
+		QSQL_CHECK(file.save(*source, TABLE_PATH));
+		const qtl::vector<char> saved = readFile(TABLE_PATH);
+
+		QTable* opened = file.open(TABLE_PATH);
+		QSQL_CHECK(opened != nullptr);
+		if (opened != nullptr)
+		{
+			qtl::vector<QValue> values;
+			values.push_back(QValue(static_cast<int64_t>(-1)));
+			values.push_back(QValue());
+			values.push_back(QValue(true));
+			values.push_back(QValue("appended"));
+			QSQL_CHECK(opened->insert(values) == ROWS);
+			const std::size_t updated = opened->update(5, 1, QValue(static_cast<int32_t>(-5)));
+			QSQL_CHECK(updated < opened->getRowCount() && opened->getRow(updated).get(1).get<int32_t>() == -5);
+			QSQL_CHECK(opened->getRow(ROWS).get(3).get<qtl::string>() == qtl::string("appended"));
+			delete opened;
+		}
+		delete source;
+		QSQL_CHECK(readFile(TABLE_PATH) == saved);
+		remove(TABLE_PATH);
+	}
+
+	QSQL_TEST(tableFileRejectsOtherFiles)
+	{
+		FILE* other = fopen(TABLE_PATH, "wb");
+		fputs("not a table file", other);
+		fclose(other);
+		QTableFile file;
+		QSQL_CHECK(file.open(TABLE_PATH) == nullptr);
+		QSQL_CHECK(file.getError()[0] != '\0');
+		remove(TABLE_PATH);
+		QSQL_CHECK(file.open(TABLE_PATH) == nullptr);
+	}
+
+	// a row count the file cannot hold is rejected before it sizes anything
+	QSQL_TEST(tableFileRejectsCorruptRowCounts)
+	{
+		QTable* source = createTable(QTableLayout::COLUMN);
+		QTableFile file;
+		QSQL_CHECK(file.save(*source, TABLE_PATH));
+		delete source;
+
+		// the row count follows the magic and the version
+		const uint64_t counts[] = { UINT64_MAX, UINT64_MAX - QColumn::CHUNK_SIZE + 2, static_cast<uint64_t>(readFile(TABLE_PATH).size()) };
+		for (const uint64_t count : counts)
+		{
+			FILE* corrupt = fopen(TABLE_PATH, "r+b");
+			fseek(corrupt, 8, SEEK_SET);
+			fwrite(&count, sizeof(count), 1, corrupt);
+			fclose(corrupt);
+			QSQL_CHECK(file.open(TABLE_PATH) == nullptr && file.getError()[0] != '\0');
+			QBufferPool pool(8);
+			QSQL_CHECK(file.open(TABLE_PATH, pool) == nullptr);
+		}
+		remove(TABLE_PATH);
+	}
+}
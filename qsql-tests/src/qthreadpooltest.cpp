@@ -0,0 +1,72 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <atomic>
+
+#include <qtl/thread/thread_pool.h>
+
+namespace qsql
+{
+	QSQL_TEST(threadPoolRunsSubmittedTasks)
+	{
+		qtl::thread_pool pool(4);
+		QSQL_CHECK(pool.size() == 4);
+
+		qtl::vector<qtl::future<int64_t>> results;
+		for (int64_t i = 0; i < 1000; i++)
+		{
+			results.push_back(pool.submit([i]() { return i * i; }));
+		}
+		int64_t sum = 0;
+		for (std::size_t i = 0; i < results.size(); i++)
+		{
+			sum += results[i].get();
+		}
+		QSQL_CHECK(sum == 332833500);
+
+		std::atomic<int> calls(0);
+		pool.submit([&calls]() { calls++; }).get();
+		QSQL_CHECK(calls == 1);
+	}
+
+	// tasks submitted by workers go to their own deques and are stolen by idle
+	// workers, the destructor runs every task before joining
+	QSQL_TEST(threadPoolRunsNestedTasks)
+	{
+		std::atomic<int> leaves(0);
+		{
+			qtl::thread_pool pool(4);
+			for (int i = 0; i < 8; i++)
+			{
+				pool.submit([&pool, &leaves]()
+				{
+					for (int j = 0; j < 500; j++)
+					{
+						pool.submit([&leaves]() { leaves++; });
+					}
+				});
+			}
+		}
+		QSQL_CHECK(leaves == 8 * 500);
+	}
+
+	QSQL_TEST(threadPoolWithOneWorker)
+	{
+		qtl::thread_pool pool(1);
+		std::atomic<int> order(0);
+		bool sequential = true;
+		qtl::vector<qtl::future<int>> results;
+		for (int i = 0; i < 100; i++)
+		{
+			results.push_back(pool.submit([&order, i]() { return order++ == i ? 1 : 0; }));
+		}
+		for (std::size_t i = 0; i < results.size(); i++)
+		{
+			sequential = results[i].get() == 1 && sequential;
+		}
+
+		// tasks from outside the pool run oldest first
+		QSQL_CHECK(sequential);
+	}
+}
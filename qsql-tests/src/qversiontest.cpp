@@ -0,0 +1,111 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	namespace
+	{
+		std::size_t countVisible(const QTable& table, const uint64_t snapshot)
+		{
+			std::size_t count = 0;
+			for (std::size_t row = 0; row < table.getRowCount(); row++)
+			{
+				count += table.isVisible(row, snapshot);
+			}
+			return count;
+		}
+
+		int64_t sumVisible(const QTable& table, const uint64_t snapshot)
+		{
+			int64_t sum = 0;
+			for (std::size_t row = 0; row < table.getRowCount(); row++)
+			{
+				sum += table.isVisible(row, snapshot) ? table.getRow(row).get(0).get<int64_t>() : 0;
+			}
+			return sum;
+		}
+	}
+
+	// a snapshot keeps seeing the rows as they were when it was taken
+	QSQL_TEST(versionSnapshotsAreIsolated)
+	{
+		QSchema schema;
+		schema.addColumn("v", QDataType::LONG);
+		QTable table(schema, QTableLayout::COLUMN);
+		for (int64_t i = 1; i <= 10; i++)
+		{
+			qtl::vector<QValue> values;
+			values.push_back(QValue(i));
+			table.insert(values);
+		}
+		QVersionClock& clock = table.getClock();
+		const uint64_t before = clock.acquire();
+
+		table.beginWrite();
+		const std::size_t updated = table.update(0, 0, QValue(static_cast<int64_t>(100)));
+		QSQL_CHECK(updated == 10);
+		QSQL_CHECK(table.erase(1));
+		qtl::vector<QValue> values;
+		values.push_back(QValue(static_cast<int64_t>(1000)));
+		table.insert(values);
+
+		// nothing is visible before the commit, to old or new snapshots
+		const uint64_t during = clock.acquire();
+		QSQL_CHECK(sumVisible(table, during) == 55);
+		clock.release(during);
+		table.commit();
+
+		const uint64_t after = clock.acquire();
+		QSQL_CHECK(countVisible(table, before) == 10 && sumVisible(table, before) == 55);
+		QSQL_CHECK(countVisible(table, after) == 10 && sumVisible(table, after) == 55 - 1 - 2 + 100 + 1000);
+		QSQL_CHECK(!table.isVisible(0, after) && table.isVisible(updated, after));
+		QSQL_CHECK(table.isErased(1));
+
+		// collecting keeps what the old snapshot still sees
+		table.collect();
+		QSQL_CHECK(sumVisible(table, before) == 55);
+		clock.release(before);
+		clock.release(after);
+		table.collect();
+		QSQL_CHECK(sumVisible(table, clock.now()) == 55 - 1 - 2 + 100 + 1000);
+		QSQL_CHECK(clock.getHorizon() == clock.now());
+	}
+
+	// a statement reads one snapshot while another statement writes
+	QSQL_TEST(versionStatementsReadSnapshots)
+	{
+		QDatabase database;
+		QSchema schema;
+		schema.addColumn("v", QDataType::LONG);
+		QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+		for (int64_t i = 0; i < 3000; i++)
+		{
+			qtl::vector<QValue> values;
+			values.push_back(QValue(i));
+			table->insert(values);
+		}
+
+		QStatement select = database.prepare("SELECT v FROM t");
+		QSQL_CHECK(select.execute());
+		QBatch* batch = select.next();
+		std::size_t count = batch ? batch->getActiveCount() : 0;
+
+		// the change commits while the select still has rows to produce
+		QStatement erase = database.prepare("DELETE FROM t WHERE v >= 1000");
+		QSQL_CHECK(erase.execute() && erase.getAffectedRows() == 2000);
+		while ((batch = select.next()) != nullptr)
+		{
+			count += batch->getActiveCount();
+		}
+		QSQL_CHECK(count == 3000);
+
+		QSQL_CHECK(select.execute());
+		count = 0;
+		while ((batch = select.next()) != nullptr)
+		{
+			count += batch->getActiveCount();
+		}
+		QSQL_CHECK(count == 1000);
+	}
+}
@@ -0,0 +1,275 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+#include <cstdio>
+
+#include <qtl/thread/thread.h>
+
+namespace qsql
+{
+	namespace
+	{
+		const char* const LOG_PATH = "qsql-tests-wal.log";
+
+		bool execute(QDatabase& database, const char* text)
+		{
+			QStatement statement = database.prepare(text);
+			return statement.isValid() && statement.execute();
+		}
+
+		int64_t sum(QDatabase& database, const char* text)
+		{
+			QStatement statement = database.prepare(text);
+			int64_t total = 0;
+			if (statement.isValid() && statement.execute())
+			{
+				while (QBatch* batch = statement.next())
+				{
+					for (std::size_t i = 0; i < batch->getActiveCount(); i++)
+					{
+						total += batch->getColumn(0).getValue(batch->hasSelection() ? batch->getSelection()[i] : i).getLong();
+					}
+				}
+			}
+			return total;
+		}
+
+		std::size_t getFileSize(const char* path)
+		{
+			FILE* file = fopen(path, "rb");
+			if (file == nullptr)
+			{
+				return 0;
+			}
+			fseek(file, 0, SEEK_END);
+			const long size = ftell(file);
+			fclose(file);
+			return static_cast<std::size_t>(size);
+		}
+
+		// Cuts the file to size bytes, as a crash in the middle of a write would
+		void truncate(const char* path, const std::size_t size)
+		{
+			FILE* file = fopen(path, "rb");
+			qtl::vector<char> data;
+			data.resize(size);
+			const std::size_t read = fread(&data[0], 1, size, file);
+			fclose(file);
+			file = fopen(path, "wb");
+			fwrite(&data[0], 1, read, file);
+			fclose(file);
+		}
+
+		void flipByte(const char* path, const std::size_t offset)
+		{
+			FILE* file = fopen(path, "r+b");
+			fseek(file, static_cast<long>(offset), SEEK_SET);
+			const int byte = fgetc(file);
+			fseek(file, static_cast<long>(offset), SEEK_SET);
+			fputc(byte ^ 0x5A, file);
+			fclose(file);
+		}
+
+		// Writes a table, then a change whose frame ends at the returned offset
+		std::size_t writeLog(std::size_t& committed)
+		{
+			QWal log;
+			QDatabase database;
+			log.open(LOG_PATH);
+			database.setLog(&log);
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			schema.addColumn("name", QDataType::STRING, true);
+			database.createTable("t", schema, QTableLayout::COLUMN);
+			for (int i = 0; i < 100; i++)
+			{
+				QStatement insert = database.prepare("INSERT INTO t VALUES (?, ?)");
+				insert.setLong(0, i);
+				insert.setString(1, i % 2 ? "odd" : "even");
+				insert.execute();
+			}
+			execute(database, "UPDATE t SET id = id + 1000 WHERE id < 10");
+			execute(database, "DELETE FROM t WHERE id BETWEEN 90 AND 99");
+			committed = getFileSize(LOG_PATH);
+			execute(database, "INSERT INTO t VALUES (5000, NULL)");
+			return getFileSize(LOG_PATH);
+		}
+
+		// Replays the log into a fresh database and returns the sum of its ids
+		int64_t replay(bool& replayed)
+		{
+			QWal log;
+			QDatabase database;
+			replayed = log.open(LOG_PATH) && log.replay(database) && database.getTable("t") != nullptr;
+			return replayed ? sum(database, "SELECT id FROM t") : 0;
+		}
+	}
+
+	QSQL_TEST(walReplaysCommittedTransactions)
+	{
+		remove(LOG_PATH);
+		std::size_t committed = 0;
+		writeLog(committed);
+
+		// ids 10 to 89, 1000 to 1009 and 5000
+		int64_t expected = 5000;
+		for (int64_t id = 10; id < 90; id++)
+		{
+			expected += id;
+		}
+		for (int64_t id = 1000; id < 1010; id++)
+		{
+			expected += id;
+		}
+		bool replayed = false;
+		QSQL_CHECK(replay(replayed) == expected);
+		QSQL_CHECK(replayed);
+
+		// a replayed log keeps logging where it ended
+		{
+			QWal log;
+			QDatabase database;
+			QSQL_CHECK(log.open(LOG_PATH) && log.replay(database));
+			database.setLog(&log);
+			QSQL_CHECK(execute(database, "INSERT INTO t VALUES (1, 'again')"));
+		}
+		QSQL_CHECK(replay(replayed) == expected + 1);
+		remove(LOG_PATH);
+	}
+
+	// a transaction torn by a crash or with a bad checksum is dropped whole
+	QSQL_TEST(walDropsTornTransactions)
+	{
+		int64_t expected = 0;
+		for (int64_t id = 10; id < 90; id++)
+		{
+			expected += id;
+		}
+		for (int64_t id = 1000; id < 1010; id++)
+		{
+			expected += id;
+		}
+
+		remove(LOG_PATH);
+		std::size_t committed = 0;
+		const std::size_t end = writeLog(committed);
+		truncate(LOG_PATH, end - 3);
+		bool replayed = false;
+		QSQL_CHECK(replay(replayed) == expected);
+		QSQL_CHECK(replayed);
+
+		// opening cut the torn frame, so the log grows from the last good one
+		QSQL_CHECK(getFileSize(LOG_PATH) == committed);
+
+		remove(LOG_PATH);
+		writeLog(committed);
+		flipByte(LOG_PATH, committed + QWal::FRAME_HEADER_SIZE + 2);
+		QSQL_CHECK(replay(replayed) == expected);
+		QSQL_CHECK(replayed);
+
+		// a truncated header is not a log
+		truncate(LOG_PATH, QWal::HEADER_SIZE / 2);
+		QWal log;
+		QSQL_CHECK(!log.open(LOG_PATH));
+		remove(LOG_PATH);
+	}
+
+	// a frame that matches its checksum but cannot be applied leaves none of
+	// its changes behind, and replaying stops there
+	QSQL_TEST(walDropsFramesThatCannotBeApplied)
+	{
+		remove(LOG_PATH);
+		{
+			QWal log;
+			QSQL_CHECK(log.open(LOG_PATH));
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			QWalTransaction transaction;
+			transaction.createTable("t", schema, QTableLayout::COLUMN);
+			for (int64_t id = 0; id < 10; id++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(id));
+				transaction.insert("t", values);
+			}
+			QSQL_CHECK(log.commit(transaction));
+
+			// writes, creates and drops a table, then inserts a row of the wrong width
+			transaction.clear();
+			qtl::vector<QValue> values;
+			values.push_back(QValue(static_cast<int64_t>(100)));
+			transaction.insert("t", values);
+			transaction.update("t", 0, 0, QValue(static_cast<int64_t>(1000)));
+			transaction.erase("t", 1);
+			transaction.createTable("u", schema, QTableLayout::ROW);
+			transaction.insert("u", values);
+			transaction.dropTable("t");
+			values.push_back(QValue(static_cast<int64_t>(200)));
+			transaction.insert("u", values);
+			QSQL_CHECK(log.commit(transaction));
+		}
+
+		QWal log;
+		QDatabase database;
+		QSQL_CHECK(log.open(LOG_PATH) && !log.replay(database));
+		QSQL_CHECK(log.getError()[0] != '\0');
+		QSQL_CHECK(database.getTable("t") != nullptr && database.getTable("u") == nullptr);
+		QSQL_CHECK(sum(database, "SELECT id FROM t") == 45);
+		QSQL_CHECK(execute(database, "UPDATE t SET id = 5 WHERE id = 0") && sum(database, "SELECT id FROM t") == 50);
+		remove(LOG_PATH);
+	}
+
+	// concurrent committers share fsyncs and every transaction is replayed
+	QSQL_TEST(walGroupsCommits)
+	{
+		remove(LOG_PATH);
+		const std::size_t threads = 4;
+		const std::size_t transactions = 50;
+		{
+			QWal log;
+			QSQL_CHECK(log.open(LOG_PATH));
+			log.setCommitDelay(200);
+			QWalTransaction create;
+			QSchema schema;
+			schema.addColumn("id", QDataType::LONG);
+			create.createTable("t", schema, QTableLayout::ROW);
+			QSQL_CHECK(log.commit(create));
+
+			qtl::thread* workers[threads];
+			bool committed[threads];
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				committed[t] = true;
+				workers[t] = new qtl::thread([&log, &committed, t, transactions]()
+				{
+					for (std::size_t i = 0; i < transactions; i++)
+					{
+						QWalTransaction transaction;
+						qtl::vector<QValue> values;
+						values.push_back(QValue(static_cast<int64_t>(t * transactions + i)));
+						transaction.insert("t", values);
+						committed[t] = log.commit(transaction) && committed[t];
+					}
+				});
+			}
+			for (std::size_t t = 0; t < threads; t++)
+			{
+				workers[t]->join();
+				delete workers[t];
+				QSQL_CHECK(committed[t]);
+			}
+			QSQL_CHECK(log.getCommitCount() == threads * transactions + 1);
+			QSQL_CHECK(log.getSyncCount() <= log.getCommitCount());
+		}
+
+		QWal log;
+		QDatabase database;
+		QSQL_CHECK(log.open(LOG_PATH) && log.replay(database));
+		const QTable* table = database.getTable("t");
+		QSQL_CHECK(table != nullptr && table->getRowCount() == threads * transactions);
+		const int64_t count = static_cast<int64_t>(threads * transactions);
+		QSQL_CHECK(sum(database, "SELECT id FROM t") == count * (count - 1) / 2);
+		remove(LOG_PATH);
+	}
+}
@@ -0,0 +1,145 @@
+#include <qsql/qsql.h>
+
+#include "qtest.h"
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr int64_t PAGE = static_cast<int64_t>(QTable::PAGE_ROWS);
+		constexpr int64_t ROWS = PAGE * 4 + 500;
+
+		// ts is the row index, v is i % 1000 and NULL on every third row
+		QTable* createTable(QDatabase& database)
+		{
+			QSchema schema;
+			schema.addColumn("ts", QDataType::LONG);
+			schema.addColumn("v", QDataType::INT, true);
+			schema.addColumn("s", QDataType::STRING);
+			QTable* table = database.createTable("t", schema, QTableLayout::COLUMN);
+			table->beginWrite();
+			for (int64_t i = 0; i < ROWS; i++)
+			{
+				qtl::vector<QValue> values;
+				values.push_back(QValue(i));
+				values.push_back(i % 3 == 0 ? QValue() : QValue(static_cast<int32_t>(i % 1000)));
+				values.push_back(QValue(i % 2 ? "odd" : "even"));
+				table->insert(values);
+			}
+			table->commit();
+			return table;
+		}
+
+		QExpression* constant(const int64_t value)
+		{
+			return new QConstantExpression(QValue(value));
+		}
+
+		std::size_t drain(QOperator& root)
+		{
+			std::size_t count = 0;
+			while (QBatch* batch = root.next())
+			{
+				count += batch->getActiveCount();
+			}
+			return count;
+		}
+	}
+
+	QSQL_TEST(zoneMapBoundsPages)
+	{
+		QDatabase database;
+		QTable* table = createTable(database);
+		const std::size_t pages = static_cast<std::size_t>((ROWS + PAGE - 1) / PAGE);
+		bool bounded = true;
+		for (std::size_t page = 0; page < pages; page++)
+		{
+			const int64_t first = static_cast<int64_t>(page) * PAGE;
+			const int64_t last = first + PAGE - 1 < ROWS - 1 ? first + PAGE - 1 : ROWS - 1;
+			bounded = bounded && !table->isOutside(page, 0, first, first) && !table->isOutside(page, 0, last, last + 100);
+			bounded = bounded && table->isOutside(page, 0, last + 1, INT64_MAX) && (page == 0 || table->isOutside(page, 0, INT64_MIN, first - 1));
+
+			// NULL rows do not widen the bounds, strings are not bounded
+			bounded = bounded && !table->isOutside(page, 1, -5, 1) && table->isOutside(page, 1, 1000, 5000) && table->isOutside(page, 1, INT64_MIN, -1);
+			bounded = bounded && !table->isOutside(page, 2, 0, 0);
+		}
+		QSQL_CHECK(bounded);
+
+		// the new version of an updated row widens the bounds of its page
+		const int64_t far = 1000000000;
+		QSQL_CHECK(table->isOutside(pages - 1, 0, far, far));
+		table->beginWrite();
+		QSQL_CHECK(table->update(5, 0, QValue(far)) == static_cast<std::size_t>(ROWS));
+		table->commit();
+		QSQL_CHECK(!table->isOutside(pages - 1, 0, far, far));
+
+		QStatement select = database.prepare("SELECT ts FROM t WHERE ts = 1000000000 OR ts = 5");
+		QSQL_CHECK(test::countRows(select) == 1);
+	}
+
+	// a range on its own drops no rows, so the scan produces the rows of the
+	// pages it does not skip
+	QSQL_TEST(zoneMapSkipsScannedPages)
+	{
+		QDatabase database;
+		QTable* table = createTable(database);
+		qtl::vector<std::size_t> columns;
+		columns.push_back(0);
+		columns.push_back(1);
+		const uint64_t snapshot = table->getClock().now();
+
+		QScanOperator inside(*table, columns, snapshot);
+		inside.addRange(0, constant(PAGE * 2 + 10), true, constant(PAGE * 2 + 20), true);
+		QSQL_CHECK(drain(inside) == static_cast<std::size_t>(PAGE));
+
+		// exclusive bounds on either side of a page keep only that page
+		QScanOperator exclusive(*table, columns, snapshot);
+		exclusive.addRange(0, constant(PAGE - 1), false, constant(PAGE * 2), false);
+		QSQL_CHECK(drain(exclusive) == static_cast<std::size_t>(PAGE));
+
+		// open bounds, and bounds on two columns that each rule out pages
+		QScanOperator open(*table, columns, snapshot);
+		open.addRange(0, constant(PAGE * 3), true, nullptr, false);
+		QSQL_CHECK(drain(open) == static_cast<std::size_t>(PAGE + 500));
+		QScanOperator both(*table, columns, snapshot);
+		both.addRange(0, nullptr, false, constant(PAGE * 2), true);
+		both.addRange(1, constant(2000), true, nullptr, false);
+		QSQL_CHECK(drain(both) == 0);
+
+		// a bound that is not an integer constant leaves the range unused
+		QScanOperator unused(*table, columns, snapshot);
+		unused.addRange(0, new QConstantExpression(QValue("x")), true, constant(0), true);
+		QSQL_CHECK(drain(unused) == static_cast<std::size_t>(ROWS));
+
+		// the bounds are read again after a reset
+		inside.reset();
+		QSQL_CHECK(drain(inside) == static_cast<std::size_t>(PAGE));
+	}
+
+	// skipping pages never changes what a query returns
+	QSQL_TEST(zoneMapKeepsResults)
+	{
+		QDatabase database;
+		createTable(database);
+		QStatement select = database.prepare("SELECT ts FROM t WHERE ts BETWEEN ? AND ?");
+		const int64_t ranges[][2] = { { 0, 0 }, { PAGE - 3, PAGE + 3 }, { PAGE * 3 + 7, ROWS + 10 }, { -10, -1 }, { ROWS, ROWS * 2 } };
+		bool matching = true;
+		for (const auto& range : ranges)
+		{
+			select.setLong(0, range[0]);
+			select.setLong(1, range[1]);
+			const int64_t low = range[0] > 0 ? range[0] : 0;
+			const int64_t high = range[1] < ROWS - 1 ? range[1] : ROWS - 1;
+			matching = matching && test::countRows(select) == static_cast<std::size_t>(high >= low ? high - low + 1 : 0);
+		}
+		QSQL_CHECK(matching);
+
+		QStatement values = database.prepare("SELECT ts FROM t WHERE v > 995 AND ts < 20000");
+		std::size_t expected = 0;
+		for (int64_t i = 0; i < 20000; i++)
+		{
+			expected += i % 3 != 0 && i % 1000 > 995;
+		}
+		QSQL_CHECK(test::countRows(values) == expected);
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef qarena_h__
+#define qarena_h__
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <qtl/vector.h>
+
+namespace qsql
+{
+	// Bump allocator handing out memory from large chunks.  Nothing is freed
+	// individually, reset() releases every allocation at once and keeps the first
+	// chunk around for reuse, rewind() does the same but keeps every chunk so
+	// that a workload repeating itself stops allocating.  Objects created in an
+	// arena are never destructed, so they must not own resources of their own.
+	class QArena
+	{
+	public:
+		static constexpr std::size_t CHUNK_SIZE = 4096;
+
+		QArena();
+		explicit QArena(const std::size_t chunkSize);
+		QArena(const QArena&) = delete;
+		~QArena();
+
+		QArena& operator=(const QArena&) = delete;
+
+		void* allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t));
+
+		template<typename T, typename ... Arguments>
+		T* create(Arguments&& ... args);
+
+		// Copies length characters of text into the arena and null terminates them
+		char* copy(const char* text, const std::size_t length);
+
+		void reset();
+		void rewind();
+
+		// Bytes handed out since the last reset
+		std::size_t getUsed() const;
+	private:
+		std::size_t __chunkSize;
+		qtl::vector<char*> __chunks;
+		qtl::vector<std::size_t> __sizes;
+		std::size_t __next;
+		char* __cursor;
+		char* __end;
+		std::size_t __used;
+
+		void* __allocateSlow(const std::size_t size, const std::size_t alignment);
+	};
+
+	inline void* QArena::allocate(const std::size_t size, const std::size_t alignment)
+	{
+		char* aligned = reinterpret_cast<char*>((reinterpret_cast<std::size_t>(__cursor) + alignment - 1) & ~(alignment - 1));
+		if (__cursor == nullptr || aligned + size > __end)
+		{
+			return __allocateSlow(size, alignment);
+		}
+		__used += aligned + size - __cursor;
+		__cursor = aligned + size;
+		return aligned;
+	}
+
+	template<typename T, typename ... Arguments>
+	inline T* QArena::create(Arguments&& ... args)
+	{
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Arguments>(args)...);
+	}
+}
+
+#endif // qarena_h__
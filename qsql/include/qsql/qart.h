@@ -0,0 +1,258 @@
+#ifndef qart_h__
+#define qart_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace qsql
+{
+	// Adaptive radix tree of byte string keys, each paired with a row.  Inner
+	// nodes branch on one byte and grow through four sizes, holding up to 4, 16,
+	// 48 or 256 children, so sparse levels stay small and dense ones are a
+	// direct lookup.  A chain of single child nodes is collapsed into a prefix
+	// of the node below it, of which the first MAX_PREFIX bytes are stored and
+	// the rest are read from a leaf when needed.  Leaves hold the whole key.
+	// No key may be a prefix of another.
+	class QArt
+	{
+	public:
+		static constexpr std::size_t MAX_PREFIX = 8;
+
+		QArt();
+		QArt(const QArt&) = delete;
+		~QArt();
+
+		QArt& operator=(const QArt&) = delete;
+
+		std::size_t size() const;
+		void clear();
+
+		// Replaces the row of a key that is already there
+		void insert(const uint8_t* key, const std::size_t length, const std::size_t row);
+		bool erase(const uint8_t* key, const std::size_t length);
+
+		// Row of key, false if there is none
+		bool find(const uint8_t* key, const std::size_t length, std::size_t& row) const;
+
+		// Calls visitor(key, length, row) for the keys from start on in ascending
+		// order, or from start back in descending order, until it returns false.
+		// start itself is visited if inclusive, a nullptr start visits every key.
+		// Returns false if the visitor stopped the walk.
+		template<typename Visitor>
+		bool visit(const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor) const;
+	private:
+		enum class QType : uint8_t
+		{
+			NODE4,
+			NODE16,
+			NODE48,
+			NODE256,
+		};
+
+		struct QNode
+		{
+			QType type;
+			uint16_t count;
+			uint32_t prefixLength;
+			uint8_t prefix[MAX_PREFIX];
+		};
+
+		// keys are sorted, children[i] is the child of byte keys[i]
+		struct QNode4 : QNode
+		{
+			uint8_t keys[4];
+			QNode* children[4];
+		};
+
+		struct QNode16 : QNode
+		{
+			uint8_t keys[16];
+			QNode* children[16];
+		};
+
+		// slots[byte] is one more than the child's index, 0 if there is none
+		struct QNode48 : QNode
+		{
+			uint8_t slots[256];
+			QNode* children[48];
+		};
+
+		struct QNode256 : QNode
+		{
+			QNode* children[256];
+		};
+
+		// leaves are tagged by the low bit of their pointer
+		struct QLeaf
+		{
+			std::size_t row;
+			std::size_t length;
+			uint8_t key[1];
+		};
+
+		QNode* __root;
+		std::size_t __size;
+
+		static bool __isLeaf(const QNode* node);
+		static QLeaf* __leaf(const QNode* node);
+		static QNode* __tag(QLeaf* leaf);
+		template<typename Node>
+		static Node* __newNode(const QType type);
+		static QLeaf* __newLeaf(const uint8_t* key, const std::size_t length, const std::size_t row);
+		static bool __matches(const QLeaf* leaf, const uint8_t* key, const std::size_t length);
+		static int __compare(const QLeaf* leaf, const uint8_t* key, const std::size_t length);
+		static const QLeaf* __minimum(const QNode* node);
+		static void __free(QNode* node);
+
+		// number of prefix bytes of node that match key from depth on
+		static std::size_t __prefixMismatch(const QNode* node, const uint8_t* key, const std::size_t length, const std::size_t depth);
+
+		static QNode** __findChild(QNode* node, const uint8_t byte);
+		static void __addChild(QNode** reference, const uint8_t byte, QNode* child);
+		static void __removeChild(QNode** reference, const uint8_t byte);
+
+		void __insert(QNode** reference, const uint8_t* key, const std::size_t length, const std::size_t row, const std::size_t depth);
+		bool __erase(QNode** reference, const uint8_t* key, const std::size_t length, const std::size_t depth);
+
+		// bounded walks compare keys with start, unbounded ones visit every key below node
+		template<typename Visitor>
+		static bool __visit(const QNode* node, const std::size_t depth, const bool bounded, const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor);
+		template<typename Visitor>
+		static bool __visitChild(const QNode* child, const uint8_t byte, const std::size_t depth, const bool bounded, const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor);
+	};
+
+	inline bool QArt::__isLeaf(const QNode* node)
+	{
+		return (reinterpret_cast<uintptr_t>(node) & 1) != 0;
+	}
+
+	inline QArt::QLeaf* QArt::__leaf(const QNode* node)
+	{
+		return reinterpret_cast<QLeaf*>(reinterpret_cast<uintptr_t>(node) & ~static_cast<uintptr_t>(1));
+	}
+
+	inline QArt::QNode* QArt::__tag(QLeaf* leaf)
+	{
+		return reinterpret_cast<QNode*>(reinterpret_cast<uintptr_t>(leaf) | 1);
+	}
+
+	template<typename Visitor>
+	inline bool QArt::visit(const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor) const
+	{
+		return __root == nullptr || __visit(__root, 0, start != nullptr, start, startLength, inclusive, descending, visitor);
+	}
+
+	template<typename Visitor>
+	bool QArt::__visit(const QNode* node, std::size_t depth, bool bounded, const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor)
+	{
+		if (__isLeaf(node))
+		{
+			const QLeaf* leaf = __leaf(node);
+			if (bounded)
+			{
+				const int result = __compare(leaf, start, startLength) * (descending ? -1 : 1);
+				if (result < 0 || (result == 0 && !inclusive))
+				{
+					return true;
+				}
+			}
+			return visitor(leaf->key, leaf->length, leaf->row);
+		}
+
+		if (bounded && node->prefixLength > 0)
+		{
+			// the prefix decides whether the whole subtree lies before or after start
+			const QLeaf* leaf = node->prefixLength > MAX_PREFIX ? __minimum(node) : nullptr;
+			for (std::size_t i = 0; i < node->prefixLength && bounded; i++)
+			{
+				if (depth + i >= startLength)
+				{
+					// keys extending start come after it
+					if (descending)
+					{
+						return true;
+					}
+					bounded = false;
+					break;
+				}
+				const uint8_t byte = leaf ? leaf->key[depth + i] : node->prefix[i];
+				if (byte != start[depth + i])
+				{
+					if ((byte > start[depth + i]) == descending)
+					{
+						return true;
+					}
+					bounded = false;
+				}
+			}
+		}
+		depth += node->prefixLength;
+		if (bounded && depth >= startLength)
+		{
+			if (descending)
+			{
+				return true;
+			}
+			bounded = false;
+		}
+
+		const int first = bounded ? start[depth] : (descending ? 255 : 0);
+		switch (node->type)
+		{
+		case QType::NODE4:
+		case QType::NODE16:
+		{
+			const uint8_t* keys = node->type == QType::NODE4 ? static_cast<const QNode4*>(node)->keys : static_cast<const QNode16*>(node)->keys;
+			QNode* const* children = node->type == QType::NODE4 ? static_cast<const QNode4*>(node)->children : static_cast<const QNode16*>(node)->children;
+			for (std::size_t i = 0; i < node->count; i++)
+			{
+				const std::size_t index = descending ? node->count - 1 - i : i;
+				if ((descending ? keys[index] > first : keys[index] < first))
+				{
+					continue;
+				}
+				if (!__visitChild(children[index], keys[index], depth, bounded, start, startLength, inclusive, descending, visitor))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		case QType::NODE48:
+		{
+			const QNode48* node48 = static_cast<const QNode48*>(node);
+			for (int byte = first; byte >= 0 && byte <= 255; byte += descending ? -1 : 1)
+			{
+				if (node48->slots[byte] && !__visitChild(node48->children[node48->slots[byte] - 1], static_cast<uint8_t>(byte), depth, bounded, start, startLength, inclusive, descending, visitor))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		case QType::NODE256:
+		{
+			const QNode256* node256 = static_cast<const QNode256*>(node);
+			for (int byte = first; byte >= 0 && byte <= 255; byte += descending ? -1 : 1)
+			{
+				if (node256->children[byte] && !__visitChild(node256->children[byte], static_cast<uint8_t>(byte), depth, bounded, start, startLength, inclusive, descending, visitor))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		}
+		return true;
+	}
+
+	template<typename Visitor>
+	inline bool QArt::__visitChild(const QNode* child, const uint8_t byte, const std::size_t depth, const bool bounded, const uint8_t* start, const std::size_t startLength, const bool inclusive, const bool descending, Visitor& visitor)
+	{
+		// only the child on start's own byte needs comparing further
+		return __visit(child, depth + 1, bounded && byte == start[depth], start, startLength, inclusive, descending, visitor);
+	}
+}
+
+#endif // qart_h__
@@ -0,0 +1,89 @@
+#ifndef qartindex_h__
+#define qartindex_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+#include "qsql/qart.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QArtIndex;
+	class QTable;
+
+	// Rows of a QArtIndex whose values lie within a range, see QBTreeRange.
+	class QArtRange
+	{
+	public:
+		QArtRange();
+
+		// Writes up to count rows and returns how many, 0 once the range is exhausted
+		std::size_t next(std::size_t* rows, const std::size_t count);
+	private:
+		const QArtIndex* __index;
+		bool __descending;
+		bool __empty;
+
+		// key the walk starts from, the last one returned once it has started,
+		// unless it starts at the first or last key
+		bool __hasStart;
+		qtl::vector<uint8_t> __start;
+		bool __inclusive;
+
+		// value that ends the walk
+		bool __bounded;
+		bool __endInclusive;
+		qtl::vector<uint8_t> __end;
+
+		friend class QArtIndex;
+	};
+
+	// Ordered index over a CHAR, INT, LONG or STRING column kept in an adaptive
+	// radix tree.  Each row is a key of its value's bytes, encoded so that they
+	// compare like the values, followed by the row, so that equal values are
+	// ordered by row and every key is unique.  Integral values are widened to
+	// 64 bits.  NULL is not indexed.
+	class QArtIndex
+	{
+	public:
+		QArtIndex(const QTable& table, const std::size_t column);
+		QArtIndex(const QArtIndex&) = delete;
+
+		QArtIndex& operator=(const QArtIndex&) = delete;
+
+		static bool isSupported(const QDataType type);
+
+		std::size_t getColumn() const;
+
+		// Number of indexed rows
+		std::size_t size() const;
+
+		// Indexes or unindexes a row by its current value in the table.  A row
+		// has to be erased from the index before its value changes.
+		void insert(const std::size_t row);
+		void erase(const std::size_t row);
+
+		// Appends the rows holding value in ascending order and returns how many
+		// were appended
+		std::size_t find(const QValue& value, qtl::vector<std::size_t>& rows) const;
+
+		// Same as QBTreeIndex::open()
+		void open(QArtRange& range, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, const bool descending) const;
+	private:
+		const QTable& __table;
+		std::size_t __column;
+		QDataType __type;
+		QArt __tree;
+
+		bool __key(const std::size_t row, qtl::vector<uint8_t>& key) const;
+		bool __bound(const QValue& value, qtl::vector<uint8_t>& key) const;
+
+		friend class QArtRange;
+	};
+}
+
+#endif // qartindex_h__
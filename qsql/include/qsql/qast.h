@@ -0,0 +1,173 @@
+#ifndef qast_h__
+#define qast_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "qsql/qdatatype.h"
+#include "qsql/qexpression.h"
+#include "qsql/qpredicate.h"
+
+namespace qsql
+{
+	// Syntax tree produced by QParser.  Every node lives in the parser's arena and
+	// is never destructed, so nodes only hold plain data.  Text points either into
+	// the parsed statement or into the arena, and lists are linked through next.
+
+	struct QAstText
+	{
+		const char* text;
+		std::size_t length;
+	};
+
+	enum class QAstExpressionType
+	{
+		COLUMN,
+		LITERAL,
+		PARAMETER,
+		STAR,
+		NEGATE,
+		NOT,
+		ARITHMETIC,
+		COMPARISON,
+		LOGICAL,
+		BETWEEN,
+		IN_LIST,
+		IS_NULL,
+		FUNCTION,
+	};
+
+	struct QAstLiteral
+	{
+		QDataType type;
+		bool isNull;
+		int64_t integer;
+		bool boolean;
+		QAstText string;
+	};
+
+	struct QAstExpression
+	{
+		QAstExpressionType type;
+
+		// offset of the expression in the statement text
+		std::size_t position;
+
+		// COLUMN is table.name where table may be empty, FUNCTION is name(arguments)
+		QAstText table;
+		QAstText name;
+
+		QAstLiteral literal;
+
+		// zero based index of a ? parameter, in order of appearance
+		std::size_t parameter;
+
+		QArithmetic arithmetic;
+		QComparison comparison;
+		QLogical logical;
+
+		// NOT BETWEEN, NOT IN and IS NOT NULL
+		bool negated;
+
+		// operands, NEGATE, NOT, BETWEEN, IN_LIST and IS_NULL only use left
+		QAstExpression* left;
+		QAstExpression* right;
+
+		// BETWEEN holds its low and high bound, IN_LIST its values and FUNCTION its arguments
+		QAstExpression* arguments;
+
+		QAstExpression* next;
+	};
+
+	struct QAstSelectItem
+	{
+		QAstExpression* expression;
+		QAstText alias;
+		QAstSelectItem* next;
+	};
+
+	struct QAstOrderItem
+	{
+		QAstExpression* expression;
+		bool descending;
+		QAstOrderItem* next;
+	};
+
+	struct QAstName
+	{
+		QAstText name;
+		QAstName* next;
+	};
+
+	struct QAstRow
+	{
+		QAstExpression* values;
+		QAstRow* next;
+	};
+
+	struct QAstAssignment
+	{
+		QAstText column;
+		QAstExpression* value;
+		QAstAssignment* next;
+	};
+
+	enum class QAstStatementType
+	{
+		SELECT_STATEMENT,
+		INSERT_STATEMENT,
+		UPDATE_STATEMENT,
+		DELETE_STATEMENT,
+	};
+
+	struct QAstStatement
+	{
+		QAstStatementType type;
+
+		// empty for a SELECT without FROM
+		QAstText table;
+
+		// SELECT
+		QAstSelectItem* items;
+
+		// table joined to table and the condition rows are joined on, empty without JOIN
+		QAstText joinTable;
+		QAstExpression* joinOn;
+
+		QAstExpression* groupBy;
+		QAstExpression* having;
+		QAstOrderItem* orderBy;
+		QAstExpression* limit;
+		QAstExpression* offset;
+
+		// SELECT, UPDATE and DELETE
+		QAstExpression* where;
+
+		// INSERT, columns is nullptr when the statement does not name them
+		QAstName* columns;
+		QAstRow* rows;
+
+		// UPDATE
+		QAstAssignment* assignments;
+
+		std::size_t parameterCount;
+	};
+
+	// Case insensitive comparison of text against a null terminated name
+	inline bool equalsIgnoreCase(const QAstText& text, const char* name)
+	{
+		std::size_t i = 0;
+		for (; i < text.length && name[i] != '\0'; i++)
+		{
+			const char a = text.text[i];
+			const char b = name[i];
+			if ((a >= 'A' && a <= 'Z' ? a + 32 : a) != (b >= 'A' && b <= 'Z' ? b + 32 : b))
+			{
+				return false;
+			}
+		}
+		return i == text.length && name[i] == '\0';
+	}
+}
+
+#endif // qast_h__
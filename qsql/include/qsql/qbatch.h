@@ -0,0 +1,186 @@
+#ifndef qbatch_h__
+#define qbatch_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+#include "qsql/qdatatype.h"
+#include "qsql/qdictionary.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	// A run of up to CAPACITY values of a single type.  A vector either references
+	// memory owned by someone else (a column chunk, another vector) or points at
+	// its own buffer, which is allocated on first use and reused across batches.
+	// A STRING vector may hold the 32-bit codes of a dictionary encoded column
+	// instead of strings, in which case getDictionary() is not nullptr.
+	class QVector
+	{
+	public:
+		static constexpr std::size_t CAPACITY = 2048;
+		static constexpr std::size_t NULL_WORDS = CAPACITY / 64;
+
+		QVector();
+		QVector(const QVector&) = delete;
+		~QVector();
+
+		QVector& operator=(const QVector&) = delete;
+
+		QDataType getType() const;
+		void* getData() const;
+
+		template<typename T>
+		T* getData() const;
+
+		// Dictionary the codes of the vector refer to, nullptr if it holds plain values
+		const QDictionary* getDictionary() const;
+
+		// Null bitmap with a set bit for each NULL value, nullptr if there are none
+		const uint64_t* getNulls() const;
+		bool isNull(const std::size_t index) const;
+
+		// Copies a single value out of the vector
+		QValue getValue(const std::size_t index) const;
+
+		void reference(const QDataType type, void* data, const uint64_t* nulls);
+		void reference(const QVector& other);
+		void referenceCodes(const QDictionary& dictionary, const uint32_t* codes, const uint64_t* nulls);
+
+		// Points the vector at its own buffer, sized for CAPACITY values of type
+		void initialize(const QDataType type);
+
+		// Points the vector at its own buffer, sized for CAPACITY codes of dictionary
+		uint32_t* initializeCodes(const QDictionary& dictionary);
+
+		// Points the vector at its own buffer filled with the strings of the first
+		// count codes of other, which has to hold codes
+		void decode(const QVector& other, const std::size_t count);
+
+		// Points the vector's null bitmap at its own zeroed buffer
+		uint64_t* initializeNulls();
+		void clearNulls();
+	private:
+		QDataType __type;
+		void* __data;
+		const uint64_t* __nulls;
+		const QDictionary* __dictionary;
+
+		QDataType __bufferType;
+		void* __buffer;
+		uint64_t* __nullBuffer;
+
+		void __releaseBuffer();
+	};
+
+	template<typename T>
+	inline T* QVector::getData() const
+	{
+		return static_cast<T*>(__data);
+	}
+
+	inline const QDictionary* QVector::getDictionary() const
+	{
+		return __dictionary;
+	}
+
+	inline bool QVector::isNull(const std::size_t index) const
+	{
+		return __nulls && ((__nulls[index >> 6] >> (index & 63)) & 1);
+	}
+
+	// A set of column vectors describing the same rows, plus an optional selection
+	// vector holding the indexes of the rows that are still active.  Operators
+	// narrow the selection instead of compacting the vectors.
+	class QBatch
+	{
+	public:
+		static constexpr std::size_t CAPACITY = QVector::CAPACITY;
+
+		QBatch();
+		explicit QBatch(const std::size_t columns);
+		QBatch(const QBatch&) = delete;
+		~QBatch();
+
+		QBatch& operator=(const QBatch&) = delete;
+
+		void setColumnCount(const std::size_t columns);
+		std::size_t getColumnCount() const;
+		QVector& getColumn(const std::size_t column) const;
+
+		std::size_t size() const;
+		void setSize(const std::size_t size);
+
+		// Index of the table row that backs the first value of the batch.  Setting
+		// it clears the row ids.
+		std::size_t getRowOffset() const;
+		void setRowOffset(const std::size_t offset);
+
+		// Table rows backing each value when they are not consecutive, as produced
+		// by an index lookup, nullptr otherwise
+		const std::size_t* getRowIds() const;
+		void setRowIds(const std::size_t* rows);
+
+		// Table row backing the value at index
+		std::size_t getRowId(const std::size_t index) const;
+
+		bool hasSelection() const;
+		const uint16_t* getSelection() const;
+		std::size_t getSelectionSize() const;
+
+		// Number of active rows, the selection size if one is set
+		std::size_t getActiveCount() const;
+
+		uint16_t* getSelectionBuffer();
+		void setSelection(const std::size_t count);
+		void referenceSelection(const QBatch& other);
+		void clearSelection();
+	private:
+		qtl::vector<QVector*> __columns;
+		std::size_t __size;
+		std::size_t __rowOffset;
+		const std::size_t* __rowIds;
+		const uint16_t* __selection;
+		std::size_t __selectionSize;
+		uint16_t* __selectionBuffer;
+	};
+
+	inline QVector& QBatch::getColumn(const std::size_t column) const
+	{
+		return *__columns[column];
+	}
+
+	inline std::size_t QBatch::size() const
+	{
+		return __size;
+	}
+
+	inline std::size_t QBatch::getRowId(const std::size_t index) const
+	{
+		return __rowIds ? __rowIds[index] : __rowOffset + index;
+	}
+
+	inline bool QBatch::hasSelection() const
+	{
+		return __selection != nullptr;
+	}
+
+	inline const uint16_t* QBatch::getSelection() const
+	{
+		return __selection;
+	}
+
+	inline std::size_t QBatch::getSelectionSize() const
+	{
+		return __selectionSize;
+	}
+
+	inline std::size_t QBatch::getActiveCount() const
+	{
+		return __selection ? __selectionSize : __size;
+	}
+}
+
+#endif // qbatch_h__
@@ -0,0 +1,76 @@
+#ifndef qbitmapindex_h__
+#define qbitmapindex_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+#include "qsql/qdatatype.h"
+#include "qsql/qdictionary.h"
+#include "qsql/qroaringbitmap.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QTable;
+
+	// Maps the values of a BOOL, CHAR or STRING column to a QRoaringBitmap of
+	// the rows holding them, which suits columns with few distinct values.
+	// Predicates on several such columns are answered by combining bitmaps
+	// instead of visiting rows.  Strings are numbered by a dictionary of the
+	// index's own.  NULL is not indexed.
+	class QBitmapIndex
+	{
+	public:
+		QBitmapIndex(const QTable& table, const std::size_t column);
+		QBitmapIndex(const QBitmapIndex&) = delete;
+		~QBitmapIndex();
+
+		QBitmapIndex& operator=(const QBitmapIndex&) = delete;
+
+		static bool isSupported(const QDataType type);
+
+		std::size_t getColumn() const;
+
+		// Number of indexed rows and distinct values
+		std::size_t size() const;
+		std::size_t getKeyCount() const;
+
+		// Indexes or unindexes a row by its current value in the table.  A row
+		// has to be erased from the index before its value changes.
+		void insert(const std::size_t row);
+		void erase(const std::size_t row);
+
+		// True if find() tells exactly which rows compare equal to value, that is
+		// value is NULL or of the column's type, or a one character string for a
+		// CHAR column.  Other types compare converted and are not looked up.
+		bool canFind(const QValue& value) const;
+
+		// Rows holding value, nullptr if there are none
+		const QRoaringBitmap* find(const QValue& value) const;
+
+		// Every indexed row, that is those whose value is not NULL
+		const QRoaringBitmap& getRows() const;
+
+		// Turns the bitmaps' containers into runs where that makes them smaller
+		void optimize();
+	private:
+		static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+
+		const QTable& __table;
+		std::size_t __column;
+		QDataType __type;
+		QDictionary __strings;
+
+		// one bitmap per key, nullptr for keys no row holds
+		qtl::vector<QRoaringBitmap*> __bitmaps;
+		QRoaringBitmap __rows;
+		std::size_t __keys;
+
+		uint32_t __key(const std::size_t row, const bool add);
+		uint32_t __key(const QValue& value) const;
+	};
+}
+
+#endif // qbitmapindex_h__
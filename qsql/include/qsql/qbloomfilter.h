@@ -0,0 +1,65 @@
+#ifndef qbloomfilter_h__
+#define qbloomfilter_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	// A Bloom filter made of blocks of one cache line, so a key is inserted or
+	// probed by touching a single line.  A key sets one bit in each of the
+	// block's 8 words, see bloomInsert().  The filter is sized from the number
+	// of keys it is meant to hold and the bits spent on each, 10 bits per key
+	// give about 1% false positives.  Keys are added and probed by their hash,
+	// computed with hashKey() or hashString().
+	//
+	// A filter without blocks holds nothing back: it may contain every key.
+	class QBloomFilter
+	{
+	public:
+		static constexpr std::size_t BLOCK_BYTES = 64;
+		static constexpr std::size_t DEFAULT_BITS_PER_KEY = 10;
+
+		QBloomFilter();
+		QBloomFilter(const std::size_t keys, const std::size_t bitsPerKey = DEFAULT_BITS_PER_KEY);
+		QBloomFilter(const QBloomFilter&) = delete;
+		~QBloomFilter();
+
+		QBloomFilter& operator=(const QBloomFilter&) = delete;
+
+		// Drops every key and sizes the filter for keys at bitsPerKey
+		void resize(const std::size_t keys, const std::size_t bitsPerKey = DEFAULT_BITS_PER_KEY);
+
+		// Drops the blocks, after which the filter may contain every key
+		void clear();
+
+		std::size_t getBlockCount() const;
+		std::size_t getBytes() const;
+
+		void insert(const uint64_t hash);
+		bool contains(const uint64_t hash) const;
+
+		// Sets bit i of bitmap for every hashes[i] the filter may contain and
+		// returns how many were set.  bitmap must hold (count + 63) / 64 words.
+		std::size_t filter(const uint64_t* hashes, const std::size_t count, uint64_t* bitmap) const;
+
+		// Integral keys are hashed widened to LONG, so equal values of CHAR, INT
+		// and LONG columns hash alike
+		static uint64_t hashKey(const int64_t key);
+		static uint64_t hashString(const qtl::string& key);
+
+		// Hash of a value that is not NULL, false for a BOOL
+		static bool hashValue(const QValue& value, uint64_t& hash);
+	private:
+		// blocks aligned to a cache line within the allocation
+		void* __allocation;
+		uint64_t* __blocks;
+		std::size_t __blockCount;
+	};
+}
+
+#endif // qbloomfilter_h__
@@ -0,0 +1,593 @@
+#ifndef qbtree_h__
+#define qbtree_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <qtl/string.h>
+
+namespace qsql
+{
+	inline int compareKeys(const int64_t left, const int64_t right)
+	{
+		return left < right ? -1 : (left > right ? 1 : 0);
+	}
+
+	inline int compareKeys(const qtl::string& left, const qtl::string& right)
+	{
+		return left.compare(right);
+	}
+
+	// B+tree of (key, row) entries.  Nodes are NODE_SIZE bytes and keep their keys
+	// and rows in separate contiguous arrays, so a search touches one page per
+	// level and binary searches a dense run of keys.  Leaves are linked in both
+	// directions for range scans.  Equal keys are ordered by row, which makes
+	// every entry unique.  Erasing does not rebalance, a node is only freed once
+	// it is empty.  Cursors are invalidated by insert() and erase().
+	template<typename Key>
+	class QBTree
+	{
+		struct QNode
+		{
+			std::size_t count;
+			bool leaf;
+		};
+
+	public:
+		static constexpr std::size_t NODE_SIZE = 4096;
+		static constexpr std::size_t LEAF_CAPACITY = (NODE_SIZE - sizeof(QNode) - 2 * sizeof(void*)) / (sizeof(Key) + sizeof(std::size_t));
+		static constexpr std::size_t INNER_CAPACITY = (NODE_SIZE - sizeof(QNode) - sizeof(void*)) / (sizeof(Key) + sizeof(std::size_t) + sizeof(void*));
+
+	private:
+		struct QLeaf : QNode
+		{
+			QLeaf* previous;
+			QLeaf* next;
+			Key keys[LEAF_CAPACITY];
+			std::size_t rows[LEAF_CAPACITY];
+		};
+
+		// children[i] holds the entries from separator i - 1 up to separator i
+		struct QInner : QNode
+		{
+			Key keys[INNER_CAPACITY];
+			std::size_t rows[INNER_CAPACITY];
+			QNode* children[INNER_CAPACITY + 1];
+		};
+
+	public:
+		// Position of an entry, invalid once it moves past either end of the tree
+		class QCursor
+		{
+		public:
+			QCursor();
+
+			bool isValid() const;
+			const Key& getKey() const;
+			std::size_t getRow() const;
+
+			void next();
+			void previous();
+		private:
+			const QLeaf* __leaf;
+			std::size_t __index;
+
+			QCursor(const QLeaf* leaf, const std::size_t index);
+
+			// moves a position that may sit at the end of a leaf onto the next entry
+			void __settle();
+
+			friend class QBTree;
+		};
+
+		QBTree();
+		QBTree(const QBTree&) = delete;
+		~QBTree();
+
+		QBTree& operator=(const QBTree&) = delete;
+
+		std::size_t size() const;
+		void clear();
+
+		void insert(const Key& key, const std::size_t row);
+		bool erase(const Key& key, const std::size_t row);
+
+		QCursor first() const;
+		QCursor last() const;
+
+		// First entry not less than, or greater than, (key, row).  The default
+		// rows compare the key alone.
+		QCursor lowerBound(const Key& key, const std::size_t row = 0) const;
+		QCursor upperBound(const Key& key, const std::size_t row = SIZE_MAX) const;
+
+		// Last entry less than, or not greater than, (key, row)
+		QCursor lastBelow(const Key& key, const std::size_t row = 0) const;
+		QCursor lastNotAbove(const Key& key, const std::size_t row = SIZE_MAX) const;
+	private:
+		QNode* __root;
+		std::size_t __size;
+
+		static int __compare(const Key& leftKey, const std::size_t leftRow, const Key& rightKey, const std::size_t rightRow);
+
+		// child of inner holding (key, row) and position of the first leaf entry not less than it
+		static std::size_t __child(const QInner* inner, const Key& key, const std::size_t row);
+		static std::size_t __position(const QLeaf* leaf, const Key& key, const std::size_t row);
+
+		// position of the first entry not less than (key, row), which may be one
+		// past the last entry of the leaf
+		QCursor __seek(const Key& key, const std::size_t row) const;
+		static QCursor __before(QCursor cursor);
+
+		// inserts into the subtree and returns the new right sibling if node split
+		QNode* __insert(QNode* node, const Key& key, const std::size_t row, Key& separator, std::size_t& separatorRow);
+
+		// erases from the subtree and returns true if node became empty and was freed
+		bool __erase(QNode* node, const Key& key, const std::size_t row, bool& found);
+		static void __destroy(QNode* node);
+	};
+
+	template<typename Key>
+	inline QBTree<Key>::QCursor::QCursor()
+		: __leaf(nullptr), __index(0)
+	{
+	}
+
+	template<typename Key>
+	inline QBTree<Key>::QCursor::QCursor(const QLeaf* leaf, const std::size_t index)
+		: __leaf(leaf), __index(index)
+	{
+	}
+
+	template<typename Key>
+	inline bool QBTree<Key>::QCursor::isValid() const
+	{
+		return __leaf != nullptr;
+	}
+
+	template<typename Key>
+	inline const Key& QBTree<Key>::QCursor::getKey() const
+	{
+		return __leaf->keys[__index];
+	}
+
+	template<typename Key>
+	inline std::size_t QBTree<Key>::QCursor::getRow() const
+	{
+		return __leaf->rows[__index];
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::QCursor::next()
+	{
+		__index++;
+		__settle();
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::QCursor::previous()
+	{
+		*this = QBTree<Key>::__before(*this);
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::QCursor::__settle()
+	{
+		while (__leaf && __index >= __leaf->count)
+		{
+			__leaf = __leaf->next;
+			__index = 0;
+		}
+	}
+
+	template<typename Key>
+	inline QBTree<Key>::QBTree()
+		: __root(nullptr), __size(0)
+	{
+	}
+
+	template<typename Key>
+	inline QBTree<Key>::~QBTree()
+	{
+		clear();
+	}
+
+	template<typename Key>
+	inline std::size_t QBTree<Key>::size() const
+	{
+		return __size;
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::clear()
+	{
+		if (__root)
+		{
+			__destroy(__root);
+		}
+		__root = nullptr;
+		__size = 0;
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::insert(const Key& key, const std::size_t row)
+	{
+		if (__root == nullptr)
+		{
+			QLeaf* leaf = new QLeaf();
+			leaf->count = 0;
+			leaf->leaf = true;
+			leaf->previous = nullptr;
+			leaf->next = nullptr;
+			__root = leaf;
+		}
+
+		Key separator = Key();
+		std::size_t separatorRow = 0;
+		QNode* sibling = __insert(__root, key, row, separator, separatorRow);
+		if (sibling)
+		{
+			QInner* root = new QInner();
+			root->count = 1;
+			root->leaf = false;
+			root->keys[0] = std::move(separator);
+			root->rows[0] = separatorRow;
+			root->children[0] = __root;
+			root->children[1] = sibling;
+			__root = root;
+		}
+		__size++;
+	}
+
+	template<typename Key>
+	inline bool QBTree<Key>::erase(const Key& key, const std::size_t row)
+	{
+		bool found = false;
+		if (__root == nullptr)
+		{
+			return false;
+		}
+		__erase(__root, key, row, found);
+
+		// an inner root left with a single child is replaced by it
+		while (__root && !__root->leaf && __root->count == 0)
+		{
+			QInner* root = static_cast<QInner*>(__root);
+			__root = root->children[0];
+			delete root;
+		}
+
+		if (found)
+		{
+			__size--;
+		}
+		return found;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::first() const
+	{
+		const QNode* node = __root;
+		while (node && !node->leaf)
+		{
+			node = static_cast<const QInner*>(node)->children[0];
+		}
+		QCursor cursor(static_cast<const QLeaf*>(node), 0);
+		cursor.__settle();
+		return cursor;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::last() const
+	{
+		const QNode* node = __root;
+		while (node && !node->leaf)
+		{
+			node = static_cast<const QInner*>(node)->children[node->count];
+		}
+		return __before(QCursor(static_cast<const QLeaf*>(node), node ? node->count : 0));
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::lowerBound(const Key& key, const std::size_t row) const
+	{
+		QCursor cursor = __seek(key, row);
+		cursor.__settle();
+		return cursor;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::upperBound(const Key& key, const std::size_t row) const
+	{
+		// no entry has the row SIZE_MAX, so seeking to it already skips every row of key
+		QCursor cursor = __seek(key, row == SIZE_MAX ? row : row + 1);
+		cursor.__settle();
+		return cursor;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::lastBelow(const Key& key, const std::size_t row) const
+	{
+		return __before(__seek(key, row));
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::lastNotAbove(const Key& key, const std::size_t row) const
+	{
+		return __before(__seek(key, row == SIZE_MAX ? row : row + 1));
+	}
+
+	template<typename Key>
+	inline int QBTree<Key>::__compare(const Key& leftKey, const std::size_t leftRow, const Key& rightKey, const std::size_t rightRow)
+	{
+		const int result = compareKeys(leftKey, rightKey);
+		if (result != 0)
+		{
+			return result;
+		}
+		return leftRow < rightRow ? -1 : (leftRow > rightRow ? 1 : 0);
+	}
+
+	template<typename Key>
+	inline std::size_t QBTree<Key>::__child(const QInner* inner, const Key& key, const std::size_t row)
+	{
+		// the child after the last separator not greater than (key, row)
+		std::size_t low = 0;
+		std::size_t high = inner->count;
+		while (low < high)
+		{
+			const std::size_t middle = (low + high) / 2;
+			if (__compare(inner->keys[middle], inner->rows[middle], key, row) <= 0)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	template<typename Key>
+	inline std::size_t QBTree<Key>::__position(const QLeaf* leaf, const Key& key, const std::size_t row)
+	{
+		std::size_t low = 0;
+		std::size_t high = leaf->count;
+		while (low < high)
+		{
+			const std::size_t middle = (low + high) / 2;
+			if (__compare(leaf->keys[middle], leaf->rows[middle], key, row) < 0)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::__seek(const Key& key, const std::size_t row) const
+	{
+		const QNode* node = __root;
+		if (node == nullptr)
+		{
+			return QCursor();
+		}
+
+		while (!node->leaf)
+		{
+			node = static_cast<const QInner*>(node)->children[__child(static_cast<const QInner*>(node), key, row)];
+		}
+		const QLeaf* leaf = static_cast<const QLeaf*>(node);
+		return QCursor(leaf, __position(leaf, key, row));
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QCursor QBTree<Key>::__before(QCursor cursor)
+	{
+		while (cursor.__leaf && cursor.__index == 0)
+		{
+			cursor.__leaf = cursor.__leaf->previous;
+			cursor.__index = cursor.__leaf ? cursor.__leaf->count : 0;
+		}
+		if (cursor.__leaf)
+		{
+			cursor.__index--;
+		}
+		return cursor;
+	}
+
+	template<typename Key>
+	inline typename QBTree<Key>::QNode* QBTree<Key>::__insert(QNode* node, const Key& key, const std::size_t row, Key& separator, std::size_t& separatorRow)
+	{
+		if (node->leaf)
+		{
+			QLeaf* leaf = static_cast<QLeaf*>(node);
+			QLeaf* sibling = nullptr;
+			if (leaf->count == LEAF_CAPACITY)
+			{
+				// move the upper half into a new leaf linked after this one
+				sibling = new QLeaf();
+				sibling->leaf = true;
+				sibling->count = LEAF_CAPACITY - LEAF_CAPACITY / 2;
+				for (std::size_t i = 0; i < sibling->count; i++)
+				{
+					sibling->keys[i] = std::move(leaf->keys[LEAF_CAPACITY / 2 + i]);
+					sibling->rows[i] = leaf->rows[LEAF_CAPACITY / 2 + i];
+				}
+				leaf->count = LEAF_CAPACITY / 2;
+				sibling->previous = leaf;
+				sibling->next = leaf->next;
+				if (leaf->next)
+				{
+					leaf->next->previous = sibling;
+				}
+				leaf->next = sibling;
+
+				if (__compare(key, row, sibling->keys[0], sibling->rows[0]) >= 0)
+				{
+					leaf = sibling;
+				}
+			}
+
+			std::size_t position = leaf->count;
+			while (position > 0 && __compare(leaf->keys[position - 1], leaf->rows[position - 1], key, row) > 0)
+			{
+				leaf->keys[position] = std::move(leaf->keys[position - 1]);
+				leaf->rows[position] = leaf->rows[position - 1];
+				position--;
+			}
+			leaf->keys[position] = key;
+			leaf->rows[position] = row;
+			leaf->count++;
+
+			if (sibling)
+			{
+				separator = sibling->keys[0];
+				separatorRow = sibling->rows[0];
+			}
+			return sibling;
+		}
+
+		QInner* inner = static_cast<QInner*>(node);
+		std::size_t child = __child(inner, key, row);
+
+		Key childSeparator = Key();
+		std::size_t childSeparatorRow = 0;
+		QNode* childSibling = __insert(inner->children[child], key, row, childSeparator, childSeparatorRow);
+		if (childSibling == nullptr)
+		{
+			return nullptr;
+		}
+
+		QInner* sibling = nullptr;
+		if (inner->count == INNER_CAPACITY)
+		{
+			// the middle separator moves up, the ones after it go to the new node
+			const std::size_t middle = INNER_CAPACITY / 2;
+			sibling = new QInner();
+			sibling->leaf = false;
+			sibling->count = INNER_CAPACITY - middle - 1;
+			for (std::size_t i = 0; i < sibling->count; i++)
+			{
+				sibling->keys[i] = std::move(inner->keys[middle + 1 + i]);
+				sibling->rows[i] = inner->rows[middle + 1 + i];
+				sibling->children[i] = inner->children[middle + 1 + i];
+			}
+			sibling->children[sibling->count] = inner->children[INNER_CAPACITY];
+			separator = std::move(inner->keys[middle]);
+			separatorRow = inner->rows[middle];
+			inner->count = middle;
+
+			if (child > middle)
+			{
+				child -= middle + 1;
+				inner = sibling;
+			}
+		}
+
+		for (std::size_t i = inner->count; i > child; i--)
+		{
+			inner->keys[i] = std::move(inner->keys[i - 1]);
+			inner->rows[i] = inner->rows[i - 1];
+			inner->children[i + 1] = inner->children[i];
+		}
+		inner->keys[child] = std::move(childSeparator);
+		inner->rows[child] = childSeparatorRow;
+		inner->children[child + 1] = childSibling;
+		inner->count++;
+		return sibling;
+	}
+
+	template<typename Key>
+	inline bool QBTree<Key>::__erase(QNode* node, const Key& key, const std::size_t row, bool& found)
+	{
+		if (node->leaf)
+		{
+			QLeaf* leaf = static_cast<QLeaf*>(node);
+			const std::size_t position = __position(leaf, key, row);
+			if (position == leaf->count || __compare(leaf->keys[position], leaf->rows[position], key, row) != 0)
+			{
+				return false;
+			}
+
+			for (std::size_t i = position + 1; i < leaf->count; i++)
+			{
+				leaf->keys[i - 1] = std::move(leaf->keys[i]);
+				leaf->rows[i - 1] = leaf->rows[i];
+			}
+			leaf->count--;
+			found = true;
+
+			// the root leaf stays allocated even when empty
+			if (leaf->count > 0 || leaf == __root)
+			{
+				return false;
+			}
+			if (leaf->previous)
+			{
+				leaf->previous->next = leaf->next;
+			}
+			if (leaf->next)
+			{
+				leaf->next->previous = leaf->previous;
+			}
+			delete leaf;
+			return true;
+		}
+
+		QInner* inner = static_cast<QInner*>(node);
+		const std::size_t child = __child(inner, key, row);
+		if (!__erase(inner->children[child], key, row, found))
+		{
+			return false;
+		}
+
+		if (inner->count == 0)
+		{
+			// the last child is gone, so is this node unless it is the root
+			if (inner == __root)
+			{
+				__root = nullptr;
+			}
+			delete inner;
+			return true;
+		}
+
+		// the freed child's range joins its left neighbour, or the right one for the first child
+		const std::size_t separator = child > 0 ? child - 1 : 0;
+		for (std::size_t i = separator + 1; i < inner->count; i++)
+		{
+			inner->keys[i - 1] = std::move(inner->keys[i]);
+			inner->rows[i - 1] = inner->rows[i];
+		}
+		for (std::size_t i = child + 1; i <= inner->count; i++)
+		{
+			inner->children[i - 1] = inner->children[i];
+		}
+		inner->count--;
+		return false;
+	}
+
+	template<typename Key>
+	inline void QBTree<Key>::__destroy(QNode* node)
+	{
+		if (node->leaf)
+		{
+			delete static_cast<QLeaf*>(node);
+			return;
+		}
+		QInner* inner = static_cast<QInner*>(node);
+		for (std::size_t i = 0; i <= inner->count; i++)
+		{
+			__destroy(inner->children[i]);
+		}
+		delete inner;
+	}
+}
+
+#endif // qbtree_h__
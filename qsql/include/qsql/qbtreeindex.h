@@ -0,0 +1,97 @@
+#ifndef qbtreeindex_h__
+#define qbtreeindex_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+
+#include "qsql/qbtree.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QBTreeIndex;
+	class QTable;
+
+	// Rows of a QBTreeIndex whose values lie within a range, in ascending or
+	// descending order of value and then row.  The range remembers the last row
+	// it returned rather than a tree position, so the table may change between
+	// two calls to next().
+	class QBTreeRange
+	{
+	public:
+		QBTreeRange();
+
+		// Writes up to count rows and returns how many, 0 once the range is exhausted
+		std::size_t next(std::size_t* rows, const std::size_t count);
+	private:
+		const QBTreeIndex* __index;
+		bool __descending;
+		bool __empty;
+
+		bool __hasLow;
+		bool __lowInclusive;
+		int64_t __lowKey;
+		qtl::string __lowString;
+
+		bool __hasHigh;
+		bool __highInclusive;
+		int64_t __highKey;
+		qtl::string __highString;
+
+		// last row returned and its value, __started is false before the first one
+		bool __started;
+		std::size_t __lastRow;
+		int64_t __lastKey;
+		qtl::string __lastString;
+
+		template<typename Key>
+		std::size_t __next(const QBTree<Key>& tree, const Key& low, const Key& high, Key& last, std::size_t* rows, const std::size_t count);
+
+		friend class QBTreeIndex;
+	};
+
+	// Ordered index over a CHAR, INT, LONG or STRING column.  Integral values are
+	// kept widened to 64 bits and strings are copied into the tree, each entry
+	// paired with its row.  NULL is not indexed.
+	class QBTreeIndex
+	{
+	public:
+		QBTreeIndex(const QTable& table, const std::size_t column);
+		QBTreeIndex(const QBTreeIndex&) = delete;
+
+		QBTreeIndex& operator=(const QBTreeIndex&) = delete;
+
+		static bool isSupported(const QDataType type);
+
+		std::size_t getColumn() const;
+
+		// Number of indexed rows
+		std::size_t size() const;
+
+		// Indexes or unindexes a row by its current value in the table.  A row
+		// has to be erased from the index before its value changes.
+		void insert(const std::size_t row);
+		void erase(const std::size_t row);
+
+		// Starts a range over the rows between low and high, a nullptr bound leaves
+		// that side open.  A NULL bound or one that cannot be compared with the
+		// column gives an empty range.
+		void open(QBTreeRange& range, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, const bool descending) const;
+	private:
+		const QTable& __table;
+		std::size_t __column;
+		QDataType __type;
+		QBTree<int64_t> __keys;
+		QBTree<qtl::string> __strings;
+
+		bool __key(const std::size_t row, int64_t& key) const;
+		bool __bound(const QValue& value, int64_t& key, qtl::string& string) const;
+
+		friend class QBTreeRange;
+	};
+}
+
+#endif // qbtreeindex_h__
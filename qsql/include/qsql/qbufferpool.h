@@ -0,0 +1,125 @@
+#ifndef qbufferpool_h__
+#define qbufferpool_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+#include <qtl/thread/condition_variable.h>
+#include <qtl/thread/mutex.h>
+
+namespace qsql
+{
+	// Fixed number of page frames caching the pages of files registered with the
+	// pool.  A page stays in its frame while it is pinned.  When a page that is
+	// not cached is pinned and no frame is free, the CLOCK hand sweeps the frames,
+	// clearing reference bits, until it finds an unpinned frame that was not used
+	// since its last pass, whose page is written back first if it was modified.
+	// Safe to use from several threads.  Only the page table and the frames'
+	// state are guarded by the pool's mutex: a miss reserves its frame and
+	// reads into it, and writes back the page it replaces, without holding it,
+	// while other pinners of that page wait for the frame to be loaded.
+	class QBufferPool
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+		static constexpr std::size_t PAGE_SIZE = static_cast<std::size_t>(128) << 10;
+		static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+
+		explicit QBufferPool(const std::size_t frames);
+		QBufferPool(const QBufferPool&) = delete;
+		~QBufferPool();
+
+		QBufferPool& operator=(const QBufferPool&) = delete;
+
+		std::size_t getFrameCount() const;
+
+		// Opens a file for reading and writing its pages through the pool, returns
+		// its id or NONE
+		uint32_t addFile(const qtl::string& path);
+
+		// Writes back the file's modified pages, drops its pages and closes it.
+		// None of them may be pinned.
+		void removeFile(const uint32_t file);
+		uint64_t getFileSize(const uint32_t file) const;
+
+		// Returns the frame holding a page, reading the page first if it is not
+		// cached.  Returns nullptr if every frame is pinned or the read fails.  A
+		// page past the end of the file reads as zeroes.
+		char* pin(const uint32_t file, const uint64_t page);
+
+		// Releases a pin, address may point anywhere into the frame.  A dirty
+		// page is written back before its frame is reused.
+		void unpin(const void* address, const bool dirty);
+
+		// Writes back every modified page
+		bool flush();
+
+		uint64_t getHits() const;
+		uint64_t getMisses() const;
+		uint64_t getEvictions() const;
+		uint64_t getWrites() const;
+
+		const char* getError() const;
+	private:
+		struct QFrame
+		{
+			uint32_t file;
+			uint64_t page;
+			uint32_t pins;
+			uint32_t next;
+			bool referenced;
+			bool dirty;
+
+			// set while the page is read into the frame, which holds nothing
+			// valid until then
+			bool loading;
+		};
+
+		// an evicted page being written back, which is read again only once
+		// that is done
+		struct QWriteBack
+		{
+			uint32_t file;
+			uint64_t page;
+		};
+
+		qtl::mutex __mutex;
+
+		// signalled whenever a frame is loaded or an evicted page written back
+		qtl::condition_variable __loaded;
+		qtl::vector<QWriteBack> __writingBack;
+
+		char* __memory;
+		qtl::vector<QFrame> __frames;
+		qtl::vector<int> __files;
+		qtl::vector<uint64_t> __fileSizes;
+		qtl::vector<qtl::string> __paths;
+
+		// page table, chains of frames threaded through QFrame::next
+		qtl::vector<uint32_t> __buckets;
+		std::size_t __mask;
+		std::size_t __hand;
+
+		std::atomic<uint64_t> __hits;
+		std::atomic<uint64_t> __misses;
+		std::atomic<uint64_t> __evictions;
+		std::atomic<uint64_t> __writes;
+		char __error[ERROR_LENGTH];
+
+		std::size_t __bucket(const uint32_t file, const uint64_t page) const;
+		void __link(const uint32_t frame);
+		void __unlink(const uint32_t frame);
+		bool __writeBack(QFrame& frame, const uint32_t index);
+		std::size_t __writeLength(const uint32_t file, const uint64_t page) const;
+		void __written(const uint32_t file, const uint64_t page, const std::size_t length);
+		bool __isWritingBack(const uint32_t file, const uint64_t page) const;
+		void __waitForWriteBacks(qtl::unique_lock<qtl::mutex>& lock, const uint32_t file);
+		uint32_t __victim();
+		void __fail(const char* format, const char* detail);
+	};
+}
+
+#endif // qbufferpool_h__
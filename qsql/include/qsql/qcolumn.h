@@ -0,0 +1,190 @@
+#ifndef qcolumn_h__
+#define qcolumn_h__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+#include "qsql/qarena.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qdictionary.h"
+#include "qsql/qsegment.h"
+
+namespace qsql
+{
+	class QBufferPool;
+
+	// Column-major storage for a single column.  Values are kept in fixed-capacity
+	// chunks, each a contiguous buffer of the column's native type, so growing the
+	// column never copies existing values and scans can walk a chunk linearly.
+	// A STRING column given a dictionary stores 32-bit codes into it instead.
+	// Chunks come from the heap, or from an arena that outlives the column when
+	// one is given, in which case they are released with the arena.
+	//
+	// Chunks attached from a buffer pool are read through it instead: pointers
+	// returned for them are valid only while the caller keeps the chunk pinned,
+	// read() and isNull() copy single values out under a pin of their own.
+	// Pooled chunks are never changed, a partial last chunk is copied into the
+	// arena when it is attached so that rows can be appended to it.
+	//
+	// A full chunk of INT or LONG in a column without an arena can be compressed
+	// into a QSegment, after which its values are only read through the segment.
+	class QColumn
+	{
+	public:
+		static constexpr std::size_t CHUNK_SHIFT = 14;
+		static constexpr std::size_t CHUNK_SIZE = static_cast<std::size_t>(1) << CHUNK_SHIFT;
+
+		explicit QColumn(const QDataType type, const bool nullable = false, const QDictionary* dictionary = nullptr, QArena* arena = nullptr);
+		QColumn(const QColumn&) = delete;
+		~QColumn();
+
+		QColumn& operator=(const QColumn&) = delete;
+
+		QDataType getType() const;
+		std::size_t getWidth() const;
+		bool isNullable() const;
+		std::size_t size() const;
+
+		// Dictionary the column's codes refer to, nullptr unless it is encoded
+		const QDictionary* getDictionary() const;
+
+		std::size_t getChunkCount() const;
+		std::size_t getChunkSize(const std::size_t chunk) const;
+		// Values of a chunk that is not compressed
+		void* getChunk(const std::size_t chunk) const;
+
+		template<typename T>
+		T* getChunk(const std::size_t chunk) const;
+
+		// Storage of a row in a chunk that is not compressed
+		void* at(const std::size_t row) const;
+
+		// Copies the value of a row in a chunk that is not compressed, false if
+		// its pooled page cannot be pinned
+		bool read(const std::size_t row, void* value) const;
+
+		// Same as at() for storing a value, the chunk must not be pooled
+		void* modify(const std::size_t row);
+
+		bool isCompressed(const std::size_t chunk) const;
+
+		// True if the chunk is read through a buffer pool
+		bool isPooled(const std::size_t chunk) const;
+
+		// Segment of a compressed chunk, nullptr for other chunks
+		const QSegment* getSegment(const std::size_t chunk) const;
+
+		// Compresses a full chunk, which must not change any more, and returns its
+		// plain values for the caller to free() once no reader can hold them.
+		// Returns nullptr and keeps the chunk as it is if no encoding is smaller.
+		void* compress(const std::size_t chunk);
+
+		// Keeps a pooled chunk in memory until it is unpinned, does nothing for
+		// other chunks.  Returns false and pins nothing if the pool has too few
+		// frames left for the chunk's pages.
+		bool pinChunk(const std::size_t chunk) const;
+		void unpinChunk(const std::size_t chunk) const;
+
+		// Pages pinChunk() pins for a pooled chunk, 0 if no chunk is pooled
+		std::size_t getChunkPages() const;
+
+		// Null bitmap of a chunk, nullptr if the column is not nullable
+		const uint64_t* getNulls(const std::size_t chunk) const;
+		bool isNull(const std::size_t row) const;
+		void setNull(const std::size_t row, const bool null);
+
+		// Appends a default initialized value and returns its storage
+		void* append();
+
+		// Appends a chunk of count values kept elsewhere, such as a mapped file.
+		// The storage has room for CHUNK_SIZE values and outlives the column,
+		// only the last chunk of a column may be partial.
+		void attach(void* values, uint64_t* nulls, const std::size_t count);
+
+		// Appends a chunk read through pool from offsets into one of its files,
+		// chunks must not straddle a pool page.  Returns false if the chunk is
+		// partial and cannot be copied out of the pool.
+		bool attach(QBufferPool& pool, const uint32_t file, const uint64_t values, const uint64_t nulls, const std::size_t count);
+	private:
+		QDataType __type;
+		std::size_t __width;
+		std::size_t __size;
+		bool __nullable;
+		const QDictionary* __dictionary;
+		QArena* __arena;
+		qtl::vector<void*> __chunks;
+		qtl::vector<uint64_t*> __nulls;
+
+		// one entry per chunk up to the last one compressed, nullptr while plain
+		qtl::vector<QSegment*> __segments;
+
+		// pooled chunks come first and have nullptr entries in __chunks and __nulls
+		// unless they were copied into the arena
+		QBufferPool* __pool;
+		uint32_t __poolFile;
+		qtl::vector<uint64_t> __poolValues;
+		qtl::vector<uint64_t> __poolNulls;
+
+		void* __pooled(const uint64_t offset) const;
+		void* __pooledAt(const std::size_t row) const;
+		bool __readPooled(const uint64_t offset, void* data, const std::size_t size) const;
+		bool __isNullPooled(const std::size_t row) const;
+		bool __copyPooled(const std::size_t chunk);
+	};
+
+	template<typename T>
+	inline T* QColumn::getChunk(const std::size_t chunk) const
+	{
+		return static_cast<T*>(getChunk(chunk));
+	}
+
+	inline void* QColumn::at(const std::size_t row) const
+	{
+		char* chunk = static_cast<char*>(__chunks[row >> CHUNK_SHIFT]);
+		assert(!isCompressed(row >> CHUNK_SHIFT));
+		if (chunk == nullptr)
+		{
+			return __pooledAt(row);
+		}
+		return chunk + (row & (CHUNK_SIZE - 1)) * __width;
+	}
+
+	inline bool QColumn::isCompressed(const std::size_t chunk) const
+	{
+		return chunk < __segments.size() && __segments[chunk] != nullptr;
+	}
+
+	inline bool QColumn::isPooled(const std::size_t chunk) const
+	{
+		return chunk < __poolValues.size() && __chunks[chunk] == nullptr;
+	}
+
+	inline const uint64_t* QColumn::getNulls(const std::size_t chunk) const
+	{
+		if (!__nullable)
+		{
+			return nullptr;
+		}
+		return __nulls[chunk] ? __nulls[chunk] : static_cast<const uint64_t*>(__pooled(__poolNulls[chunk]));
+	}
+
+	inline bool QColumn::isNull(const std::size_t row) const
+	{
+		if (!__nullable)
+		{
+			return false;
+		}
+		const uint64_t* nulls = __nulls[row >> CHUNK_SHIFT];
+		if (nulls == nullptr)
+		{
+			return __isNullPooled(row);
+		}
+		const std::size_t bit = row & (CHUNK_SIZE - 1);
+		return (nulls[bit >> 6] >> (bit & 63)) & 1;
+	}
+}
+
+#endif // qcolumn_h__
@@ -0,0 +1,112 @@
+#ifndef qdatabase_h__
+#define qdatabase_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+#include <qtl/thread/thread_pool.h>
+
+#include "qsql/qarena.h"
+#include "qsql/qparser.h"
+#include "qsql/qplan.h"
+#include "qsql/qplancache.h"
+#include "qsql/qplanner.h"
+#include "qsql/qschema.h"
+#include "qsql/qstatement.h"
+#include "qsql/qtable.h"
+#include "qsql/qversion.h"
+#include "qsql/qwal.h"
+
+namespace qsql
+{
+	// A named set of tables and the entry point for SQL.  prepare() parses,
+	// binds and plans a statement once; preparing the same statement again is
+	// served from the plan cache without parsing.  Dropping a table invalidates
+	// every plan built so far.  With a log attached every change to a table,
+	// and the creation and removal of tables, is written to it.  The tables
+	// share a clock, so a statement reading several of them sees one point in
+	// time.
+	class QDatabase
+	{
+	public:
+		QDatabase();
+		QDatabase(const QDatabase&) = delete;
+		~QDatabase();
+
+		QDatabase& operator=(const QDatabase&) = delete;
+
+		// Returns nullptr if a table of that name already exists.  Table names
+		// are case insensitive.
+		QTable* createTable(const qtl::string& name, const QSchema& schema, const QTableLayout layout = QTableLayout::ROW);
+
+		// Takes ownership of a table built elsewhere, such as one opened by
+		// QTableFile.  Returns false and leaves the table to the caller if the
+		// name is taken.  Adding a table is not logged.  The table is moved to the
+		// database's clock, so no snapshot of it may be in use.
+		bool addTable(const qtl::string& name, QTable* table);
+		QTable* getTable(const qtl::string& name) const;
+		QTable* findTable(const char* name, const std::size_t length) const;
+		bool dropTable(const qtl::string& name);
+		std::size_t getTableCount() const;
+
+		QVersionClock& getClock();
+
+		// Drops row versions that no snapshot in use can see from every table
+		void collectGarbage();
+
+		// Incremented whenever existing plans become invalid
+		uint64_t getVersion() const;
+
+		QStatement prepare(const qtl::string& text);
+
+		QPlanCache& getPlanCache();
+
+		// Pool that a SELECT scanning a whole table is read on, split into one
+		// pipeline per worker, nullptr (the default) to run every plan on the
+		// calling thread.  The pool must outlive the database and statements
+		// must not be run on its workers.  With a pool the rows of a SELECT
+		// without ORDER BY come out in no particular order.  Changing the pool
+		// invalidates existing plans.
+		void setThreadPool(qtl::thread_pool* pool);
+		qtl::thread_pool* getThreadPool() const;
+
+		// Logs every later change to log, nullptr stops logging.  A synchronous
+		// log is flushed before a statement's changes are applied.  Otherwise
+		// execute() returns once they are appended and the caller flushes up to
+		// QStatement::getLogPosition(), which lets threads that serialize their
+		// statements share fsyncs.  A log is replayed before it is attached.
+		void setLog(QWal* log, const bool synchronous = true);
+		QWal* getLog() const;
+		bool isLogSynchronous() const;
+	private:
+		struct QTableEntry
+		{
+			qtl::string name;
+			QTable* table;
+		};
+
+		// declared first, tables stamp their commits by it until they are destroyed
+		QVersionClock __clock;
+		qtl::vector<QTableEntry> __tables;
+		uint64_t __version;
+
+		qtl::thread_pool* __pool;
+
+		QWal* __log;
+		bool __synchronous;
+		QWalTransaction __transaction;
+
+		QArena __arena;
+		QParser __parser;
+		QPlanner __planner;
+		QPlanCache __planCache;
+
+		void __release(QPlan* plan);
+
+		friend class QStatement;
+	};
+}
+
+#endif // qdatabase_h__
@@ -1,6 +1,11 @@
 #ifndef qdatatype_h__
 #define qdatatype_h__
 
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+
 namespace qsql
 {
 	enum class QDataType
@@ -11,6 +16,93 @@ namespace qsql
 		BOOL,
 		STRING,
 	};
+
+	template<QDataType Type>
+	struct QNativeType;
+
+	template<>
+	struct QNativeType<QDataType::CHAR>
+	{
+		typedef char type;
+	};
+
+	template<>
+	struct QNativeType<QDataType::INT>
+	{
+		typedef int32_t type;
+	};
+
+	template<>
+	struct QNativeType<QDataType::LONG>
+	{
+		typedef int64_t type;
+	};
+
+	template<>
+	struct QNativeType<QDataType::BOOL>
+	{
+		typedef bool type;
+	};
+
+	template<>
+	struct QNativeType<QDataType::STRING>
+	{
+		typedef qtl::string type;
+	};
+
+	inline std::size_t getDataTypeSize(const QDataType type)
+	{
+		switch (type)
+		{
+		case QDataType::CHAR:
+			return sizeof(QNativeType<QDataType::CHAR>::type);
+		case QDataType::INT:
+			return sizeof(QNativeType<QDataType::INT>::type);
+		case QDataType::LONG:
+			return sizeof(QNativeType<QDataType::LONG>::type);
+		case QDataType::BOOL:
+			return sizeof(QNativeType<QDataType::BOOL>::type);
+		case QDataType::STRING:
+			return sizeof(QNativeType<QDataType::STRING>::type);
+		}
+		return 0;
+	}
+
+	inline std::size_t getDataTypeAlignment(const QDataType type)
+	{
+		switch (type)
+		{
+		case QDataType::CHAR:
+			return alignof(QNativeType<QDataType::CHAR>::type);
+		case QDataType::INT:
+			return alignof(QNativeType<QDataType::INT>::type);
+		case QDataType::LONG:
+			return alignof(QNativeType<QDataType::LONG>::type);
+		case QDataType::BOOL:
+			return alignof(QNativeType<QDataType::BOOL>::type);
+		case QDataType::STRING:
+			return alignof(QNativeType<QDataType::STRING>::type);
+		}
+		return 1;
+	}
+
+	inline const char* getDataTypeName(const QDataType type)
+	{
+		switch (type)
+		{
+		case QDataType::CHAR:
+			return "CHAR";
+		case QDataType::INT:
+			return "INT";
+		case QDataType::LONG:
+			return "LONG";
+		case QDataType::BOOL:
+			return "BOOL";
+		case QDataType::STRING:
+			return "STRING";
+		}
+		return "";
+	}
 }
 
 #endif
@@ -0,0 +1,103 @@
+#ifndef qdictionary_h__
+#define qdictionary_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+namespace qsql
+{
+	class QVector;
+
+	// The distinct strings of a dictionary encoded column.  Each string is stored
+	// once and identified by a 32-bit code, assigned in order of first appearance
+	// and never reused.  Strings live in fixed-size chunks so that references to
+	// them stay valid while the dictionary grows, and are found by an open
+	// addressed table of codes.
+	//
+	// A single writer may encode while other threads decode codes they have
+	// read from a column, the chunk directory is replaced rather than resized
+	// so a decode never sees it move.
+	class QDictionary
+	{
+	public:
+		static constexpr uint32_t NONE = static_cast<uint32_t>(-1);
+		static constexpr std::size_t CHUNK_SHIFT = 10;
+		static constexpr std::size_t CHUNK_SIZE = static_cast<std::size_t>(1) << CHUNK_SHIFT;
+
+		QDictionary();
+		QDictionary(const QDictionary&) = delete;
+		~QDictionary();
+
+		QDictionary& operator=(const QDictionary&) = delete;
+
+		// Number of distinct strings
+		std::size_t size() const;
+
+		// Code of value, which is added if the dictionary does not hold it yet
+		uint32_t encode(const qtl::string& value);
+
+		// Code of value, NONE if the dictionary does not hold it
+		uint32_t find(const qtl::string& value) const;
+
+		const qtl::string& decode(const uint32_t code) const;
+	private:
+		// directories replaced by a larger one are kept until destruction
+		std::atomic<qtl::string**> __directory;
+		std::size_t __capacity;
+		qtl::vector<qtl::string**> __retired;
+		qtl::vector<std::size_t> __hashes;
+		uint32_t* __slots;
+		std::size_t __mask;
+		std::atomic<std::size_t> __size;
+
+		std::size_t __locate(const qtl::string& value, const std::size_t hash) const;
+		void __grow();
+	};
+
+	inline const qtl::string& QDictionary::decode(const uint32_t code) const
+	{
+		return __directory.load(std::memory_order_acquire)[code >> CHUNK_SHIFT][code & (CHUNK_SIZE - 1)];
+	}
+
+	// Outcome of a predicate for every string of a dictionary, so that a vector
+	// of codes is filtered with a table lookup per row instead of a string
+	// comparison.  The table is extended as the dictionary grows and rebuilt for
+	// another dictionary or after reset().
+	class QDictionaryFilter
+	{
+	public:
+		QDictionaryFilter();
+
+		void reset();
+
+		template<typename Predicate>
+		void update(const QDictionary& dictionary, Predicate predicate);
+
+		// Writes the rows of selection (or the first count rows) whose code
+		// matches to out, returning how many were written.  NULL never matches.
+		std::size_t select(const QVector& codes, const uint16_t* selection, const std::size_t count, uint16_t* out) const;
+	private:
+		const QDictionary* __dictionary;
+		qtl::vector<uint8_t> __matches;
+	};
+
+	template<typename Predicate>
+	inline void QDictionaryFilter::update(const QDictionary& dictionary, Predicate predicate)
+	{
+		if (__dictionary != &dictionary)
+		{
+			__dictionary = &dictionary;
+			__matches.clear();
+		}
+		for (std::size_t code = __matches.size(); code < dictionary.size(); code++)
+		{
+			__matches.push_back(predicate(dictionary.decode(static_cast<uint32_t>(code))) ? 1 : 0);
+		}
+	}
+}
+
+#endif // qdictionary_h__
@@ -0,0 +1,253 @@
+#ifndef qexpression_h__
+#define qexpression_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+#include "qsql/qbatch.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qdictionary.h"
+#include "qsql/qpredicate.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	enum class QArithmetic
+	{
+		ADD,
+		SUBTRACT,
+		MULTIPLY,
+		DIVIDE,
+		MODULO,
+	};
+
+	enum class QLogical
+	{
+		AND,
+		OR,
+	};
+
+	// Expressions are evaluated a whole batch at a time.  evaluate() computes the
+	// expression for every value of the batch, ignoring the selection, so the
+	// kernels are straight loops the compiler can vectorize.  select() evaluates
+	// a predicate for the rows listed in selection (or the first count rows when
+	// selection is nullptr) and writes the indexes of the rows that are TRUE to
+	// out, returning how many were written.  out may alias selection.
+	class QExpression
+	{
+	public:
+		virtual ~QExpression() = default;
+
+		virtual QDataType getType() const = 0;
+
+		// Non-null when the expression is a constant that can be used as a scalar operand
+		virtual const QValue* getConstant() const;
+
+		// Non-null when the expression reads a dictionary encoded column, the codes
+		// of the batch can then be used instead of the strings evaluate() decodes
+		virtual const QVector* getCodes(const QBatch& batch);
+
+		virtual const QVector& evaluate(const QBatch& batch) = 0;
+		virtual std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out);
+	};
+
+	class QColumnExpression : public QExpression
+	{
+	public:
+		QColumnExpression(const std::size_t column, const QDataType type);
+
+		std::size_t getColumn() const;
+
+		QDataType getType() const override;
+		const QVector* getCodes(const QBatch& batch) override;
+		const QVector& evaluate(const QBatch& batch) override;
+	private:
+		std::size_t __column;
+		QDataType __type;
+		QVector __decoded;
+	};
+
+	class QConstantExpression : public QExpression
+	{
+	public:
+		explicit QConstantExpression(const QValue& value);
+
+		QDataType getType() const override;
+		const QValue* getConstant() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+	private:
+		QValue __value;
+		QVector __vector;
+		bool __filled;
+	};
+
+	// A statement parameter.  The value lives in the prepared plan and is read
+	// each time the expression is evaluated, converted to the parameter's type.
+	class QParameterExpression : public QExpression
+	{
+	public:
+		QParameterExpression(const QValue& value, const QDataType type);
+
+		QDataType getType() const override;
+		const QValue* getConstant() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+	private:
+		const QValue& __value;
+		QDataType __type;
+		QVector __vector;
+	};
+
+	class QArithmeticExpression : public QExpression
+	{
+	public:
+		QArithmeticExpression(const QArithmetic op, QExpression* left, QExpression* right);
+		~QArithmeticExpression() override;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+	private:
+		QArithmetic __op;
+		QExpression* __left;
+		QExpression* __right;
+		QDataType __type;
+		QVector __result;
+		QVector __leftScratch;
+		QVector __rightScratch;
+	};
+
+	class QComparisonExpression : public QExpression
+	{
+	public:
+		QComparisonExpression(const QComparison op, QExpression* left, QExpression* right);
+		~QComparisonExpression() override;
+
+		QComparison getComparison() const;
+		QExpression* getLeft() const;
+		QExpression* getRight() const;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+		std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out) override;
+	private:
+		QComparison __op;
+		QExpression* __left;
+		QExpression* __right;
+		QDataType __operandType;
+		QVector __result;
+		QVector __leftScratch;
+		QVector __rightScratch;
+		uint16_t __indexes[QVector::CAPACITY];
+
+		// constant the code filter was built for, parameters change between executions
+		qtl::string __codeKey;
+		QDictionaryFilter __codeFilter;
+	};
+
+	// child BETWEEN low AND high, both bounds inclusive
+	class QBetweenExpression : public QExpression
+	{
+	public:
+		QBetweenExpression(QExpression* child, const QValue& low, const QValue& high);
+		~QBetweenExpression() override;
+
+		QExpression* getChild() const;
+		const QValue& getLow() const;
+		const QValue& getHigh() const;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+		std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out) override;
+	private:
+		QExpression* __child;
+		QValue __low;
+		QValue __high;
+		QDataType __operandType;
+		QVector __result;
+		QVector __scratch;
+		uint16_t __indexes[QVector::CAPACITY];
+		QDictionaryFilter __codeFilter;
+	};
+
+	// child IN (values...), NULL entries of the list never match
+	class QInExpression : public QExpression
+	{
+	public:
+		QInExpression(QExpression* child, const qtl::vector<QValue>& values);
+		~QInExpression() override;
+
+		QExpression* getChild() const;
+		const qtl::vector<QValue>& getValues() const;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+		std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out) override;
+	private:
+		QExpression* __child;
+		qtl::vector<QValue> __values;
+		QDataType __operandType;
+		bool __hasNull;
+
+		// the non-null values of the list converted to the operand type
+		qtl::vector<int32_t> __ints;
+		qtl::vector<int64_t> __longs;
+		qtl::vector<qtl::string> __strings;
+
+		QVector __result;
+		QVector __scratch;
+		uint16_t __indexes[QVector::CAPACITY];
+		QDictionaryFilter __codeFilter;
+	};
+
+	class QLogicalExpression : public QExpression
+	{
+	public:
+		QLogicalExpression(const QLogical op, QExpression* left, QExpression* right);
+		~QLogicalExpression() override;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+		std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out) override;
+	private:
+		QLogical __op;
+		QExpression* __left;
+		QExpression* __right;
+		QVector __result;
+		uint16_t __leftSelection[QVector::CAPACITY];
+		uint16_t __rest[QVector::CAPACITY];
+		uint16_t __rightSelection[QVector::CAPACITY];
+	};
+
+	// child IS NULL, or child IS NOT NULL when negated
+	class QIsNullExpression : public QExpression
+	{
+	public:
+		QIsNullExpression(QExpression* child, const bool negated);
+		~QIsNullExpression() override;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+		std::size_t select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out) override;
+	private:
+		QExpression* __child;
+		bool __negated;
+		QVector __result;
+	};
+
+	class QNotExpression : public QExpression
+	{
+	public:
+		explicit QNotExpression(QExpression* child);
+		~QNotExpression() override;
+
+		QDataType getType() const override;
+		const QVector& evaluate(const QBatch& batch) override;
+	private:
+		QExpression* __child;
+		QVector __result;
+	};
+}
+
+#endif // qexpression_h__
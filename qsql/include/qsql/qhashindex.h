@@ -0,0 +1,75 @@
+#ifndef qhashindex_h__
+#define qhashindex_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+#include "qsql/qdatatype.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QTable;
+
+	// Maps the values of a CHAR, INT, LONG or STRING column to the rows holding
+	// them.  Every distinct value owns one slot of an open addressed table and
+	// heads a chain of rows linked through a per-row array, so duplicates never
+	// lengthen probe sequences.  Integral values are hashed widened to 64 bits
+	// with qtl::hash, strings with qtl::hash<qtl::string> and compared against
+	// the table instead of being copied.  NULL is not indexed.
+	class QHashIndex
+	{
+	public:
+		QHashIndex(const QTable& table, const std::size_t column);
+		QHashIndex(const QHashIndex&) = delete;
+		~QHashIndex();
+
+		QHashIndex& operator=(const QHashIndex&) = delete;
+
+		static bool isSupported(const QDataType type);
+
+		std::size_t getColumn() const;
+
+		// Number of indexed rows and distinct values
+		std::size_t size() const;
+		std::size_t getKeyCount() const;
+
+		// Indexes or unindexes a row by its current value in the table.  A row
+		// has to be erased from the index before its value changes.
+		void insert(const std::size_t row);
+		void erase(const std::size_t row);
+
+		// Appends the rows holding value and returns how many were appended
+		std::size_t find(const QValue& value, qtl::vector<std::size_t>& rows) const;
+	private:
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+		struct QSlot
+		{
+			std::size_t hash;
+			int64_t key;
+			std::size_t head;
+		};
+
+		const QTable& __table;
+		std::size_t __column;
+		QDataType __type;
+		QSlot* __slots;
+		std::size_t __mask;
+		std::size_t __keys;
+		std::size_t __size;
+
+		// next row holding the same value, NONE at the end of a chain
+		qtl::vector<std::size_t> __next;
+
+		bool __key(const std::size_t row, std::size_t& hash, int64_t& key) const;
+		std::size_t __locate(const std::size_t hash, const int64_t key, const qtl::string* string) const;
+		void __grow();
+		void __remove(std::size_t slot);
+	};
+}
+
+#endif // qhashindex_h__
@@ -0,0 +1,91 @@
+#ifndef qlexer_h__
+#define qlexer_h__
+
+#include <cstddef>
+
+namespace qsql
+{
+	enum class QTokenType
+	{
+		END,
+		INVALID,
+		IDENTIFIER,
+		INTEGER,
+		STRING,
+		PARAMETER,
+
+		KEYWORD_AND,
+		KEYWORD_AS,
+		KEYWORD_ASC,
+		KEYWORD_BETWEEN,
+		KEYWORD_BY,
+		KEYWORD_DELETE,
+		KEYWORD_DESC,
+		KEYWORD_FALSE,
+		KEYWORD_FROM,
+		KEYWORD_GROUP,
+		KEYWORD_HAVING,
+		KEYWORD_IN,
+		KEYWORD_INNER,
+		KEYWORD_INSERT,
+		KEYWORD_INTO,
+		KEYWORD_IS,
+		KEYWORD_JOIN,
+		KEYWORD_LIMIT,
+		KEYWORD_NOT,
+		KEYWORD_NULL,
+		KEYWORD_OFFSET,
+		KEYWORD_ON,
+		KEYWORD_OR,
+		KEYWORD_ORDER,
+		KEYWORD_SELECT,
+		KEYWORD_SET,
+		KEYWORD_TRUE,
+		KEYWORD_UPDATE,
+		KEYWORD_VALUES,
+		KEYWORD_WHERE,
+
+		COMMA,
+		DOT,
+		SEMICOLON,
+		LEFT_PAREN,
+		RIGHT_PAREN,
+		STAR,
+		PLUS,
+		MINUS,
+		SLASH,
+		PERCENT,
+		EQUAL,
+		NOT_EQUAL,
+		LESS,
+		LESS_EQUAL,
+		GREATER,
+		GREATER_EQUAL,
+	};
+
+	// A token points into the text being lexed, nothing is copied.  The text of a
+	// STRING token excludes the quotes but still contains doubled '' escapes.
+	struct QToken
+	{
+		QTokenType type;
+		const char* text;
+		std::size_t length;
+		std::size_t position;
+	};
+
+	class QLexer
+	{
+	public:
+		QLexer(const char* text, const std::size_t length);
+
+		// Returns the next token, END once the text is exhausted and INVALID on a
+		// character that cannot start a token or an unterminated string
+		QToken next();
+	private:
+		const char* __text;
+		std::size_t __length;
+		std::size_t __position;
+	};
+}
+
+#endif // qlexer_h__
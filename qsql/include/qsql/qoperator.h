@@ -0,0 +1,737 @@
+#ifndef qoperator_h__
+#define qoperator_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <qtl/shared_ptr.h>
+#include <qtl/string.h>
+#include <qtl/vector.h>
+#include <qtl/thread/condition_variable.h>
+#include <qtl/thread/mpmc_queue.h>
+#include <qtl/thread/mutex.h>
+#include <qtl/thread/thread_pool.h>
+
+#include "qsql/qarena.h"
+#include "qsql/qartindex.h"
+#include "qsql/qbatch.h"
+#include "qsql/qbitmapindex.h"
+#include "qsql/qbloomfilter.h"
+#include "qsql/qbtreeindex.h"
+#include "qsql/qcolumn.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qexpression.h"
+#include "qsql/qhashindex.h"
+#include "qsql/qtable.h"
+
+namespace qsql
+{
+	// Physical operators form a pull based pipeline.  Each call to next() produces
+	// the operator's next batch, or nullptr once the input is exhausted.  A batch
+	// returned by next() stays valid until the following call.  reset() rewinds
+	// the pipeline so that a prepared plan can be run again.
+	class QOperator
+	{
+	public:
+		virtual ~QOperator() = default;
+
+		virtual std::size_t getColumnCount() const = 0;
+		virtual QDataType getColumnType(const std::size_t column) const = 0;
+
+		virtual QBatch* next() = 0;
+		virtual void reset() = 0;
+	};
+
+	// Hands out the rows of a table in morsels, pages of rows that the scans of
+	// a parallel plan claim one at a time so that faster workers take more.
+	class QMorselCursor
+	{
+	public:
+		static constexpr std::size_t MORSEL_SIZE = QTable::PAGE_ROWS;
+
+		QMorselCursor();
+		QMorselCursor(const QMorselCursor&) = delete;
+
+		QMorselCursor& operator=(const QMorselCursor&) = delete;
+
+		// Starts handing out the rows [0, rows), not while a scan claims morsels
+		void reset(const std::size_t rows);
+
+		// Claims the rows [first, end) of the next morsel, false once every row
+		// has been handed out
+		bool next(std::size_t& first, std::size_t& end);
+	private:
+		std::atomic<std::size_t> __next;
+		std::size_t __end;
+	};
+
+	// Produces the requested columns of a table.  Column-major tables are read
+	// in place, row-major tables are gathered into the batch's own vectors.
+	// Rows not visible to the snapshot, read on every call to next(), are left
+	// out of the batch's selection.  Given a morsel cursor the scan reads only
+	// the morsels it claims from it.
+	//
+	// Ranges given to the scan let it skip the pages whose zone map shows that
+	// none of their rows lie within them, without reading the pages, and keys
+	// the pages whose Bloom filter rules the key out.  A runtime filter, such
+	// as the one a hash join builds on its keys, drops the rows of each batch
+	// it rules out.
+	class QScanOperator : public QOperator
+	{
+	public:
+		QScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const uint64_t& snapshot, QMorselCursor* morsels = nullptr);
+		~QScanOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		// Skips pages where no value of column, a column of the table, lies
+		// between low and high.  A nullptr bound leaves that side open.  The
+		// bounds are read after each reset and a bound that is not an integer
+		// constant then leaves the range unused.  The scan owns the bounds.
+		void addRange(const std::size_t column, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive);
+
+		// Skips pages where no row holds key in column, a column of the table
+		// with Bloom filters.  Read and owned like the bounds of a range.
+		void addKey(const std::size_t column, QExpression* key);
+
+		// Drops the rows whose value of column, a column of the scan's output,
+		// is NULL or not in filter.  The filter is read from each batch on and
+		// has to outlive the scan.
+		void addRuntimeFilter(const std::size_t column, const QBloomFilter& filter);
+
+		QBatch* next() override;
+		void reset() override;
+
+		// The buffer pool's error once the scan could not pin a chunk read
+		// through it, next() then returns nullptr until the scan is reset.
+		// nullptr while the scan has not failed.
+		const char* getError() const;
+	private:
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+		const QTable& __table;
+		qtl::vector<std::size_t> __columns;
+		const uint64_t& __snapshot;
+		QMorselCursor* __morsels;
+		std::size_t __position;
+		QBatch __batch;
+
+		// rows the scan covers, fixed by its first batch since rows appended
+		// later belong to commits after the snapshot, or the end of the morsel
+		std::size_t __end;
+
+		// chunk whose pages stay pinned while batches reference it, and whether
+		// the pool had too few frames free for one
+		std::size_t __pinned;
+		bool __failed;
+
+		struct QScanRange
+		{
+			std::size_t column;
+			QExpression* low;
+			bool lowInclusive;
+			QExpression* high;
+			bool highInclusive;
+		};
+		qtl::vector<QScanRange> __ranges;
+
+		struct QScanKey
+		{
+			std::size_t column;
+			QExpression* key;
+		};
+		qtl::vector<QScanKey> __keys;
+
+		struct QRuntimeFilter
+		{
+			std::size_t column;
+			const QBloomFilter* filter;
+		};
+		qtl::vector<QRuntimeFilter> __filters;
+
+		// column, low and high of each range in use and column and hash of each
+		// key, read by the first batch
+		qtl::vector<int64_t> __bounds;
+		qtl::vector<uint64_t> __hashes;
+		bool __bounded;
+
+		bool __pin(const std::size_t chunk);
+		void __unpin();
+		void __bound();
+		bool __isOutside(const std::size_t page) const;
+		void __applyFilters();
+	};
+
+	// Produces the rows of a table whose indexed column equals a constant.  The
+	// key is read and looked up in the column's hash index after each reset, so
+	// it may be a statement parameter.  Rows come out in table order.
+	class QIndexScanOperator : public QOperator
+	{
+	public:
+		QIndexScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QHashIndex& index, QExpression* key, const uint64_t& snapshot);
+		~QIndexScanOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		const QTable& __table;
+		qtl::vector<std::size_t> __columns;
+		const QHashIndex& __index;
+		QExpression* __key;
+		const uint64_t& __snapshot;
+		qtl::vector<std::size_t> __rows;
+		std::size_t __position;
+		bool __found;
+		QBatch __batch;
+	};
+
+	// A predicate answered by bitmap indexes.  A leaf holds the rows of an
+	// indexed column that equal a key, or when negated the indexed rows that do
+	// not, so NULLs satisfy neither; an inner node is the AND or OR of its
+	// children.  Keys are read when the condition is evaluated.
+	class QBitmapCondition
+	{
+	public:
+		QBitmapCondition(const QBitmapIndex& index, QExpression* key, const bool negated);
+		QBitmapCondition(const QLogical op, QBitmapCondition* left, QBitmapCondition* right);
+		QBitmapCondition(const QBitmapCondition&) = delete;
+		~QBitmapCondition();
+
+		QBitmapCondition& operator=(const QBitmapCondition&) = delete;
+
+		// Sets rows to the rows satisfying the condition, false if a key is not
+		// constant or cannot be looked up
+		bool evaluate(QRoaringBitmap& rows) const;
+	private:
+		const QBitmapIndex* __index;
+		QExpression* __key;
+		bool __negated;
+		QLogical __op;
+		QBitmapCondition* __left;
+		QBitmapCondition* __right;
+	};
+
+	// Produces the rows of a table that may satisfy a QBitmapCondition, in table
+	// order.  The condition is evaluated after each reset, and if it cannot be
+	// every row is produced, so a filter above has to check the predicate.
+	class QBitmapScanOperator : public QOperator
+	{
+	public:
+		QBitmapScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, QBitmapCondition* condition, const uint64_t& snapshot);
+		~QBitmapScanOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		const QTable& __table;
+		qtl::vector<std::size_t> __columns;
+		QBitmapCondition* __condition;
+		const uint64_t& __snapshot;
+		QRoaringBitmap __matches;
+		bool __evaluated;
+		bool __every;
+		std::size_t __position;
+		std::size_t __rows[QBatch::CAPACITY];
+		QBatch __batch;
+	};
+
+	// Produces the rows of a table whose indexed column lies between two
+	// constants, in the column's order or its reverse.  A nullptr bound leaves
+	// that side of the range open.  The bounds are read after each reset and the
+	// index is walked one batch at a time, so a LIMIT above stops the walk early.
+	// The index is either a B+tree or an adaptive radix tree.
+	class QIndexRangeScanOperator : public QOperator
+	{
+	public:
+		QIndexRangeScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QBTreeIndex& index, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending, const uint64_t& snapshot);
+		QIndexRangeScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QArtIndex& index, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending, const uint64_t& snapshot);
+		~QIndexRangeScanOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		const QTable& __table;
+		qtl::vector<std::size_t> __columns;
+		const QBTreeIndex* __index;
+		const QArtIndex* __art;
+		QExpression* __low;
+		QExpression* __high;
+		bool __lowInclusive;
+		bool __highInclusive;
+		bool __descending;
+		const uint64_t& __snapshot;
+		bool __opened;
+		QBTreeRange __range;
+		QArtRange __artRange;
+		std::size_t __rows[QBatch::CAPACITY];
+		QBatch __batch;
+	};
+
+	class QFilterOperator : public QOperator
+	{
+	public:
+		QFilterOperator(QOperator* child, QExpression* predicate);
+		~QFilterOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QOperator* __child;
+		QExpression* __predicate;
+	};
+
+	class QProjectionOperator : public QOperator
+	{
+	public:
+		QProjectionOperator(QOperator* child, const qtl::vector<QExpression*>& expressions);
+		~QProjectionOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QOperator* __child;
+		qtl::vector<QExpression*> __expressions;
+		QBatch __batch;
+	};
+
+	// Runs copies of a pipeline on the workers of a pool and produces their
+	// batches as they come, so rows come out in no particular order.  The scans
+	// of the copies share a morsel cursor.  A batch belongs to the copy that
+	// produced it, so each copy runs as a task that produces a single batch and
+	// is submitted again once the reader moves past it, never holding a worker
+	// while it waits.  A table of a single morsel is read by the first copy on
+	// the calling thread.
+	class QGatherOperator : public QOperator
+	{
+	public:
+		// Takes ownership of the pipelines and of the cursor their scans share
+		QGatherOperator(const QTable& table, const qtl::vector<QOperator*>& pipelines, QMorselCursor* morsels, qtl::thread_pool& pool);
+		~QGatherOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+		const QTable& __table;
+		qtl::vector<QOperator*> __pipelines;
+		QMorselCursor* __morsels;
+		qtl::thread_pool& __pool;
+		bool __started;
+
+		// false while the first pipeline runs on the calling thread
+		bool __parallel;
+
+		// batch produced by each copy's last task
+		qtl::vector<QBatch*> __handed;
+
+		// copies whose tasks have finished, pushed by the tasks, and the copy
+		// whose batch is being read.  A copy without a batch has run out of rows.
+		qtl::mpmc_queue<std::size_t> __ready;
+		std::size_t __reading;
+
+		// tasks the reader has not taken from the queue, and tasks that have
+		// not returned, counted under __mutex
+		std::size_t __pending;
+		std::size_t __active;
+
+		// signalled by each task as it returns, the reader sleeps on it while
+		// nothing is queued
+		qtl::mutex __mutex;
+		qtl::condition_variable __produced;
+
+		void __start();
+		void __stop();
+		void __submit(const std::size_t copy);
+		void __run(const std::size_t copy);
+		bool __take(std::size_t& copy);
+	};
+
+	// Produces a single row without columns, the input of a SELECT without FROM
+	class QSingleRowOperator : public QOperator
+	{
+	public:
+		QSingleRowOperator();
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QBatch __batch;
+		bool __done;
+	};
+
+	// Materializes its whole input and produces it ordered by the key expressions.
+	// NULL sorts after every other value and rows with equal keys keep their
+	// input order.  The materialized rows live in the scratch arena of the plan,
+	// which is rewound only after the operator has been reset.
+	class QSortOperator : public QOperator
+	{
+	public:
+		QSortOperator(QOperator* child, const qtl::vector<QExpression*>& keys, const qtl::vector<bool>& descending, QArena& scratch);
+		~QSortOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QOperator* __child;
+		qtl::vector<QExpression*> __keys;
+		qtl::vector<bool> __descending;
+		qtl::vector<QColumn*> __columns;
+		qtl::vector<QColumn*> __keyColumns;
+		QArena& __scratch;
+		uint32_t* __order;
+		std::size_t __rows;
+		std::size_t __position;
+		bool __sorted;
+		QBatch __batch;
+
+		void __materialize();
+		void __clear();
+		int __compare(const uint32_t left, const uint32_t right) const;
+	};
+
+	// The rows of a join's build input in a hash table on the join key, shared by
+	// the copies of a parallel join.  Keys are either strings or numbers widened
+	// to LONG, and rows with a NULL key never match so they are left out.  The
+	// entries are radix partitioned on the top bits of their hash into
+	// partitions small enough to stay in the L2 cache while they are probed.
+	// A Bloom filter of the keys lets the probe side's scan drop rows that
+	// cannot match before they reach the join.
+	class QJoinHashTable
+	{
+	public:
+		static constexpr uint32_t NONE = UINT32_MAX;
+		static constexpr std::size_t PARTITION_SIZE = static_cast<std::size_t>(256) << 10;
+		static constexpr std::size_t MAX_PARTITION_BITS = 10;
+
+		// Takes ownership of the input and of the key evaluated on its batches.
+		// columns are the input columns kept for the join's result.
+		QJoinHashTable(QOperator* input, QExpression* key, const qtl::vector<std::size_t>& columns);
+		QJoinHashTable(const QJoinHashTable&) = delete;
+		~QJoinHashTable();
+
+		QJoinHashTable& operator=(const QJoinHashTable&) = delete;
+
+		// Reads the whole input once after each reset.  Every copy of a join
+		// calls it, the first one builds the table while the others wait.
+		void build();
+		void reset();
+
+		std::size_t size() const;
+		std::size_t getPartitionCount() const;
+		std::size_t getPartition(const uint64_t hash) const;
+
+		// Kept columns of the build rows, in input order
+		QDataType getColumnType(const std::size_t column) const;
+		const QColumn& getColumn(const std::size_t column) const;
+
+		// First entry in the bucket of hash, NONE if it is empty.  The entries
+		// of a bucket are chained through next().
+		uint32_t find(const uint64_t hash) const;
+		uint32_t next(const uint32_t entry) const;
+		bool matches(const uint32_t entry, const uint64_t hash, const int64_t key) const;
+		bool matches(const uint32_t entry, const uint64_t hash, const qtl::string& key) const;
+
+		// Build row of an entry, a row of the kept columns
+		uint32_t getRow(const uint32_t entry) const;
+
+		// Filter of the keys' hashes, which may contain every key until build()
+		const QBloomFilter& getFilter() const;
+
+		static uint64_t hashKey(const int64_t key);
+		static uint64_t hashString(const qtl::string& key);
+	private:
+		struct QJoinEntry
+		{
+			uint64_t hash;
+			int64_t key;
+			uint32_t row;
+			uint32_t next;
+		};
+
+		QOperator* __input;
+		QExpression* __key;
+		qtl::vector<std::size_t> __kept;
+		qtl::vector<QDataType> __types;
+
+		qtl::mutex __mutex;
+		std::atomic<bool> __built;
+
+		// build rows in input order, with their keys and the hashes of the keys
+		qtl::vector<QColumn*> __columns;
+		QColumn* __stringKeys;
+		qtl::vector<int64_t> __keys;
+		qtl::vector<uint64_t> __hashes;
+
+		// entries grouped by partition, each partition with its own buckets
+		std::size_t __partitionBits;
+		qtl::vector<QJoinEntry> __entries;
+		qtl::vector<uint32_t> __buckets;
+		qtl::vector<uint32_t> __bucketStarts;
+		qtl::vector<uint32_t> __bucketMasks;
+
+		QBloomFilter __filter;
+
+		void __materialize();
+		void __partition();
+		void __clear();
+	};
+
+	inline uint32_t QJoinHashTable::find(const uint64_t hash) const
+	{
+		const std::size_t partition = getPartition(hash);
+		return __buckets[__bucketStarts[partition] + (hash & __bucketMasks[partition])];
+	}
+
+	inline uint32_t QJoinHashTable::next(const uint32_t entry) const
+	{
+		return __entries[entry].next;
+	}
+
+	inline bool QJoinHashTable::matches(const uint32_t entry, const uint64_t hash, const int64_t key) const
+	{
+		return __entries[entry].hash == hash && __entries[entry].key == key;
+	}
+
+	inline bool QJoinHashTable::matches(const uint32_t entry, const uint64_t hash, const qtl::string& key) const
+	{
+		return __entries[entry].hash == hash && *static_cast<const qtl::string*>(__stringKeys->at(__entries[entry].row)) == key;
+	}
+
+	inline uint32_t QJoinHashTable::getRow(const uint32_t entry) const
+	{
+		return __entries[entry].row;
+	}
+
+	inline std::size_t QJoinHashTable::getPartition(const uint64_t hash) const
+	{
+		return __partitionBits ? static_cast<std::size_t>(hash >> (64 - __partitionBits)) : 0;
+	}
+
+	// Inner equi-join of its probe input with the rows of a hash table built on
+	// the other input.  The rows of each probe batch are ordered by partition
+	// before the table is probed, so consecutive lookups stay in one partition.
+	// Matching pairs are gathered into batches of the result's columns, each
+	// taken from the probe row or the build row.
+	class QHashJoinOperator : public QOperator
+	{
+	public:
+		// A result column, a column of the probe input or a kept column of the table
+		struct QJoinColumn
+		{
+			bool build;
+			std::size_t column;
+		};
+
+		// Takes ownership of the probe input and of the key evaluated on its batches
+		QHashJoinOperator(QOperator* probe, QExpression* key, const qtl::shared_ptr<QJoinHashTable>& table, const qtl::vector<QJoinColumn>& columns);
+		~QHashJoinOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QOperator* __probe;
+		QExpression* __key;
+		qtl::shared_ptr<QJoinHashTable> __table;
+		qtl::vector<QJoinColumn> __columns;
+		QBatch __batch;
+
+		// probe batch being joined, its keys, and its rows with a key ordered by partition
+		QBatch* __input;
+		const QVector* __keys;
+		uint16_t __rows[QBatch::CAPACITY];
+		uint64_t __hashes[QBatch::CAPACITY];
+		std::size_t __count;
+		qtl::vector<uint32_t> __partitionCounts;
+
+		// row of __rows being matched and the next entry of its chain
+		std::size_t __position;
+		uint32_t __entry;
+		bool __chained;
+
+		// matching pairs of the batch being produced
+		uint16_t __probeRows[QBatch::CAPACITY];
+		uint32_t __buildRows[QBatch::CAPACITY];
+
+		void __prepare();
+		std::size_t __match();
+		void __produce(const std::size_t count);
+	};
+
+	enum class QAggregateFunction
+	{
+		COUNT,
+		SUM,
+		MIN,
+		MAX,
+		AVG,
+	};
+
+	// An aggregate call, argument is nullptr for COUNT(*)
+	struct QAggregate
+	{
+		QAggregateFunction function;
+		QExpression* argument;
+	};
+
+	enum class QAggregateMode
+	{
+		// rows in, aggregates out
+		COMPLETE,
+
+		// rows in, states out, the pre-aggregation each worker of a parallel plan runs on its own rows
+		PARTIAL,
+
+		// states in, aggregates out, merging the states of the workers
+		FINAL,
+	};
+
+	// Groups its input by the key expressions in a hash table and accumulates
+	// aggregates per group a batch at a time: the groups of a batch's rows are
+	// looked up first, then each aggregate is updated over the whole batch.
+	// NULL keys form a group of their own and NULL arguments are skipped.  SUM
+	// and AVG are LONG, AVG rounds toward zero.  Without keys a single row is
+	// produced, even for an empty input.
+	//
+	// The state of an aggregate is its count for COUNT, its count and sum for SUM
+	// and AVG, and its value for MIN and MAX.  A PARTIAL aggregation produces the
+	// keys followed by the state columns of each aggregate, which a FINAL one reads.
+	//
+	// Once its groups outgrow the memory budget a PARTIAL aggregation produces
+	// them and starts over.  The others spill their states by hash into
+	// SPILL_PARTITIONS temporary files and, once the input is exhausted,
+	// aggregate each file on its own.
+	class QHashAggregateOperator : public QOperator
+	{
+	public:
+		static constexpr std::size_t MEMORY_BUDGET = static_cast<std::size_t>(64) << 20;
+		static constexpr std::size_t SPILL_BITS = 4;
+		static constexpr std::size_t SPILL_PARTITIONS = static_cast<std::size_t>(1) << SPILL_BITS;
+
+		// Takes ownership of the child and of the expressions.  A FINAL aggregation
+		// reads keys and states from its child's columns, its keys only give
+		// their types and its aggregates have no argument.
+		QHashAggregateOperator(QOperator* child, const qtl::vector<QExpression*>& keys, const qtl::vector<QAggregate>& aggregates, const QAggregateMode mode, const std::size_t budget = MEMORY_BUDGET);
+		~QHashAggregateOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		static constexpr uint32_t NONE = UINT32_MAX;
+		static constexpr std::size_t INITIAL_SLOTS = 256;
+
+		QOperator* __child;
+		qtl::vector<QExpression*> __keys;
+		qtl::vector<QAggregate> __aggregates;
+		QAggregateMode __mode;
+
+		// type of each key, of each aggregate's value, and the state columns of
+		// each aggregate in a row of states
+		qtl::vector<QDataType> __keyTypes;
+		qtl::vector<QDataType> __valueTypes;
+		qtl::vector<std::size_t> __stateColumns;
+		std::size_t __stateColumnCount;
+		std::size_t __maxGroups;
+
+		// groups: their keys and hashes, the hash table's slots, and per group the
+		// count and sum of each aggregate and the value of each MIN and MAX
+		qtl::vector<QColumn*> __keyColumns;
+		qtl::vector<uint64_t> __hashes;
+		qtl::vector<uint32_t> __slots;
+		qtl::vector<int64_t> __counts;
+		qtl::vector<int64_t> __sums;
+		qtl::vector<QColumn*> __values;
+
+		// rows of the batch being accumulated, their hashes and groups
+		qtl::vector<const QVector*> __keyVectors;
+		uint16_t __rows[QBatch::CAPACITY];
+		uint64_t __rowHashes[QBatch::CAPACITY];
+		uint32_t __groups[QBatch::CAPACITY];
+
+		// rows of states spilled to temporary files, the bytes written to each,
+		// and the partition read next
+		qtl::vector<FILE*> __spillFiles;
+		qtl::vector<long> __spillSizes;
+		bool __spilled;
+		std::size_t __partition;
+		QBatch __spillBatch;
+
+		bool __consumed;
+		bool __exhausted;
+		std::size_t __position;
+		QBatch __batch;
+
+		void __consume();
+		void __accumulate(const QBatch& batch, const bool states);
+		void __findGroups(const std::size_t count);
+		uint32_t __addGroup(const uint16_t row, const uint64_t hash);
+		void __update(const std::size_t aggregate, const QVector& argument, const std::size_t count);
+		void __merge(const std::size_t aggregate, const QBatch& batch, const std::size_t count);
+		void __produce(const std::size_t count);
+		bool __spill();
+		void __load(const std::size_t partition);
+		void __clear();
+		void __closeSpill();
+		QDataType __stateType(const std::size_t column) const;
+	};
+
+	// Skips the first offset rows of its input and stops after limit rows.  Both
+	// are read from constant expressions each time the operator is reset, so
+	// they may be statement parameters.
+	class QLimitOperator : public QOperator
+	{
+	public:
+		QLimitOperator(QOperator* child, QExpression* limit, QExpression* offset);
+		~QLimitOperator() override;
+
+		std::size_t getColumnCount() const override;
+		QDataType getColumnType(const std::size_t column) const override;
+
+		QBatch* next() override;
+		void reset() override;
+	private:
+		QOperator* __child;
+		QExpression* __limit;
+		QExpression* __offset;
+		std::size_t __remaining;
+		std::size_t __skip;
+		bool __initialized;
+
+		void __initialize();
+	};
+}
+
+#endif // qoperator_h__
@@ -0,0 +1,75 @@
+#ifndef qparser_h__
+#define qparser_h__
+
+#include <cstddef>
+
+#include <qtl/string.h>
+
+#include "qsql/qarena.h"
+#include "qsql/qast.h"
+#include "qsql/qlexer.h"
+
+namespace qsql
+{
+	// Recursive descent parser for SELECT, INSERT, UPDATE and DELETE.  The syntax
+	// tree is allocated in arena and may point into the statement text, so both
+	// have to outlive it.  Parsing allocates nothing outside of the arena.
+	class QParser
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+		// Deepest expression a statement may hold, counting parentheses, prefix
+		// operators and chained binary operators.  Deeper ones are rejected
+		// before parsing or binding them exhausts the stack.
+		static constexpr std::size_t MAX_DEPTH = 256;
+
+		explicit QParser(QArena& arena);
+
+		// Parses a single statement, optionally followed by a semicolon.  Returns
+		// nullptr on a syntax error, which is then described by getError().
+		QAstStatement* parse(const char* text, const std::size_t length);
+		QAstStatement* parse(const qtl::string& text);
+
+		const char* getError() const;
+		std::size_t getErrorPosition() const;
+	private:
+		QArena& __arena;
+		const char* __text;
+		QLexer __lexer;
+		QToken __token;
+		std::size_t __parameterCount;
+		std::size_t __depth;
+		bool __failed;
+		char __error[ERROR_LENGTH];
+		std::size_t __errorPosition;
+
+		void __advance();
+		bool __accept(const QTokenType type);
+		bool __expect(const QTokenType type, const char* message);
+		void __fail(const char* message);
+		bool __nest();
+
+		QAstStatement* __parseSelect();
+		QAstStatement* __parseInsert();
+		QAstStatement* __parseUpdate();
+		QAstStatement* __parseDelete();
+
+		bool __parseIdentifier(QAstText& name, const char* message);
+		QAstExpression* __parseList();
+		QAstText __unescape(const QToken& token, const char quote);
+
+		QAstExpression* __parseExpression();
+		QAstExpression* __parseAnd();
+		QAstExpression* __parseNot();
+		QAstExpression* __parsePredicate();
+		QAstExpression* __parseAdditive();
+		QAstExpression* __parseMultiplicative();
+		QAstExpression* __parseUnary();
+		QAstExpression* __parsePrimary();
+		QAstExpression* __parseInteger(const bool negative);
+
+		QAstExpression* __node(const QAstExpressionType type, const std::size_t position);
+	};
+}
+
+#endif // qparser_h__
@@ -0,0 +1,146 @@
+#ifndef qplan_h__
+#define qplan_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+#include "qsql/qarena.h"
+#include "qsql/qbatch.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qexpression.h"
+#include "qsql/qoperator.h"
+#include "qsql/qtable.h"
+#include "qsql/qvalue.h"
+#include "qsql/qwal.h"
+
+namespace qsql
+{
+	enum class QPlanType
+	{
+		SELECT_PLAN,
+		INSERT_PLAN,
+		UPDATE_PLAN,
+		DELETE_PLAN,
+	};
+
+	// Physical plan of a prepared statement, built once by QPlanner and executed
+	// any number of times.  Parameter values are kept in slots owned by the plan
+	// that the plan's expressions read on every execution, so rebinding a
+	// parameter never touches the operator tree.
+	class QPlan
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+		static constexpr std::size_t SCRATCH_CHUNK_SIZE = static_cast<std::size_t>(1) << 20;
+
+		QPlan(const QPlanType type, QTable* table, const std::size_t parameterCount);
+		QPlan(const QPlan&) = delete;
+		~QPlan();
+
+		QPlan& operator=(const QPlan&) = delete;
+
+		QPlanType getType() const;
+		QTable* getTable() const;
+
+		// Normalized statement text the plan is cached under, and the database
+		// version it was planned against
+		const qtl::string& getKey() const;
+		void setKey(const qtl::string& key, const uint64_t version);
+		uint64_t getVersion() const;
+
+		std::size_t getParameterCount() const;
+		QDataType getParameterType(const std::size_t parameter) const;
+
+		// Returns false if the index is out of range or the value cannot be
+		// converted to the parameter's type
+		bool setParameter(const std::size_t parameter, const QValue& value);
+		void clearParameters();
+
+		// Result columns of a SELECT
+		std::size_t getColumnCount() const;
+		QDataType getColumnType(const std::size_t column) const;
+		const qtl::string& getColumnName(const std::size_t column) const;
+
+		// Runs an INSERT, UPDATE or DELETE to completion as a single write of the
+		// table, or rewinds a SELECT so that its rows can be pulled with next().
+		// A SELECT reads a snapshot of the table taken here, which is held until
+		// next() has returned every row.  Returns false and leaves the table
+		// untouched if a parameter is unbound or a value cannot be stored.
+		// Changes are appended to log, if given, before they are applied, and
+		// when synchronous the log is flushed first too.
+		bool execute(QWal* log = nullptr, const bool synchronous = true);
+		std::size_t getAffectedRows() const;
+
+		// End of the log records written by the last execution, 0 if it wrote none
+		uint64_t getLogPosition() const;
+		QBatch* next();
+
+		const char* getError() const;
+	private:
+		QPlanType __type;
+		QTable* __table;
+		qtl::string __tableName;
+		qtl::string __key;
+		uint64_t __version;
+
+		QValue* __parameters;
+		qtl::vector<QDataType> __parameterTypes;
+		qtl::vector<bool> __bound;
+
+		// SELECT produces the rows of root, UPDATE and DELETE modify the rows it produces
+		QOperator* __root;
+		qtl::vector<qtl::string> __columnNames;
+
+		// scans of root, which end early if they cannot pin a chunk of a buffer pool
+		qtl::vector<const QScanOperator*> __scans;
+
+		// memory operators need for a single execution, such as the rows a sort
+		// materializes, rewound in one step when the plan is executed again
+		QArena __scratch;
+
+		// snapshot the scans read, valid while __reading
+		uint64_t __snapshot;
+		bool __reading;
+
+		// INSERT, rows of getColumnCount() values where each value is a parameter slot or a literal
+		qtl::vector<const QValue*> __insertValues;
+		qtl::vector<QValue*> __literals;
+		QValue __nullValue;
+		qtl::vector<QValue> __row;
+
+		// UPDATE, the assigned table columns and their values evaluated on the rows of root
+		qtl::vector<std::size_t> __assignedColumns;
+		qtl::vector<QExpression*> __assignedValues;
+		qtl::vector<const QVector*> __vectors;
+
+		// UPDATE and DELETE, rows collected before the table is modified
+		qtl::vector<std::size_t> __rows;
+		qtl::vector<QValue> __values;
+
+		// INSERT, UPDATE and DELETE, the changes of an execution as they are logged
+		QWalTransaction __transaction;
+		uint64_t __logPosition;
+
+		std::size_t __affectedRows;
+		bool __executed;
+		char __error[ERROR_LENGTH];
+
+		bool __executeInsert(QWal* log, const bool synchronous);
+		bool __executeUpdate(QWal* log, const bool synchronous);
+		bool __executeDelete(QWal* log, const bool synchronous);
+		bool __isScanFailed();
+		void __fillRow(const std::size_t row);
+		bool __writeLog(QWal* log, const bool synchronous);
+		void __rewind();
+		void __acquire();
+		void __release();
+		void __fail(const char* format, const std::size_t value);
+
+		friend class QPlanner;
+	};
+}
+
+#endif // qplan_h__
@@ -0,0 +1,67 @@
+#ifndef qplancache_h__
+#define qplancache_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+
+#include "qsql/qplan.h"
+
+namespace qsql
+{
+	// Keeps the plans of prepared statements that are not in use, keyed by the
+	// normalized statement text.  A plan is checked out by acquire() while a
+	// statement executes it and handed back by release(), so a plan is never
+	// shared between two statements.  The table is open addressed with linear
+	// probing and evicts the least recently released plan once it is full.
+	class QPlanCache
+	{
+	public:
+		static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+		explicit QPlanCache(const std::size_t capacity = DEFAULT_CAPACITY);
+		QPlanCache(const QPlanCache&) = delete;
+		~QPlanCache();
+
+		QPlanCache& operator=(const QPlanCache&) = delete;
+
+		// Removes and returns the plan cached for key, or nullptr.  Plans built
+		// against another database version are dropped instead of returned.
+		QPlan* acquire(const qtl::string& key, const uint64_t version);
+
+		// Caches plan under its key, taking ownership of it
+		void release(QPlan* plan, const uint64_t version);
+
+		void clear();
+
+		std::size_t size() const;
+		std::size_t getCapacity() const;
+		std::size_t getHits() const;
+		std::size_t getMisses() const;
+
+		// Rewrites a statement so that statements differing only in whitespace,
+		// comments and keyword case get the same key
+		static qtl::string normalize(const qtl::string& text);
+	private:
+		struct QEntry
+		{
+			QPlan* plan;
+			std::size_t hash;
+			uint64_t lastUsed;
+		};
+
+		QEntry* __entries;
+		std::size_t __mask;
+		std::size_t __capacity;
+		std::size_t __size;
+		uint64_t __clock;
+		std::size_t __hits;
+		std::size_t __misses;
+
+		std::size_t __find(const qtl::string& key, const std::size_t hash) const;
+		void __remove(std::size_t slot);
+	};
+}
+
+#endif // qplancache_h__
@@ -0,0 +1,182 @@
+#ifndef qplanner_h__
+#define qplanner_h__
+
+#include <cstddef>
+
+#include <qtl/shared_ptr.h>
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+#include "qsql/qast.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qexpression.h"
+#include "qsql/qoperator.h"
+#include "qsql/qplan.h"
+#include "qsql/qtable.h"
+
+namespace qsql
+{
+	class QDatabase;
+
+	// Binds a syntax tree against the tables of a database and builds its
+	// physical plan.  Names are resolved case insensitively.  The type of a
+	// parameter is inferred from where it appears: the other operand of a
+	// comparison or arithmetic, the assigned or inserted column, and LONG when
+	// nothing constrains it.
+	class QPlanner
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+
+		explicit QPlanner(QDatabase& database);
+
+		// Returns nullptr if the statement does not bind, which is then described by getError()
+		QPlan* plan(const QAstStatement& statement);
+
+		const char* getError() const;
+	private:
+		// A column of a SELECT result, either an expression or a table column expanded from *
+		struct QOutputColumn
+		{
+			const QAstExpression* expression;
+			std::size_t column;
+			qtl::string name;
+
+			// table of a join the column belongs to, 1 for the joined table
+			std::size_t side;
+		};
+
+		// What column expressions index into while a join is bound: the scan
+		// columns of one of its tables, or the columns of the join's result
+		enum class QBinding
+		{
+			TABLE,
+			JOINED_TABLE,
+			JOIN_RESULT,
+		};
+
+		// A column of a join's result, the column of one of its tables
+		struct QJoinSource
+		{
+			std::size_t side;
+			std::size_t column;
+		};
+
+		// Bounds that a WHERE clause puts on a B+tree indexed column, nullptr where it is open
+		struct QIndexRange
+		{
+			const QAstExpression* low;
+			bool lowInclusive;
+			const QAstExpression* high;
+			bool highInclusive;
+		};
+
+		QDatabase& __database;
+		QPlan* __plan;
+		QTable* __table;
+		QAstText __tableName;
+
+		// table columns read by the scan, bound column expressions index into this list
+		qtl::vector<std::size_t> __scanColumns;
+
+		// SELECT with a JOIN, the joined table and its scan columns.  Conjuncts of
+		// ON and WHERE that read a single table filter its scan, the equality of
+		// a key of each table joins them, and the rest filter the joined rows.
+		QTable* __joinTable;
+		QAstText __joinName;
+		qtl::vector<std::size_t> __joinScanColumns;
+		QBinding __binding;
+		qtl::vector<QJoinSource> __joinSources;
+		qtl::vector<const QAstExpression*> __joinFilters[2];
+		qtl::vector<const QAstExpression*> __joinResidual;
+		const QAstExpression* __joinKeys[2];
+
+		// side whose rows are built into the hash table, which the copies of a
+		// parallel join share
+		std::size_t __buildSide;
+		qtl::shared_ptr<QJoinHashTable> __joinHash;
+
+		// SELECT with GROUP BY, HAVING or aggregates: its group keys and the
+		// aggregate calls it makes, and the type of each of them.  While
+		// __aggregated is set expressions are bound above the aggregation, where
+		// keys and calls are its columns in that order.
+		bool __grouped;
+		bool __aggregated;
+		qtl::vector<const QAstExpression*> __groupKeys;
+		qtl::vector<const QAstExpression*> __aggregateCalls;
+		qtl::vector<QDataType> __groupTypes;
+
+		// set by __scan() when its rows already come out in the requested order
+		bool __ordered;
+
+		// set by __scan() when it reads the morsels of the cursor it was given
+		bool __shared;
+
+		bool __failed;
+		char __error[ERROR_LENGTH];
+
+		QPlan* __planSelect(const QAstStatement& statement);
+		QPlan* __planInsert(const QAstStatement& statement);
+		QPlan* __planUpdate(const QAstStatement& statement);
+		QPlan* __planDelete(const QAstStatement& statement);
+
+		void __checkPool(const QTable* table, const qtl::vector<std::size_t>& columns);
+		std::size_t __findColumn(const QAstText& name) const;
+		std::size_t __findColumn(const QTable& table, const QAstText& name) const;
+		QOperator* __scan(const QAstExpression* where, const std::size_t order = QSchema::npos, const bool descending = false, QMorselCursor* morsels = nullptr);
+		// Walk of an ordered index over column, which has to have one
+		QOperator* __rangeScan(const std::size_t column, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending);
+
+		// Another scan of the cursor's morsels filtered by where, and projected to outputs if project is set
+		QOperator* __copyPipeline(const QAstExpression* where, const qtl::vector<QOutputColumn>& outputs, QMorselCursor* morsels, const bool project);
+		// Pipeline of a join up to the join itself, whose probe scan reads the cursor's morsels if given
+		QOperator* __join(QMorselCursor* morsels);
+		// Aggregation of input bound in mode, FINAL reads the columns of a PARTIAL one
+		QOperator* __aggregate(QOperator* input, const QAggregateMode mode);
+		const QAstExpression* __findIndexKey(const QAstExpression* expression, std::size_t& column) const;
+		// Condition the bitmap indexes answer for expression, or for its negation,
+		// that holds for at least the rows satisfying it, nullptr if there is none
+		QBitmapCondition* __bindBitmap(const QAstExpression* expression, const bool negated);
+		void __findRange(const QAstExpression* expression, std::size_t& column, QIndexRange& range) const;
+		// Column of a conjunct that compares it to literals or parameters, with the bounds it puts on it
+		const QAstExpression* __findBounds(const QAstExpression* expression, QIndexRange& bounds) const;
+		// Gives scan the ranges the conjuncts of where put on integer columns
+		void __addRanges(QScanOperator& scan, const QAstExpression* where);
+		std::size_t __findOrderColumn(const QAstExpression* expression, const qtl::vector<QOutputColumn>& outputs) const;
+
+		QExpression* __bindPredicate(const QAstExpression* where);
+		QExpression* __bindConjuncts(const qtl::vector<const QAstExpression*>& conjuncts);
+
+		// Sorts the conjuncts of a join and returns those bound above it
+		QExpression* __bindJoin(const QAstStatement& statement);
+		void __splitConjuncts(const QAstExpression* expression, qtl::vector<const QAstExpression*>& conjuncts) const;
+		unsigned __findSides(const QAstExpression* expression);
+		bool __resolveColumn(const QAstExpression* expression, std::size_t& side, std::size_t& column);
+		void __collectAggregates(const QAstExpression* expression);
+		bool __bindAggregate(const QAstExpression* call, QAggregate& aggregate);
+		QExpression* __bindHaving(const QAstExpression* having);
+		std::size_t __findGrouped(const QAstExpression* expression);
+		bool __sameExpression(const QAstExpression* left, const QAstExpression* right);
+		QExpression* __bindOrderKey(const QAstExpression* expression, const qtl::vector<QOutputColumn>& outputs);
+		QExpression* __bindOutput(const QOutputColumn& output);
+		QExpression* __bindLimit(const QAstExpression* expression, const char* clause);
+
+		QExpression* __bind(const QAstExpression* expression, const QDataType hint);
+		QExpression* __bindColumn(const std::size_t column);
+		QExpression* __bindJoinColumn(const std::size_t side, const std::size_t column);
+		std::size_t __scanIndex(qtl::vector<std::size_t>& columns, const std::size_t column) const;
+		QExpression* __bindComparison(const QComparison op, const QAstExpression* left, const QAstExpression* right);
+		QExpression* __bindBetween(const QAstExpression* expression);
+		QExpression* __bindIn(const QAstExpression* expression);
+		QExpression* __negate(QExpression* expression, const bool negated);
+
+		bool __isComparable(const QExpression* left, const QExpression* right) const;
+		bool __isComparable(const QDataType type, const QValue& value) const;
+		bool __isAssignable(const QDataType type, const QExpression* value) const;
+		QValue __literal(const QAstLiteral& literal) const;
+
+		void __fail(const char* format, ...);
+	};
+}
+
+#endif // qplanner_h__
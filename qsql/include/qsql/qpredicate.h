@@ -0,0 +1,17 @@
+#ifndef qpredicate_h__
+#define qpredicate_h__
+
+namespace qsql
+{
+	enum class QComparison
+	{
+		EQUAL,
+		NOT_EQUAL,
+		LESS,
+		LESS_EQUAL,
+		GREATER,
+		GREATER_EQUAL,
+	};
+}
+
+#endif // qpredicate_h__
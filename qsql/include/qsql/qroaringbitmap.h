@@ -0,0 +1,131 @@
+#ifndef qroaringbitmap_h__
+#define qroaringbitmap_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+namespace qsql
+{
+	// The low 16 bits of the rows of a QRoaringBitmap that share their high
+	// bits, held in whichever form is smallest: a sorted array while there are
+	// at most ARRAY_LIMIT of them, otherwise a bitmap of the whole range, or
+	// runs of consecutive values once optimize() finds those smaller.  Runs
+	// are turned back into another form before they are changed.
+	class QRoaringContainer
+	{
+	public:
+		enum class QType
+		{
+			ARRAY,
+			BITMAP,
+			RUN,
+		};
+
+		static constexpr std::size_t WORDS = 1024;
+		static constexpr std::size_t ARRAY_LIMIT = 4096;
+
+		QRoaringContainer();
+		QRoaringContainer(const QRoaringContainer& other);
+		~QRoaringContainer();
+
+		QRoaringContainer& operator=(const QRoaringContainer&) = delete;
+
+		QType getType() const;
+		std::size_t getCardinality() const;
+		std::size_t getBytes() const;
+
+		// False if the value was already there, or for remove() was not
+		bool add(const uint16_t value);
+		bool remove(const uint16_t value);
+		bool contains(const uint16_t value) const;
+
+		void intersect(const QRoaringContainer& other);
+		void unite(const QRoaringContainer& other);
+		void subtract(const QRoaringContainer& other);
+		void optimize();
+
+		// Sets the bit of each value below count * 64 in count words, at most WORDS
+		void setBits(uint64_t* words, const std::size_t count = WORDS) const;
+
+		// Writes base + value for up to capacity values from first on, ascending,
+		// and returns how many were written.  first is left after the last value
+		// written, or at 65536 once every value was written.
+		std::size_t extract(uint32_t& first, const std::size_t base, std::size_t* rows, const std::size_t capacity) const;
+	private:
+		QType __type;
+		uint32_t __cardinality;
+
+		// values of an array, or the first value and length - 1 of each run
+		uint16_t* __values;
+		uint32_t __size;
+		uint32_t __capacity;
+
+		// bits of a bitmap, nullptr otherwise
+		uint64_t* __words;
+
+		uint32_t __runsBefore(const uint16_t value) const;
+		void __reserve(const uint32_t size);
+		void __adopt(uint16_t* values, const uint32_t size);
+		void __toBitmap();
+		void __settle();
+	};
+
+	// A compressed set of row indexes, split by the high bits of a row into
+	// containers of 65536 rows each, see QRoaringContainer.  Sets are combined
+	// in place: intersect(), unite() and subtract() are AND, OR and AND NOT,
+	// and NOT is a subtract() from the rows it is taken within.  Containers in
+	// bitmap form are combined a word at a time by the qsimd bitmap kernels.
+	class QRoaringBitmap
+	{
+	public:
+		static constexpr std::size_t CONTAINER_SHIFT = 16;
+
+		QRoaringBitmap();
+		QRoaringBitmap(const QRoaringBitmap& other);
+		QRoaringBitmap(QRoaringBitmap&& other) noexcept;
+		~QRoaringBitmap();
+
+		QRoaringBitmap& operator=(const QRoaringBitmap& other);
+		QRoaringBitmap& operator=(QRoaringBitmap&& other) noexcept;
+
+		bool isEmpty() const;
+		std::size_t getCardinality() const;
+		std::size_t getBytes() const;
+
+		void add(const std::size_t row);
+		void remove(const std::size_t row);
+		bool contains(const std::size_t row) const;
+		void clear();
+
+		void intersect(const QRoaringBitmap& other);
+		void unite(const QRoaringBitmap& other);
+		void subtract(const QRoaringBitmap& other);
+
+		// Turns containers into runs where that makes them smaller
+		void optimize();
+
+		// Writes up to capacity rows from position on, ascending, and returns how
+		// many were written.  position is left after the last row written.
+		std::size_t extract(std::size_t& position, std::size_t* rows, const std::size_t capacity) const;
+
+		// Sets the bit of each row below words * 64 in bitmap, which holds words
+		// words.  Rows past it are left out.
+		void setBits(uint64_t* bitmap, const std::size_t words) const;
+	private:
+		struct QEntry
+		{
+			std::size_t key;
+			QRoaringContainer* container;
+		};
+
+		// ascending by key, no container is empty
+		qtl::vector<QEntry> __entries;
+
+		std::size_t __find(const std::size_t key) const;
+		void __compact();
+	};
+}
+
+#endif // qroaringbitmap_h__
@@ -0,0 +1,110 @@
+#ifndef qschema_h__
+#define qschema_h__
+
+#include <cstddef>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+
+#include "qsql/qdatatype.h"
+
+namespace qsql
+{
+	// How the values of a column are stored.  A DICTIONARY column stores a 32-bit
+	// code per value and each distinct string once, only STRING columns can be
+	// dictionary encoded.  A COMPRESSED column packs each full chunk of a
+	// column-major table into a QSegment once it is committed, only INT and LONG
+	// columns can be compressed.
+	enum class QEncoding
+	{
+		PLAIN,
+		DICTIONARY,
+		COMPRESSED,
+	};
+
+	// Describes the columns of a table and the fixed-width layout of a packed row.
+	// A row starts with a null bitmap (one bit per column, present only when a
+	// column is nullable) followed by the column values ordered by decreasing
+	// alignment so that padding is kept to a minimum.
+	class QSchema
+	{
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		QSchema();
+
+		// A column is PLAIN unless the encoding given applies to its type
+		std::size_t addColumn(const qtl::string& name, const QDataType type, const bool nullable = false, const QEncoding encoding = QEncoding::PLAIN);
+
+		std::size_t getColumnCount() const;
+		std::size_t findColumn(const qtl::string& name) const;
+
+		const qtl::string& getColumnName(const std::size_t column) const;
+		QDataType getColumnType(const std::size_t column) const;
+		bool isNullable(const std::size_t column) const;
+		QEncoding getColumnEncoding(const std::size_t column) const;
+		std::size_t getColumnOffset(const std::size_t column) const;
+
+		bool hasNullable() const;
+		std::size_t getRowSize() const;
+		std::size_t getRowAlignment() const;
+	private:
+		struct QColumnInfo
+		{
+			qtl::string name;
+			QDataType type;
+			bool nullable;
+			QEncoding encoding;
+			std::size_t offset;
+		};
+
+		qtl::vector<QColumnInfo> __columns;
+		std::size_t __rowSize;
+		std::size_t __rowAlignment;
+		bool __hasNullable;
+
+		void __computeLayout();
+	};
+
+	inline std::size_t QSchema::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	inline QDataType QSchema::getColumnType(const std::size_t column) const
+	{
+		return __columns[column].type;
+	}
+
+	inline bool QSchema::isNullable(const std::size_t column) const
+	{
+		return __columns[column].nullable;
+	}
+
+	inline QEncoding QSchema::getColumnEncoding(const std::size_t column) const
+	{
+		return __columns[column].encoding;
+	}
+
+	inline std::size_t QSchema::getColumnOffset(const std::size_t column) const
+	{
+		return __columns[column].offset;
+	}
+
+	inline bool QSchema::hasNullable() const
+	{
+		return __hasNullable;
+	}
+
+	inline std::size_t QSchema::getRowSize() const
+	{
+		return __rowSize;
+	}
+
+	inline std::size_t QSchema::getRowAlignment() const
+	{
+		return __rowAlignment;
+	}
+}
+
+#endif // qschema_h__
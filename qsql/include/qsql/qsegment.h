@@ -0,0 +1,85 @@
+#ifndef qsegment_h__
+#define qsegment_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+
+#include "qsql/qdatatype.h"
+
+namespace qsql
+{
+	// How a segment packs its values, each into the fewest bits that hold them
+	enum class QSegmentEncoding
+	{
+		// offset of each value from the smallest one
+		FRAME_OF_REFERENCE,
+
+		// difference of each value from the one before, offset from the smallest
+		// difference, with the value itself at every CHECKPOINT-th row
+		DELTA,
+
+		// a value per run of equal values, offset from the smallest one, and the
+		// row after each run
+		RUN_LENGTH,
+	};
+
+	// The values of a full column chunk of INT or LONG, compressed once the chunk
+	// can no longer change.  The encoding is picked from statistics gathered
+	// over the values: their range, the range of their differences and the
+	// number of runs.  Rows that are NULL take the value of the row before them,
+	// so they neither widen the range nor break a run, and are told apart by the
+	// column's null bitmap.
+	//
+	// Values are decoded a range at a time into a plain array, and ranges of
+	// values are matched against the packed form where the encoding allows it.
+	class QSegment
+	{
+	public:
+		static constexpr std::size_t CHECKPOINT = 128;
+
+		QSegment(const QSegment&) = delete;
+
+		QSegment& operator=(const QSegment&) = delete;
+
+		// Encodes count values of type, returns nullptr if no encoding is smaller
+		// than the values themselves
+		static QSegment* encode(const QDataType type, const void* values, const uint64_t* nulls, const std::size_t count);
+
+		QDataType getType() const;
+		QSegmentEncoding getEncoding() const;
+		std::size_t size() const;
+
+		// Bytes taken by the packed values
+		std::size_t getBytes() const;
+
+		int64_t get(const std::size_t row) const;
+
+		// Writes count values from first to values, as int32_t or int64_t by the
+		// segment's type
+		void decode(const std::size_t first, const std::size_t count, void* values) const;
+
+		// Sets bit i of bits for every row i whose value lies between low and high,
+		// both inclusive, and returns how many were set.  NULL rows are not told
+		// apart here.
+		std::size_t select(const int64_t low, const int64_t high, uint64_t* bits) const;
+	private:
+		QDataType __type;
+		QSegmentEncoding __encoding;
+		std::size_t __count;
+		uint64_t __base;
+		unsigned __width;
+		qtl::vector<uint64_t> __packed;
+		qtl::vector<int64_t> __checkpoints;
+		qtl::vector<uint16_t> __runEnds;
+
+		QSegment(const QDataType type, const QSegmentEncoding encoding, const std::size_t count);
+
+		uint64_t __unpack(const std::size_t index) const;
+		void __pack(const std::size_t index, const uint64_t value);
+		std::size_t __findRun(const std::size_t row) const;
+	};
+}
+
+#endif // qsegment_h__
@@ -0,0 +1,60 @@
+#ifndef qsimd_h__
+#define qsimd_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "qsql/qpredicate.h"
+
+namespace qsql
+{
+	// Ordered from least to most capable
+	enum class QSimdLevel
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+	};
+
+	// Instruction set used by the filter kernels, detected through CPUID on first use
+	QSimdLevel getSimdLevel();
+
+	// Restricts the kernels to level, a level the processor does not support is
+	// ignored.  Kernels already running on other threads may finish on the old one.
+	void setSimdLevel(const QSimdLevel level);
+
+	// Filter kernels set bit i of bitmap when values[i] satisfies the predicate.
+	// bitmap must hold (count + 63) / 64 words, unused bits of the last word are cleared.
+	void filterCompare(const QComparison op, const int32_t* values, const std::size_t count, const int32_t constant, uint64_t* bitmap);
+	void filterCompare(const QComparison op, const int64_t* values, const std::size_t count, const int64_t constant, uint64_t* bitmap);
+
+	void filterBetween(const int32_t* values, const std::size_t count, const int32_t low, const int32_t high, uint64_t* bitmap);
+	void filterBetween(const int64_t* values, const std::size_t count, const int64_t low, const int64_t high, uint64_t* bitmap);
+
+	void filterIn(const int32_t* values, const std::size_t count, const int32_t* list, const std::size_t listSize, uint64_t* bitmap);
+	void filterIn(const int64_t* values, const std::size_t count, const int64_t* list, const std::size_t listSize, uint64_t* bitmap);
+
+	void filterBool(const bool* values, const std::size_t count, const bool constant, uint64_t* bitmap);
+
+	// Blocked Bloom filter kernels over blockCount blocks of BLOOM_BLOCK_WORDS
+	// words, one cache line each.  A hash picks a block by its high 32 bits and
+	// sets one bit in every word of the block by its low 32 bits.  blockCount
+	// must not be 0.
+	constexpr std::size_t BLOOM_BLOCK_WORDS = 8;
+	void bloomInsert(uint64_t* blocks, const std::size_t blockCount, const uint64_t hash);
+	bool bloomContains(const uint64_t* blocks, const std::size_t blockCount, const uint64_t hash);
+
+	// Sets bit i of bitmap when hashes[i] may be in the filter
+	void filterBloom(const uint64_t* blocks, const std::size_t blockCount, const uint64_t* hashes, const std::size_t count, uint64_t* bitmap);
+
+	void bitmapAnd(uint64_t* destination, const uint64_t* source, const std::size_t words);
+	void bitmapOr(uint64_t* destination, const uint64_t* source, const std::size_t words);
+	void bitmapAndNot(uint64_t* destination, const uint64_t* source, const std::size_t words);
+
+	std::size_t bitmapCount(const uint64_t* bitmap, const std::size_t words);
+
+	// Writes the index of every set bit among the first count bits to selection
+	std::size_t bitmapToSelection(const uint64_t* bitmap, const std::size_t count, uint16_t* selection);
+}
+
+#endif // qsimd_h__
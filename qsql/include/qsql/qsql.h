@@ -1,4 +1,31 @@
 #ifndef qsql_h__
 #define qsql_h__
 
+#include "qsql/qdatatype.h"
+#include "qsql/qvalue.h"
+#include "qsql/qpredicate.h"
+#include "qsql/qsegment.h"
+#include "qsql/qbloomfilter.h"
+#include "qsql/qroaringbitmap.h"
+#include "qsql/qcolumn.h"
+#include "qsql/qschema.h"
+#include "qsql/qversion.h"
+#include "qsql/qtable.h"
+#include "qsql/qbatch.h"
+#include "qsql/qsimd.h"
+#include "qsql/qexpression.h"
+#include "qsql/qoperator.h"
+#include "qsql/qarena.h"
+#include "qsql/qlexer.h"
+#include "qsql/qast.h"
+#include "qsql/qparser.h"
+#include "qsql/qplan.h"
+#include "qsql/qplanner.h"
+#include "qsql/qplancache.h"
+#include "qsql/qstatement.h"
+#include "qsql/qwal.h"
+#include "qsql/qbufferpool.h"
+#include "qsql/qtablefile.h"
+#include "qsql/qdatabase.h"
+
 #endif // qsql_h__
\ No newline at end of file
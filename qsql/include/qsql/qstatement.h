@@ -0,0 +1,85 @@
+#ifndef qstatement_h__
+#define qstatement_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+
+#include "qsql/qbatch.h"
+#include "qsql/qdatatype.h"
+#include "qsql/qplan.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QDatabase;
+
+	// A statement prepared by QDatabase::prepare().  Parameters are numbered from
+	// zero in the order their ? appear and keep their value across executions
+	// until they are set again or cleared.  The statement holds its plan until it
+	// is destroyed, at which point the plan goes back to the database's cache, so
+	// the database has to outlive its statements.
+	class QStatement
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+
+		QStatement();
+		QStatement(const QStatement&) = delete;
+		QStatement(QStatement&& other) noexcept;
+		~QStatement();
+
+		QStatement& operator=(const QStatement&) = delete;
+		QStatement& operator=(QStatement&& other) noexcept;
+
+		// False if the statement failed to parse or bind, see getError()
+		bool isValid() const;
+		const char* getError() const;
+
+		std::size_t getParameterCount() const;
+		QDataType getParameterType(const std::size_t parameter) const;
+
+		// Each setter returns false if the index is out of range or the value
+		// cannot be converted to the parameter's type
+		bool setNull(const std::size_t parameter);
+		bool setChar(const std::size_t parameter, const char value);
+		bool setInt(const std::size_t parameter, const int32_t value);
+		bool setLong(const std::size_t parameter, const int64_t value);
+		bool setBool(const std::size_t parameter, const bool value);
+		bool setString(const std::size_t parameter, const qtl::string& value);
+		void clearParameters();
+
+		// Runs the statement, SELECT results are then read with next().  Fails
+		// if a parameter is unbound or a table was dropped since preparing.
+		// Changes are logged to the database's log, if it has one.
+		bool execute();
+		std::size_t getAffectedRows() const;
+
+		// End of the log records the last execution wrote, for flushing a log
+		// that is not synchronous
+		uint64_t getLogPosition() const;
+
+		std::size_t getColumnCount() const;
+		QDataType getColumnType(const std::size_t column) const;
+		const qtl::string& getColumnName(const std::size_t column) const;
+
+		// Next batch of a SELECT's result, nullptr once all rows were produced.  A
+		// column read from a dictionary encoded column holds codes, which
+		// QVector::getValue() decodes.
+		QBatch* next();
+	private:
+		QDatabase* __database;
+		QPlan* __plan;
+		char __error[ERROR_LENGTH];
+
+		QStatement(QDatabase* database, QPlan* plan, const char* error);
+
+		bool __set(const std::size_t parameter, const QValue& value);
+		void __release();
+
+		friend class QDatabase;
+	};
+}
+
+#endif // qstatement_h__
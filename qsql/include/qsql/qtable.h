@@ -1,53 +1,412 @@
-#ifndef qrow_h__
-#define qrow_h__
+#ifndef qtable_h__
+#define qtable_h__
+
+#include <cstdint>
 
 #include <qtl/vector.h>
 #include <qtl/string.h>
+#include <qtl/thread/mutex.h>
+#include <qtl/thread/shared_mutex.h>
 
+#include "qsql/qarena.h"
+#include "qsql/qartindex.h"
+#include "qsql/qbitmapindex.h"
+#include "qsql/qbloomfilter.h"
+#include "qsql/qbtreeindex.h"
+#include "qsql/qbufferpool.h"
+#include "qsql/qcolumn.h"
 #include "qsql/qdatatype.h"
+#include "qsql/qdictionary.h"
+#include "qsql/qhashindex.h"
+#include "qsql/qpredicate.h"
+#include "qsql/qschema.h"
+#include "qsql/qvalue.h"
+#include "qsql/qversion.h"
 
 namespace qsql
 {
+	class QExpression;
 	class QField;
 	class QRow;
 	class QTable;
 
+	enum class QTableLayout
+	{
+		ROW,
+		COLUMN,
+	};
+
 	class QField
 	{
 		QField(const QDataType type, void* value);
+
+		// Holds a value decoded from a compressed chunk
+		QField(const QDataType type, const int64_t value);
 	public:
 		QDataType getType() const;
+		bool isNull() const;
 
 		template<typename T>
 		T& get();
 	private:
 		QDataType __type;
 		void* __value;
+		int64_t __decoded;
+		bool __held;
+
+		friend class QRow;
+		friend class QTable;
 	};
 
 	template<typename T>
 	inline T& QField::get()
 	{
-		return *reinterpret_cast<T*>(__value);
+		return *reinterpret_cast<T*>(__held ? &__decoded : __value);
+	}
+
+	// only integers are compressed, a string always lives in the table
+	template<>
+	inline qtl::string& QField::get<qtl::string>()
+	{
+		return *reinterpret_cast<qtl::string*>(__value);
 	}
 
 	class QRow
 	{
-		QRow(const qtl::vector<QField>& fields, void* data);
+		QRow(const QTable* table, char* data, const std::size_t index);
 	public:
-		QField get(const size_t column) const;
+		QField get(const std::size_t column) const;
+		std::size_t getIndex() const;
 	private:
-		qtl::vector<QField> __fields;
-		void* __data;
+		const QTable* __table;
+		char* __data;
+		std::size_t __index;
+
+		friend class QTable;
 	};
 
+	// Rows are versioned so that readers see a snapshot of the table while it is
+	// written.  Rows are never changed once committed: an update appends a new
+	// version of the row and ends the old one, an erase only ends it.  Versions
+	// carry the timestamps of the commits that began and ended them when some
+	// snapshot was in use at the time, other versions are visible to every
+	// snapshot until erased.  Versions no snapshot can see any more stay in the
+	// indexes until collect() drops them.
+	//
+	// Writes are serialized by beginWrite() and commit().  Readers hold the
+	// latch shared while they read the table's storage and writers hold it
+	// exclusively for each change, so a scan only waits for a single row to be
+	// written and a write for a single batch to be read.
 	class QTable
 	{
 	public:
+		static constexpr std::size_t PAGE_SHIFT = QColumn::CHUNK_SHIFT;
+		static constexpr std::size_t PAGE_ROWS = QColumn::CHUNK_SIZE;
+
+		// Row pages and column chunks are carved from arena chunks of this size
+		static constexpr std::size_t STORAGE_CHUNK_SIZE = static_cast<std::size_t>(4) << 20;
+
+		// A commit collects garbage once this many ended versions await collection
+		static constexpr std::size_t COLLECT_THRESHOLD = 4096;
+
+		// A version is visible to the snapshots taken at or after begin and before end
+		static constexpr uint64_t NEVER = static_cast<uint64_t>(-1);
+		struct QVersion
+		{
+			uint64_t begin;
+			uint64_t end;
+		};
+
+		// The table stamps its commits by clock, or by a clock of its own if none is given
+		explicit QTable(const QSchema& schema, const QTableLayout layout = QTableLayout::ROW, QVersionClock* clock = nullptr);
+		QTable(const QTable&) = delete;
+		~QTable();
+
+		QTable& operator=(const QTable&) = delete;
+
+		const QSchema& getSchema() const;
+		QTableLayout getLayout() const;
+		std::size_t getColumnCount() const;
+		std::size_t getRowCount() const;
+		QDataType getColumnType(const std::size_t column) const;
+
+		// Only valid for tables with a column-major layout
+		const QColumn& getColumn(const std::size_t column) const;
+
+		QVersionClock& getClock() const;
+
+		// Moves the table to another clock, only while no snapshot of the table
+		// is in use and nothing writes it
+		void setClock(QVersionClock& clock);
+
+		// Starts a write made of the following insert(), update() and erase()
+		// calls, which snapshots see together once commit() is called.  A second
+		// write waits until the first one commits.  Outside a write every change
+		// commits on its own, which is only safe while no other thread writes.
+		void beginWrite();
+		void commit();
+
+		// Ends the write without any snapshot ever seeing it.  Rows it ended are
+		// current again, rows it inserted keep their index and storage erased.
+		void abort();
+
+		// Appends a row and returns its index, or returns getRowCount() unchanged
+		// if a value cannot be stored in its column
+		std::size_t insert(const qtl::vector<QValue>& values);
+
+		// True if value (possibly NULL) can be stored in column
+		bool canStore(const std::size_t column, const QValue& value) const;
+
+		// Writes a new version of the row with value in column and returns its
+		// index, or returns getRowCount() if the row was erased or the value
+		// cannot be stored in the column.  Further updates of the row within the
+		// same write change the new version.
+		std::size_t update(const std::size_t row, const std::size_t column, const QValue& value);
+
+		// Ends the row's version.  Erased rows keep their index and storage,
+		// scans skip them.  isErased() is true once the erase is committed.
+		bool erase(const std::size_t row);
+		bool isErased(const std::size_t row) const;
+		std::size_t getErasedCount() const;
+
+		// True if the row is visible to a reader holding snapshot
+		bool isVisible(const std::size_t row, const uint64_t snapshot) const;
+
+		// Sets bit i of live for every row first + i visible to snapshot, where
+		// first is a multiple of 64 and count rows lie within a page.  Returns
+		// false without setting live if every row is visible.
+		bool getVisible(const std::size_t first, const std::size_t count, const uint64_t snapshot, uint64_t* live) const;
+
+		// True if no row of a page can hold a value of column from low to high,
+		// both inclusive, as told by the page's zone map.  Only INT and LONG
+		// columns are bounded, and only the pages the table wrote itself.
+		bool isOutside(const std::size_t page, const std::size_t column, const int64_t low, const int64_t high) const;
+
+		// True if no row of a page can hold a value of column whose
+		// QBloomFilter::hashValue() is hash, as told by the page's Bloom filter.
+		// False if the column has no filters.
+		bool isAbsent(const std::size_t page, const std::size_t column, const uint64_t hash) const;
+
+		// Held shared while reading rows concurrently with a write
+		qtl::shared_mutex& getLatch() const;
+
+		// Drops ended versions that no snapshot in use can see from the indexes and
+		// releases timestamps no snapshot needs any more
+		void collect();
+
+		// Bitmap with a set bit for each erased row, nullptr if no row was erased
+		const uint64_t* getErased() const;
+
+		// Fields of a row read through a buffer pool hold a copy of its values,
+		// reading them needs a frame of the pool that is not pinned
+		QRow getRow(const std::size_t row) const;
+
+		// True if the table was opened from a file by QTableFile, either mapped
+		// or read through a buffer pool
+		bool isMapped() const;
+
+		// Pool the table's rows are read through, nullptr if they are in memory
+		QBufferPool* getBufferPool() const;
+
+		// Dictionary of a dictionary encoded column, nullptr for other columns
+		const QDictionary* getDictionary(const std::size_t column) const;
+
+		// Code stored for a value of a dictionary encoded column, the value must not be NULL
+		uint32_t getCode(const std::size_t row, const std::size_t column) const;
+
+		// Builds a hash index over column that is kept up to date from then on.
+		// Returns false if the column's type cannot be indexed or it already is.
+		bool createHashIndex(const std::size_t column);
+
+		// Index over column, nullptr if there is none
+		const QHashIndex* getHashIndex(const std::size_t column) const;
+
+		// Same as createHashIndex() for an ordered index, which serves range
+		// predicates and returns rows sorted by the column
+		bool createBTreeIndex(const std::size_t column);
+		const QBTreeIndex* getBTreeIndex(const std::size_t column) const;
+
+		// Same as createBTreeIndex() for an adaptive radix tree, which compares
+		// keys a byte at a time and so builds and searches string columns faster.
+		// Filters and the planner prefer it over a B+tree on the same column.
+		bool createArtIndex(const std::size_t column);
+		const QArtIndex* getArtIndex(const std::size_t column) const;
+
+		// Same as createHashIndex() for a bitmap index, which suits BOOL, CHAR
+		// and STRING columns of few distinct values and lets predicates on
+		// several of them be combined as bitmaps
+		bool createBitmapIndex(const std::size_t column);
+		const QBitmapIndex* getBitmapIndex(const std::size_t column) const;
+
+		// Builds a Bloom filter of the values of column for every page, spending
+		// bitsPerKey bits on each row, and keeps them up to date from then on.
+		// Scans looking for a value skip the pages whose filter rules it out.
+		// Returns false if the column's type cannot be hash indexed or it already
+		// has filters.
+		bool createBloomFilter(const std::size_t column, const std::size_t bitsPerKey = QBloomFilter::DEFAULT_BITS_PER_KEY);
+		bool hasBloomFilter(const std::size_t column) const;
+
+		// Scans column and sets bit i of bitmap for every row i that satisfies the
+		// predicate, returning the number of matching rows.  NULL never matches.
+		// Equality on a hash indexed column, ranges on an ordered index and
+		// equality, inequality and lists on a bitmap indexed one read the index
+		// instead of scanning, ranges on a compressed column are matched against
+		// its segments without decoding them where possible.
+		// Equality on a column with Bloom filters skips the pages they rule out.
+		// No row matches if a chunk of a table read through a buffer pool
+		// cannot be pinned.
+		std::size_t filter(const std::size_t column, const QComparison op, const QValue& value, qtl::vector<uint64_t>& bitmap) const;
+		std::size_t filterBetween(const std::size_t column, const QValue& low, const QValue& high, qtl::vector<uint64_t>& bitmap) const;
+		std::size_t filterIn(const std::size_t column, const qtl::vector<QValue>& values, qtl::vector<uint64_t>& bitmap) const;
 	private:
-		qtl::vector<QRow> __rows;
-		void* __data;
+		QSchema __schema;
+		QTableLayout __layout;
+		std::size_t __rowCount;
+
+		// owns the row pages and column chunks, the table only grows so they are
+		// released together when it is destroyed
+		QArena __storage;
+
+		QVersionClock* __clock;
+		QVersionClock* __ownClock;
+		mutable qtl::shared_mutex __latch;
+		qtl::mutex __writer;
+		bool __writing;
+
+		// rows from here on were inserted by the write in progress
+		std::size_t __committedRows;
+
+		// timestamps of the rows of each page, nullptr while they are not needed
+		qtl::vector<QVersion*> __versions;
+
+		// rows the write in progress ends and the versions replacing them, an
+		// erased row replaced by itself, with a bit per row in __retiring
+		struct QRetired
+		{
+			std::size_t row;
+			std::size_t successor;
+		};
+		qtl::vector<QRetired> __retired;
+		qtl::vector<uint64_t> __retiring;
+
+		// erased rows still indexed for snapshots that can see them
+		qtl::vector<std::size_t> __garbage;
+
+		// file the first chunks of each column are read from, see QTableFile
+		void* __mapping;
+		std::size_t __mappingSize;
+
+		// or the pool and the pool's id of that file
+		QBufferPool* __pool;
+		uint32_t __poolFile;
+
+		// row-major storage, pages of PAGE_ROWS packed rows
+		qtl::vector<char*> __pages;
+
+		// column-major storage
+		qtl::vector<QColumn*> __columns;
+
+		// one bit per row, set once the row is erased
+		qtl::vector<uint64_t> __erased;
+		std::size_t __erasedCount;
+
+		// one entry per column, nullptr unless the column is dictionary encoded
+		qtl::vector<QDictionary*> __dictionaries;
+
+		// zone map, one entry per page and column with the bounds of the values
+		// written to the page and how many of them are NULL.  Bounds only widen,
+		// so they stay true when a write in progress changes its own rows.
+		struct QZone
+		{
+			int64_t min;
+			int64_t max;
+			std::size_t nulls;
+		};
+		qtl::vector<QZone> __zones;
+
+		// Bloom filters, one per page and column, nullptr for the columns
+		// without filters, and the bits per key of each column's filters
+		qtl::vector<QBloomFilter*> __blooms;
+		qtl::vector<std::size_t> __bloomBits;
+
+		// chunks before this one are compressed in every COMPRESSED column where
+		// that makes them smaller
+		std::size_t __compressedChunks;
+
+		// plain values of compressed chunks, released once no snapshot taken
+		// before the commit that compressed them is in use
+		struct QStaleChunk
+		{
+			void* values;
+			uint64_t timestamp;
+		};
+		qtl::vector<QStaleChunk> __staleChunks;
+
+		// one entry per column, nullptr unless the column is indexed
+		qtl::vector<QHashIndex*> __hashIndexes;
+		qtl::vector<QBTreeIndex*> __btreeIndexes;
+		qtl::vector<QArtIndex*> __artIndexes;
+		qtl::vector<QBitmapIndex*> __bitmapIndexes;
+
+		char* __rowData(const std::size_t row) const;
+		std::size_t __append(const qtl::vector<QValue>& values);
+		void __assign(const std::size_t row, const std::size_t column, const QValue& value);
+		QZone* __zonesOf(const std::size_t row);
+		void __widen(QZone& zone, const std::size_t column, const QValue& value) const;
+		void __addToBloom(const std::size_t row, const std::size_t column);
+		void __retire(const std::size_t row, const std::size_t successor);
+		bool __isRetiring(const std::size_t row) const;
+		bool __isCurrent(const std::size_t row) const;
+		QVersion* __version(const std::size_t row, const bool allocate);
+		void __collect(const uint64_t horizon);
+		void __compress(const uint64_t timestamp, const bool read);
+		void __releaseChunks(const uint64_t horizon);
+		void __indexRow(const std::size_t row);
+		void __unindexRow(const std::size_t row);
+		QField __getColumnField(const std::size_t row, const std::size_t column) const;
+		void __store(const std::size_t column, const QValue& value, void* data);
+		bool __validate(const qtl::vector<QValue>& values) const;
+		bool __validate(const std::size_t column, const QValue& value) const;
+		std::size_t __filter(const std::size_t column, QExpression& predicate, qtl::vector<uint64_t>& bitmap, const int64_t* bounds = nullptr, const QValue* key = nullptr) const;
+		std::size_t __filterCompressed(const std::size_t column, const int64_t low, const int64_t high, qtl::vector<uint64_t>& bitmap) const;
+		std::size_t __filterBitmap(const QRoaringBitmap& rows, qtl::vector<uint64_t>& bitmap) const;
+		template<typename Range, typename Index>
+		std::size_t __filterRange(const Index& index, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, qtl::vector<uint64_t>& bitmap) const;
+		std::size_t __filterRange(const std::size_t column, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, qtl::vector<uint64_t>& bitmap) const;
+
+		friend class QRow;
+		friend class QTableFile;
 	};
+
+	inline QRow::QRow(const QTable* table, char* data, const std::size_t index)
+		: __table(table), __data(data), __index(index)
+	{
+	}
+
+	inline QField QRow::get(const std::size_t column) const
+	{
+		if (__data)
+		{
+			const QSchema& schema = __table->__schema;
+			if (schema.isNullable(column) && ((__data[column >> 3] >> (column & 7)) & 1))
+			{
+				return QField(schema.getColumnType(column), nullptr);
+			}
+			const QDictionary* dictionary = __table->__dictionaries[column];
+			void* value = __data + schema.getColumnOffset(column);
+			if (dictionary)
+			{
+				value = const_cast<qtl::string*>(&dictionary->decode(*static_cast<uint32_t*>(value)));
+			}
+			return QField(schema.getColumnType(column), value);
+		}
+		return __table->__getColumnField(__index, column);
+	}
+
+	inline char* QTable::__rowData(const std::size_t row) const
+	{
+		return __pages[row >> PAGE_SHIFT] + (row & (PAGE_ROWS - 1)) * __schema.getRowSize();
+	}
 }
 
-#endif // qrow_h__
+#endif // qtable_h__
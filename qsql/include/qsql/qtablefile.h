@@ -0,0 +1,81 @@
+#ifndef qtablefile_h__
+#define qtablefile_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <qtl/string.h>
+
+#include "qsql/qbufferpool.h"
+#include "qsql/qtable.h"
+
+namespace qsql
+{
+	// Page-oriented file format for a table that is opened by mapping the file
+	// rather than reading it, so opening takes time independent of the number of
+	// rows and the operating system's page cache holds the data.
+	//
+	// The file starts with a header page holding the row count and the name,
+	// type and nullability of every column.  Each column follows as a segment
+	// of QColumn::CHUNK_SIZE value chunks laid out exactly as QColumn keeps them
+	// in memory, then a segment of null bitmap chunks if it is nullable.  STRING
+	// columns are stored dictionary encoded, as 32-bit codes and a segment with
+	// the distinct strings.  A footer lists the offset of every segment and the
+	// last bytes of the file point at the footer.  Segments start on page
+	// boundaries.
+	//
+	// An opened table has a column-major layout and its STRING columns are
+	// dictionary encoded.  The mapping is private: the table can still be
+	// modified, the changes stay in memory and are not written to the file.
+	// A table can also be opened through a buffer pool to work on files larger
+	// than memory, only the pages in use are then kept in memory.  The pool
+	// only reads the file: the partial last chunk is copied into memory when
+	// the table is opened, which is the only chunk rows are appended to.
+	// Tables opened by mapping and tables built in memory do not use a pool,
+	// the page cache already bounds what a mapping keeps resident.
+	class QTableFile
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+		static constexpr uint32_t MAGIC = 0x4C425451;
+		static constexpr uint32_t VERSION = 2;
+
+		// a page of the buffer pool, so no chunk straddles two of its pages
+		static constexpr std::size_t PAGE_SIZE = QBufferPool::PAGE_SIZE;
+
+		QTableFile();
+
+		// Writes the rows of table, including erased ones, to a file at path
+		bool save(const QTable& table, const qtl::string& path);
+
+		// Maps the file at path and returns a table reading from it, nullptr if
+		// the file cannot be mapped or is not a table file
+		QTable* open(const qtl::string& path);
+
+		// Returns a table reading its rows through pool, which must outlive it.
+		// The file is never written, rows appended to its partial last chunk
+		// are kept in memory with the rest of the changes.  Also returns nullptr
+		// if the pool has no frame free to copy that chunk.
+		QTable* open(const qtl::string& path, QBufferPool& pool);
+
+		const char* getError() const;
+
+		// Releases a mapping made by open(), called by the table that owns it
+		static void unmap(void* mapping, const std::size_t size);
+	private:
+		struct QSource;
+
+		FILE* __file;
+		uint64_t __offset;
+		bool __failed;
+		char __error[ERROR_LENGTH];
+
+		void __write(const void* data, const std::size_t size);
+		void __pad();
+		QTable* __load(const QSource& source, const qtl::string& path);
+		void __fail(const char* format, const char* detail);
+	};
+}
+
+#endif // qtablefile_h__
@@ -0,0 +1,51 @@
+#ifndef qvalue_h__
+#define qvalue_h__
+
+#include <cstdint>
+
+#include <qtl/string.h>
+
+#include "qsql/qdatatype.h"
+
+namespace qsql
+{
+	class QValue
+	{
+	public:
+		QValue();
+		QValue(const char value);
+		QValue(const int32_t value);
+		QValue(const int64_t value);
+		QValue(const bool value);
+		QValue(const char* value);
+		QValue(const qtl::string& value);
+
+		QDataType getType() const;
+		bool isNull() const;
+
+		char getChar() const;
+		int32_t getInt() const;
+		int64_t getLong() const;
+		bool getBool() const;
+		const qtl::string& getString() const;
+
+		bool canStore(const QDataType type) const;
+
+		// Writes the value into storage of the given type, widening or narrowing
+		// integral values as needed.  Returns false if the types are incompatible.
+		bool store(const QDataType type, void* destination) const;
+	private:
+		QDataType __type;
+		bool __isNull;
+		union
+		{
+			char __char;
+			int32_t __int;
+			int64_t __long;
+			bool __bool;
+		};
+		qtl::string __string;
+	};
+}
+
+#endif // qvalue_h__
@@ -0,0 +1,54 @@
+#ifndef qversion_h__
+#define qversion_h__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/vector.h>
+#include <qtl/thread/mutex.h>
+
+namespace qsql
+{
+	// Commit timestamps shared by the tables of a database.  A reader takes a
+	// snapshot, the timestamp of the last commit, and sees exactly the changes
+	// committed up to it.  Commits are published one at a time in timestamp
+	// order, so a snapshot never sees part of a commit.  Snapshots in use are
+	// tracked so that versions no snapshot can see any more are collected.
+	class QVersionClock
+	{
+	public:
+		QVersionClock();
+		QVersionClock(const QVersionClock&) = delete;
+
+		QVersionClock& operator=(const QVersionClock&) = delete;
+
+		// Timestamp of the last commit
+		uint64_t now() const;
+
+		// Takes a snapshot of the last commit, which stays in use until released
+		uint64_t acquire();
+		void release(const uint64_t snapshot);
+
+		// Oldest snapshot in use, now() if there is none.  Versions that ended
+		// at or before it are not visible to any snapshot.
+		uint64_t getHorizon();
+
+		// Starts a commit and returns its timestamp, the commit holds the clock
+		// until end() publishes it so no snapshot is taken in between.  read is
+		// set if a snapshot is in use, otherwise every later snapshot sees the
+		// commit and its changes need no timestamps.
+		uint64_t begin(bool& read);
+		void end(const uint64_t timestamp);
+	private:
+		qtl::mutex __mutex;
+		std::atomic<uint64_t> __now;
+
+		// snapshots in use, unordered, each appears once per acquire()
+		qtl::vector<uint64_t> __snapshots;
+
+		uint64_t __horizon() const;
+	};
+}
+
+#endif // qversion_h__
@@ -0,0 +1,165 @@
+#ifndef qwal_h__
+#define qwal_h__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <qtl/string.h>
+#include <qtl/vector.h>
+#include <qtl/thread/condition_variable.h>
+#include <qtl/thread/mutex.h>
+
+#include "qsql/qschema.h"
+#include "qsql/qtable.h"
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	class QDatabase;
+
+	enum class QWalRecordType : uint8_t
+	{
+		CREATE_TABLE = 1,
+		DROP_TABLE,
+		INSERT_ROW,
+		UPDATE_VALUE,
+		ERASE_ROW,
+	};
+
+	// Growable buffer of bytes that records are encoded into
+	class QWalBuffer
+	{
+	public:
+		QWalBuffer();
+		QWalBuffer(const QWalBuffer&) = delete;
+		~QWalBuffer();
+
+		QWalBuffer& operator=(const QWalBuffer&) = delete;
+
+		const char* getData() const;
+		std::size_t size() const;
+
+		void append(const void* data, const std::size_t size);
+		void clear();
+		void swap(QWalBuffer& other);
+	private:
+		char* __data;
+		std::size_t __size;
+		std::size_t __capacity;
+	};
+
+	// The records of one transaction, encoded as they are added.  A transaction
+	// is written to the log as a single checksummed frame, so recovery applies
+	// either all of its records or none of them.  Tables are named by the name
+	// they were created with, rows by their index in the table.
+	class QWalTransaction
+	{
+	public:
+		void createTable(const qtl::string& name, const QSchema& schema, const QTableLayout layout);
+		void dropTable(const qtl::string& name);
+		void insert(const qtl::string& table, const qtl::vector<QValue>& values);
+		void update(const qtl::string& table, const std::size_t row, const std::size_t column, const QValue& value);
+		void erase(const qtl::string& table, const std::size_t row);
+
+		bool isEmpty() const;
+		void clear();
+	private:
+		QWalBuffer __records;
+
+		void __putType(const QWalRecordType type);
+		void __putString(const qtl::string& value);
+		void __putValue(const QValue& value);
+
+		friend class QWal;
+	};
+
+	// Append-only write-ahead log.  A transaction is appended to an in-memory
+	// buffer and becomes durable once a flush covering its position returns.
+	// Flushes are grouped: the first committer to arrive writes and syncs the
+	// buffer on behalf of everyone who appended before it while later committers
+	// wait, so concurrent transactions share a single fsync.  A commit delay
+	// makes that leader wait a little before writing when others are committing
+	// too, trading latency for larger groups.
+	//
+	// Every frame is a 32-bit payload length and a CRC-32C of the payload
+	// followed by the payload.  Opening a log cuts it after its last complete
+	// frame, which drops a transaction that was torn by a crash.
+	class QWal
+	{
+	public:
+		static constexpr std::size_t ERROR_LENGTH = 128;
+		static constexpr uint32_t MAGIC = 0x4C415751;
+		static constexpr uint32_t VERSION = 1;
+		static constexpr std::size_t HEADER_SIZE = 8;
+		static constexpr std::size_t FRAME_HEADER_SIZE = 8;
+
+		QWal();
+		QWal(const QWal&) = delete;
+		~QWal();
+
+		QWal& operator=(const QWal&) = delete;
+
+		// Opens or creates the log at path.  Returns false if the file cannot be
+		// opened or is not a log.
+		bool open(const qtl::string& path);
+
+		// Flushes whatever was appended and closes the file
+		void close();
+		bool isOpen() const;
+
+		// Applies every transaction in the log to database, which should be in
+		// the state the log was started from, usually empty.  Has to be called
+		// before the database logs to this log.  Returns false at the first
+		// transaction that cannot be applied, which leaves no change behind.
+		bool replay(QDatabase& database);
+
+		// Time a flush waits for more committers before writing, 0 by default
+		void setCommitDelay(const uint32_t microseconds);
+		uint32_t getCommitDelay() const;
+
+		// Appends a transaction and returns the position it ends at, 0 if the
+		// log is not open or a write has failed.  Safe to call from any thread.
+		uint64_t append(const QWalTransaction& transaction);
+
+		// Blocks until everything up to position is on disk.  Returns false once
+		// a write or sync has failed, the log stays failed until it is reopened.
+		bool flush(const uint64_t position);
+
+		// append() followed by flush()
+		bool commit(const QWalTransaction& transaction);
+
+		// Transactions appended and fsyncs issued since the log was opened
+		uint64_t getCommitCount() const;
+		uint64_t getSyncCount() const;
+
+		const char* getError() const;
+	private:
+		int __file;
+		uint32_t __commitDelay;
+
+		qtl::mutex __mutex;
+		qtl::condition_variable __flushed;
+
+		// appended transactions not yet handed to a flush, and the buffer the
+		// current flush is writing
+		QWalBuffer __pending;
+		QWalBuffer __writing;
+
+		// end of the last appended transaction and of the last synced one
+		uint64_t __appendedPosition;
+		uint64_t __syncedPosition;
+		bool __flushing;
+		bool __failed;
+		std::size_t __committers;
+
+		uint64_t __commitCount;
+		uint64_t __syncCount;
+		char __error[ERROR_LENGTH];
+
+		uint64_t __scan();
+		bool __apply(QDatabase& database, const char* data, const std::size_t size);
+		void __fail(const char* format, const char* detail);
+	};
+}
+
+#endif // qwal_h__
@@ -0,0 +1,86 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qarena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace qsql
+{
+	QArena::QArena()
+		: QArena(CHUNK_SIZE)
+	{
+	}
+
+	QArena::QArena(const std::size_t chunkSize)
+		: __chunkSize(chunkSize), __next(0), __cursor(nullptr), __end(nullptr), __used(0)
+	{
+	}
+
+	QArena::~QArena()
+	{
+		for (std::size_t i = 0; i < __chunks.size(); i++)
+		{
+			free(__chunks[i]);
+		}
+	}
+
+	char* QArena::copy(const char* text, const std::size_t length)
+	{
+		char* result = static_cast<char*>(allocate(length + 1, 1));
+		memcpy(result, text, length);
+		result[length] = '\0';
+		return result;
+	}
+
+	void QArena::reset()
+	{
+		// only the first chunk is kept, anything after it was needed by an unusually large request
+		while (__chunks.size() > 1)
+		{
+			free(__chunks.back());
+			__chunks.erase(--__chunks.end());
+			__sizes.erase(--__sizes.end());
+		}
+		rewind();
+	}
+
+	void QArena::rewind()
+	{
+		__next = __chunks.empty() ? 0 : 1;
+		__cursor = __chunks.empty() ? nullptr : __chunks[0];
+		__end = __chunks.empty() ? nullptr : __chunks[0] + __sizes[0];
+		__used = 0;
+	}
+
+	std::size_t QArena::getUsed() const
+	{
+		return __used;
+	}
+
+	void* QArena::__allocateSlow(const std::size_t size, const std::size_t alignment)
+	{
+		const std::size_t needed = size + alignment;
+
+		// chunks kept by rewind() are reused in order, one too small for the request is skipped
+		while (__next < __chunks.size())
+		{
+			const std::size_t chunk = __next++;
+			if (__sizes[chunk] >= needed)
+			{
+				__cursor = __chunks[chunk];
+				__end = __chunks[chunk] + __sizes[chunk];
+				return allocate(size, alignment);
+			}
+		}
+
+		const std::size_t chunkSize = needed > __chunkSize ? needed : __chunkSize;
+		char* chunk = static_cast<char*>(malloc(chunkSize));
+		__chunks.push_back(chunk);
+		__sizes.push_back(chunkSize);
+		__next = __chunks.size();
+		__cursor = chunk;
+		__end = chunk + chunkSize;
+		return allocate(size, alignment);
+	}
+}
@@ -0,0 +1,596 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qart.h"
+
+#include <cstdlib>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 )
+#define QSQL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace qsql
+{
+	namespace
+	{
+		inline uint32_t countTrailingZeros(const uint32_t word)
+		{
+#if defined ( _MSC_VER )
+			unsigned long index;
+			_BitScanForward(&index, word);
+			return index;
+#else
+			return static_cast<uint32_t>(__builtin_ctz(word));
+#endif
+		}
+
+		// Index of byte among the count keys of a Node16, count if it is not there
+		inline std::size_t searchNode16(const uint8_t* keys, const std::size_t count, const uint8_t byte)
+		{
+#if defined ( QSQL_SSE2 )
+			const __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches)) & ((1u << count) - 1);
+			return mask ? countTrailingZeros(mask) : count;
+#else
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (keys[i] == byte)
+				{
+					return i;
+				}
+			}
+			return count;
+#endif
+		}
+	}
+
+	QArt::QArt()
+		: __root(nullptr), __size(0)
+	{
+	}
+
+	QArt::~QArt()
+	{
+		clear();
+	}
+
+	std::size_t QArt::size() const
+	{
+		return __size;
+	}
+
+	void QArt::clear()
+	{
+		if (__root)
+		{
+			__free(__root);
+		}
+		__root = nullptr;
+		__size = 0;
+	}
+
+	void QArt::insert(const uint8_t* key, const std::size_t length, const std::size_t row)
+	{
+		__insert(&__root, key, length, row, 0);
+	}
+
+	bool QArt::erase(const uint8_t* key, const std::size_t length)
+	{
+		return __root && __erase(&__root, key, length, 0);
+	}
+
+	bool QArt::find(const uint8_t* key, const std::size_t length, std::size_t& row) const
+	{
+		// prefixes are only checked as far as they are stored, the leaf is compared in full
+		QNode* node = __root;
+		std::size_t depth = 0;
+		while (node && !__isLeaf(node))
+		{
+			const std::size_t stored = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+			if (depth + node->prefixLength >= length || memcmp(node->prefix, key + depth, stored) != 0)
+			{
+				return false;
+			}
+			depth += node->prefixLength;
+			QNode** child = __findChild(node, key[depth]);
+			node = child ? *child : nullptr;
+			depth++;
+		}
+		if (node == nullptr || !__matches(__leaf(node), key, length))
+		{
+			return false;
+		}
+		row = __leaf(node)->row;
+		return true;
+	}
+
+	template<typename Node>
+	Node* QArt::__newNode(const QType type)
+	{
+		Node* node = static_cast<Node*>(calloc(1, sizeof(Node)));
+		node->type = type;
+		return node;
+	}
+
+	QArt::QLeaf* QArt::__newLeaf(const uint8_t* key, const std::size_t length, const std::size_t row)
+	{
+		QLeaf* leaf = static_cast<QLeaf*>(malloc(offsetof(QLeaf, key) + length));
+		leaf->row = row;
+		leaf->length = length;
+		memcpy(leaf->key, key, length);
+		return leaf;
+	}
+
+	bool QArt::__matches(const QLeaf* leaf, const uint8_t* key, const std::size_t length)
+	{
+		return leaf->length == length && memcmp(leaf->key, key, length) == 0;
+	}
+
+	int QArt::__compare(const QLeaf* leaf, const uint8_t* key, const std::size_t length)
+	{
+		const int result = memcmp(leaf->key, key, leaf->length < length ? leaf->length : length);
+		if (result != 0)
+		{
+			return result < 0 ? -1 : 1;
+		}
+		return leaf->length < length ? -1 : (leaf->length > length ? 1 : 0);
+	}
+
+	const QArt::QLeaf* QArt::__minimum(const QNode* node)
+	{
+		while (!__isLeaf(node))
+		{
+			switch (node->type)
+			{
+			case QType::NODE4:
+				node = static_cast<const QNode4*>(node)->children[0];
+				break;
+			case QType::NODE16:
+				node = static_cast<const QNode16*>(node)->children[0];
+				break;
+			case QType::NODE48:
+			{
+				const QNode48* node48 = static_cast<const QNode48*>(node);
+				std::size_t byte = 0;
+				while (node48->slots[byte] == 0)
+				{
+					byte++;
+				}
+				node = node48->children[node48->slots[byte] - 1];
+				break;
+			}
+			case QType::NODE256:
+			{
+				const QNode256* node256 = static_cast<const QNode256*>(node);
+				std::size_t byte = 0;
+				while (node256->children[byte] == nullptr)
+				{
+					byte++;
+				}
+				node = node256->children[byte];
+				break;
+			}
+			}
+		}
+		return __leaf(node);
+	}
+
+	void QArt::__free(QNode* node)
+	{
+		if (__isLeaf(node))
+		{
+			free(__leaf(node));
+			return;
+		}
+
+		switch (node->type)
+		{
+		case QType::NODE4:
+			for (std::size_t i = 0; i < node->count; i++)
+			{
+				__free(static_cast<QNode4*>(node)->children[i]);
+			}
+			break;
+		case QType::NODE16:
+			for (std::size_t i = 0; i < node->count; i++)
+			{
+				__free(static_cast<QNode16*>(node)->children[i]);
+			}
+			break;
+		case QType::NODE48:
+			for (std::size_t i = 0; i < 256; i++)
+			{
+				QNode48* node48 = static_cast<QNode48*>(node);
+				if (node48->slots[i])
+				{
+					__free(node48->children[node48->slots[i] - 1]);
+				}
+			}
+			break;
+		case QType::NODE256:
+			for (std::size_t i = 0; i < 256; i++)
+			{
+				if (static_cast<QNode256*>(node)->children[i])
+				{
+					__free(static_cast<QNode256*>(node)->children[i]);
+				}
+			}
+			break;
+		}
+		free(node);
+	}
+
+	std::size_t QArt::__prefixMismatch(const QNode* node, const uint8_t* key, const std::size_t length, const std::size_t depth)
+	{
+		// bytes past the stored ones are read from any leaf below, they all share the prefix
+		const QLeaf* leaf = node->prefixLength > MAX_PREFIX ? __minimum(node) : nullptr;
+		std::size_t i = 0;
+		for (; i < node->prefixLength && depth + i < length; i++)
+		{
+			const uint8_t byte = i < MAX_PREFIX ? node->prefix[i] : leaf->key[depth + i];
+			if (byte != key[depth + i])
+			{
+				break;
+			}
+		}
+		return i;
+	}
+
+	QArt::QNode** QArt::__findChild(QNode* node, const uint8_t byte)
+	{
+		switch (node->type)
+		{
+		case QType::NODE4:
+		{
+			QNode4* node4 = static_cast<QNode4*>(node);
+			for (std::size_t i = 0; i < node->count; i++)
+			{
+				if (node4->keys[i] == byte)
+				{
+					return &node4->children[i];
+				}
+			}
+			return nullptr;
+		}
+		case QType::NODE16:
+		{
+			QNode16* node16 = static_cast<QNode16*>(node);
+			const std::size_t index = searchNode16(node16->keys, node->count, byte);
+			return index < node->count ? &node16->children[index] : nullptr;
+		}
+		case QType::NODE48:
+		{
+			QNode48* node48 = static_cast<QNode48*>(node);
+			return node48->slots[byte] ? &node48->children[node48->slots[byte] - 1] : nullptr;
+		}
+		case QType::NODE256:
+		{
+			QNode256* node256 = static_cast<QNode256*>(node);
+			return node256->children[byte] ? &node256->children[byte] : nullptr;
+		}
+		}
+		return nullptr;
+	}
+
+	void QArt::__addChild(QNode** reference, const uint8_t byte, QNode* child)
+	{
+		QNode* node = *reference;
+		switch (node->type)
+		{
+		case QType::NODE4:
+		case QType::NODE16:
+		{
+			const bool small = node->type == QType::NODE4;
+			uint8_t* keys = small ? static_cast<QNode4*>(node)->keys : static_cast<QNode16*>(node)->keys;
+			QNode** children = small ? static_cast<QNode4*>(node)->children : static_cast<QNode16*>(node)->children;
+			if (node->count < (small ? 4 : 16))
+			{
+				std::size_t index = 0;
+				while (index < node->count && keys[index] < byte)
+				{
+					index++;
+				}
+				memmove(keys + index + 1, keys + index, node->count - index);
+				memmove(children + index + 1, children + index, (node->count - index) * sizeof(QNode*));
+				keys[index] = byte;
+				children[index] = child;
+				node->count++;
+				return;
+			}
+
+			// a full Node4 becomes a Node16, a full Node16 a Node48
+			QNode* grown;
+			if (small)
+			{
+				QNode16* node16 = __newNode<QNode16>(QType::NODE16);
+				memcpy(node16->keys, keys, node->count);
+				memcpy(node16->children, children, node->count * sizeof(QNode*));
+				grown = node16;
+			}
+			else
+			{
+				QNode48* node48 = __newNode<QNode48>(QType::NODE48);
+				for (std::size_t i = 0; i < node->count; i++)
+				{
+					node48->slots[keys[i]] = static_cast<uint8_t>(i + 1);
+					node48->children[i] = children[i];
+				}
+				grown = node48;
+			}
+			grown->count = node->count;
+			grown->prefixLength = node->prefixLength;
+			memcpy(grown->prefix, node->prefix, MAX_PREFIX);
+			free(node);
+			*reference = grown;
+			__addChild(reference, byte, child);
+			return;
+		}
+		case QType::NODE48:
+		{
+			QNode48* node48 = static_cast<QNode48*>(node);
+			if (node->count < 48)
+			{
+				// slots of removed children are reused
+				std::size_t slot = 0;
+				while (node48->children[slot])
+				{
+					slot++;
+				}
+				node48->children[slot] = child;
+				node48->slots[byte] = static_cast<uint8_t>(slot + 1);
+				node->count++;
+				return;
+			}
+
+			QNode256* node256 = __newNode<QNode256>(QType::NODE256);
+			for (std::size_t i = 0; i < 256; i++)
+			{
+				if (node48->slots[i])
+				{
+					node256->children[i] = node48->children[node48->slots[i] - 1];
+				}
+			}
+			node256->count = node->count;
+			node256->prefixLength = node->prefixLength;
+			memcpy(node256->prefix, node->prefix, MAX_PREFIX);
+			free(node);
+			*reference = node256;
+			__addChild(reference, byte, child);
+			return;
+		}
+		case QType::NODE256:
+			static_cast<QNode256*>(node)->children[byte] = child;
+			node->count++;
+			return;
+		}
+	}
+
+	void QArt::__removeChild(QNode** reference, const uint8_t byte)
+	{
+		QNode* node = *reference;
+		switch (node->type)
+		{
+		case QType::NODE4:
+		case QType::NODE16:
+		{
+			const bool small = node->type == QType::NODE4;
+			uint8_t* keys = small ? static_cast<QNode4*>(node)->keys : static_cast<QNode16*>(node)->keys;
+			QNode** children = small ? static_cast<QNode4*>(node)->children : static_cast<QNode16*>(node)->children;
+			std::size_t index = 0;
+			while (keys[index] != byte)
+			{
+				index++;
+			}
+			memmove(keys + index, keys + index + 1, node->count - index - 1);
+			memmove(children + index, children + index + 1, (node->count - index - 1) * sizeof(QNode*));
+			node->count--;
+
+			if (small && node->count == 1)
+			{
+				// the only child takes the node's place, with the node's prefix and byte before its own
+				QNode* child = children[0];
+				if (!__isLeaf(child))
+				{
+					uint8_t prefix[MAX_PREFIX];
+					std::size_t length = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+					memcpy(prefix, node->prefix, length);
+					if (length < MAX_PREFIX)
+					{
+						prefix[length++] = keys[0];
+					}
+					const std::size_t rest = child->prefixLength < MAX_PREFIX - length ? child->prefixLength : MAX_PREFIX - length;
+					memcpy(prefix + length, child->prefix, rest);
+					memcpy(child->prefix, prefix, length + rest);
+					child->prefixLength += node->prefixLength + 1;
+				}
+				free(node);
+				*reference = child;
+			}
+			else if (!small && node->count == 3)
+			{
+				QNode4* node4 = __newNode<QNode4>(QType::NODE4);
+				memcpy(node4->keys, keys, node->count);
+				memcpy(node4->children, children, node->count * sizeof(QNode*));
+				node4->count = node->count;
+				node4->prefixLength = node->prefixLength;
+				memcpy(node4->prefix, node->prefix, MAX_PREFIX);
+				free(node);
+				*reference = node4;
+			}
+			return;
+		}
+		case QType::NODE48:
+		{
+			QNode48* node48 = static_cast<QNode48*>(node);
+			node48->children[node48->slots[byte] - 1] = nullptr;
+			node48->slots[byte] = 0;
+			node->count--;
+			if (node->count == 12)
+			{
+				QNode16* node16 = __newNode<QNode16>(QType::NODE16);
+				std::size_t count = 0;
+				for (std::size_t i = 0; i < 256; i++)
+				{
+					if (node48->slots[i])
+					{
+						node16->keys[count] = static_cast<uint8_t>(i);
+						node16->children[count++] = node48->children[node48->slots[i] - 1];
+					}
+				}
+				node16->count = node->count;
+				node16->prefixLength = node->prefixLength;
+				memcpy(node16->prefix, node->prefix, MAX_PREFIX);
+				free(node);
+				*reference = node16;
+			}
+			return;
+		}
+		case QType::NODE256:
+		{
+			QNode256* node256 = static_cast<QNode256*>(node);
+			node256->children[byte] = nullptr;
+			node->count--;
+			if (node->count == 37)
+			{
+				QNode48* node48 = __newNode<QNode48>(QType::NODE48);
+				std::size_t count = 0;
+				for (std::size_t i = 0; i < 256; i++)
+				{
+					if (node256->children[i])
+					{
+						node48->children[count] = node256->children[i];
+						node48->slots[i] = static_cast<uint8_t>(++count);
+					}
+				}
+				node48->count = node->count;
+				node48->prefixLength = node->prefixLength;
+				memcpy(node48->prefix, node->prefix, MAX_PREFIX);
+				free(node);
+				*reference = node48;
+			}
+			return;
+		}
+		}
+	}
+
+	void QArt::__insert(QNode** reference, const uint8_t* key, const std::size_t length, const std::size_t row, std::size_t depth)
+	{
+		QNode* node = *reference;
+		if (node == nullptr)
+		{
+			*reference = __tag(__newLeaf(key, length, row));
+			__size++;
+			return;
+		}
+
+		if (__isLeaf(node))
+		{
+			QLeaf* leaf = __leaf(node);
+			if (__matches(leaf, key, length))
+			{
+				leaf->row = row;
+				return;
+			}
+
+			// the two keys part after their common bytes, which become the prefix
+			std::size_t common = 0;
+			while (depth + common < length && depth + common < leaf->length && key[depth + common] == leaf->key[depth + common])
+			{
+				common++;
+			}
+			QNode4* split = __newNode<QNode4>(QType::NODE4);
+			split->prefixLength = static_cast<uint32_t>(common);
+			memcpy(split->prefix, key + depth, common < MAX_PREFIX ? common : MAX_PREFIX);
+			*reference = split;
+			__addChild(reference, leaf->key[depth + common], node);
+			__addChild(reference, key[depth + common], __tag(__newLeaf(key, length, row)));
+			__size++;
+			return;
+		}
+
+		if (node->prefixLength > 0)
+		{
+			const std::size_t mismatch = __prefixMismatch(node, key, length, depth);
+			if (mismatch < node->prefixLength)
+			{
+				// a new node takes the matching part of the prefix, the old one keeps what follows its byte
+				QNode4* split = __newNode<QNode4>(QType::NODE4);
+				split->prefixLength = static_cast<uint32_t>(mismatch);
+				memcpy(split->prefix, node->prefix, mismatch < MAX_PREFIX ? mismatch : MAX_PREFIX);
+
+				uint8_t byte;
+				if (node->prefixLength <= MAX_PREFIX)
+				{
+					byte = node->prefix[mismatch];
+					node->prefixLength -= static_cast<uint32_t>(mismatch + 1);
+					memmove(node->prefix, node->prefix + mismatch + 1, node->prefixLength);
+				}
+				else
+				{
+					const QLeaf* leaf = __minimum(node);
+					byte = leaf->key[depth + mismatch];
+					node->prefixLength -= static_cast<uint32_t>(mismatch + 1);
+					memcpy(node->prefix, leaf->key + depth + mismatch + 1, node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX);
+				}
+
+				*reference = split;
+				__addChild(reference, byte, node);
+				__addChild(reference, key[depth + mismatch], __tag(__newLeaf(key, length, row)));
+				__size++;
+				return;
+			}
+			depth += node->prefixLength;
+		}
+
+		QNode** child = __findChild(node, key[depth]);
+		if (child)
+		{
+			__insert(child, key, length, row, depth + 1);
+			return;
+		}
+		__addChild(reference, key[depth], __tag(__newLeaf(key, length, row)));
+		__size++;
+	}
+
+	bool QArt::__erase(QNode** reference, const uint8_t* key, const std::size_t length, std::size_t depth)
+	{
+		QNode* node = *reference;
+		if (__isLeaf(node))
+		{
+			// only the root can be a leaf reached here
+			if (!__matches(__leaf(node), key, length))
+			{
+				return false;
+			}
+			free(__leaf(node));
+			*reference = nullptr;
+			__size--;
+			return true;
+		}
+
+		const std::size_t stored = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+		if (depth + node->prefixLength >= length || memcmp(node->prefix, key + depth, stored) != 0)
+		{
+			return false;
+		}
+		depth += node->prefixLength;
+
+		QNode** child = __findChild(node, key[depth]);
+		if (child == nullptr)
+		{
+			return false;
+		}
+		if (!__isLeaf(*child))
+		{
+			return __erase(child, key, length, depth + 1);
+		}
+		if (!__matches(__leaf(*child), key, length))
+		{
+			return false;
+		}
+		free(__leaf(*child));
+		__removeChild(reference, key[depth]);
+		__size--;
+		return true;
+	}
+}
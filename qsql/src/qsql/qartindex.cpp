@@ -0,0 +1,278 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qartindex.h"
+#include "qsql/qtable.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr std::size_t ROW_BYTES = 8;
+
+		// big-endian with the sign bit flipped, so that the bytes compare like the values
+		void appendInteger(qtl::vector<uint8_t>& key, const int64_t value)
+		{
+			const uint64_t bits = static_cast<uint64_t>(value) ^ (static_cast<uint64_t>(1) << 63);
+			for (int shift = 56; shift >= 0; shift -= 8)
+			{
+				key.push_back(static_cast<uint8_t>(bits >> shift));
+			}
+		}
+
+		// a NUL byte is escaped to 0 1 and the string ends with 0 0, so that no
+		// string's key is a prefix of another's
+		void appendString(qtl::vector<uint8_t>& key, const qtl::string& value)
+		{
+			for (std::size_t i = 0; i < value.length(); i++)
+			{
+				const uint8_t byte = static_cast<uint8_t>(value[i]);
+				key.push_back(byte);
+				if (byte == 0)
+				{
+					key.push_back(1);
+				}
+			}
+			key.push_back(0);
+			key.push_back(0);
+		}
+
+		void appendRow(qtl::vector<uint8_t>& key, const std::size_t row)
+		{
+			for (int shift = 56; shift >= 0; shift -= 8)
+			{
+				key.push_back(static_cast<uint8_t>(static_cast<uint64_t>(row) >> shift));
+			}
+		}
+
+		// Compares the value of a key, without its row, to an encoded value
+		int compareValue(const uint8_t* key, const std::size_t length, const qtl::vector<uint8_t>& value)
+		{
+			const std::size_t size = length - ROW_BYTES;
+			const int result = memcmp(key, value.data(), size < value.size() ? size : value.size());
+			if (result != 0)
+			{
+				return result;
+			}
+			return size < value.size() ? -1 : (size > value.size() ? 1 : 0);
+		}
+	}
+
+	QArtRange::QArtRange()
+		: __index(nullptr), __descending(false), __empty(true), __hasStart(false), __inclusive(false), __bounded(false), __endInclusive(false)
+	{
+	}
+
+	std::size_t QArtRange::next(std::size_t* rows, const std::size_t count)
+	{
+		if (__empty)
+		{
+			return 0;
+		}
+
+		// every call walks the tree again from the last row returned
+		std::size_t written = 0;
+		const uint8_t* lastKey = nullptr;
+		std::size_t lastLength = 0;
+		auto visitor = [&](const uint8_t* key, const std::size_t length, const std::size_t row)
+		{
+			if (__bounded)
+			{
+				const int result = compareValue(key, length, __end) * (__descending ? -1 : 1);
+				if (result > 0 || (result == 0 && !__endInclusive))
+				{
+					return false;
+				}
+			}
+			rows[written++] = row;
+			lastKey = key;
+			lastLength = length;
+			return written < count;
+		};
+		__index->__tree.visit(__hasStart ? __start.data() : nullptr, __start.size(), __inclusive, __descending, visitor);
+
+		if (written < count)
+		{
+			__empty = true;
+		}
+		if (written > 0)
+		{
+			__start.clear();
+			for (std::size_t i = 0; i < lastLength; i++)
+			{
+				__start.push_back(lastKey[i]);
+			}
+			__hasStart = true;
+			__inclusive = false;
+		}
+		return written;
+	}
+
+	QArtIndex::QArtIndex(const QTable& table, const std::size_t column)
+		: __table(table), __column(column), __type(table.getColumnType(column))
+	{
+		assert(isSupported(__type));
+	}
+
+	bool QArtIndex::isSupported(const QDataType type)
+	{
+		return type == QDataType::CHAR || type == QDataType::INT || type == QDataType::LONG || type == QDataType::STRING;
+	}
+
+	std::size_t QArtIndex::getColumn() const
+	{
+		return __column;
+	}
+
+	std::size_t QArtIndex::size() const
+	{
+		return __tree.size();
+	}
+
+	void QArtIndex::insert(const std::size_t row)
+	{
+		qtl::vector<uint8_t> key;
+		if (__key(row, key))
+		{
+			__tree.insert(key.data(), key.size(), row);
+		}
+	}
+
+	void QArtIndex::erase(const std::size_t row)
+	{
+		qtl::vector<uint8_t> key;
+		if (__key(row, key))
+		{
+			__tree.erase(key.data(), key.size());
+		}
+	}
+
+	std::size_t QArtIndex::find(const QValue& value, qtl::vector<std::size_t>& rows) const
+	{
+		qtl::vector<uint8_t> key;
+		if (!__bound(value, key))
+		{
+			return 0;
+		}
+
+		// the rows of a value are the keys it is a prefix of
+		std::size_t count = 0;
+		auto visitor = [&](const uint8_t* found, const std::size_t length, const std::size_t row)
+		{
+			if (compareValue(found, length, key) != 0)
+			{
+				return false;
+			}
+			rows.push_back(row);
+			count++;
+			return true;
+		};
+		__tree.visit(key.data(), key.size(), true, false, visitor);
+		return count;
+	}
+
+	void QArtIndex::open(QArtRange& range, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, const bool descending) const
+	{
+		range.__index = this;
+		range.__descending = descending;
+		range.__start.clear();
+		range.__end.clear();
+
+		qtl::vector<uint8_t> lowKey;
+		qtl::vector<uint8_t> highKey;
+		range.__empty = (low && !__bound(*low, lowKey)) || (high && !__bound(*high, highKey));
+		if (range.__empty)
+		{
+			return;
+		}
+
+		// keys of the starting value come after its bytes, and before them followed by the largest row
+		const QValue* start = descending ? high : low;
+		const bool startInclusive = descending ? highInclusive : lowInclusive;
+		range.__hasStart = start != nullptr;
+		range.__inclusive = true;
+		range.__start = qtl::move(descending ? highKey : lowKey);
+		if (start && startInclusive == descending)
+		{
+			for (std::size_t i = 0; i < ROW_BYTES; i++)
+			{
+				range.__start.push_back(0xFF);
+			}
+		}
+
+		range.__bounded = (descending ? low : high) != nullptr;
+		range.__endInclusive = descending ? lowInclusive : highInclusive;
+		range.__end = qtl::move(descending ? lowKey : highKey);
+	}
+
+	bool QArtIndex::__key(const std::size_t row, qtl::vector<uint8_t>& key) const
+	{
+		QField field = __table.getRow(row).get(__column);
+		if (field.isNull())
+		{
+			return false;
+		}
+
+		key.reserve(__type == QDataType::STRING ? field.get<qtl::string>().length() + 2 + ROW_BYTES : 2 * ROW_BYTES);
+
+		switch (__type)
+		{
+		case QDataType::CHAR:
+			appendInteger(key, field.get<char>());
+			break;
+		case QDataType::INT:
+			appendInteger(key, field.get<int32_t>());
+			break;
+		case QDataType::LONG:
+			appendInteger(key, field.get<int64_t>());
+			break;
+		case QDataType::STRING:
+			appendString(key, field.get<qtl::string>());
+			break;
+		case QDataType::BOOL:
+			return false;
+		}
+		appendRow(key, row);
+		return true;
+	}
+
+	bool QArtIndex::__bound(const QValue& value, qtl::vector<uint8_t>& key) const
+	{
+		if (value.isNull())
+		{
+			return false;
+		}
+
+		if (__type == QDataType::STRING)
+		{
+			if (value.getType() != QDataType::STRING)
+			{
+				return false;
+			}
+			appendString(key, value.getString());
+			return true;
+		}
+
+		// integral values compare widened, a one character string bounds a CHAR
+		if (value.getType() == QDataType::STRING)
+		{
+			if (__type != QDataType::CHAR || value.getString().length() != 1)
+			{
+				return false;
+			}
+			appendInteger(key, value.getString()[0]);
+			return true;
+		}
+		if (value.getType() == QDataType::BOOL)
+		{
+			return false;
+		}
+		int64_t integer = 0;
+		value.store(QDataType::LONG, &integer);
+		key.reserve(ROW_BYTES);
+		appendInteger(key, integer);
+		return true;
+	}
+}
@@ -0,0 +1,253 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qbatch.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace qsql
+{
+	QVector::QVector()
+		: __type(QDataType::INT), __data(nullptr), __nulls(nullptr), __dictionary(nullptr),
+		__bufferType(QDataType::INT), __buffer(nullptr), __nullBuffer(nullptr)
+	{
+	}
+
+	QVector::~QVector()
+	{
+		__releaseBuffer();
+		free(__nullBuffer);
+	}
+
+	QDataType QVector::getType() const
+	{
+		return __type;
+	}
+
+	void* QVector::getData() const
+	{
+		return __data;
+	}
+
+	const uint64_t* QVector::getNulls() const
+	{
+		return __nulls;
+	}
+
+	QValue QVector::getValue(const std::size_t index) const
+	{
+		if (isNull(index))
+		{
+			return QValue();
+		}
+
+		switch (__type)
+		{
+		case QDataType::CHAR:
+			return QValue(getData<char>()[index]);
+		case QDataType::INT:
+			return QValue(getData<int32_t>()[index]);
+		case QDataType::LONG:
+			return QValue(getData<int64_t>()[index]);
+		case QDataType::BOOL:
+			return QValue(getData<bool>()[index]);
+		case QDataType::STRING:
+			if (__dictionary)
+			{
+				return QValue(__dictionary->decode(getData<uint32_t>()[index]));
+			}
+			return QValue(getData<qtl::string>()[index]);
+		}
+		return QValue();
+	}
+
+	void QVector::reference(const QDataType type, void* data, const uint64_t* nulls)
+	{
+		__type = type;
+		__data = data;
+		__nulls = nulls;
+		__dictionary = nullptr;
+	}
+
+	void QVector::reference(const QVector& other)
+	{
+		reference(other.__type, other.__data, other.__nulls);
+		__dictionary = other.__dictionary;
+	}
+
+	void QVector::referenceCodes(const QDictionary& dictionary, const uint32_t* codes, const uint64_t* nulls)
+	{
+		reference(QDataType::STRING, const_cast<uint32_t*>(codes), nulls);
+		__dictionary = &dictionary;
+	}
+
+	void QVector::initialize(const QDataType type)
+	{
+		if (__buffer == nullptr || __bufferType != type)
+		{
+			__releaseBuffer();
+			if (type == QDataType::STRING)
+			{
+				__buffer = new qtl::string[CAPACITY];
+			}
+			else
+			{
+				__buffer = malloc(CAPACITY * getDataTypeSize(type));
+			}
+			__bufferType = type;
+		}
+		__type = type;
+		__data = __buffer;
+		__nulls = nullptr;
+		__dictionary = nullptr;
+	}
+
+	uint32_t* QVector::initializeCodes(const QDictionary& dictionary)
+	{
+		// codes share the buffer of INT values, which has the same width
+		initialize(QDataType::INT);
+		__type = QDataType::STRING;
+		__dictionary = &dictionary;
+		return getData<uint32_t>();
+	}
+
+	void QVector::decode(const QVector& other, const std::size_t count)
+	{
+		const QDictionary& dictionary = *other.__dictionary;
+		const uint32_t* codes = other.getData<uint32_t>();
+		initialize(QDataType::STRING);
+		qtl::string* values = getData<qtl::string>();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			if (!other.isNull(i))
+			{
+				values[i] = dictionary.decode(codes[i]);
+			}
+		}
+		if (other.__nulls)
+		{
+			memcpy(initializeNulls(), other.__nulls, (count + 63) / 64 * sizeof(uint64_t));
+		}
+	}
+
+	uint64_t* QVector::initializeNulls()
+	{
+		if (__nullBuffer == nullptr)
+		{
+			__nullBuffer = static_cast<uint64_t*>(malloc(NULL_WORDS * sizeof(uint64_t)));
+		}
+		memset(__nullBuffer, 0, NULL_WORDS * sizeof(uint64_t));
+		__nulls = __nullBuffer;
+		return __nullBuffer;
+	}
+
+	void QVector::clearNulls()
+	{
+		__nulls = nullptr;
+	}
+
+	void QVector::__releaseBuffer()
+	{
+		if (__buffer == nullptr)
+		{
+			return;
+		}
+		if (__bufferType == QDataType::STRING)
+		{
+			delete[] static_cast<qtl::string*>(__buffer);
+		}
+		else
+		{
+			free(__buffer);
+		}
+		__buffer = nullptr;
+	}
+
+	QBatch::QBatch()
+		: __size(0), __rowOffset(0), __rowIds(nullptr), __selection(nullptr), __selectionSize(0),
+		__selectionBuffer(static_cast<uint16_t*>(malloc(CAPACITY * sizeof(uint16_t))))
+	{
+	}
+
+	QBatch::QBatch(const std::size_t columns)
+		: QBatch()
+	{
+		setColumnCount(columns);
+	}
+
+	QBatch::~QBatch()
+	{
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			delete __columns[i];
+		}
+		free(__selectionBuffer);
+	}
+
+	void QBatch::setColumnCount(const std::size_t columns)
+	{
+		while (__columns.size() < columns)
+		{
+			__columns.push_back(new QVector());
+		}
+		while (__columns.size() > columns)
+		{
+			delete __columns.back();
+			__columns.erase(--__columns.end());
+		}
+	}
+
+	std::size_t QBatch::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	void QBatch::setSize(const std::size_t size)
+	{
+		__size = size;
+	}
+
+	std::size_t QBatch::getRowOffset() const
+	{
+		return __rowOffset;
+	}
+
+	void QBatch::setRowOffset(const std::size_t offset)
+	{
+		__rowOffset = offset;
+		__rowIds = nullptr;
+	}
+
+	const std::size_t* QBatch::getRowIds() const
+	{
+		return __rowIds;
+	}
+
+	void QBatch::setRowIds(const std::size_t* rows)
+	{
+		__rowIds = rows;
+	}
+
+	uint16_t* QBatch::getSelectionBuffer()
+	{
+		return __selectionBuffer;
+	}
+
+	void QBatch::setSelection(const std::size_t count)
+	{
+		__selection = __selectionBuffer;
+		__selectionSize = count;
+	}
+
+	void QBatch::referenceSelection(const QBatch& other)
+	{
+		__selection = other.__selection;
+		__selectionSize = other.__selectionSize;
+	}
+
+	void QBatch::clearSelection()
+	{
+		__selection = nullptr;
+		__selectionSize = 0;
+	}
+}
@@ -0,0 +1,159 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qbitmapindex.h"
+#include "qsql/qtable.h"
+
+#include <cassert>
+
+namespace qsql
+{
+	QBitmapIndex::QBitmapIndex(const QTable& table, const std::size_t column)
+		: __table(table), __column(column), __type(table.getColumnType(column)), __keys(0)
+	{
+		assert(isSupported(__type));
+	}
+
+	QBitmapIndex::~QBitmapIndex()
+	{
+		for (QRoaringBitmap* bitmap : __bitmaps)
+		{
+			delete bitmap;
+		}
+	}
+
+	bool QBitmapIndex::isSupported(const QDataType type)
+	{
+		return type == QDataType::BOOL || type == QDataType::CHAR || type == QDataType::STRING;
+	}
+
+	std::size_t QBitmapIndex::getColumn() const
+	{
+		return __column;
+	}
+
+	std::size_t QBitmapIndex::size() const
+	{
+		return __rows.getCardinality();
+	}
+
+	std::size_t QBitmapIndex::getKeyCount() const
+	{
+		return __keys;
+	}
+
+	void QBitmapIndex::insert(const std::size_t row)
+	{
+		const uint32_t key = __key(row, true);
+		if (key == NONE)
+		{
+			return;
+		}
+
+		while (__bitmaps.size() <= key)
+		{
+			__bitmaps.push_back(nullptr);
+		}
+		if (__bitmaps[key] == nullptr)
+		{
+			__bitmaps[key] = new QRoaringBitmap();
+			__keys++;
+		}
+		__bitmaps[key]->add(row);
+		__rows.add(row);
+	}
+
+	void QBitmapIndex::erase(const std::size_t row)
+	{
+		const uint32_t key = __key(row, false);
+		if (key == NONE || key >= __bitmaps.size() || __bitmaps[key] == nullptr)
+		{
+			return;
+		}
+
+		__bitmaps[key]->remove(row);
+		__rows.remove(row);
+		if (__bitmaps[key]->isEmpty())
+		{
+			delete __bitmaps[key];
+			__bitmaps[key] = nullptr;
+			__keys--;
+		}
+	}
+
+	bool QBitmapIndex::canFind(const QValue& value) const
+	{
+		if (value.isNull() || value.getType() == __type)
+		{
+			return true;
+		}
+		return __type == QDataType::CHAR && value.getType() == QDataType::STRING && value.getString().length() == 1;
+	}
+
+	const QRoaringBitmap* QBitmapIndex::find(const QValue& value) const
+	{
+		const uint32_t key = __key(value);
+		return key < __bitmaps.size() ? __bitmaps[key] : nullptr;
+	}
+
+	const QRoaringBitmap& QBitmapIndex::getRows() const
+	{
+		return __rows;
+	}
+
+	void QBitmapIndex::optimize()
+	{
+		for (QRoaringBitmap* bitmap : __bitmaps)
+		{
+			if (bitmap)
+			{
+				bitmap->optimize();
+			}
+		}
+		__rows.optimize();
+	}
+
+	uint32_t QBitmapIndex::__key(const std::size_t row, const bool add)
+	{
+		QField field = __table.getRow(row).get(__column);
+		if (field.isNull())
+		{
+			return NONE;
+		}
+
+		switch (__type)
+		{
+		case QDataType::BOOL:
+			return field.get<bool>() ? 1 : 0;
+		case QDataType::CHAR:
+			return static_cast<unsigned char>(field.get<char>());
+		case QDataType::STRING:
+			return add ? __strings.encode(field.get<qtl::string>()) : __strings.find(field.get<qtl::string>());
+		case QDataType::INT:
+		case QDataType::LONG:
+			break;
+		}
+		return NONE;
+	}
+
+	uint32_t QBitmapIndex::__key(const QValue& value) const
+	{
+		if (!canFind(value) || value.isNull())
+		{
+			return NONE;
+		}
+
+		switch (__type)
+		{
+		case QDataType::BOOL:
+			return value.getBool() ? 1 : 0;
+		case QDataType::CHAR:
+			return static_cast<unsigned char>(value.getType() == QDataType::STRING ? value.getString()[0] : value.getChar());
+		case QDataType::STRING:
+			return __strings.find(value.getString());
+		case QDataType::INT:
+		case QDataType::LONG:
+			break;
+		}
+		return NONE;
+	}
+}
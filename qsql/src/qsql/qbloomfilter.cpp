@@ -0,0 +1,138 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qbloomfilter.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <qtl/hash.h>
+
+#include "qsql/qsimd.h"
+
+namespace qsql
+{
+	namespace
+	{
+		// Finalizer of MurmurHash3, the high bits of the result pick the block
+		inline uint64_t mixHash(uint64_t hash)
+		{
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdULL;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ULL;
+			hash ^= hash >> 33;
+			return hash;
+		}
+	}
+
+	QBloomFilter::QBloomFilter()
+		: __allocation(nullptr), __blocks(nullptr), __blockCount(0)
+	{
+	}
+
+	QBloomFilter::QBloomFilter(const std::size_t keys, const std::size_t bitsPerKey)
+		: __allocation(nullptr), __blocks(nullptr), __blockCount(0)
+	{
+		resize(keys, bitsPerKey);
+	}
+
+	QBloomFilter::~QBloomFilter()
+	{
+		clear();
+	}
+
+	void QBloomFilter::resize(const std::size_t keys, const std::size_t bitsPerKey)
+	{
+		clear();
+
+		// at least one block, so a filter of no keys rejects every key
+		const std::size_t bits = keys * bitsPerKey;
+		__blockCount = (bits + BLOCK_BYTES * 8 - 1) / (BLOCK_BYTES * 8);
+		__blockCount = __blockCount ? __blockCount : 1;
+		__allocation = malloc(__blockCount * BLOCK_BYTES + BLOCK_BYTES - 1);
+		__blocks = reinterpret_cast<uint64_t*>((reinterpret_cast<std::size_t>(__allocation) + BLOCK_BYTES - 1) & ~(BLOCK_BYTES - 1));
+		memset(__blocks, 0, __blockCount * BLOCK_BYTES);
+	}
+
+	void QBloomFilter::clear()
+	{
+		free(__allocation);
+		__allocation = nullptr;
+		__blocks = nullptr;
+		__blockCount = 0;
+	}
+
+	std::size_t QBloomFilter::getBlockCount() const
+	{
+		return __blockCount;
+	}
+
+	std::size_t QBloomFilter::getBytes() const
+	{
+		return __blockCount * BLOCK_BYTES;
+	}
+
+	void QBloomFilter::insert(const uint64_t hash)
+	{
+		if (__blockCount)
+		{
+			bloomInsert(__blocks, __blockCount, hash);
+		}
+	}
+
+	bool QBloomFilter::contains(const uint64_t hash) const
+	{
+		return __blockCount == 0 || bloomContains(__blocks, __blockCount, hash);
+	}
+
+	std::size_t QBloomFilter::filter(const uint64_t* hashes, const std::size_t count, uint64_t* bitmap) const
+	{
+		const std::size_t words = (count + 63) / 64;
+		if (__blockCount == 0)
+		{
+			for (std::size_t word = 0; word < words; word++)
+			{
+				bitmap[word] = ~static_cast<uint64_t>(0);
+			}
+			if (count & 63)
+			{
+				bitmap[words - 1] = (static_cast<uint64_t>(1) << (count & 63)) - 1;
+			}
+			return count;
+		}
+		filterBloom(__blocks, __blockCount, hashes, count, bitmap);
+		return bitmapCount(bitmap, words);
+	}
+
+	uint64_t QBloomFilter::hashKey(const int64_t key)
+	{
+		return mixHash(qtl::hash<int64_t>()(key));
+	}
+
+	uint64_t QBloomFilter::hashString(const qtl::string& key)
+	{
+		return mixHash(qtl::hash<qtl::string>()(key));
+	}
+
+	bool QBloomFilter::hashValue(const QValue& value, uint64_t& hash)
+	{
+		switch (value.getType())
+		{
+		case QDataType::CHAR:
+			hash = hashKey(value.getChar());
+			return true;
+		case QDataType::INT:
+			hash = hashKey(value.getInt());
+			return true;
+		case QDataType::LONG:
+			hash = hashKey(value.getLong());
+			return true;
+		case QDataType::STRING:
+			hash = hashString(value.getString());
+			return true;
+		case QDataType::BOOL:
+			break;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,218 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qbtreeindex.h"
+#include "qsql/qtable.h"
+
+#include <cassert>
+
+namespace qsql
+{
+	QBTreeRange::QBTreeRange()
+		: __index(nullptr), __descending(false), __empty(true), __hasLow(false), __lowInclusive(false), __lowKey(0),
+		__hasHigh(false), __highInclusive(false), __highKey(0), __started(false), __lastRow(0), __lastKey(0)
+	{
+	}
+
+	std::size_t QBTreeRange::next(std::size_t* rows, const std::size_t count)
+	{
+		if (__empty)
+		{
+			return 0;
+		}
+		if (__index->__type == QDataType::STRING)
+		{
+			return __next(__index->__strings, __lowString, __highString, __lastString, rows, count);
+		}
+		return __next(__index->__keys, __lowKey, __highKey, __lastKey, rows, count);
+	}
+
+	template<typename Key>
+	std::size_t QBTreeRange::__next(const QBTree<Key>& tree, const Key& low, const Key& high, Key& last, std::size_t* rows, const std::size_t count)
+	{
+		// every call seeks again past the last row returned
+		typename QBTree<Key>::QCursor cursor;
+		if (__started)
+		{
+			cursor = __descending ? tree.lastBelow(last, __lastRow) : tree.upperBound(last, __lastRow);
+		}
+		else if (__descending)
+		{
+			cursor = !__hasHigh ? tree.last() : (__highInclusive ? tree.lastNotAbove(high) : tree.lastBelow(high));
+		}
+		else
+		{
+			cursor = !__hasLow ? tree.first() : (__lowInclusive ? tree.lowerBound(low) : tree.upperBound(low));
+		}
+
+		const bool bounded = __descending ? __hasLow : __hasHigh;
+		const bool inclusive = __descending ? __lowInclusive : __highInclusive;
+		const Key& end = __descending ? low : high;
+		const Key* lastKey = nullptr;
+		std::size_t written = 0;
+		while (written < count && cursor.isValid())
+		{
+			if (bounded)
+			{
+				const int result = compareKeys(cursor.getKey(), end) * (__descending ? -1 : 1);
+				if (result > 0 || (result == 0 && !inclusive))
+				{
+					break;
+				}
+			}
+
+			lastKey = &cursor.getKey();
+			rows[written++] = cursor.getRow();
+			if (__descending)
+			{
+				cursor.previous();
+			}
+			else
+			{
+				cursor.next();
+			}
+		}
+
+		if (written < count)
+		{
+			__empty = true;
+		}
+		if (written > 0)
+		{
+			last = *lastKey;
+			__lastRow = rows[written - 1];
+			__started = true;
+		}
+		return written;
+	}
+
+	QBTreeIndex::QBTreeIndex(const QTable& table, const std::size_t column)
+		: __table(table), __column(column), __type(table.getColumnType(column))
+	{
+		assert(isSupported(__type));
+	}
+
+	bool QBTreeIndex::isSupported(const QDataType type)
+	{
+		return type == QDataType::CHAR || type == QDataType::INT || type == QDataType::LONG || type == QDataType::STRING;
+	}
+
+	std::size_t QBTreeIndex::getColumn() const
+	{
+		return __column;
+	}
+
+	std::size_t QBTreeIndex::size() const
+	{
+		return __type == QDataType::STRING ? __strings.size() : __keys.size();
+	}
+
+	void QBTreeIndex::insert(const std::size_t row)
+	{
+		QField field = __table.getRow(row).get(__column);
+		if (field.isNull())
+		{
+			return;
+		}
+
+		if (__type == QDataType::STRING)
+		{
+			__strings.insert(field.get<qtl::string>(), row);
+			return;
+		}
+
+		int64_t key = 0;
+		if (__key(row, key))
+		{
+			__keys.insert(key, row);
+		}
+	}
+
+	void QBTreeIndex::erase(const std::size_t row)
+	{
+		QField field = __table.getRow(row).get(__column);
+		if (field.isNull())
+		{
+			return;
+		}
+
+		if (__type == QDataType::STRING)
+		{
+			__strings.erase(field.get<qtl::string>(), row);
+			return;
+		}
+
+		int64_t key = 0;
+		if (__key(row, key))
+		{
+			__keys.erase(key, row);
+		}
+	}
+
+	void QBTreeIndex::open(QBTreeRange& range, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, const bool descending) const
+	{
+		range.__index = this;
+		range.__descending = descending;
+		range.__started = false;
+		range.__hasLow = low != nullptr;
+		range.__lowInclusive = lowInclusive;
+		range.__hasHigh = high != nullptr;
+		range.__highInclusive = highInclusive;
+		range.__empty = (low && !__bound(*low, range.__lowKey, range.__lowString)) || (high && !__bound(*high, range.__highKey, range.__highString));
+	}
+
+	bool QBTreeIndex::__key(const std::size_t row, int64_t& key) const
+	{
+		QField field = __table.getRow(row).get(__column);
+		switch (__type)
+		{
+		case QDataType::CHAR:
+			key = field.get<char>();
+			return true;
+		case QDataType::INT:
+			key = field.get<int32_t>();
+			return true;
+		case QDataType::LONG:
+			key = field.get<int64_t>();
+			return true;
+		case QDataType::BOOL:
+		case QDataType::STRING:
+			break;
+		}
+		return false;
+	}
+
+	bool QBTreeIndex::__bound(const QValue& value, int64_t& key, qtl::string& string) const
+	{
+		if (value.isNull())
+		{
+			return false;
+		}
+
+		if (__type == QDataType::STRING)
+		{
+			if (value.getType() != QDataType::STRING)
+			{
+				return false;
+			}
+			string = value.getString();
+			return true;
+		}
+
+		// integral values compare widened, a one character string bounds a CHAR
+		if (value.getType() == QDataType::STRING)
+		{
+			if (__type != QDataType::CHAR || value.getString().length() != 1)
+			{
+				return false;
+			}
+			key = value.getString()[0];
+			return true;
+		}
+		if (value.getType() == QDataType::BOOL)
+		{
+			return false;
+		}
+		value.store(QDataType::LONG, &key);
+		return true;
+	}
+}
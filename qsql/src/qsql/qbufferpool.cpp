@@ -0,0 +1,527 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qbufferpool.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined ( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qsql
+{
+	namespace
+	{
+		int openFile(const char* path, uint64_t& size)
+		{
+#if defined ( _WIN32 )
+			int file = -1;
+			_sopen_s(&file, path, _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+			const int64_t end = file >= 0 ? _lseeki64(file, 0, SEEK_END) : -1;
+#else
+			const int file = ::open(path, O_RDWR | O_CLOEXEC);
+			struct stat status;
+			const int64_t end = file >= 0 && fstat(file, &status) == 0 ? static_cast<int64_t>(status.st_size) : -1;
+#endif
+			size = end >= 0 ? static_cast<uint64_t>(end) : 0;
+			return file;
+		}
+
+		// Returns the number of bytes read, less than size only at the end of the file or on an error
+		std::size_t readAt(const int file, void* data, const std::size_t size, const uint64_t offset)
+		{
+			std::size_t done = 0;
+#if defined ( _WIN32 )
+			if (_lseeki64(file, static_cast<int64_t>(offset), SEEK_SET) < 0)
+			{
+				return 0;
+			}
+#endif
+			while (done < size)
+			{
+#if defined ( _WIN32 )
+				const int result = _read(file, static_cast<char*>(data) + done, static_cast<unsigned int>(size - done));
+#else
+				const ssize_t result = ::pread(file, static_cast<char*>(data) + done, size - done, static_cast<off_t>(offset + done));
+				if (result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (result <= 0)
+				{
+					break;
+				}
+				done += static_cast<std::size_t>(result);
+			}
+			return done;
+		}
+
+		bool writeAt(const int file, const void* data, const std::size_t size, const uint64_t offset)
+		{
+			std::size_t done = 0;
+#if defined ( _WIN32 )
+			if (_lseeki64(file, static_cast<int64_t>(offset), SEEK_SET) < 0)
+			{
+				return false;
+			}
+#endif
+			while (done < size)
+			{
+#if defined ( _WIN32 )
+				const int result = _write(file, static_cast<const char*>(data) + done, static_cast<unsigned int>(size - done));
+#else
+				const ssize_t result = ::pwrite(file, static_cast<const char*>(data) + done, size - done, static_cast<off_t>(offset + done));
+				if (result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (result <= 0)
+				{
+					return false;
+				}
+				done += static_cast<std::size_t>(result);
+			}
+			return true;
+		}
+
+		bool syncFile(const int file)
+		{
+#if defined ( _WIN32 )
+			return _commit(file) == 0;
+#elif defined ( __linux__ )
+			return ::fdatasync(file) == 0;
+#else
+			return ::fsync(file) == 0;
+#endif
+		}
+
+		void closeFile(const int file)
+		{
+#if defined ( _WIN32 )
+			_close(file);
+#else
+			::close(file);
+#endif
+		}
+	}
+
+	QBufferPool::QBufferPool(const std::size_t frames)
+		: __memory(nullptr), __mask(0), __hand(0), __hits(0), __misses(0), __evictions(0), __writes(0)
+	{
+		assert(frames > 0);
+		__error[0] = '\0';
+		__memory = static_cast<char*>(malloc(frames * PAGE_SIZE));
+		__frames.reserve(frames);
+		for (std::size_t i = 0; i < frames; i++)
+		{
+			const QFrame frame = { NONE, 0, 0, NONE, false, false, false };
+			__frames.push_back(frame);
+		}
+
+		// about two buckets per frame keeps the chains short
+		std::size_t buckets = 1;
+		while (buckets < frames * 2)
+		{
+			buckets <<= 1;
+		}
+		__buckets.resize(buckets);
+		for (std::size_t i = 0; i < buckets; i++)
+		{
+			__buckets[i] = NONE;
+		}
+		__mask = buckets - 1;
+	}
+
+	QBufferPool::~QBufferPool()
+	{
+		flush();
+		for (std::size_t file = 0; file < __files.size(); file++)
+		{
+			if (__files[file] >= 0)
+			{
+				closeFile(__files[file]);
+			}
+		}
+		free(__memory);
+	}
+
+	std::size_t QBufferPool::getFrameCount() const
+	{
+		return __frames.size();
+	}
+
+	uint32_t QBufferPool::addFile(const qtl::string& path)
+	{
+		uint64_t size = 0;
+		const int descriptor = openFile(path.c_str(), size);
+		if (descriptor < 0)
+		{
+			__fail("cannot open %s", path.c_str());
+			return NONE;
+		}
+
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		uint32_t file = 0;
+		while (file < __files.size() && __files[file] >= 0)
+		{
+			file++;
+		}
+		if (file == __files.size())
+		{
+			__files.push_back(descriptor);
+			__fileSizes.push_back(size);
+			__paths.push_back(path);
+		}
+		else
+		{
+			__files[file] = descriptor;
+			__fileSizes[file] = size;
+			__paths[file] = path;
+		}
+		return file;
+	}
+
+	void QBufferPool::removeFile(const uint32_t file)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		assert(file < __files.size() && __files[file] >= 0);
+		__waitForWriteBacks(lock, file);
+		for (uint32_t index = 0; index < __frames.size(); index++)
+		{
+			QFrame& frame = __frames[index];
+			if (frame.file == file)
+			{
+				assert(frame.pins == 0);
+				if (frame.dirty)
+				{
+					__writeBack(frame, index);
+				}
+				__unlink(index);
+				frame.file = NONE;
+				frame.referenced = false;
+			}
+		}
+		closeFile(__files[file]);
+		__files[file] = -1;
+	}
+
+	uint64_t QBufferPool::getFileSize(const uint32_t file) const
+	{
+		return __fileSizes[file];
+	}
+
+	char* QBufferPool::pin(const uint32_t file, const uint64_t page)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		for (;;)
+		{
+			uint32_t cached = NONE;
+			for (uint32_t index = __buckets[__bucket(file, page)]; index != NONE; index = __frames[index].next)
+			{
+				if (__frames[index].file == file && __frames[index].page == page)
+				{
+					cached = index;
+					break;
+				}
+			}
+			if (cached != NONE)
+			{
+				QFrame& frame = __frames[cached];
+				frame.pins++;
+				frame.referenced = true;
+				while (frame.loading)
+				{
+					__loaded.wait(lock);
+				}
+				if (frame.file == file && frame.page == page)
+				{
+					__hits.fetch_add(1, std::memory_order_relaxed);
+					return __memory + cached * PAGE_SIZE;
+				}
+
+				// reading the page failed, this pin tries again
+				frame.pins--;
+				continue;
+			}
+
+			// the file does not hold the page's last changes yet
+			if (__isWritingBack(file, page))
+			{
+				__loaded.wait(lock);
+				continue;
+			}
+			break;
+		}
+		__misses.fetch_add(1, std::memory_order_relaxed);
+
+		const uint32_t index = __victim();
+		if (index == NONE)
+		{
+			__fail("%s", "every frame of the buffer pool is pinned");
+			return nullptr;
+		}
+
+		// the frame is pinned and loading from here on, so no other miss takes it
+		// and pinners of the page wait for it
+		QFrame& frame = __frames[index];
+		const QWriteBack evicted = { frame.file, frame.page };
+		const bool writeBack = frame.file != NONE && frame.dirty;
+		const int evictedFile = writeBack ? __files[evicted.file] : -1;
+		const std::size_t evictedLength = writeBack ? __writeLength(evicted.file, evicted.page) : 0;
+		if (frame.file != NONE)
+		{
+			__unlink(index);
+			__evictions.fetch_add(1, std::memory_order_relaxed);
+			if (writeBack)
+			{
+				__writingBack.push_back(evicted);
+			}
+		}
+		frame.file = file;
+		frame.page = page;
+		frame.pins = 1;
+		frame.referenced = true;
+		frame.dirty = false;
+		frame.loading = true;
+		__link(index);
+
+		// the part of a page past the end of the file reads as zeroes
+		const int descriptor = __files[file];
+		const uint64_t offset = page * PAGE_SIZE;
+		const uint64_t size = __fileSizes[file];
+		const std::size_t expected = offset >= size ? 0 : (size - offset < PAGE_SIZE ? static_cast<std::size_t>(size - offset) : PAGE_SIZE);
+		// qtl's unique_lock does not track unlocking, so the mutex is released
+		// directly and taken again before the lock goes out of scope
+		__mutex.unlock();
+
+		char* data = __memory + index * PAGE_SIZE;
+		const bool written = !writeBack || writeAt(evictedFile, data, evictedLength, evicted.page * PAGE_SIZE);
+		const bool read = written && readAt(descriptor, data, expected, offset) == expected;
+		if (read)
+		{
+			memset(data + expected, 0, PAGE_SIZE - expected);
+		}
+
+		__mutex.lock();
+		if (writeBack)
+		{
+			for (std::size_t i = 0; i < __writingBack.size(); i++)
+			{
+				if (__writingBack[i].file == evicted.file && __writingBack[i].page == evicted.page)
+				{
+					__writingBack[i] = __writingBack[__writingBack.size() - 1];
+					__writingBack.erase(--__writingBack.end());
+					break;
+				}
+			}
+			if (written)
+			{
+				__written(evicted.file, evicted.page, evictedLength);
+			}
+		}
+		frame.loading = false;
+		if (!read)
+		{
+			// a page that could not be written back stays in the frame
+			__unlink(index);
+			frame.pins--;
+			if (written)
+			{
+				frame.file = NONE;
+				__fail("cannot read %s", __paths[file].c_str());
+			}
+			else
+			{
+				frame.file = evicted.file;
+				frame.page = evicted.page;
+				frame.dirty = true;
+				__link(index);
+				__fail("cannot write %s", __paths[evicted.file].c_str());
+			}
+		}
+		__loaded.notify_all();
+		return read ? data : nullptr;
+	}
+
+	void QBufferPool::unpin(const void* address, const bool dirty)
+	{
+		const std::size_t index = static_cast<std::size_t>(static_cast<const char*>(address) - __memory) / PAGE_SIZE;
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		assert(index < __frames.size() && __frames[index].pins > 0);
+		QFrame& frame = __frames[index];
+		frame.pins--;
+		frame.dirty = frame.dirty || dirty;
+	}
+
+	bool QBufferPool::flush()
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		__waitForWriteBacks(lock, NONE);
+		bool flushed = true;
+		for (uint32_t index = 0; index < __frames.size(); index++)
+		{
+			QFrame& frame = __frames[index];
+			if (frame.file != NONE && frame.dirty && !frame.loading)
+			{
+				flushed = __writeBack(frame, index) && flushed;
+			}
+		}
+		for (std::size_t file = 0; file < __files.size(); file++)
+		{
+			if (__files[file] >= 0 && !syncFile(__files[file]))
+			{
+				__fail("cannot sync %s", __paths[file].c_str());
+				flushed = false;
+			}
+		}
+		return flushed;
+	}
+
+	uint64_t QBufferPool::getHits() const
+	{
+		return __hits.load(std::memory_order_relaxed);
+	}
+
+	uint64_t QBufferPool::getMisses() const
+	{
+		return __misses.load(std::memory_order_relaxed);
+	}
+
+	uint64_t QBufferPool::getEvictions() const
+	{
+		return __evictions.load(std::memory_order_relaxed);
+	}
+
+	uint64_t QBufferPool::getWrites() const
+	{
+		return __writes.load(std::memory_order_relaxed);
+	}
+
+	const char* QBufferPool::getError() const
+	{
+		return __error;
+	}
+
+	std::size_t QBufferPool::__bucket(const uint32_t file, const uint64_t page) const
+	{
+		uint64_t key = (page << 8) ^ file;
+		key *= 0x9E3779B97F4A7C15ull;
+		return static_cast<std::size_t>(key >> 32) & __mask;
+	}
+
+	void QBufferPool::__link(const uint32_t frame)
+	{
+		uint32_t& head = __buckets[__bucket(__frames[frame].file, __frames[frame].page)];
+		__frames[frame].next = head;
+		head = frame;
+	}
+
+	void QBufferPool::__unlink(const uint32_t frame)
+	{
+		uint32_t* link = &__buckets[__bucket(__frames[frame].file, __frames[frame].page)];
+		while (*link != frame)
+		{
+			link = &__frames[*link].next;
+		}
+		*link = __frames[frame].next;
+		__frames[frame].next = NONE;
+	}
+
+	bool QBufferPool::__writeBack(QFrame& frame, const uint32_t index)
+	{
+		const std::size_t length = __writeLength(frame.file, frame.page);
+		if (!writeAt(__files[frame.file], __memory + index * PAGE_SIZE, length, frame.page * PAGE_SIZE))
+		{
+			__fail("cannot write %s", __paths[frame.file].c_str());
+			return false;
+		}
+		__written(frame.file, frame.page, length);
+		frame.dirty = false;
+		return true;
+	}
+
+	std::size_t QBufferPool::__writeLength(const uint32_t file, const uint64_t page) const
+	{
+		// only the part of the page within the file is written, a page past its end grows it
+		const uint64_t offset = page * PAGE_SIZE;
+		const uint64_t size = __fileSizes[file];
+		return offset >= size || size - offset >= PAGE_SIZE ? PAGE_SIZE : static_cast<std::size_t>(size - offset);
+	}
+
+	void QBufferPool::__written(const uint32_t file, const uint64_t page, const std::size_t length)
+	{
+		const uint64_t end = page * PAGE_SIZE + length;
+		__fileSizes[file] = end > __fileSizes[file] ? end : __fileSizes[file];
+		__writes.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	bool QBufferPool::__isWritingBack(const uint32_t file, const uint64_t page) const
+	{
+		for (std::size_t i = 0; i < __writingBack.size(); i++)
+		{
+			if (__writingBack[i].file == file && __writingBack[i].page == page)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Waits until no page of file is being written back, of any file if file is NONE
+	void QBufferPool::__waitForWriteBacks(qtl::unique_lock<qtl::mutex>& lock, const uint32_t file)
+	{
+		for (;;)
+		{
+			bool writing = false;
+			for (std::size_t i = 0; i < __writingBack.size() && !writing; i++)
+			{
+				writing = file == NONE || __writingBack[i].file == file;
+			}
+			if (!writing)
+			{
+				return;
+			}
+			__loaded.wait(lock);
+		}
+	}
+
+	uint32_t QBufferPool::__victim()
+	{
+		// two sweeps clear every reference bit, after them only pinned frames remain
+		const std::size_t frames = __frames.size();
+		for (std::size_t step = 0; step < frames * 2; step++)
+		{
+			QFrame& frame = __frames[__hand];
+			const uint32_t index = static_cast<uint32_t>(__hand);
+			__hand = __hand + 1 == frames ? 0 : __hand + 1;
+			if (frame.pins > 0)
+			{
+				continue;
+			}
+			if (frame.file == NONE || !frame.referenced)
+			{
+				return index;
+			}
+			frame.referenced = false;
+		}
+		return NONE;
+	}
+
+	void QBufferPool::__fail(const char* format, const char* detail)
+	{
+		snprintf(__error, ERROR_LENGTH, format, detail);
+	}
+}
@@ -0,0 +1,312 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qcolumn.h"
+#include "qsql/qbufferpool.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace qsql
+{
+	QColumn::QColumn(const QDataType type, const bool nullable, const QDictionary* dictionary, QArena* arena)
+		: __type(type), __width(dictionary ? sizeof(uint32_t) : getDataTypeSize(type)), __size(0), __nullable(nullable), __dictionary(dictionary),
+		__arena(arena), __pool(nullptr), __poolFile(0)
+	{
+	}
+
+	QColumn::~QColumn()
+	{
+		for (std::size_t chunk = 0; chunk < __chunks.size(); chunk++)
+		{
+			if (__type == QDataType::STRING && __dictionary == nullptr)
+			{
+				qtl::string* values = static_cast<qtl::string*>(__chunks[chunk]);
+				const std::size_t count = getChunkSize(chunk);
+				for (std::size_t i = 0; i < count; i++)
+				{
+					values[i].~string();
+				}
+			}
+			if (__arena == nullptr)
+			{
+				free(__chunks[chunk]);
+			}
+		}
+		for (std::size_t chunk = 0; chunk < __nulls.size() && __arena == nullptr; chunk++)
+		{
+			free(__nulls[chunk]);
+		}
+		for (std::size_t chunk = 0; chunk < __segments.size(); chunk++)
+		{
+			delete __segments[chunk];
+		}
+	}
+
+	QDataType QColumn::getType() const
+	{
+		return __type;
+	}
+
+	std::size_t QColumn::getWidth() const
+	{
+		return __width;
+	}
+
+	bool QColumn::isNullable() const
+	{
+		return __nullable;
+	}
+
+	std::size_t QColumn::size() const
+	{
+		return __size;
+	}
+
+	const QDictionary* QColumn::getDictionary() const
+	{
+		return __dictionary;
+	}
+
+	std::size_t QColumn::getChunkCount() const
+	{
+		return __chunks.size();
+	}
+
+	std::size_t QColumn::getChunkSize(const std::size_t chunk) const
+	{
+		const std::size_t first = chunk << CHUNK_SHIFT;
+		return __size - first < CHUNK_SIZE ? __size - first : CHUNK_SIZE;
+	}
+
+	void* QColumn::getChunk(const std::size_t chunk) const
+	{
+		assert(!isCompressed(chunk));
+		return __chunks[chunk] ? __chunks[chunk] : __pooled(__poolValues[chunk]);
+	}
+
+	bool QColumn::read(const std::size_t row, void* value) const
+	{
+		const std::size_t chunk = row >> CHUNK_SHIFT;
+		if (isPooled(chunk))
+		{
+			return __readPooled(__poolValues[chunk] + (row & (CHUNK_SIZE - 1)) * __width, value, __width);
+		}
+		memcpy(value, at(row), __width);
+		return true;
+	}
+
+	void* QColumn::modify(const std::size_t row)
+	{
+		assert(!isCompressed(row >> CHUNK_SHIFT) && !isPooled(row >> CHUNK_SHIFT));
+		return at(row);
+	}
+
+	const QSegment* QColumn::getSegment(const std::size_t chunk) const
+	{
+		return chunk < __segments.size() ? __segments[chunk] : nullptr;
+	}
+
+	void* QColumn::compress(const std::size_t chunk)
+	{
+		// chunks carved from an arena cannot be released on their own
+		assert(__arena == nullptr && (__type == QDataType::INT || __type == QDataType::LONG));
+		assert(getChunkSize(chunk) == CHUNK_SIZE && !isCompressed(chunk));
+		QSegment* segment = QSegment::encode(__type, __chunks[chunk], __nullable ? __nulls[chunk] : nullptr, CHUNK_SIZE);
+		if (segment == nullptr)
+		{
+			return nullptr;
+		}
+		while (__segments.size() <= chunk)
+		{
+			__segments.push_back(nullptr);
+		}
+		__segments[chunk] = segment;
+		void* values = __chunks[chunk];
+		__chunks[chunk] = nullptr;
+		return values;
+	}
+
+	bool QColumn::pinChunk(const std::size_t chunk) const
+	{
+		if (!isPooled(chunk))
+		{
+			return true;
+		}
+		char* values = __pool->pin(__poolFile, __poolValues[chunk] / QBufferPool::PAGE_SIZE);
+		if (values == nullptr)
+		{
+			return false;
+		}
+		if (__nullable && __pool->pin(__poolFile, __poolNulls[chunk] / QBufferPool::PAGE_SIZE) == nullptr)
+		{
+			__pool->unpin(values, false);
+			return false;
+		}
+		return true;
+	}
+
+	void QColumn::unpinChunk(const std::size_t chunk) const
+	{
+		if (isPooled(chunk))
+		{
+			__pool->unpin(__pooled(__poolValues[chunk]), false);
+			if (__nullable)
+			{
+				__pool->unpin(__pooled(__poolNulls[chunk]), false);
+			}
+		}
+	}
+
+	std::size_t QColumn::getChunkPages() const
+	{
+		return __pool ? (__nullable ? 2 : 1) : 0;
+	}
+
+	void* QColumn::append()
+	{
+		if ((__size & (CHUNK_SIZE - 1)) == 0)
+		{
+			if (__arena)
+			{
+				__chunks.push_back(__arena->allocate(CHUNK_SIZE * __width));
+				if (__nullable)
+				{
+					uint64_t* nulls = static_cast<uint64_t*>(__arena->allocate(CHUNK_SIZE / 8, alignof(uint64_t)));
+					memset(nulls, 0, CHUNK_SIZE / 8);
+					__nulls.push_back(nulls);
+				}
+			}
+			else
+			{
+				__chunks.push_back(malloc(CHUNK_SIZE * __width));
+				if (__nullable)
+				{
+					__nulls.push_back(static_cast<uint64_t*>(calloc(CHUNK_SIZE / 64, sizeof(uint64_t))));
+				}
+			}
+		}
+
+		void* value = at(__size++);
+		if (__type == QDataType::STRING && __dictionary == nullptr)
+		{
+			::new (value) qtl::string();
+		}
+		else
+		{
+			memset(value, 0, __width);
+		}
+		return value;
+	}
+
+	void QColumn::attach(void* values, uint64_t* nulls, const std::size_t count)
+	{
+		assert((__size & (CHUNK_SIZE - 1)) == 0 && count <= CHUNK_SIZE);
+		assert(__arena != nullptr && (nulls != nullptr || !__nullable));
+		__chunks.push_back(values);
+		if (__nullable)
+		{
+			__nulls.push_back(nulls);
+		}
+		__size += count;
+	}
+
+	bool QColumn::attach(QBufferPool& pool, const uint32_t file, const uint64_t values, const uint64_t nulls, const std::size_t count)
+	{
+		assert((__size & (CHUNK_SIZE - 1)) == 0 && count <= CHUNK_SIZE);
+		assert(__arena != nullptr && __chunks.size() == __poolValues.size() && (__pool == nullptr || __pool == &pool));
+		assert(values % QBufferPool::PAGE_SIZE + CHUNK_SIZE * __width <= QBufferPool::PAGE_SIZE);
+		assert(!__nullable || nulls % QBufferPool::PAGE_SIZE + CHUNK_SIZE / 8 <= QBufferPool::PAGE_SIZE);
+		__pool = &pool;
+		__poolFile = file;
+		__chunks.push_back(nullptr);
+		__poolValues.push_back(values);
+		if (__nullable)
+		{
+			__nulls.push_back(nullptr);
+			__poolNulls.push_back(nulls);
+		}
+		__size += count;
+		return count == CHUNK_SIZE || __copyPooled(__chunks.size() - 1);
+	}
+
+	void QColumn::setNull(const std::size_t row, const bool null)
+	{
+		const std::size_t chunk = row >> CHUNK_SHIFT;
+		assert(!isPooled(chunk));
+		uint64_t* nulls = __nulls[chunk];
+		const std::size_t bit = row & (CHUNK_SIZE - 1);
+		if (null)
+		{
+			nulls[bit >> 6] |= static_cast<uint64_t>(1) << (bit & 63);
+		}
+		else
+		{
+			nulls[bit >> 6] &= ~(static_cast<uint64_t>(1) << (bit & 63));
+		}
+	}
+
+	// Only for pages the caller keeps pinned, so the pin is a hit that cannot
+	// fail and the page stays in its frame once this pin is released
+	void* QColumn::__pooled(const uint64_t offset) const
+	{
+		char* page = __pool->pin(__poolFile, offset / QBufferPool::PAGE_SIZE);
+		assert(page != nullptr);
+		__pool->unpin(page, false);
+		return page + offset % QBufferPool::PAGE_SIZE;
+	}
+
+	void* QColumn::__pooledAt(const std::size_t row) const
+	{
+		return static_cast<char*>(__pooled(__poolValues[row >> CHUNK_SHIFT])) + (row & (CHUNK_SIZE - 1)) * __width;
+	}
+
+	// The page may hold another one as soon as it is unpinned, so the bytes
+	// are copied while it is pinned
+	bool QColumn::__readPooled(const uint64_t offset, void* data, const std::size_t size) const
+	{
+		char* page = __pool->pin(__poolFile, offset / QBufferPool::PAGE_SIZE);
+		if (page == nullptr)
+		{
+			return false;
+		}
+		memcpy(data, page + offset % QBufferPool::PAGE_SIZE, size);
+		__pool->unpin(page, false);
+		return true;
+	}
+
+	// isNull() cannot fail, reading a row of a pooled column needs a frame that
+	// no scan keeps pinned
+	bool QColumn::__isNullPooled(const std::size_t row) const
+	{
+		const std::size_t bit = row & (CHUNK_SIZE - 1);
+		uint64_t word = 0;
+		const bool read = __readPooled(__poolNulls[row >> CHUNK_SHIFT] + (bit >> 6) * sizeof(uint64_t), &word, sizeof(word));
+		assert(read);
+		(void)read;
+		return (word >> (bit & 63)) & 1;
+	}
+
+	// Copies a pooled chunk and its null bitmap into the arena, which is where
+	// every change to it goes from then on, so the pool never writes the file
+	bool QColumn::__copyPooled(const std::size_t chunk)
+	{
+		const uint64_t offsets[2] = { __poolValues[chunk], __nullable ? __poolNulls[chunk] : 0 };
+		const std::size_t sizes[2] = { CHUNK_SIZE * __width, CHUNK_SIZE / 8 };
+		void* copies[2] = { __arena->allocate(sizes[0]), __nullable ? __arena->allocate(sizes[1], alignof(uint64_t)) : nullptr };
+		for (std::size_t i = 0; i < (__nullable ? 2u : 1u); i++)
+		{
+			if (!__readPooled(offsets[i], copies[i], sizes[i]))
+			{
+				return false;
+			}
+		}
+		__chunks[chunk] = copies[0];
+		if (__nullable)
+		{
+			__nulls[chunk] = static_cast<uint64_t*>(copies[1]);
+		}
+		return true;
+	}
+}
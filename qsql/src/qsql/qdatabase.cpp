@@ -0,0 +1,188 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qdatabase.h"
+
+namespace qsql
+{
+	QDatabase::QDatabase()
+		: __version(0), __pool(nullptr), __log(nullptr), __synchronous(true), __parser(__arena), __planner(*this)
+	{
+	}
+
+	QDatabase::~QDatabase()
+	{
+		__planCache.clear();
+		for (QTableEntry& entry : __tables)
+		{
+			delete entry.table;
+		}
+	}
+
+	QTable* QDatabase::createTable(const qtl::string& name, const QSchema& schema, const QTableLayout layout)
+	{
+		if (name.length() == 0 || findTable(name.c_str(), name.length()))
+		{
+			return nullptr;
+		}
+		if (__log)
+		{
+			__transaction.clear();
+			__transaction.createTable(name, schema, layout);
+			if (!__log->commit(__transaction))
+			{
+				return nullptr;
+			}
+		}
+		QTable* table = new QTable(schema, layout, &__clock);
+		__tables.push_back({ name, table });
+		return table;
+	}
+
+	bool QDatabase::addTable(const qtl::string& name, QTable* table)
+	{
+		if (name.length() == 0 || findTable(name.c_str(), name.length()))
+		{
+			return false;
+		}
+		table->setClock(__clock);
+		__tables.push_back({ name, table });
+		return true;
+	}
+
+	QTable* QDatabase::getTable(const qtl::string& name) const
+	{
+		return findTable(name.c_str(), name.length());
+	}
+
+	QTable* QDatabase::findTable(const char* name, const std::size_t length) const
+	{
+		const QAstText text = { name, length };
+		for (const QTableEntry& entry : __tables)
+		{
+			if (equalsIgnoreCase(text, entry.name.c_str()))
+			{
+				return entry.table;
+			}
+		}
+		return nullptr;
+	}
+
+	bool QDatabase::dropTable(const qtl::string& name)
+	{
+		const QAstText text = { name.c_str(), name.length() };
+		for (std::size_t i = 0; i < __tables.size(); i++)
+		{
+			if (equalsIgnoreCase(text, __tables[i].name.c_str()))
+			{
+				if (__log)
+				{
+					__transaction.clear();
+					__transaction.dropTable(__tables[i].name);
+					if (!__log->commit(__transaction))
+					{
+						return false;
+					}
+				}
+
+				// plans may point at the table, they are all invalidated
+				__version++;
+				__planCache.clear();
+				delete __tables[i].table;
+				__tables[i] = __tables.back();
+				__tables.erase(--__tables.end());
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::size_t QDatabase::getTableCount() const
+	{
+		return __tables.size();
+	}
+
+	QVersionClock& QDatabase::getClock()
+	{
+		return __clock;
+	}
+
+	void QDatabase::collectGarbage()
+	{
+		for (QTableEntry& entry : __tables)
+		{
+			entry.table->collect();
+		}
+	}
+
+	uint64_t QDatabase::getVersion() const
+	{
+		return __version;
+	}
+
+	QStatement QDatabase::prepare(const qtl::string& text)
+	{
+		const qtl::string key = QPlanCache::normalize(text);
+		QPlan* plan = __planCache.acquire(key, __version);
+		if (plan)
+		{
+			plan->clearParameters();
+			return QStatement(this, plan, nullptr);
+		}
+
+		// the syntax tree is only needed until the plan is built
+		__arena.reset();
+		const QAstStatement* statement = __parser.parse(text);
+		if (statement == nullptr)
+		{
+			return QStatement(this, nullptr, __parser.getError());
+		}
+
+		plan = __planner.plan(*statement);
+		if (plan == nullptr)
+		{
+			return QStatement(this, nullptr, __planner.getError());
+		}
+		plan->setKey(key, __version);
+		return QStatement(this, plan, nullptr);
+	}
+
+	QPlanCache& QDatabase::getPlanCache()
+	{
+		return __planCache;
+	}
+
+	void QDatabase::setThreadPool(qtl::thread_pool* pool)
+	{
+		if (pool != __pool)
+		{
+			__pool = pool;
+			__version++;
+		}
+	}
+
+	qtl::thread_pool* QDatabase::getThreadPool() const
+	{
+		return __pool;
+	}
+
+	void QDatabase::setLog(QWal* log, const bool synchronous)
+	{
+		__log = log;
+		__synchronous = synchronous;
+	}
+
+	QWal* QDatabase::getLog() const
+	{
+		return __log;
+	}
+
+	bool QDatabase::isLogSynchronous() const
+	{
+		return __synchronous;
+	}
+
+	void QDatabase::__release(QPlan* plan)
+	{
+		__planCache.release(plan, __version);
+	}
+}
@@ -0,0 +1,164 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qdictionary.h"
+#include "qsql/qbatch.h"
+
+#include <qtl/hash.h>
+
+#include <cstdlib>
+
+namespace qsql
+{
+	QDictionary::QDictionary()
+		: __directory(nullptr), __capacity(0), __slots(nullptr), __mask(15), __size(0)
+	{
+		__slots = static_cast<uint32_t*>(malloc((__mask + 1) * sizeof(uint32_t)));
+		for (std::size_t slot = 0; slot <= __mask; slot++)
+		{
+			__slots[slot] = NONE;
+		}
+	}
+
+	QDictionary::~QDictionary()
+	{
+		qtl::string** directory = __directory.load(std::memory_order_relaxed);
+		const std::size_t chunks = (__size.load(std::memory_order_relaxed) + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+		for (std::size_t i = 0; i < chunks; i++)
+		{
+			delete[] directory[i];
+		}
+		free(directory);
+		for (std::size_t i = 0; i < __retired.size(); i++)
+		{
+			free(__retired[i]);
+		}
+		free(__slots);
+	}
+
+	std::size_t QDictionary::size() const
+	{
+		return __size.load(std::memory_order_acquire);
+	}
+
+	uint32_t QDictionary::encode(const qtl::string& value)
+	{
+		const std::size_t hash = qtl::hash<qtl::string>()(value);
+		std::size_t slot = __locate(value, hash);
+		if (__slots[slot] != NONE)
+		{
+			return __slots[slot];
+		}
+
+		const std::size_t size = __size.load(std::memory_order_relaxed);
+		if ((size + 1) * 2 > __mask + 1)
+		{
+			__grow();
+			slot = __locate(value, hash);
+		}
+
+		qtl::string** directory = __directory.load(std::memory_order_relaxed);
+		const std::size_t chunk = size >> CHUNK_SHIFT;
+		if ((size & (CHUNK_SIZE - 1)) == 0)
+		{
+			if (chunk == __capacity)
+			{
+				// readers may still hold the old directory, it is copied and kept
+				const std::size_t capacity = __capacity ? __capacity * 2 : 8;
+				qtl::string** grown = static_cast<qtl::string**>(malloc(capacity * sizeof(qtl::string*)));
+				for (std::size_t i = 0; i < chunk; i++)
+				{
+					grown[i] = directory[i];
+				}
+				if (directory)
+				{
+					__retired.push_back(directory);
+				}
+				directory = grown;
+				__capacity = capacity;
+			}
+			directory[chunk] = new qtl::string[CHUNK_SIZE];
+			__directory.store(directory, std::memory_order_release);
+		}
+
+		const uint32_t code = static_cast<uint32_t>(size);
+		directory[chunk][code & (CHUNK_SIZE - 1)] = value;
+		__hashes.push_back(hash);
+		__slots[slot] = code;
+		__size.store(size + 1, std::memory_order_release);
+		return code;
+	}
+
+	uint32_t QDictionary::find(const qtl::string& value) const
+	{
+		return __slots[__locate(value, qtl::hash<qtl::string>()(value))];
+	}
+
+	std::size_t QDictionary::__locate(const qtl::string& value, const std::size_t hash) const
+	{
+		// returns the slot of the value, or the empty slot that ends its probe sequence
+		std::size_t slot = hash & __mask;
+		while (__slots[slot] != NONE)
+		{
+			const uint32_t code = __slots[slot];
+			if (__hashes[code] == hash && decode(code) == value)
+			{
+				return slot;
+			}
+			slot = (slot + 1) & __mask;
+		}
+		return slot;
+	}
+
+	void QDictionary::__grow()
+	{
+		const std::size_t capacity = (__mask + 1) * 2;
+		free(__slots);
+		__slots = static_cast<uint32_t*>(malloc(capacity * sizeof(uint32_t)));
+		__mask = capacity - 1;
+		for (std::size_t slot = 0; slot < capacity; slot++)
+		{
+			__slots[slot] = NONE;
+		}
+
+		// strings are distinct, so each code only needs an empty slot
+		const std::size_t size = __size.load(std::memory_order_relaxed);
+		for (std::size_t code = 0; code < size; code++)
+		{
+			std::size_t slot = __hashes[code] & __mask;
+			while (__slots[slot] != NONE)
+			{
+				slot = (slot + 1) & __mask;
+			}
+			__slots[slot] = static_cast<uint32_t>(code);
+		}
+	}
+
+	QDictionaryFilter::QDictionaryFilter()
+		: __dictionary(nullptr)
+	{
+	}
+
+	void QDictionaryFilter::reset()
+	{
+		__dictionary = nullptr;
+		__matches.clear();
+	}
+
+	std::size_t QDictionaryFilter::select(const QVector& codes, const uint16_t* selection, const std::size_t count, uint16_t* out) const
+	{
+		const uint32_t* data = codes.getData<uint32_t>();
+		const uint8_t* matches = __matches.data();
+		const uint64_t* nulls = codes.getNulls();
+		std::size_t selected = 0;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const uint16_t index = selection ? selection[i] : static_cast<uint16_t>(i);
+
+			// the code stored for a NULL is not meaningful and may not be in the table
+			const bool null = nulls && ((nulls[index >> 6] >> (index & 63)) & 1);
+			out[selected] = index;
+			selected += !null && matches[data[index]];
+		}
+		return selected;
+	}
+}
@@ -0,0 +1,1303 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qexpression.h"
+#include "qsql/qsimd.h"
+
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		template<typename T>
+		struct QVectorOperand
+		{
+			const T* data;
+
+			const T& operator[](const std::size_t index) const
+			{
+				return data[index];
+			}
+		};
+
+		template<typename T>
+		struct QScalarOperand
+		{
+			const T& value;
+
+			const T& operator[](const std::size_t) const
+			{
+				return value;
+			}
+		};
+
+		template<typename From, typename To>
+		void convert(const From* input, To* output, const std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				output[i] = static_cast<To>(input[i]);
+			}
+		}
+
+		template<typename To>
+		void convertVector(const QVector& input, To* output, const std::size_t count)
+		{
+			switch (input.getType())
+			{
+			case QDataType::CHAR:
+				convert(input.getData<char>(), output, count);
+				break;
+			case QDataType::INT:
+				convert(input.getData<int32_t>(), output, count);
+				break;
+			case QDataType::LONG:
+				convert(input.getData<int64_t>(), output, count);
+				break;
+			case QDataType::BOOL:
+				convert(input.getData<bool>(), output, count);
+				break;
+			case QDataType::STRING:
+				break;
+			}
+		}
+
+		// Returns the data of input as type, converting it into scratch when the types differ
+		const void* widen(const QVector& input, const QDataType type, const std::size_t count, QVector& scratch)
+		{
+			if (input.getType() == type)
+			{
+				return input.getData();
+			}
+
+			scratch.initialize(type);
+			switch (type)
+			{
+			case QDataType::CHAR:
+				convertVector(input, scratch.getData<char>(), count);
+				break;
+			case QDataType::INT:
+				convertVector(input, scratch.getData<int32_t>(), count);
+				break;
+			case QDataType::LONG:
+				convertVector(input, scratch.getData<int64_t>(), count);
+				break;
+			case QDataType::BOOL:
+				convertVector(input, scratch.getData<bool>(), count);
+				break;
+			case QDataType::STRING:
+				break;
+			}
+			return scratch.getData();
+		}
+
+		template<typename T>
+		T scalarOf(const QValue& value, const QDataType type)
+		{
+			T result = T();
+			value.store(type, &result);
+			return result;
+		}
+
+		QDataType arithmeticType(const QDataType left, const QDataType right)
+		{
+			return (left == QDataType::LONG || right == QDataType::LONG) ? QDataType::LONG : QDataType::INT;
+		}
+
+		QDataType comparisonType(const QDataType left, const QDataType right)
+		{
+			if (left == right)
+			{
+				return left;
+			}
+			if (left == QDataType::STRING || right == QDataType::STRING)
+			{
+				return QDataType::STRING;
+			}
+			return arithmeticType(left, right);
+		}
+
+		QComparison flip(const QComparison op)
+		{
+			switch (op)
+			{
+			case QComparison::LESS:
+				return QComparison::GREATER;
+			case QComparison::LESS_EQUAL:
+				return QComparison::GREATER_EQUAL;
+			case QComparison::GREATER:
+				return QComparison::LESS;
+			case QComparison::GREATER_EQUAL:
+				return QComparison::LESS_EQUAL;
+			default:
+				return op;
+			}
+		}
+
+		// Merges the null bitmaps of both operands into result, leaving it without nulls if neither has any
+		void mergeNulls(const QVector& left, const QVector& right, QVector& result)
+		{
+			const uint64_t* l = left.getNulls();
+			const uint64_t* r = right.getNulls();
+			if (l == nullptr && r == nullptr)
+			{
+				return;
+			}
+
+			uint64_t* nulls = result.getNulls() ? const_cast<uint64_t*>(result.getNulls()) : result.initializeNulls();
+			for (std::size_t i = 0; i < QVector::NULL_WORDS; i++)
+			{
+				nulls[i] |= (l ? l[i] : 0) | (r ? r[i] : 0);
+			}
+		}
+
+		// Turns the result of a filter kernel over the dense rows [0, count) into a selection vector
+		std::size_t selectBitmap(uint64_t* bitmap, const uint64_t* nulls, const std::size_t count, uint16_t* out)
+		{
+			if (nulls)
+			{
+				bitmapAndNot(bitmap, nulls, (count + 63) / 64);
+			}
+			return bitmapToSelection(bitmap, count, out);
+		}
+
+		std::size_t removeNulls(const uint64_t* nulls, uint16_t* rows, const std::size_t count)
+		{
+			std::size_t selected = 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const uint16_t index = rows[i];
+				rows[selected] = index;
+				selected += !((nulls[index >> 6] >> (index & 63)) & 1);
+			}
+			return selected;
+		}
+
+		struct QAdd
+		{
+			template<typename T, typename U>
+			static T apply(const T left, const T right)
+			{
+				return static_cast<T>(static_cast<U>(left) + static_cast<U>(right));
+			}
+		};
+
+		struct QSubtract
+		{
+			template<typename T, typename U>
+			static T apply(const T left, const T right)
+			{
+				return static_cast<T>(static_cast<U>(left) - static_cast<U>(right));
+			}
+		};
+
+		struct QMultiply
+		{
+			template<typename T, typename U>
+			static T apply(const T left, const T right)
+			{
+				return static_cast<T>(static_cast<U>(left) * static_cast<U>(right));
+			}
+		};
+
+		template<typename T, typename U, typename Op, typename L, typename R>
+		void arithmeticLoop(const L& left, const R& right, T* out, const std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				out[i] = Op::template apply<T, U>(left[i], right[i]);
+			}
+		}
+
+		// Division by zero produces NULL, division by -1 is a wrapping negation
+		template<typename T, typename U, typename L, typename R>
+		void divideLoop(const L& left, const R& right, T* out, uint64_t* nulls, const std::size_t count, const bool modulo)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const T divisor = right[i];
+				if (divisor == 0)
+				{
+					out[i] = 0;
+					nulls[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+				}
+				else if (divisor == -1)
+				{
+					out[i] = modulo ? 0 : static_cast<T>(static_cast<U>(0) - static_cast<U>(left[i]));
+				}
+				else
+				{
+					out[i] = modulo ? left[i] % divisor : left[i] / divisor;
+				}
+			}
+		}
+
+		template<typename T, typename U, typename L, typename R>
+		void arithmetic(const QArithmetic op, const L& left, const R& right, QVector& result, const std::size_t count)
+		{
+			T* out = result.getData<T>();
+			switch (op)
+			{
+			case QArithmetic::ADD:
+				arithmeticLoop<T, U, QAdd>(left, right, out, count);
+				break;
+			case QArithmetic::SUBTRACT:
+				arithmeticLoop<T, U, QSubtract>(left, right, out, count);
+				break;
+			case QArithmetic::MULTIPLY:
+				arithmeticLoop<T, U, QMultiply>(left, right, out, count);
+				break;
+			case QArithmetic::DIVIDE:
+			case QArithmetic::MODULO:
+				divideLoop<T, U>(left, right, out, result.initializeNulls(), count, op == QArithmetic::MODULO);
+				break;
+			}
+		}
+
+		template<QComparison Op>
+		struct QCompare;
+
+		template<>
+		struct QCompare<QComparison::EQUAL>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left == right;
+			}
+		};
+
+		template<>
+		struct QCompare<QComparison::NOT_EQUAL>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left != right;
+			}
+		};
+
+		template<>
+		struct QCompare<QComparison::LESS>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left < right;
+			}
+
+			static bool apply(const qtl::string& left, const qtl::string& right)
+			{
+				return left.compare(right) < 0;
+			}
+		};
+
+		template<>
+		struct QCompare<QComparison::LESS_EQUAL>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left <= right;
+			}
+
+			static bool apply(const qtl::string& left, const qtl::string& right)
+			{
+				return left.compare(right) <= 0;
+			}
+		};
+
+		template<>
+		struct QCompare<QComparison::GREATER>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left > right;
+			}
+
+			static bool apply(const qtl::string& left, const qtl::string& right)
+			{
+				return left.compare(right) > 0;
+			}
+		};
+
+		template<>
+		struct QCompare<QComparison::GREATER_EQUAL>
+		{
+			template<typename T>
+			static bool apply(const T& left, const T& right)
+			{
+				return left >= right;
+			}
+
+			static bool apply(const qtl::string& left, const qtl::string& right)
+			{
+				return left.compare(right) >= 0;
+			}
+		};
+
+		template<typename Compare, typename L, typename R>
+		std::size_t selectLoop(const L& left, const R& right, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			std::size_t selected = 0;
+			if (selection)
+			{
+				for (std::size_t i = 0; i < count; i++)
+				{
+					const uint16_t index = selection[i];
+					out[selected] = index;
+					selected += Compare::apply(left[index], right[index]);
+				}
+			}
+			else
+			{
+				for (std::size_t i = 0; i < count; i++)
+				{
+					out[selected] = static_cast<uint16_t>(i);
+					selected += Compare::apply(left[i], right[i]);
+				}
+			}
+			return selected;
+		}
+
+		template<typename L, typename R>
+		std::size_t selectCompare(const QComparison op, const L& left, const R& right, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				return selectLoop<QCompare<QComparison::EQUAL>>(left, right, selection, count, out);
+			case QComparison::NOT_EQUAL:
+				return selectLoop<QCompare<QComparison::NOT_EQUAL>>(left, right, selection, count, out);
+			case QComparison::LESS:
+				return selectLoop<QCompare<QComparison::LESS>>(left, right, selection, count, out);
+			case QComparison::LESS_EQUAL:
+				return selectLoop<QCompare<QComparison::LESS_EQUAL>>(left, right, selection, count, out);
+			case QComparison::GREATER:
+				return selectLoop<QCompare<QComparison::GREATER>>(left, right, selection, count, out);
+			case QComparison::GREATER_EQUAL:
+				return selectLoop<QCompare<QComparison::GREATER_EQUAL>>(left, right, selection, count, out);
+			}
+			return 0;
+		}
+
+		template<typename T>
+		std::size_t selectTyped(const QComparison op, const void* left, const void* right, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			const QVectorOperand<T> l = { static_cast<const T*>(left) };
+			const QVectorOperand<T> r = { static_cast<const T*>(right) };
+			return selectCompare(op, l, r, selection, count, out);
+		}
+
+		// Type the operand of a BETWEEN or IN is compared as after taking value into account
+		QDataType listType(const QDataType current, const QDataType child, const QValue& value)
+		{
+			if (value.isNull())
+			{
+				return current;
+			}
+			// a single character string literal compares against CHAR values as a CHAR
+			if (child == QDataType::STRING || (child == QDataType::CHAR && value.getType() == QDataType::STRING))
+			{
+				return child;
+			}
+			return arithmeticType(current, value.getType());
+		}
+
+		template<typename T>
+		std::size_t selectBetween(const void* data, const T& low, const T& high, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			const QVectorOperand<T> values = { static_cast<const T*>(data) };
+			const QScalarOperand<T> l = { low };
+			const QScalarOperand<T> h = { high };
+			const std::size_t selected = selectLoop<QCompare<QComparison::GREATER_EQUAL>>(values, l, selection, count, out);
+			return selectLoop<QCompare<QComparison::LESS_EQUAL>>(values, h, out, selected, out);
+		}
+
+		template<typename T>
+		std::size_t selectIn(const void* data, const qtl::vector<T>& list, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			const T* values = static_cast<const T*>(data);
+			const std::size_t size = list.size();
+			std::size_t selected = 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const uint16_t index = selection ? selection[i] : static_cast<uint16_t>(i);
+				bool found = false;
+				for (std::size_t j = 0; j < size; j++)
+				{
+					found |= values[index] == list[j];
+				}
+				out[selected] = index;
+				selected += found;
+			}
+			return selected;
+		}
+
+		// Fills the first count values of vector with value converted to type
+		void broadcast(const QValue& value, const QDataType type, const std::size_t count, QVector& vector)
+		{
+			vector.initialize(type);
+			if (value.isNull())
+			{
+				memset(vector.initializeNulls(), 0xff, QVector::NULL_WORDS * sizeof(uint64_t));
+			}
+			else
+			{
+				char* data = vector.getData<char>();
+				const std::size_t width = getDataTypeSize(type);
+				for (std::size_t i = 0; i < count; i++)
+				{
+					value.store(type, data + i * width);
+				}
+			}
+		}
+
+		bool compareStrings(const QComparison op, const qtl::string& left, const qtl::string& right)
+		{
+			const int result = left.compare(right);
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				return result == 0;
+			case QComparison::NOT_EQUAL:
+				return result != 0;
+			case QComparison::LESS:
+				return result < 0;
+			case QComparison::LESS_EQUAL:
+				return result <= 0;
+			case QComparison::GREATER:
+				return result > 0;
+			case QComparison::GREATER_EQUAL:
+				return result >= 0;
+			}
+			return false;
+		}
+
+		// The vector holding an operand's nulls, which does not need its codes decoded
+		const QVector& nullsOf(QExpression& expression, const QBatch& batch)
+		{
+			const QVector* codes = expression.getCodes(batch);
+			return codes ? *codes : expression.evaluate(batch);
+		}
+
+		// Writes TRUE for the selected rows of a dense select() into result
+		void scatterSelection(const uint16_t* indexes, const std::size_t selected, const std::size_t count, QVector& result)
+		{
+			result.initialize(QDataType::BOOL);
+			bool* out = result.getData<bool>();
+			memset(out, 0, count * sizeof(bool));
+			for (std::size_t i = 0; i < selected; i++)
+			{
+				out[indexes[i]] = true;
+			}
+		}
+
+		template<typename T>
+		std::size_t selectTypedScalar(const QComparison op, const void* left, const T& right, const uint16_t* selection, const std::size_t count, uint16_t* out)
+		{
+			const QVectorOperand<T> l = { static_cast<const T*>(left) };
+			const QScalarOperand<T> r = { right };
+			return selectCompare(op, l, r, selection, count, out);
+		}
+	}
+
+	const QValue* QExpression::getConstant() const
+	{
+		return nullptr;
+	}
+
+	const QVector* QExpression::getCodes(const QBatch&)
+	{
+		return nullptr;
+	}
+
+	std::size_t QExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		const QVector& values = evaluate(batch);
+		const bool* data = values.getData<bool>();
+		const bool truth = true;
+		const QVectorOperand<bool> l = { data };
+		const QScalarOperand<bool> r = { truth };
+		std::size_t selected = selectLoop<QCompare<QComparison::EQUAL>>(l, r, selection, count, out);
+		if (values.getNulls())
+		{
+			selected = removeNulls(values.getNulls(), out, selected);
+		}
+		return selected;
+	}
+
+	QColumnExpression::QColumnExpression(const std::size_t column, const QDataType type)
+		: __column(column), __type(type)
+	{
+	}
+
+	std::size_t QColumnExpression::getColumn() const
+	{
+		return __column;
+	}
+
+	QDataType QColumnExpression::getType() const
+	{
+		return __type;
+	}
+
+	const QVector* QColumnExpression::getCodes(const QBatch& batch)
+	{
+		const QVector& vector = batch.getColumn(__column);
+		return vector.getDictionary() ? &vector : nullptr;
+	}
+
+	const QVector& QColumnExpression::evaluate(const QBatch& batch)
+	{
+		const QVector& vector = batch.getColumn(__column);
+		if (vector.getDictionary())
+		{
+			__decoded.decode(vector, batch.size());
+			return __decoded;
+		}
+		return vector;
+	}
+
+	QConstantExpression::QConstantExpression(const QValue& value)
+		: __value(value), __filled(false)
+	{
+	}
+
+	QDataType QConstantExpression::getType() const
+	{
+		return __value.getType();
+	}
+
+	const QValue* QConstantExpression::getConstant() const
+	{
+		return &__value;
+	}
+
+	const QVector& QConstantExpression::evaluate(const QBatch&)
+	{
+		if (__filled)
+		{
+			return __vector;
+		}
+
+		broadcast(__value, __value.getType(), QVector::CAPACITY, __vector);
+		__filled = true;
+		return __vector;
+	}
+
+	QParameterExpression::QParameterExpression(const QValue& value, const QDataType type)
+		: __value(value), __type(type)
+	{
+	}
+
+	QDataType QParameterExpression::getType() const
+	{
+		return __type;
+	}
+
+	const QValue* QParameterExpression::getConstant() const
+	{
+		return &__value;
+	}
+
+	const QVector& QParameterExpression::evaluate(const QBatch& batch)
+	{
+		// the value may change between executions, so it is broadcast every time
+		broadcast(__value, __type, batch.size(), __vector);
+		return __vector;
+	}
+
+	QArithmeticExpression::QArithmeticExpression(const QArithmetic op, QExpression* left, QExpression* right)
+		: __op(op), __left(left), __right(right), __type(arithmeticType(left->getType(), right->getType()))
+	{
+	}
+
+	QArithmeticExpression::~QArithmeticExpression()
+	{
+		delete __left;
+		delete __right;
+	}
+
+	QDataType QArithmeticExpression::getType() const
+	{
+		return __type;
+	}
+
+	const QVector& QArithmeticExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		const QValue* leftConstant = __left->getConstant();
+		const QValue* rightConstant = __right->getConstant();
+
+		// constant operands are only used as scalars when they are not NULL, a NULL
+		// constant goes through the vector path so that it propagates its null bitmap
+		if (leftConstant && leftConstant->isNull())
+		{
+			leftConstant = nullptr;
+		}
+		if (rightConstant && rightConstant->isNull())
+		{
+			rightConstant = nullptr;
+		}
+
+		const QVector* leftVector = leftConstant ? nullptr : &__left->evaluate(batch);
+		const QVector* rightVector = rightConstant ? nullptr : &__right->evaluate(batch);
+		const void* leftData = leftVector ? widen(*leftVector, __type, count, __leftScratch) : nullptr;
+		const void* rightData = rightVector ? widen(*rightVector, __type, count, __rightScratch) : nullptr;
+
+		__result.initialize(__type);
+		if (__type == QDataType::INT)
+		{
+			typedef int32_t T;
+			typedef uint32_t U;
+			if (leftData && rightData)
+			{
+				arithmetic<T, U>(__op, QVectorOperand<T>{ static_cast<const T*>(leftData) }, QVectorOperand<T>{ static_cast<const T*>(rightData) }, __result, count);
+			}
+			else if (leftData)
+			{
+				const T scalar = scalarOf<T>(*rightConstant, __type);
+				arithmetic<T, U>(__op, QVectorOperand<T>{ static_cast<const T*>(leftData) }, QScalarOperand<T>{ scalar }, __result, count);
+			}
+			else if (rightData)
+			{
+				const T scalar = scalarOf<T>(*leftConstant, __type);
+				arithmetic<T, U>(__op, QScalarOperand<T>{ scalar }, QVectorOperand<T>{ static_cast<const T*>(rightData) }, __result, count);
+			}
+			else
+			{
+				const T left = scalarOf<T>(*leftConstant, __type);
+				const T right = scalarOf<T>(*rightConstant, __type);
+				arithmetic<T, U>(__op, QScalarOperand<T>{ left }, QScalarOperand<T>{ right }, __result, count);
+			}
+		}
+		else
+		{
+			typedef int64_t T;
+			typedef uint64_t U;
+			if (leftData && rightData)
+			{
+				arithmetic<T, U>(__op, QVectorOperand<T>{ static_cast<const T*>(leftData) }, QVectorOperand<T>{ static_cast<const T*>(rightData) }, __result, count);
+			}
+			else if (leftData)
+			{
+				const T scalar = scalarOf<T>(*rightConstant, __type);
+				arithmetic<T, U>(__op, QVectorOperand<T>{ static_cast<const T*>(leftData) }, QScalarOperand<T>{ scalar }, __result, count);
+			}
+			else if (rightData)
+			{
+				const T scalar = scalarOf<T>(*leftConstant, __type);
+				arithmetic<T, U>(__op, QScalarOperand<T>{ scalar }, QVectorOperand<T>{ static_cast<const T*>(rightData) }, __result, count);
+			}
+			else
+			{
+				const T left = scalarOf<T>(*leftConstant, __type);
+				const T right = scalarOf<T>(*rightConstant, __type);
+				arithmetic<T, U>(__op, QScalarOperand<T>{ left }, QScalarOperand<T>{ right }, __result, count);
+			}
+		}
+
+		if (leftVector || rightVector)
+		{
+			const QVector& left = leftVector ? *leftVector : *rightVector;
+			const QVector& right = rightVector ? *rightVector : *leftVector;
+			mergeNulls(left, right, __result);
+		}
+		return __result;
+	}
+
+	QComparisonExpression::QComparisonExpression(const QComparison op, QExpression* left, QExpression* right)
+		: __op(op), __left(left), __right(right), __operandType(comparisonType(left->getType(), right->getType()))
+	{
+		// a single character string literal compares against CHAR values as a CHAR
+		if ((left->getType() == QDataType::CHAR && right->getConstant()) || (right->getType() == QDataType::CHAR && left->getConstant()))
+		{
+			__operandType = QDataType::CHAR;
+		}
+	}
+
+	QComparisonExpression::~QComparisonExpression()
+	{
+		delete __left;
+		delete __right;
+	}
+
+	QComparison QComparisonExpression::getComparison() const
+	{
+		return __op;
+	}
+
+	QExpression* QComparisonExpression::getLeft() const
+	{
+		return __left;
+	}
+
+	QExpression* QComparisonExpression::getRight() const
+	{
+		return __right;
+	}
+
+	QDataType QComparisonExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QComparisonExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		scatterSelection(__indexes, select(batch, nullptr, count, __indexes), count, __result);
+
+		const QValue* leftConstant = __left->getConstant();
+		const QValue* rightConstant = __right->getConstant();
+		if ((leftConstant && leftConstant->isNull()) || (rightConstant && rightConstant->isNull()))
+		{
+			memset(__result.initializeNulls(), 0xff, QVector::NULL_WORDS * sizeof(uint64_t));
+		}
+		else
+		{
+			const QVector* leftVector = leftConstant ? nullptr : &nullsOf(*__left, batch);
+			const QVector* rightVector = rightConstant ? nullptr : &nullsOf(*__right, batch);
+			if (leftVector || rightVector)
+			{
+				mergeNulls(leftVector ? *leftVector : *rightVector, rightVector ? *rightVector : *leftVector, __result);
+			}
+		}
+		return __result;
+	}
+
+	std::size_t QComparisonExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		QExpression* left = __left;
+		QExpression* right = __right;
+		QComparison op = __op;
+
+		// keep a constant operand on the right so it can be used as a scalar
+		if (left->getConstant() && !right->getConstant())
+		{
+			left = __right;
+			right = __left;
+			op = flip(op);
+		}
+
+		const QValue* constant = right->getConstant();
+		if (constant && constant->isNull())
+		{
+			return 0;
+		}
+
+		// a dictionary encoded column is compared once per distinct string
+		const QVector* codes = constant && __operandType == QDataType::STRING ? left->getCodes(batch) : nullptr;
+		if (codes)
+		{
+			if (!(constant->getString() == __codeKey))
+			{
+				__codeKey = constant->getString();
+				__codeFilter.reset();
+			}
+			const qtl::string& key = __codeKey;
+			__codeFilter.update(*codes->getDictionary(), [op, &key](const qtl::string& value) { return compareStrings(op, value, key); });
+			return __codeFilter.select(*codes, selection, count, out);
+		}
+
+		const QVector& leftVector = left->evaluate(batch);
+		const void* leftData = widen(leftVector, __operandType, batch.size(), __leftScratch);
+
+		std::size_t selected = 0;
+		if (constant && selection == nullptr)
+		{
+			// dense input against a constant runs through the SIMD filter kernels
+			uint64_t bitmap[QVector::NULL_WORDS];
+			switch (__operandType)
+			{
+			case QDataType::INT:
+				filterCompare(op, static_cast<const int32_t*>(leftData), count, scalarOf<int32_t>(*constant, __operandType), bitmap);
+				return selectBitmap(bitmap, leftVector.getNulls(), count, out);
+			case QDataType::LONG:
+				filterCompare(op, static_cast<const int64_t*>(leftData), count, scalarOf<int64_t>(*constant, __operandType), bitmap);
+				return selectBitmap(bitmap, leftVector.getNulls(), count, out);
+			case QDataType::BOOL:
+				if (op == QComparison::EQUAL || op == QComparison::NOT_EQUAL)
+				{
+					const bool value = scalarOf<bool>(*constant, __operandType);
+					filterBool(static_cast<const bool*>(leftData), count, op == QComparison::EQUAL ? value : !value, bitmap);
+					return selectBitmap(bitmap, leftVector.getNulls(), count, out);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (constant)
+		{
+			switch (__operandType)
+			{
+			case QDataType::CHAR:
+				selected = selectTypedScalar<char>(op, leftData, scalarOf<char>(*constant, __operandType), selection, count, out);
+				break;
+			case QDataType::INT:
+				selected = selectTypedScalar<int32_t>(op, leftData, scalarOf<int32_t>(*constant, __operandType), selection, count, out);
+				break;
+			case QDataType::LONG:
+				selected = selectTypedScalar<int64_t>(op, leftData, scalarOf<int64_t>(*constant, __operandType), selection, count, out);
+				break;
+			case QDataType::BOOL:
+				selected = selectTypedScalar<bool>(op, leftData, scalarOf<bool>(*constant, __operandType), selection, count, out);
+				break;
+			case QDataType::STRING:
+				selected = selectTypedScalar<qtl::string>(op, leftData, constant->getString(), selection, count, out);
+				break;
+			}
+
+			if (leftVector.getNulls())
+			{
+				selected = removeNulls(leftVector.getNulls(), out, selected);
+			}
+			return selected;
+		}
+
+		const QVector& rightVector = right->evaluate(batch);
+		const void* rightData = widen(rightVector, __operandType, batch.size(), __rightScratch);
+		switch (__operandType)
+		{
+		case QDataType::CHAR:
+			selected = selectTyped<char>(op, leftData, rightData, selection, count, out);
+			break;
+		case QDataType::INT:
+			selected = selectTyped<int32_t>(op, leftData, rightData, selection, count, out);
+			break;
+		case QDataType::LONG:
+			selected = selectTyped<int64_t>(op, leftData, rightData, selection, count, out);
+			break;
+		case QDataType::BOOL:
+			selected = selectTyped<bool>(op, leftData, rightData, selection, count, out);
+			break;
+		case QDataType::STRING:
+			selected = selectTyped<qtl::string>(op, leftData, rightData, selection, count, out);
+			break;
+		}
+
+		if (leftVector.getNulls())
+		{
+			selected = removeNulls(leftVector.getNulls(), out, selected);
+		}
+		if (rightVector.getNulls())
+		{
+			selected = removeNulls(rightVector.getNulls(), out, selected);
+		}
+		return selected;
+	}
+
+	QBetweenExpression::QBetweenExpression(QExpression* child, const QValue& low, const QValue& high)
+		: __child(child), __low(low), __high(high)
+	{
+		const QDataType type = child->getType();
+		__operandType = (type == QDataType::STRING || type == QDataType::CHAR) ? type : arithmeticType(type, type);
+		__operandType = listType(__operandType, type, low);
+		__operandType = listType(__operandType, type, high);
+	}
+
+	QBetweenExpression::~QBetweenExpression()
+	{
+		delete __child;
+	}
+
+	QExpression* QBetweenExpression::getChild() const
+	{
+		return __child;
+	}
+
+	const QValue& QBetweenExpression::getLow() const
+	{
+		return __low;
+	}
+
+	const QValue& QBetweenExpression::getHigh() const
+	{
+		return __high;
+	}
+
+	QDataType QBetweenExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QBetweenExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		scatterSelection(__indexes, select(batch, nullptr, count, __indexes), count, __result);
+
+		const QVector& child = nullsOf(*__child, batch);
+		if (__low.isNull() || __high.isNull())
+		{
+			memset(__result.initializeNulls(), 0xff, QVector::NULL_WORDS * sizeof(uint64_t));
+		}
+		else
+		{
+			mergeNulls(child, child, __result);
+		}
+		return __result;
+	}
+
+	std::size_t QBetweenExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		if (__low.isNull() || __high.isNull())
+		{
+			return 0;
+		}
+
+		const QVector* codes = __operandType == QDataType::STRING ? __child->getCodes(batch) : nullptr;
+		if (codes)
+		{
+			const qtl::string& low = __low.getString();
+			const qtl::string& high = __high.getString();
+			__codeFilter.update(*codes->getDictionary(), [&low, &high](const qtl::string& value) { return value.compare(low) >= 0 && value.compare(high) <= 0; });
+			return __codeFilter.select(*codes, selection, count, out);
+		}
+
+		const QVector& child = __child->evaluate(batch);
+		const void* data = widen(child, __operandType, batch.size(), __scratch);
+
+		std::size_t selected = 0;
+		switch (__operandType)
+		{
+		case QDataType::CHAR:
+			selected = selectBetween<char>(data, scalarOf<char>(__low, __operandType), scalarOf<char>(__high, __operandType), selection, count, out);
+			break;
+		case QDataType::INT:
+			if (selection == nullptr)
+			{
+				uint64_t bitmap[QVector::NULL_WORDS];
+				filterBetween(static_cast<const int32_t*>(data), count, scalarOf<int32_t>(__low, __operandType), scalarOf<int32_t>(__high, __operandType), bitmap);
+				return selectBitmap(bitmap, child.getNulls(), count, out);
+			}
+			selected = selectBetween<int32_t>(data, scalarOf<int32_t>(__low, __operandType), scalarOf<int32_t>(__high, __operandType), selection, count, out);
+			break;
+		case QDataType::LONG:
+			if (selection == nullptr)
+			{
+				uint64_t bitmap[QVector::NULL_WORDS];
+				filterBetween(static_cast<const int64_t*>(data), count, scalarOf<int64_t>(__low, __operandType), scalarOf<int64_t>(__high, __operandType), bitmap);
+				return selectBitmap(bitmap, child.getNulls(), count, out);
+			}
+			selected = selectBetween<int64_t>(data, scalarOf<int64_t>(__low, __operandType), scalarOf<int64_t>(__high, __operandType), selection, count, out);
+			break;
+		case QDataType::BOOL:
+			selected = selectBetween<bool>(data, scalarOf<bool>(__low, __operandType), scalarOf<bool>(__high, __operandType), selection, count, out);
+			break;
+		case QDataType::STRING:
+			selected = selectBetween<qtl::string>(data, __low.getString(), __high.getString(), selection, count, out);
+			break;
+		}
+
+		if (child.getNulls())
+		{
+			selected = removeNulls(child.getNulls(), out, selected);
+		}
+		return selected;
+	}
+
+	QInExpression::QInExpression(QExpression* child, const qtl::vector<QValue>& values)
+		: __child(child), __values(values), __hasNull(false)
+	{
+		const QDataType type = child->getType();
+		__operandType = (type == QDataType::STRING || type == QDataType::CHAR) ? type : arithmeticType(type, type);
+		for (const QValue& value : __values)
+		{
+			__operandType = listType(__operandType, type, value);
+			__hasNull |= value.isNull();
+		}
+
+		for (const QValue& value : __values)
+		{
+			if (value.isNull())
+			{
+				continue;
+			}
+			switch (__operandType)
+			{
+			case QDataType::CHAR:
+				__ints.push_back(scalarOf<char>(value, QDataType::CHAR));
+				break;
+			case QDataType::LONG:
+				__longs.push_back(scalarOf<int64_t>(value, QDataType::LONG));
+				break;
+			case QDataType::STRING:
+				__strings.push_back(value.getString());
+				break;
+			default:
+				__ints.push_back(scalarOf<int32_t>(value, QDataType::INT));
+				break;
+			}
+		}
+
+		// CHAR values are widened so that they can use the integer kernels
+		if (__operandType == QDataType::CHAR)
+		{
+			__operandType = QDataType::INT;
+		}
+	}
+
+	QInExpression::~QInExpression()
+	{
+		delete __child;
+	}
+
+	QExpression* QInExpression::getChild() const
+	{
+		return __child;
+	}
+
+	const qtl::vector<QValue>& QInExpression::getValues() const
+	{
+		return __values;
+	}
+
+	QDataType QInExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QInExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		scatterSelection(__indexes, select(batch, nullptr, count, __indexes), count, __result);
+
+		const QVector& child = nullsOf(*__child, batch);
+		mergeNulls(child, child, __result);
+
+		// a value missing from a list that contains NULL is unknown rather than FALSE
+		if (__hasNull)
+		{
+			const bool* found = __result.getData<bool>();
+			uint64_t* nulls = __result.getNulls() ? const_cast<uint64_t*>(__result.getNulls()) : __result.initializeNulls();
+			for (std::size_t i = 0; i < count; i++)
+			{
+				nulls[i >> 6] |= static_cast<uint64_t>(!found[i]) << (i & 63);
+			}
+		}
+		return __result;
+	}
+
+	std::size_t QInExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		const QVector* codes = __operandType == QDataType::STRING ? __child->getCodes(batch) : nullptr;
+		if (codes)
+		{
+			const qtl::vector<qtl::string>& strings = __strings;
+			__codeFilter.update(*codes->getDictionary(), [&strings](const qtl::string& value)
+			{
+				for (const qtl::string& string : strings)
+				{
+					if (value == string)
+					{
+						return true;
+					}
+				}
+				return false;
+			});
+			return __codeFilter.select(*codes, selection, count, out);
+		}
+
+		const QVector& child = __child->evaluate(batch);
+		const void* data = widen(child, __operandType, batch.size(), __scratch);
+
+		std::size_t selected = 0;
+		switch (__operandType)
+		{
+		case QDataType::LONG:
+			if (selection == nullptr)
+			{
+				uint64_t bitmap[QVector::NULL_WORDS];
+				filterIn(static_cast<const int64_t*>(data), count, __longs.data(), __longs.size(), bitmap);
+				return selectBitmap(bitmap, child.getNulls(), count, out);
+			}
+			selected = selectIn(data, __longs, selection, count, out);
+			break;
+		case QDataType::STRING:
+			selected = selectIn(data, __strings, selection, count, out);
+			break;
+		default:
+			if (selection == nullptr)
+			{
+				uint64_t bitmap[QVector::NULL_WORDS];
+				filterIn(static_cast<const int32_t*>(data), count, __ints.data(), __ints.size(), bitmap);
+				return selectBitmap(bitmap, child.getNulls(), count, out);
+			}
+			selected = selectIn(data, __ints, selection, count, out);
+			break;
+		}
+
+		if (child.getNulls())
+		{
+			selected = removeNulls(child.getNulls(), out, selected);
+		}
+		return selected;
+	}
+
+	QLogicalExpression::QLogicalExpression(const QLogical op, QExpression* left, QExpression* right)
+		: __op(op), __left(left), __right(right)
+	{
+	}
+
+	QLogicalExpression::~QLogicalExpression()
+	{
+		delete __left;
+		delete __right;
+	}
+
+	QDataType QLogicalExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QLogicalExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		const QVector& left = __left->evaluate(batch);
+		const QVector& right = __right->evaluate(batch);
+		const bool* l = left.getData<bool>();
+		const bool* r = right.getData<bool>();
+
+		__result.initialize(QDataType::BOOL);
+		bool* out = __result.getData<bool>();
+		if (__op == QLogical::AND)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				out[i] = l[i] & r[i];
+			}
+		}
+		else
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				out[i] = l[i] | r[i];
+			}
+		}
+		mergeNulls(left, right, __result);
+		return __result;
+	}
+
+	std::size_t QLogicalExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		const std::size_t left = __left->select(batch, selection, count, __leftSelection);
+		if (__op == QLogical::AND)
+		{
+			return __right->select(batch, __leftSelection, left, out);
+		}
+
+		// only rows the left side rejected need to be tested against the right side
+		std::size_t rest = 0;
+		std::size_t cursor = 0;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const uint16_t index = selection ? selection[i] : static_cast<uint16_t>(i);
+			if (cursor < left && __leftSelection[cursor] == index)
+			{
+				cursor++;
+			}
+			else
+			{
+				__rest[rest++] = index;
+			}
+		}
+
+		const std::size_t right = __right->select(batch, __rest, rest, __rightSelection);
+
+		std::size_t l = 0;
+		std::size_t r = 0;
+		std::size_t selected = 0;
+		while (l < left && r < right)
+		{
+			out[selected++] = __leftSelection[l] < __rightSelection[r] ? __leftSelection[l++] : __rightSelection[r++];
+		}
+		while (l < left)
+		{
+			out[selected++] = __leftSelection[l++];
+		}
+		while (r < right)
+		{
+			out[selected++] = __rightSelection[r++];
+		}
+		return selected;
+	}
+
+	QIsNullExpression::QIsNullExpression(QExpression* child, const bool negated)
+		: __child(child), __negated(negated)
+	{
+	}
+
+	QIsNullExpression::~QIsNullExpression()
+	{
+		delete __child;
+	}
+
+	QDataType QIsNullExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QIsNullExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		const QVector& child = nullsOf(*__child, batch);
+
+		__result.initialize(QDataType::BOOL);
+		bool* out = __result.getData<bool>();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			out[i] = child.isNull(i) != __negated;
+		}
+		return __result;
+	}
+
+	std::size_t QIsNullExpression::select(const QBatch& batch, const uint16_t* selection, const std::size_t count, uint16_t* out)
+	{
+		const QVector& child = nullsOf(*__child, batch);
+		std::size_t selected = 0;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const uint16_t index = selection ? selection[i] : static_cast<uint16_t>(i);
+			out[selected] = index;
+			selected += child.isNull(index) != __negated;
+		}
+		return selected;
+	}
+
+	QNotExpression::QNotExpression(QExpression* child)
+		: __child(child)
+	{
+	}
+
+	QNotExpression::~QNotExpression()
+	{
+		delete __child;
+	}
+
+	QDataType QNotExpression::getType() const
+	{
+		return QDataType::BOOL;
+	}
+
+	const QVector& QNotExpression::evaluate(const QBatch& batch)
+	{
+		const std::size_t count = batch.size();
+		const QVector& child = __child->evaluate(batch);
+		const bool* in = child.getData<bool>();
+
+		__result.initialize(QDataType::BOOL);
+		bool* out = __result.getData<bool>();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			out[i] = !in[i];
+		}
+		if (child.getNulls())
+		{
+			memcpy(__result.initializeNulls(), child.getNulls(), QVector::NULL_WORDS * sizeof(uint64_t));
+		}
+		return __result;
+	}
+}
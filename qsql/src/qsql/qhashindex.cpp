@@ -0,0 +1,264 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qhashindex.h"
+#include "qsql/qtable.h"
+
+#include <qtl/hash.h>
+
+#include <cassert>
+#include <cstdlib>
+
+namespace qsql
+{
+	namespace
+	{
+		inline std::size_t hashKey(const int64_t key)
+		{
+			return qtl::hash<int64_t>()(key);
+		}
+
+		inline std::size_t hashString(const qtl::string& key)
+		{
+			return qtl::hash<qtl::string>()(key);
+		}
+
+		inline const qtl::string& stringAt(const QTable& table, const std::size_t row, const std::size_t column)
+		{
+			return table.getRow(row).get(column).get<qtl::string>();
+		}
+	}
+
+	QHashIndex::QHashIndex(const QTable& table, const std::size_t column)
+		: __table(table), __column(column), __type(table.getColumnType(column)), __slots(nullptr), __mask(15), __keys(0), __size(0)
+	{
+		assert(isSupported(__type));
+		__slots = static_cast<QSlot*>(malloc((__mask + 1) * sizeof(QSlot)));
+		for (std::size_t slot = 0; slot <= __mask; slot++)
+		{
+			__slots[slot].head = NONE;
+		}
+	}
+
+	QHashIndex::~QHashIndex()
+	{
+		free(__slots);
+	}
+
+	bool QHashIndex::isSupported(const QDataType type)
+	{
+		return type == QDataType::CHAR || type == QDataType::INT || type == QDataType::LONG || type == QDataType::STRING;
+	}
+
+	std::size_t QHashIndex::getColumn() const
+	{
+		return __column;
+	}
+
+	std::size_t QHashIndex::size() const
+	{
+		return __size;
+	}
+
+	std::size_t QHashIndex::getKeyCount() const
+	{
+		return __keys;
+	}
+
+	void QHashIndex::insert(const std::size_t row)
+	{
+		std::size_t hash = 0;
+		int64_t key = 0;
+		if (!__key(row, hash, key))
+		{
+			return;
+		}
+
+		while (__next.size() <= row)
+		{
+			__next.push_back(NONE);
+		}
+		if ((__keys + 1) * 2 > __mask + 1)
+		{
+			__grow();
+		}
+
+		const std::size_t slot = __locate(hash, key, __type == QDataType::STRING ? &stringAt(__table, row, __column) : nullptr);
+		if (__slots[slot].head == NONE)
+		{
+			__slots[slot].hash = hash;
+			__slots[slot].key = key;
+			__keys++;
+		}
+		__next[row] = __slots[slot].head;
+		__slots[slot].head = row;
+		__size++;
+	}
+
+	void QHashIndex::erase(const std::size_t row)
+	{
+		std::size_t hash = 0;
+		int64_t key = 0;
+		if (!__key(row, hash, key))
+		{
+			return;
+		}
+
+		const std::size_t slot = __locate(hash, key, __type == QDataType::STRING ? &stringAt(__table, row, __column) : nullptr);
+		std::size_t* link = &__slots[slot].head;
+		while (*link != NONE && *link != row)
+		{
+			link = &__next[*link];
+		}
+		if (*link == NONE)
+		{
+			return;
+		}
+
+		*link = __next[row];
+		__next[row] = NONE;
+		__size--;
+		if (__slots[slot].head == NONE)
+		{
+			__remove(slot);
+		}
+	}
+
+	std::size_t QHashIndex::find(const QValue& value, qtl::vector<std::size_t>& rows) const
+	{
+		if (value.isNull())
+		{
+			return 0;
+		}
+
+		std::size_t hash = 0;
+		int64_t key = 0;
+		const qtl::string* string = nullptr;
+		if (__type == QDataType::STRING)
+		{
+			if (value.getType() != QDataType::STRING)
+			{
+				return 0;
+			}
+			string = &value.getString();
+			hash = hashString(*string);
+		}
+		else
+		{
+			// integral values compare widened, a one character string matches a CHAR
+			if (value.getType() == QDataType::STRING)
+			{
+				if (__type != QDataType::CHAR || value.getString().length() != 1)
+				{
+					return 0;
+				}
+				key = value.getString()[0];
+			}
+			else
+			{
+				value.store(QDataType::LONG, &key);
+			}
+			hash = hashKey(key);
+		}
+
+		std::size_t count = 0;
+		for (std::size_t row = __slots[__locate(hash, key, string)].head; row != NONE; row = __next[row])
+		{
+			rows.push_back(row);
+			count++;
+		}
+		return count;
+	}
+
+	bool QHashIndex::__key(const std::size_t row, std::size_t& hash, int64_t& key) const
+	{
+		QField field = __table.getRow(row).get(__column);
+		if (field.isNull())
+		{
+			return false;
+		}
+
+		switch (__type)
+		{
+		case QDataType::CHAR:
+			key = field.get<char>();
+			break;
+		case QDataType::INT:
+			key = field.get<int32_t>();
+			break;
+		case QDataType::LONG:
+			key = field.get<int64_t>();
+			break;
+		case QDataType::STRING:
+			hash = hashString(field.get<qtl::string>());
+			return true;
+		case QDataType::BOOL:
+			return false;
+		}
+		hash = hashKey(key);
+		return true;
+	}
+
+	std::size_t QHashIndex::__locate(const std::size_t hash, const int64_t key, const qtl::string* string) const
+	{
+		// returns the slot of the value, or the empty slot that ends its probe sequence
+		std::size_t slot = hash & __mask;
+		while (__slots[slot].head != NONE)
+		{
+			const QSlot& candidate = __slots[slot];
+			if (candidate.hash == hash && (string ? stringAt(__table, candidate.head, __column) == *string : candidate.key == key))
+			{
+				return slot;
+			}
+			slot = (slot + 1) & __mask;
+		}
+		return slot;
+	}
+
+	void QHashIndex::__grow()
+	{
+		const std::size_t capacity = (__mask + 1) * 2;
+		QSlot* slots = static_cast<QSlot*>(malloc(capacity * sizeof(QSlot)));
+		for (std::size_t slot = 0; slot < capacity; slot++)
+		{
+			slots[slot].head = NONE;
+		}
+
+		// values are distinct, so they only need an empty slot
+		for (std::size_t old = 0; old <= __mask; old++)
+		{
+			if (__slots[old].head == NONE)
+			{
+				continue;
+			}
+			std::size_t slot = __slots[old].hash & (capacity - 1);
+			while (slots[slot].head != NONE)
+			{
+				slot = (slot + 1) & (capacity - 1);
+			}
+			slots[slot] = __slots[old];
+		}
+
+		free(__slots);
+		__slots = slots;
+		__mask = capacity - 1;
+	}
+
+	void QHashIndex::__remove(std::size_t slot)
+	{
+		// backward shift deletion keeps every probe sequence free of holes
+		__slots[slot].head = NONE;
+		__keys--;
+		std::size_t next = (slot + 1) & __mask;
+		while (__slots[next].head != NONE)
+		{
+			const std::size_t home = __slots[next].hash & __mask;
+			if (((next - home) & __mask) >= ((next - slot) & __mask))
+			{
+				__slots[slot] = __slots[next];
+				__slots[next].head = NONE;
+				slot = next;
+			}
+			next = (next + 1) & __mask;
+		}
+	}
+}
@@ -0,0 +1,248 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qlexer.h"
+
+namespace qsql
+{
+	namespace
+	{
+		struct QKeyword
+		{
+			const char* text;
+			std::size_t length;
+			QTokenType type;
+		};
+
+		inline char toUpper(const char c)
+		{
+			return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+		}
+
+		inline bool isIdentifierStart(const char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+		}
+
+		inline bool isDigit(const char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		inline bool isIdentifierPart(const char c)
+		{
+			return isIdentifierStart(c) || isDigit(c);
+		}
+
+		bool matches(const char* text, const std::size_t length, const QKeyword& keyword)
+		{
+			if (length != keyword.length)
+			{
+				return false;
+			}
+			for (std::size_t i = 0; i < length; i++)
+			{
+				if (toUpper(text[i]) != keyword.text[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// keywords grouped by their first letter so that an identifier is only
+		// compared against the handful of keywords it could be
+		QTokenType lookupKeyword(const char* text, const std::size_t length)
+		{
+			static const QKeyword A[] = { { "AND", 3, QTokenType::KEYWORD_AND }, { "AS", 2, QTokenType::KEYWORD_AS }, { "ASC", 3, QTokenType::KEYWORD_ASC } };
+			static const QKeyword B[] = { { "BETWEEN", 7, QTokenType::KEYWORD_BETWEEN }, { "BY", 2, QTokenType::KEYWORD_BY } };
+			static const QKeyword D[] = { { "DELETE", 6, QTokenType::KEYWORD_DELETE }, { "DESC", 4, QTokenType::KEYWORD_DESC } };
+			static const QKeyword F[] = { { "FALSE", 5, QTokenType::KEYWORD_FALSE }, { "FROM", 4, QTokenType::KEYWORD_FROM } };
+			static const QKeyword G[] = { { "GROUP", 5, QTokenType::KEYWORD_GROUP } };
+			static const QKeyword H[] = { { "HAVING", 6, QTokenType::KEYWORD_HAVING } };
+			static const QKeyword I[] = { { "IN", 2, QTokenType::KEYWORD_IN }, { "INNER", 5, QTokenType::KEYWORD_INNER }, { "INSERT", 6, QTokenType::KEYWORD_INSERT }, { "INTO", 4, QTokenType::KEYWORD_INTO }, { "IS", 2, QTokenType::KEYWORD_IS } };
+			static const QKeyword J[] = { { "JOIN", 4, QTokenType::KEYWORD_JOIN } };
+			static const QKeyword L[] = { { "LIMIT", 5, QTokenType::KEYWORD_LIMIT } };
+			static const QKeyword N[] = { { "NOT", 3, QTokenType::KEYWORD_NOT }, { "NULL", 4, QTokenType::KEYWORD_NULL } };
+			static const QKeyword O[] = { { "OFFSET", 6, QTokenType::KEYWORD_OFFSET }, { "ON", 2, QTokenType::KEYWORD_ON }, { "OR", 2, QTokenType::KEYWORD_OR }, { "ORDER", 5, QTokenType::KEYWORD_ORDER } };
+			static const QKeyword S[] = { { "SELECT", 6, QTokenType::KEYWORD_SELECT }, { "SET", 3, QTokenType::KEYWORD_SET } };
+			static const QKeyword T[] = { { "TRUE", 4, QTokenType::KEYWORD_TRUE } };
+			static const QKeyword U[] = { { "UPDATE", 6, QTokenType::KEYWORD_UPDATE } };
+			static const QKeyword V[] = { { "VALUES", 6, QTokenType::KEYWORD_VALUES } };
+			static const QKeyword W[] = { { "WHERE", 5, QTokenType::KEYWORD_WHERE } };
+
+			const QKeyword* candidates = nullptr;
+			std::size_t count = 0;
+			switch (toUpper(text[0]))
+			{
+			case 'A': candidates = A; count = sizeof(A) / sizeof(QKeyword); break;
+			case 'B': candidates = B; count = sizeof(B) / sizeof(QKeyword); break;
+			case 'D': candidates = D; count = sizeof(D) / sizeof(QKeyword); break;
+			case 'F': candidates = F; count = sizeof(F) / sizeof(QKeyword); break;
+			case 'G': candidates = G; count = sizeof(G) / sizeof(QKeyword); break;
+			case 'H': candidates = H; count = sizeof(H) / sizeof(QKeyword); break;
+			case 'I': candidates = I; count = sizeof(I) / sizeof(QKeyword); break;
+			case 'J': candidates = J; count = sizeof(J) / sizeof(QKeyword); break;
+			case 'L': candidates = L; count = sizeof(L) / sizeof(QKeyword); break;
+			case 'N': candidates = N; count = sizeof(N) / sizeof(QKeyword); break;
+			case 'O': candidates = O; count = sizeof(O) / sizeof(QKeyword); break;
+			case 'S': candidates = S; count = sizeof(S) / sizeof(QKeyword); break;
+			case 'T': candidates = T; count = sizeof(T) / sizeof(QKeyword); break;
+			case 'U': candidates = U; count = sizeof(U) / sizeof(QKeyword); break;
+			case 'V': candidates = V; count = sizeof(V) / sizeof(QKeyword); break;
+			case 'W': candidates = W; count = sizeof(W) / sizeof(QKeyword); break;
+			default: break;
+			}
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (matches(text, length, candidates[i]))
+				{
+					return candidates[i].type;
+				}
+			}
+			return QTokenType::IDENTIFIER;
+		}
+	}
+
+	QLexer::QLexer(const char* text, const std::size_t length)
+		: __text(text), __length(length), __position(0)
+	{
+	}
+
+	QToken QLexer::next()
+	{
+		// skip whitespace and -- comments
+		while (__position < __length)
+		{
+			const char c = __text[__position];
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			{
+				__position++;
+			}
+			else if (c == '-' && __position + 1 < __length && __text[__position + 1] == '-')
+			{
+				while (__position < __length && __text[__position] != '\n')
+				{
+					__position++;
+				}
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		const std::size_t start = __position;
+		QToken token = { QTokenType::END, __text + start, 0, start };
+		if (__position >= __length)
+		{
+			return token;
+		}
+
+		const char c = __text[__position++];
+		if (isIdentifierStart(c))
+		{
+			while (__position < __length && isIdentifierPart(__text[__position]))
+			{
+				__position++;
+			}
+			token.length = __position - start;
+			token.type = lookupKeyword(token.text, token.length);
+			return token;
+		}
+
+		if (isDigit(c))
+		{
+			while (__position < __length && isDigit(__text[__position]))
+			{
+				__position++;
+			}
+			token.type = QTokenType::INTEGER;
+			token.length = __position - start;
+			return token;
+		}
+
+		if (c == '\'' || c == '"')
+		{
+			// single quotes delimit strings, double quotes delimit identifiers, both escape the quote by doubling it
+			token.type = c == '\'' ? QTokenType::STRING : QTokenType::IDENTIFIER;
+			token.text = __text + __position;
+			while (true)
+			{
+				if (__position >= __length)
+				{
+					token.type = QTokenType::INVALID;
+					token.text = __text + start;
+					token.length = __length - start;
+					return token;
+				}
+				if (__text[__position] == c)
+				{
+					if (__position + 1 < __length && __text[__position + 1] == c)
+					{
+						__position += 2;
+						continue;
+					}
+					break;
+				}
+				__position++;
+			}
+			token.length = __text + __position - token.text;
+			__position++;
+			return token;
+		}
+
+		token.length = 1;
+		const char following = __position < __length ? __text[__position] : '\0';
+		switch (c)
+		{
+		case ',': token.type = QTokenType::COMMA; break;
+		case '.': token.type = QTokenType::DOT; break;
+		case ';': token.type = QTokenType::SEMICOLON; break;
+		case '(': token.type = QTokenType::LEFT_PAREN; break;
+		case ')': token.type = QTokenType::RIGHT_PAREN; break;
+		case '*': token.type = QTokenType::STAR; break;
+		case '+': token.type = QTokenType::PLUS; break;
+		case '-': token.type = QTokenType::MINUS; break;
+		case '/': token.type = QTokenType::SLASH; break;
+		case '%': token.type = QTokenType::PERCENT; break;
+		case '?': token.type = QTokenType::PARAMETER; break;
+		case '=':
+			token.type = QTokenType::EQUAL;
+			if (following == '=')
+			{
+				token.length = 2;
+			}
+			break;
+		case '!':
+			token.type = following == '=' ? QTokenType::NOT_EQUAL : QTokenType::INVALID;
+			token.length = following == '=' ? 2 : 1;
+			break;
+		case '<':
+			if (following == '=')
+			{
+				token.type = QTokenType::LESS_EQUAL;
+				token.length = 2;
+			}
+			else if (following == '>')
+			{
+				token.type = QTokenType::NOT_EQUAL;
+				token.length = 2;
+			}
+			else
+			{
+				token.type = QTokenType::LESS;
+			}
+			break;
+		case '>':
+			token.type = following == '=' ? QTokenType::GREATER_EQUAL : QTokenType::GREATER;
+			token.length = following == '=' ? 2 : 1;
+			break;
+		default:
+			token.type = QTokenType::INVALID;
+			break;
+		}
+		__position = start + token.length;
+		return token;
+	}
+}
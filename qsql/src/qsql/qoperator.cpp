@@ -0,0 +1,2495 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qoperator.h"
+
+#include <qtl/hash.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		void copyValue(const QDataType type, const void* source, void* destination, const std::size_t index)
+		{
+			switch (type)
+			{
+			case QDataType::CHAR:
+				static_cast<char*>(destination)[index] = *static_cast<const char*>(source);
+				break;
+			case QDataType::INT:
+				static_cast<int32_t*>(destination)[index] = *static_cast<const int32_t*>(source);
+				break;
+			case QDataType::LONG:
+				static_cast<int64_t*>(destination)[index] = *static_cast<const int64_t*>(source);
+				break;
+			case QDataType::BOOL:
+				static_cast<bool*>(destination)[index] = *static_cast<const bool*>(source);
+				break;
+			case QDataType::STRING:
+				static_cast<qtl::string*>(destination)[index] = *static_cast<const qtl::string*>(source);
+				break;
+			}
+		}
+
+		// Appends the active values of vector to column, which has to be nullable
+		void appendValues(const QVector& vector, const uint16_t* selection, const std::size_t count, QColumn& column)
+		{
+			const QDataType type = column.getType();
+			const std::size_t width = getDataTypeSize(type);
+			const char* data = static_cast<const char*>(vector.getData());
+			const QDictionary* dictionary = vector.getDictionary();
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const std::size_t index = selection ? selection[i] : i;
+				const std::size_t row = column.size();
+				void* value = column.append();
+				if (vector.isNull(index))
+				{
+					column.setNull(row, true);
+				}
+				else if (dictionary)
+				{
+					*static_cast<qtl::string*>(value) = dictionary->decode(vector.getData<uint32_t>()[index]);
+				}
+				else
+				{
+					copyValue(type, data + index * width, value, 0);
+				}
+			}
+		}
+
+		// Finalizer of MurmurHash3, spreads every bit of a hash over the top bits
+		// that pick a join partition
+		inline uint64_t mixHash(uint64_t hash)
+		{
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdULL;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ULL;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		// Join key at index of a CHAR, INT or LONG vector, widened to LONG
+		inline int64_t numericKey(const QVector& vector, const std::size_t index)
+		{
+			switch (vector.getType())
+			{
+			case QDataType::CHAR:
+				return vector.getData<char>()[index];
+			case QDataType::INT:
+				return vector.getData<int32_t>()[index];
+			default:
+				return vector.getData<int64_t>()[index];
+			}
+		}
+
+		// Adds two LONG values wrapping on overflow like LONG arithmetic does
+		inline int64_t addWrapping(const int64_t left, const int64_t right)
+		{
+			return static_cast<int64_t>(static_cast<uint64_t>(left) + static_cast<uint64_t>(right));
+		}
+
+		inline const qtl::string& stringKey(const QVector& vector, const std::size_t index)
+		{
+			const QDictionary* dictionary = vector.getDictionary();
+			return dictionary ? dictionary->decode(vector.getData<uint32_t>()[index]) : vector.getData<qtl::string>()[index];
+		}
+
+		// Holds a table's latch shared for a scope
+		class QReadLatch
+		{
+		public:
+			explicit QReadLatch(const QTable& table)
+				: __latch(table.getLatch())
+			{
+				__latch.lock_shared();
+			}
+
+			~QReadLatch()
+			{
+				__latch.unlock_shared();
+			}
+		private:
+			qtl::shared_mutex& __latch;
+		};
+
+		// Selects the rows of a batch gathered from rows that are visible to snapshot
+		void selectVisible(const QTable& table, const std::size_t* rows, const std::size_t count, const uint64_t snapshot, QBatch& batch)
+		{
+			uint16_t* selection = batch.getSelectionBuffer();
+			std::size_t selected = 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				selection[selected] = static_cast<uint16_t>(i);
+				selected += table.isVisible(rows[i], snapshot);
+			}
+			if (selected < count)
+			{
+				batch.setSelection(selected);
+			}
+		}
+
+		// Copies the given columns of count table rows into the batch's own vectors.
+		// The rows are first, first + 1, ... or, when rows is not nullptr, rows[0..count).
+		// Dictionary encoded columns are copied as codes.
+		void gatherRows(const QTable& table, const qtl::vector<std::size_t>& columns, const std::size_t* rows, const std::size_t first, const std::size_t count, QBatch& batch)
+		{
+			const QSchema& schema = table.getSchema();
+			for (std::size_t i = 0; i < columns.size(); i++)
+			{
+				const std::size_t column = columns[i];
+				const QDataType type = schema.getColumnType(column);
+				const QDictionary* dictionary = table.getDictionary(column);
+				QVector& vector = batch.getColumn(i);
+				uint32_t* codes = nullptr;
+				if (dictionary)
+				{
+					codes = vector.initializeCodes(*dictionary);
+				}
+				else
+				{
+					vector.initialize(type);
+				}
+				uint64_t* nulls = schema.isNullable(column) ? vector.initializeNulls() : nullptr;
+
+				if (codes)
+				{
+					for (std::size_t row = 0; row < count; row++)
+					{
+						const std::size_t source = rows ? rows[row] : first + row;
+						if (nulls && table.getRow(source).get(column).isNull())
+						{
+							nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+							continue;
+						}
+						codes[row] = table.getCode(source, column);
+					}
+					continue;
+				}
+
+				for (std::size_t row = 0; row < count; row++)
+				{
+					QField field = table.getRow(rows ? rows[row] : first + row).get(column);
+					if (field.isNull())
+					{
+						nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+						continue;
+					}
+
+					switch (type)
+					{
+					case QDataType::CHAR:
+						vector.getData<char>()[row] = field.get<char>();
+						break;
+					case QDataType::INT:
+						vector.getData<int32_t>()[row] = field.get<int32_t>();
+						break;
+					case QDataType::LONG:
+						vector.getData<int64_t>()[row] = field.get<int64_t>();
+						break;
+					case QDataType::BOOL:
+						vector.getData<bool>()[row] = field.get<bool>();
+						break;
+					case QDataType::STRING:
+						vector.getData<qtl::string>()[row] = field.get<qtl::string>();
+						break;
+					}
+				}
+			}
+		}
+
+		template<typename T>
+		int compareTyped(const void* left, const void* right)
+		{
+			const T& l = *static_cast<const T*>(left);
+			const T& r = *static_cast<const T*>(right);
+			return (r < l) - (l < r);
+		}
+
+		int compareValues(const QDataType type, const void* left, const void* right)
+		{
+			switch (type)
+			{
+			case QDataType::CHAR:
+				return compareTyped<char>(left, right);
+			case QDataType::INT:
+				return compareTyped<int32_t>(left, right);
+			case QDataType::LONG:
+				return compareTyped<int64_t>(left, right);
+			case QDataType::BOOL:
+				return compareTyped<bool>(left, right);
+			case QDataType::STRING:
+				return static_cast<const qtl::string*>(left)->compare(*static_cast<const qtl::string*>(right));
+			}
+			return 0;
+		}
+
+		// Hash of the key at index, NULL keys all hash the same
+		uint64_t hashValue(const QVector& vector, const QDataType type, const std::size_t index)
+		{
+			if (vector.isNull(index))
+			{
+				return 0x9e3779b97f4a7c15ULL;
+			}
+			switch (type)
+			{
+			case QDataType::STRING:
+				return qtl::hash<qtl::string>()(stringKey(vector, index));
+			case QDataType::BOOL:
+				return qtl::hash<int64_t>()(vector.getData<bool>()[index]);
+			default:
+				return qtl::hash<int64_t>()(numericKey(vector, index));
+			}
+		}
+
+		// Value at index of a vector of type, decoded if the vector holds codes
+		inline const void* valueAt(const QVector& vector, const QDataType type, const std::size_t index)
+		{
+			if (vector.getDictionary())
+			{
+				return &stringKey(vector, index);
+			}
+			return static_cast<const char*>(vector.getData()) + index * getDataTypeSize(type);
+		}
+
+		// Whether the value at index equals the one of a column's row, NULL equals NULL
+		bool equalValues(const QVector& vector, const std::size_t index, const QColumn& column, const std::size_t row)
+		{
+			const bool null = vector.isNull(index);
+			if (null || column.isNull(row))
+			{
+				return null && column.isNull(row);
+			}
+			return compareValues(column.getType(), valueAt(vector, column.getType(), index), column.at(row)) == 0;
+		}
+
+		// Copies count rows of a column from first into a vector
+		void copyColumn(const QColumn& column, const std::size_t first, const std::size_t count, QVector& vector)
+		{
+			const QDataType type = column.getType();
+			vector.initialize(type);
+			uint64_t* nulls = nullptr;
+			for (std::size_t row = 0; row < count; row++)
+			{
+				if (column.isNull(first + row))
+				{
+					nulls = nulls ? nulls : vector.initializeNulls();
+					nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					continue;
+				}
+				copyValue(type, column.at(first + row), vector.getData(), row);
+			}
+		}
+
+		// Writes a null flag and, unless value is nullptr, the value.  Strings
+		// are written as their length and characters.
+		bool writeValue(FILE* file, const QDataType type, const void* value)
+		{
+			const char null = value == nullptr;
+			if (fwrite(&null, 1, 1, file) != 1 || null)
+			{
+				return !ferror(file);
+			}
+			if (type != QDataType::STRING)
+			{
+				return fwrite(value, getDataTypeSize(type), 1, file) == 1;
+			}
+			const qtl::string& string = *static_cast<const qtl::string*>(value);
+			const uint32_t length = static_cast<uint32_t>(string.length());
+			return fwrite(&length, sizeof(length), 1, file) == 1 && (length == 0 || fwrite(string.c_str(), length, 1, file) == 1);
+		}
+
+		// Reads a value written by writeValue into data[index], returns the bytes
+		// read, 1 for NULL or 0 if the file ends first
+		long readValue(FILE* file, const QDataType type, void* data, const std::size_t index, qtl::vector<char>& buffer)
+		{
+			char null;
+			if (fread(&null, 1, 1, file) != 1)
+			{
+				return 0;
+			}
+			if (null)
+			{
+				return 1;
+			}
+			if (type != QDataType::STRING)
+			{
+				const std::size_t width = getDataTypeSize(type);
+				return fread(static_cast<char*>(data) + index * width, width, 1, file) == 1 ? static_cast<long>(1 + width) : 0;
+			}
+			uint32_t length;
+			if (fread(&length, sizeof(length), 1, file) != 1)
+			{
+				return 0;
+			}
+			buffer.resize(length + 1);
+			if (length > 0 && fread(buffer.data(), length, 1, file) != 1)
+			{
+				return 0;
+			}
+			buffer[length] = '\0';
+			static_cast<qtl::string*>(data)[index] = qtl::string(buffer.data(), length);
+			return static_cast<long>(1 + sizeof(length) + length);
+		}
+	}
+
+	QMorselCursor::QMorselCursor()
+		: __next(0), __end(0)
+	{
+	}
+
+	void QMorselCursor::reset(const std::size_t rows)
+	{
+		__end = rows;
+		__next.store(0, std::memory_order_relaxed);
+	}
+
+	bool QMorselCursor::next(std::size_t& first, std::size_t& end)
+	{
+		const std::size_t position = __next.fetch_add(MORSEL_SIZE, std::memory_order_relaxed);
+		if (position >= __end)
+		{
+			return false;
+		}
+		first = position;
+		end = __end - position < MORSEL_SIZE ? __end : position + MORSEL_SIZE;
+		return true;
+	}
+
+	QScanOperator::QScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const uint64_t& snapshot, QMorselCursor* morsels)
+		: __table(table), __columns(columns), __snapshot(snapshot), __morsels(morsels), __position(0), __batch(columns.size()), __end(NONE),
+		__pinned(NONE), __failed(false), __bounded(false)
+	{
+	}
+
+	QScanOperator::~QScanOperator()
+	{
+		__unpin();
+		for (const QScanRange& range : __ranges)
+		{
+			delete range.low;
+			delete range.high;
+		}
+		for (const QScanKey& key : __keys)
+		{
+			delete key.key;
+		}
+	}
+
+	void QScanOperator::addRange(const std::size_t column, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive)
+	{
+		__ranges.push_back({ column, low, lowInclusive, high, highInclusive });
+		__bounded = false;
+	}
+
+	void QScanOperator::addKey(const std::size_t column, QExpression* key)
+	{
+		__keys.push_back({ column, key });
+		__bounded = false;
+	}
+
+	void QScanOperator::addRuntimeFilter(const std::size_t column, const QBloomFilter& filter)
+	{
+		__filters.push_back({ column, &filter });
+	}
+
+	std::size_t QScanOperator::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	QDataType QScanOperator::getColumnType(const std::size_t column) const
+	{
+		return __table.getColumnType(__columns[column]);
+	}
+
+	QBatch* QScanOperator::next()
+	{
+		// the latch keeps a writer from growing the table while the batch is assembled,
+		// the values it references are never changed once committed
+		const QReadLatch latch(__table);
+		if (__failed)
+		{
+			return nullptr;
+		}
+		if (__end == NONE && __morsels == nullptr)
+		{
+			__end = __table.getRowCount();
+		}
+		if (!__bounded)
+		{
+			__bound();
+		}
+		for (;;)
+		{
+			// a scan sharing a cursor moves on to the next morsel it claims
+			if ((__end == NONE || __position >= __end) && (__morsels == nullptr || !__morsels->next(__position, __end)))
+			{
+				break;
+			}
+
+			const std::size_t page = __position >> QTable::PAGE_SHIFT;
+			if (__isOutside(page))
+			{
+				const std::size_t next = (page + 1) << QTable::PAGE_SHIFT;
+				__position = next < __end ? next : __end;
+				continue;
+			}
+
+			std::size_t count = __end - __position < QBatch::CAPACITY ? __end - __position : QBatch::CAPACITY;
+			if (__table.getLayout() == QTableLayout::COLUMN)
+			{
+				const std::size_t chunk = __position >> QColumn::CHUNK_SHIFT;
+				const std::size_t offset = __position & (QColumn::CHUNK_SIZE - 1);
+				if (count > QColumn::CHUNK_SIZE - offset)
+				{
+					count = QColumn::CHUNK_SIZE - offset;
+				}
+
+				// a chunk read through a buffer pool stays pinned until the scan moves past it
+				if (chunk != __pinned)
+				{
+					__unpin();
+					if (!__pin(chunk))
+					{
+						__failed = true;
+						return nullptr;
+					}
+				}
+
+				for (std::size_t i = 0; i < __columns.size(); i++)
+				{
+					const QColumn& column = __table.getColumn(__columns[i]);
+					const uint64_t* nulls = column.getNulls(chunk);
+					nulls = nulls ? nulls + (offset >> 6) : nullptr;
+					if (const QSegment* segment = column.getSegment(chunk))
+					{
+						// compressed chunks are decoded into the batch's own buffer
+						QVector& vector = __batch.getColumn(i);
+						vector.initialize(column.getType());
+						segment->decode(offset, count, vector.getData());
+						vector.reference(column.getType(), vector.getData(), nulls);
+						continue;
+					}
+					char* data = static_cast<char*>(column.getChunk(chunk)) + offset * column.getWidth();
+					if (column.getDictionary())
+					{
+						__batch.getColumn(i).referenceCodes(*column.getDictionary(), reinterpret_cast<uint32_t*>(data), nulls);
+					}
+					else
+					{
+						__batch.getColumn(i).reference(column.getType(), data, nulls);
+					}
+				}
+			}
+			else
+			{
+				gatherRows(__table, __columns, nullptr, __position, count, __batch);
+			}
+
+			__batch.setSize(count);
+			__batch.setRowOffset(__position);
+			__batch.clearSelection();
+
+			// batches start on a multiple of 64 rows and stay within a page
+			uint64_t live[QVector::NULL_WORDS];
+			if (__table.getVisible(__position, count, __snapshot, live))
+			{
+				__batch.setSelection(bitmapToSelection(live, count, __batch.getSelectionBuffer()));
+			}
+			if (!__filters.empty())
+			{
+				__applyFilters();
+			}
+
+			__position += count;
+			if (__batch.getActiveCount() > 0)
+			{
+				return &__batch;
+			}
+		}
+		__unpin();
+		return nullptr;
+	}
+
+	void QScanOperator::reset()
+	{
+		__unpin();
+		__failed = false;
+		__position = 0;
+		__end = NONE;
+		__bounded = false;
+	}
+
+	const char* QScanOperator::getError() const
+	{
+		return __failed ? __table.getBufferPool()->getError() : nullptr;
+	}
+
+	void QScanOperator::__bound()
+	{
+		__bounds.clear();
+		for (const QScanRange& range : __ranges)
+		{
+			int64_t bounds[2] = { INT64_MIN, INT64_MAX };
+			bool usable = true;
+			bool empty = false;
+			for (int side = 0; side < 2 && usable; side++)
+			{
+				const QExpression* bound = side ? range.high : range.low;
+				if (bound == nullptr)
+				{
+					continue;
+				}
+				const QValue* value = bound->getConstant();
+				usable = value && !value->isNull() && (value->getType() == QDataType::INT || value->getType() == QDataType::LONG);
+				if (!usable)
+				{
+					break;
+				}
+
+				// nothing lies beyond the end of the domain
+				const int64_t key = value->getType() == QDataType::INT ? value->getInt() : value->getLong();
+				const bool inclusive = side ? range.highInclusive : range.lowInclusive;
+				const int64_t end = side ? INT64_MIN : INT64_MAX;
+				empty = empty || (!inclusive && key == end);
+				bounds[side] = inclusive || key == end ? key : side ? key - 1 : key + 1;
+			}
+			if (usable)
+			{
+				__bounds.push_back(static_cast<int64_t>(range.column));
+				__bounds.push_back(empty ? INT64_MAX : bounds[0]);
+				__bounds.push_back(empty ? INT64_MIN : bounds[1]);
+			}
+		}
+
+		__hashes.clear();
+		for (const QScanKey& key : __keys)
+		{
+			const QValue* value = key.key->getConstant();
+			uint64_t hash;
+			if (value && !value->isNull() && QBloomFilter::hashValue(*value, hash))
+			{
+				__hashes.push_back(key.column);
+				__hashes.push_back(hash);
+			}
+		}
+		__bounded = true;
+	}
+
+	bool QScanOperator::__isOutside(const std::size_t page) const
+	{
+		for (std::size_t i = 0; i < __bounds.size(); i += 3)
+		{
+			if (__table.isOutside(page, static_cast<std::size_t>(__bounds[i]), __bounds[i + 1], __bounds[i + 2]))
+			{
+				return true;
+			}
+		}
+		for (std::size_t i = 0; i < __hashes.size(); i += 2)
+		{
+			if (__table.isAbsent(page, static_cast<std::size_t>(__hashes[i]), __hashes[i + 1]))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void QScanOperator::__applyFilters()
+	{
+		uint16_t rows[QBatch::CAPACITY];
+		uint64_t hashes[QBatch::CAPACITY];
+		uint64_t found[QVector::NULL_WORDS];
+		for (const QRuntimeFilter& filter : __filters)
+		{
+			// a filter is not built until its join reads the build side
+			if (filter.filter->getBlockCount() == 0)
+			{
+				continue;
+			}
+
+			const QVector& keys = __batch.getColumn(filter.column);
+			const bool strings = keys.getType() == QDataType::STRING;
+			const uint16_t* selection = __batch.getSelection();
+			const std::size_t active = __batch.getActiveCount();
+			std::size_t count = 0;
+			for (std::size_t i = 0; i < active; i++)
+			{
+				const uint16_t row = selection ? selection[i] : static_cast<uint16_t>(i);
+				if (keys.isNull(row))
+				{
+					continue;
+				}
+				rows[count] = row;
+				hashes[count] = strings ? QBloomFilter::hashString(stringKey(keys, row)) : QBloomFilter::hashKey(numericKey(keys, row));
+				count++;
+			}
+
+			filter.filter->filter(hashes, count, found);
+			uint16_t* kept = __batch.getSelectionBuffer();
+			std::size_t selected = 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				kept[selected] = rows[i];
+				selected += (found[i >> 6] >> (i & 63)) & 1;
+			}
+			__batch.setSelection(selected);
+		}
+	}
+
+	// Pins the chunk in every column or, if the pool runs out of frames, in none
+	bool QScanOperator::__pin(const std::size_t chunk)
+	{
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			if (!__table.getColumn(__columns[i]).pinChunk(chunk))
+			{
+				while (i-- > 0)
+				{
+					__table.getColumn(__columns[i]).unpinChunk(chunk);
+				}
+				return false;
+			}
+		}
+		__pinned = chunk;
+		return true;
+	}
+
+	void QScanOperator::__unpin()
+	{
+		if (__pinned != NONE)
+		{
+			for (std::size_t i = 0; i < __columns.size(); i++)
+			{
+				__table.getColumn(__columns[i]).unpinChunk(__pinned);
+			}
+			__pinned = NONE;
+		}
+	}
+
+	QIndexScanOperator::QIndexScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QHashIndex& index, QExpression* key, const uint64_t& snapshot)
+		: __table(table), __columns(columns), __index(index), __key(key), __snapshot(snapshot), __position(0), __found(false), __batch(columns.size())
+	{
+	}
+
+	QIndexScanOperator::~QIndexScanOperator()
+	{
+		delete __key;
+	}
+
+	std::size_t QIndexScanOperator::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	QDataType QIndexScanOperator::getColumnType(const std::size_t column) const
+	{
+		return __table.getColumnType(__columns[column]);
+	}
+
+	QBatch* QIndexScanOperator::next()
+	{
+		// the index holds every version of a row, the snapshot picks the one it sees
+		const QReadLatch latch(__table);
+		if (!__found)
+		{
+			__rows.clear();
+			const QValue* key = __key->getConstant();
+			if (key && __index.find(*key, __rows) > 1)
+			{
+				std::sort(__rows.data(), __rows.data() + __rows.size());
+			}
+			__found = true;
+		}
+
+		while (__position < __rows.size())
+		{
+			const std::size_t remaining = __rows.size() - __position;
+			const std::size_t count = remaining < QBatch::CAPACITY ? remaining : QBatch::CAPACITY;
+			gatherRows(__table, __columns, __rows.data() + __position, 0, count, __batch);
+			__batch.setSize(count);
+			__batch.setRowOffset(0);
+			__batch.setRowIds(__rows.data() + __position);
+			__batch.clearSelection();
+			selectVisible(__table, __rows.data() + __position, count, __snapshot, __batch);
+			__position += count;
+			if (__batch.getActiveCount() > 0)
+			{
+				return &__batch;
+			}
+		}
+		return nullptr;
+	}
+
+	void QIndexScanOperator::reset()
+	{
+		__position = 0;
+		__found = false;
+	}
+
+	QBitmapCondition::QBitmapCondition(const QBitmapIndex& index, QExpression* key, const bool negated)
+		: __index(&index), __key(key), __negated(negated), __op(QLogical::AND), __left(nullptr), __right(nullptr)
+	{
+	}
+
+	QBitmapCondition::QBitmapCondition(const QLogical op, QBitmapCondition* left, QBitmapCondition* right)
+		: __index(nullptr), __key(nullptr), __negated(false), __op(op), __left(left), __right(right)
+	{
+	}
+
+	QBitmapCondition::~QBitmapCondition()
+	{
+		delete __key;
+		delete __left;
+		delete __right;
+	}
+
+	bool QBitmapCondition::evaluate(QRoaringBitmap& rows) const
+	{
+		if (__index == nullptr)
+		{
+			QRoaringBitmap right;
+			if (!__left->evaluate(rows) || !__right->evaluate(right))
+			{
+				return false;
+			}
+			if (__op == QLogical::AND)
+			{
+				rows.intersect(right);
+			}
+			else
+			{
+				rows.unite(right);
+			}
+			return true;
+		}
+
+		const QValue* key = __key->getConstant();
+		if (key == nullptr || !__index->canFind(*key))
+		{
+			return false;
+		}
+
+		// comparing with NULL holds for no row, negated or not
+		rows.clear();
+		const QRoaringBitmap* found = __index->find(*key);
+		if (__negated && !key->isNull())
+		{
+			rows = __index->getRows();
+			if (found)
+			{
+				rows.subtract(*found);
+			}
+		}
+		else if (found && !__negated)
+		{
+			rows = *found;
+		}
+		return true;
+	}
+
+	QBitmapScanOperator::QBitmapScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, QBitmapCondition* condition, const uint64_t& snapshot)
+		: __table(table), __columns(columns), __condition(condition), __snapshot(snapshot), __evaluated(false), __every(false), __position(0), __batch(columns.size())
+	{
+	}
+
+	QBitmapScanOperator::~QBitmapScanOperator()
+	{
+		delete __condition;
+	}
+
+	std::size_t QBitmapScanOperator::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	QDataType QBitmapScanOperator::getColumnType(const std::size_t column) const
+	{
+		return __table.getColumnType(__columns[column]);
+	}
+
+	QBatch* QBitmapScanOperator::next()
+	{
+		// the indexes hold every version of a row, the snapshot picks the one it sees
+		const QReadLatch latch(__table);
+		if (!__evaluated)
+		{
+			__every = !__condition->evaluate(__matches);
+			__position = 0;
+			__evaluated = true;
+		}
+
+		for (;;)
+		{
+			std::size_t count = 0;
+			if (__every)
+			{
+				const std::size_t size = __table.getRowCount();
+				for (; count < QBatch::CAPACITY && __position < size; count++)
+				{
+					__rows[count] = __position++;
+				}
+			}
+			else
+			{
+				count = __matches.extract(__position, __rows, QBatch::CAPACITY);
+			}
+			if (count == 0)
+			{
+				return nullptr;
+			}
+
+			gatherRows(__table, __columns, __rows, 0, count, __batch);
+			__batch.setSize(count);
+			__batch.setRowOffset(0);
+			__batch.setRowIds(__rows);
+			__batch.clearSelection();
+			selectVisible(__table, __rows, count, __snapshot, __batch);
+			if (__batch.getActiveCount() > 0)
+			{
+				return &__batch;
+			}
+		}
+	}
+
+	void QBitmapScanOperator::reset()
+	{
+		__evaluated = false;
+	}
+
+	QIndexRangeScanOperator::QIndexRangeScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QBTreeIndex& index, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending, const uint64_t& snapshot)
+		: __table(table), __columns(columns), __index(&index), __art(nullptr), __low(low), __high(high), __lowInclusive(lowInclusive), __highInclusive(highInclusive),
+		__descending(descending), __snapshot(snapshot), __opened(false), __batch(columns.size())
+	{
+	}
+
+	QIndexRangeScanOperator::QIndexRangeScanOperator(const QTable& table, const qtl::vector<std::size_t>& columns, const QArtIndex& index, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending, const uint64_t& snapshot)
+		: __table(table), __columns(columns), __index(nullptr), __art(&index), __low(low), __high(high), __lowInclusive(lowInclusive), __highInclusive(highInclusive),
+		__descending(descending), __snapshot(snapshot), __opened(false), __batch(columns.size())
+	{
+	}
+
+	QIndexRangeScanOperator::~QIndexRangeScanOperator()
+	{
+		delete __low;
+		delete __high;
+	}
+
+	std::size_t QIndexRangeScanOperator::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	QDataType QIndexRangeScanOperator::getColumnType(const std::size_t column) const
+	{
+		return __table.getColumnType(__columns[column]);
+	}
+
+	QBatch* QIndexRangeScanOperator::next()
+	{
+		const QReadLatch latch(__table);
+		if (!__opened)
+		{
+			const QValue* low = __low ? __low->getConstant() : nullptr;
+			const QValue* high = __high ? __high->getConstant() : nullptr;
+			if (__art)
+			{
+				__art->open(__artRange, low, __lowInclusive, high, __highInclusive, __descending);
+			}
+			else
+			{
+				__index->open(__range, low, __lowInclusive, high, __highInclusive, __descending);
+			}
+			if ((__low && !low) || (__high && !high))
+			{
+				// a bound that is not constant cannot be looked up
+				__range = QBTreeRange();
+				__artRange = QArtRange();
+			}
+			__opened = true;
+		}
+
+		while (const std::size_t count = __art ? __artRange.next(__rows, QBatch::CAPACITY) : __range.next(__rows, QBatch::CAPACITY))
+		{
+			gatherRows(__table, __columns, __rows, 0, count, __batch);
+			__batch.setSize(count);
+			__batch.setRowOffset(0);
+			__batch.setRowIds(__rows);
+			__batch.clearSelection();
+			selectVisible(__table, __rows, count, __snapshot, __batch);
+			if (__batch.getActiveCount() > 0)
+			{
+				return &__batch;
+			}
+		}
+		return nullptr;
+	}
+
+	void QIndexRangeScanOperator::reset()
+	{
+		__opened = false;
+	}
+
+	QFilterOperator::QFilterOperator(QOperator* child, QExpression* predicate)
+		: __child(child), __predicate(predicate)
+	{
+	}
+
+	QFilterOperator::~QFilterOperator()
+	{
+		delete __predicate;
+		delete __child;
+	}
+
+	std::size_t QFilterOperator::getColumnCount() const
+	{
+		return __child->getColumnCount();
+	}
+
+	QDataType QFilterOperator::getColumnType(const std::size_t column) const
+	{
+		return __child->getColumnType(column);
+	}
+
+	QBatch* QFilterOperator::next()
+	{
+		QBatch* batch;
+		while ((batch = __child->next()) != nullptr)
+		{
+			const std::size_t count = batch->getActiveCount();
+			const std::size_t selected = __predicate->select(*batch, batch->getSelection(), count, batch->getSelectionBuffer());
+			if (selected > 0)
+			{
+				batch->setSelection(selected);
+				return batch;
+			}
+		}
+		return nullptr;
+	}
+
+	void QFilterOperator::reset()
+	{
+		__child->reset();
+	}
+
+	QProjectionOperator::QProjectionOperator(QOperator* child, const qtl::vector<QExpression*>& expressions)
+		: __child(child), __expressions(expressions), __batch(expressions.size())
+	{
+	}
+
+	QProjectionOperator::~QProjectionOperator()
+	{
+		for (std::size_t i = 0; i < __expressions.size(); i++)
+		{
+			delete __expressions[i];
+		}
+		delete __child;
+	}
+
+	std::size_t QProjectionOperator::getColumnCount() const
+	{
+		return __expressions.size();
+	}
+
+	QDataType QProjectionOperator::getColumnType(const std::size_t column) const
+	{
+		return __expressions[column]->getType();
+	}
+
+	QBatch* QProjectionOperator::next()
+	{
+		QBatch* input = __child->next();
+		if (input == nullptr)
+		{
+			return nullptr;
+		}
+
+		// dictionary encoded columns are passed on as codes, decoding is left to the reader
+		for (std::size_t i = 0; i < __expressions.size(); i++)
+		{
+			const QVector* codes = __expressions[i]->getCodes(*input);
+			__batch.getColumn(i).reference(codes ? *codes : __expressions[i]->evaluate(*input));
+		}
+		__batch.setSize(input->size());
+		__batch.setRowOffset(input->getRowOffset());
+		__batch.setRowIds(input->getRowIds());
+		__batch.referenceSelection(*input);
+		return &__batch;
+	}
+
+	void QProjectionOperator::reset()
+	{
+		__child->reset();
+	}
+
+	QGatherOperator::QGatherOperator(const QTable& table, const qtl::vector<QOperator*>& pipelines, QMorselCursor* morsels, qtl::thread_pool& pool)
+		: __table(table), __pipelines(pipelines), __morsels(morsels), __pool(pool), __started(false), __parallel(false),
+		__ready(pipelines.size()), __reading(NONE), __pending(0), __active(0)
+	{
+		__handed.resize(__pipelines.size());
+	}
+
+	QGatherOperator::~QGatherOperator()
+	{
+		__stop();
+		for (std::size_t i = 0; i < __pipelines.size(); i++)
+		{
+			delete __pipelines[i];
+		}
+		delete __morsels;
+	}
+
+	std::size_t QGatherOperator::getColumnCount() const
+	{
+		return __pipelines[0]->getColumnCount();
+	}
+
+	QDataType QGatherOperator::getColumnType(const std::size_t column) const
+	{
+		return __pipelines[0]->getColumnType(column);
+	}
+
+	QBatch* QGatherOperator::next()
+	{
+		if (!__started)
+		{
+			__start();
+		}
+		if (!__parallel)
+		{
+			return __pipelines[0]->next();
+		}
+
+		// the copy whose batch was read last goes on to its next batch
+		if (__reading != NONE)
+		{
+			__submit(__reading);
+			__reading = NONE;
+		}
+
+		std::size_t copy;
+		while (__take(copy))
+		{
+			if (__handed[copy])
+			{
+				__reading = copy;
+				return __handed[copy];
+			}
+		}
+		return nullptr;
+	}
+
+	void QGatherOperator::reset()
+	{
+		__stop();
+		for (std::size_t i = 0; i < __pipelines.size(); i++)
+		{
+			__pipelines[i]->reset();
+		}
+	}
+
+	void QGatherOperator::__start()
+	{
+		// the rows are counted once, copies of a single morsel would have nothing to share
+		__started = true;
+		std::size_t rows;
+		{
+			const QReadLatch latch(__table);
+			rows = __table.getRowCount();
+		}
+		__morsels->reset(rows);
+		const std::size_t morsels = (rows + QMorselCursor::MORSEL_SIZE - 1) / QMorselCursor::MORSEL_SIZE;
+		const std::size_t copies = morsels < __pipelines.size() ? morsels : __pipelines.size();
+		__parallel = copies > 1;
+		if (!__parallel)
+		{
+			return;
+		}
+
+		for (std::size_t copy = 0; copy < copies; copy++)
+		{
+			__submit(copy);
+		}
+	}
+
+	void QGatherOperator::__stop()
+	{
+		// tasks end after a single batch, so waiting for them is short
+		if (__parallel)
+		{
+			std::size_t copy;
+			while (__take(copy))
+			{
+			}
+			__reading = NONE;
+			__parallel = false;
+		}
+		__started = false;
+	}
+
+	void QGatherOperator::__submit(const std::size_t copy)
+	{
+		__pending++;
+		__mutex.lock();
+		__active++;
+		__mutex.unlock();
+		__pool.submit([this, copy]() { __run(copy); });
+	}
+
+	void QGatherOperator::__run(const std::size_t copy)
+	{
+		__handed[copy] = __pipelines[copy]->next();
+
+		// each copy is queued at most once, the queue holds all of them
+		const bool pushed = __ready.try_push(copy);
+		assert(pushed);
+		(void)pushed;
+
+		// the operator may be destroyed once no task is active, so the count
+		// drops and the reader is woken under the mutex, the last thing done
+		__mutex.lock();
+		__active--;
+		__produced.notify_one();
+		__mutex.unlock();
+	}
+
+	bool QGatherOperator::__take(std::size_t& copy)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		while (__pending > 0)
+		{
+			if (__ready.try_pop(copy))
+			{
+				__pending--;
+				return true;
+			}
+			__produced.wait(lock);
+		}
+
+		// every task has queued its copy, the last of them are about to return
+		while (__active > 0)
+		{
+			__produced.wait(lock);
+		}
+		return false;
+	}
+
+	QSingleRowOperator::QSingleRowOperator()
+		: __batch(0), __done(false)
+	{
+	}
+
+	std::size_t QSingleRowOperator::getColumnCount() const
+	{
+		return 0;
+	}
+
+	QDataType QSingleRowOperator::getColumnType(const std::size_t) const
+	{
+		assert(false);
+		return QDataType::INT;
+	}
+
+	QBatch* QSingleRowOperator::next()
+	{
+		if (__done)
+		{
+			return nullptr;
+		}
+		__done = true;
+		__batch.setSize(1);
+		__batch.setRowOffset(0);
+		__batch.clearSelection();
+		return &__batch;
+	}
+
+	void QSingleRowOperator::reset()
+	{
+		__done = false;
+	}
+
+	QSortOperator::QSortOperator(QOperator* child, const qtl::vector<QExpression*>& keys, const qtl::vector<bool>& descending, QArena& scratch)
+		: __child(child), __keys(keys), __descending(descending), __scratch(scratch), __order(nullptr), __rows(0), __position(0), __sorted(false),
+		__batch(child->getColumnCount())
+	{
+	}
+
+	QSortOperator::~QSortOperator()
+	{
+		__clear();
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			delete __keys[i];
+		}
+		delete __child;
+	}
+
+	std::size_t QSortOperator::getColumnCount() const
+	{
+		return __child->getColumnCount();
+	}
+
+	QDataType QSortOperator::getColumnType(const std::size_t column) const
+	{
+		return __child->getColumnType(column);
+	}
+
+	QBatch* QSortOperator::next()
+	{
+		if (!__sorted)
+		{
+			__materialize();
+			__sorted = true;
+		}
+
+		const std::size_t rows = __rows;
+		if (__position >= rows)
+		{
+			return nullptr;
+		}
+
+		const std::size_t count = rows - __position < QBatch::CAPACITY ? rows - __position : QBatch::CAPACITY;
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			const QColumn& column = *__columns[i];
+			QVector& vector = __batch.getColumn(i);
+			vector.initialize(column.getType());
+			uint64_t* nulls = nullptr;
+			for (std::size_t row = 0; row < count; row++)
+			{
+				const uint32_t source = __order[__position + row];
+				if (column.isNull(source))
+				{
+					nulls = nulls ? nulls : vector.initializeNulls();
+					nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					continue;
+				}
+				copyValue(column.getType(), column.at(source), vector.getData(), row);
+			}
+		}
+
+		__batch.setSize(count);
+		__batch.setRowOffset(__position);
+		__batch.clearSelection();
+		__position += count;
+		return &__batch;
+	}
+
+	void QSortOperator::reset()
+	{
+		__clear();
+		__position = 0;
+		__sorted = false;
+		__child->reset();
+	}
+
+	void QSortOperator::__materialize()
+	{
+		for (std::size_t i = 0; i < __child->getColumnCount(); i++)
+		{
+			__columns.push_back(new QColumn(__child->getColumnType(i), true, nullptr, &__scratch));
+		}
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			__keyColumns.push_back(new QColumn(__keys[i]->getType(), true, nullptr, &__scratch));
+		}
+
+		QBatch* batch;
+		while ((batch = __child->next()) != nullptr)
+		{
+			const std::size_t count = batch->getActiveCount();
+			const uint16_t* selection = batch->getSelection();
+			for (std::size_t i = 0; i < __columns.size(); i++)
+			{
+				appendValues(batch->getColumn(i), selection, count, *__columns[i]);
+			}
+			for (std::size_t i = 0; i < __keys.size(); i++)
+			{
+				appendValues(__keys[i]->evaluate(*batch), selection, count, *__keyColumns[i]);
+			}
+		}
+
+		__rows = __columns.empty() ? 0 : __columns[0]->size();
+		__order = static_cast<uint32_t*>(__scratch.allocate(__rows * sizeof(uint32_t), alignof(uint32_t)));
+		for (std::size_t i = 0; i < __rows; i++)
+		{
+			__order[i] = static_cast<uint32_t>(i);
+		}
+
+		// ties are broken by input position, which keeps the sort stable without a merge buffer
+		std::sort(__order, __order + __rows, [this](const uint32_t left, const uint32_t right)
+		{
+			const int order = __compare(left, right);
+			return order != 0 ? order < 0 : left < right;
+		});
+	}
+
+	void QSortOperator::__clear()
+	{
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			delete __columns[i];
+		}
+		for (std::size_t i = 0; i < __keyColumns.size(); i++)
+		{
+			delete __keyColumns[i];
+		}
+		__columns.clear();
+		__keyColumns.clear();
+		__order = nullptr;
+		__rows = 0;
+	}
+
+	int QSortOperator::__compare(const uint32_t left, const uint32_t right) const
+	{
+		for (std::size_t i = 0; i < __keyColumns.size(); i++)
+		{
+			const QColumn& column = *__keyColumns[i];
+			const bool leftNull = column.isNull(left);
+			const bool rightNull = column.isNull(right);
+			int order;
+			if (leftNull || rightNull)
+			{
+				order = static_cast<int>(leftNull) - static_cast<int>(rightNull);
+			}
+			else
+			{
+				order = compareValues(column.getType(), column.at(left), column.at(right));
+			}
+
+			if (order != 0)
+			{
+				return __descending[i] ? -order : order;
+			}
+		}
+		return 0;
+	}
+
+	QJoinHashTable::QJoinHashTable(QOperator* input, QExpression* key, const qtl::vector<std::size_t>& columns)
+		: __input(input), __key(key), __kept(columns), __built(false), __stringKeys(nullptr), __partitionBits(0)
+	{
+		for (std::size_t i = 0; i < __kept.size(); i++)
+		{
+			__types.push_back(__input->getColumnType(__kept[i]));
+		}
+	}
+
+	QJoinHashTable::~QJoinHashTable()
+	{
+		__clear();
+		delete __key;
+		delete __input;
+	}
+
+	void QJoinHashTable::build()
+	{
+		if (__built.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		if (!__built.load(std::memory_order_relaxed))
+		{
+			__materialize();
+			__filter.resize(__hashes.size());
+			for (const uint64_t hash : __hashes)
+			{
+				__filter.insert(hash);
+			}
+			__partition();
+			__built.store(true, std::memory_order_release);
+		}
+	}
+
+	void QJoinHashTable::reset()
+	{
+		__clear();
+		__built.store(false, std::memory_order_relaxed);
+		__input->reset();
+	}
+
+	std::size_t QJoinHashTable::size() const
+	{
+		return __entries.size();
+	}
+
+	std::size_t QJoinHashTable::getPartitionCount() const
+	{
+		return static_cast<std::size_t>(1) << __partitionBits;
+	}
+
+	QDataType QJoinHashTable::getColumnType(const std::size_t column) const
+	{
+		return __types[column];
+	}
+
+	const QColumn& QJoinHashTable::getColumn(const std::size_t column) const
+	{
+		return *__columns[column];
+	}
+
+	const QBloomFilter& QJoinHashTable::getFilter() const
+	{
+		return __filter;
+	}
+
+	uint64_t QJoinHashTable::hashKey(const int64_t key)
+	{
+		return QBloomFilter::hashKey(key);
+	}
+
+	uint64_t QJoinHashTable::hashString(const qtl::string& key)
+	{
+		return QBloomFilter::hashString(key);
+	}
+
+	void QJoinHashTable::__materialize()
+	{
+		// the table is shared between threads, so its rows live on the heap
+		// rather than in the plan's scratch arena
+		for (std::size_t i = 0; i < __kept.size(); i++)
+		{
+			__columns.push_back(new QColumn(__types[i], true));
+		}
+		const bool strings = __key->getType() == QDataType::STRING;
+		if (strings)
+		{
+			__stringKeys = new QColumn(QDataType::STRING, true);
+		}
+
+		uint16_t rows[QBatch::CAPACITY];
+		QBatch* batch;
+		while ((batch = __input->next()) != nullptr)
+		{
+			const QVector& keys = __key->evaluate(*batch);
+			const uint16_t* selection = batch->getSelection();
+			const std::size_t active = batch->getActiveCount();
+			std::size_t count = 0;
+			for (std::size_t i = 0; i < active; i++)
+			{
+				const uint16_t row = selection ? selection[i] : static_cast<uint16_t>(i);
+				rows[count] = row;
+				count += !keys.isNull(row);
+			}
+
+			for (std::size_t i = 0; i < __kept.size(); i++)
+			{
+				appendValues(batch->getColumn(__kept[i]), rows, count, *__columns[i]);
+			}
+			if (strings)
+			{
+				const std::size_t first = __stringKeys->size();
+				appendValues(keys, rows, count, *__stringKeys);
+				for (std::size_t i = 0; i < count; i++)
+				{
+					__hashes.push_back(hashString(*static_cast<const qtl::string*>(__stringKeys->at(first + i))));
+				}
+				continue;
+			}
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const int64_t key = numericKey(keys, rows[i]);
+				__keys.push_back(key);
+				__hashes.push_back(hashKey(key));
+			}
+		}
+	}
+
+	void QJoinHashTable::__partition()
+	{
+		// enough partitions for each one's entries and buckets to fit in L2
+		const std::size_t rows = __hashes.size();
+		const std::size_t bytes = rows * (sizeof(QJoinEntry) + 2 * sizeof(uint32_t));
+		__partitionBits = 0;
+		while (__partitionBits < MAX_PARTITION_BITS && (bytes >> __partitionBits) > PARTITION_SIZE)
+		{
+			__partitionBits++;
+		}
+		const std::size_t partitions = getPartitionCount();
+
+		// a histogram of the partitions gives each one its range of entries,
+		// which the rows are then scattered into
+		qtl::vector<uint32_t> starts;
+		starts.resize(partitions + 1);
+		for (std::size_t row = 0; row < rows; row++)
+		{
+			starts[getPartition(__hashes[row]) + 1]++;
+		}
+		for (std::size_t partition = 0; partition < partitions; partition++)
+		{
+			starts[partition + 1] += starts[partition];
+		}
+
+		qtl::vector<uint32_t> cursors = starts;
+		__entries.resize(rows);
+		for (std::size_t row = 0; row < rows; row++)
+		{
+			QJoinEntry& entry = __entries[cursors[getPartition(__hashes[row])]++];
+			entry.hash = __hashes[row];
+			entry.key = __keys.empty() ? 0 : __keys[row];
+			entry.row = static_cast<uint32_t>(row);
+		}
+		__keys.clear();
+		__hashes.clear();
+
+		// each partition chains its entries from a power of 2 of buckets, at
+		// least as many as it has entries
+		uint32_t total = 0;
+		for (std::size_t partition = 0; partition < partitions; partition++)
+		{
+			uint32_t buckets = 1;
+			while (buckets < starts[partition + 1] - starts[partition])
+			{
+				buckets <<= 1;
+			}
+			__bucketStarts.push_back(total);
+			__bucketMasks.push_back(buckets - 1);
+			total += buckets;
+		}
+		__buckets.resize(total);
+		for (uint32_t i = 0; i < total; i++)
+		{
+			__buckets[i] = NONE;
+		}
+		for (std::size_t partition = 0; partition < partitions; partition++)
+		{
+			for (uint32_t entry = starts[partition]; entry < starts[partition + 1]; entry++)
+			{
+				uint32_t& bucket = __buckets[__bucketStarts[partition] + (__entries[entry].hash & __bucketMasks[partition])];
+				__entries[entry].next = bucket;
+				bucket = entry;
+			}
+		}
+	}
+
+	void QJoinHashTable::__clear()
+	{
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			delete __columns[i];
+		}
+		delete __stringKeys;
+		__columns.clear();
+		__stringKeys = nullptr;
+		__keys.clear();
+		__hashes.clear();
+		__entries.clear();
+		__buckets.clear();
+		__bucketStarts.clear();
+		__bucketMasks.clear();
+		__filter.clear();
+		__partitionBits = 0;
+	}
+
+	QHashJoinOperator::QHashJoinOperator(QOperator* probe, QExpression* key, const qtl::shared_ptr<QJoinHashTable>& table, const qtl::vector<QJoinColumn>& columns)
+		: __probe(probe), __key(key), __table(table), __columns(columns), __batch(columns.size()), __input(nullptr), __keys(nullptr), __count(0),
+		__position(0), __entry(QJoinHashTable::NONE), __chained(false)
+	{
+	}
+
+	QHashJoinOperator::~QHashJoinOperator()
+	{
+		delete __key;
+		delete __probe;
+	}
+
+	std::size_t QHashJoinOperator::getColumnCount() const
+	{
+		return __columns.size();
+	}
+
+	QDataType QHashJoinOperator::getColumnType(const std::size_t column) const
+	{
+		const QJoinColumn& source = __columns[column];
+		return source.build ? __table->getColumnType(source.column) : __probe->getColumnType(source.column);
+	}
+
+	QBatch* QHashJoinOperator::next()
+	{
+		__table->build();
+		for (;;)
+		{
+			if (__input == nullptr)
+			{
+				__input = __probe->next();
+				if (__input == nullptr)
+				{
+					return nullptr;
+				}
+				__prepare();
+			}
+
+			// the pairs are gathered before the next probe batch replaces this one
+			const std::size_t count = __match();
+			if (count > 0)
+			{
+				__produce(count);
+			}
+			if (__position == __count)
+			{
+				__input = nullptr;
+			}
+			if (count > 0)
+			{
+				return &__batch;
+			}
+		}
+	}
+
+	void QHashJoinOperator::reset()
+	{
+		__input = nullptr;
+		__count = 0;
+		__position = 0;
+		__chained = false;
+		__table->reset();
+		__probe->reset();
+	}
+
+	void QHashJoinOperator::__prepare()
+	{
+		const QVector& keys = __key->evaluate(*__input);
+		const bool strings = keys.getType() == QDataType::STRING;
+		const uint16_t* selection = __input->getSelection();
+		const std::size_t active = __input->getActiveCount();
+
+		uint16_t rows[QBatch::CAPACITY];
+		uint64_t hashes[QBatch::CAPACITY];
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < active; i++)
+		{
+			const uint16_t row = selection ? selection[i] : static_cast<uint16_t>(i);
+			if (keys.isNull(row))
+			{
+				continue;
+			}
+			rows[count] = row;
+			hashes[count] = strings ? QJoinHashTable::hashString(stringKey(keys, row)) : QJoinHashTable::hashKey(numericKey(keys, row));
+			count++;
+		}
+
+		// a counting sort by partition, the rows of a partition keep their order
+		const std::size_t partitions = __table->getPartitionCount();
+		if (partitions == 1)
+		{
+			memcpy(__rows, rows, count * sizeof(uint16_t));
+			memcpy(__hashes, hashes, count * sizeof(uint64_t));
+		}
+		else
+		{
+			__partitionCounts.resize(partitions);
+			for (std::size_t partition = 0; partition < partitions; partition++)
+			{
+				__partitionCounts[partition] = 0;
+			}
+			for (std::size_t i = 0; i < count; i++)
+			{
+				__partitionCounts[__table->getPartition(hashes[i])]++;
+			}
+			uint32_t start = 0;
+			for (std::size_t partition = 0; partition < partitions; partition++)
+			{
+				const uint32_t size = __partitionCounts[partition];
+				__partitionCounts[partition] = start;
+				start += size;
+			}
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const uint32_t target = __partitionCounts[__table->getPartition(hashes[i])]++;
+				__rows[target] = rows[i];
+				__hashes[target] = hashes[i];
+			}
+		}
+
+		__keys = &keys;
+		__count = count;
+		__position = 0;
+		__chained = false;
+	}
+
+	std::size_t QHashJoinOperator::__match()
+	{
+		// a row with more matches than fit in a batch resumes its chain on the next call
+		const QJoinHashTable& table = *__table;
+		const bool strings = __keys->getType() == QDataType::STRING;
+		std::size_t count = 0;
+		for (; __position < __count; __position++, __chained = false)
+		{
+			const uint16_t row = __rows[__position];
+			const uint64_t hash = __hashes[__position];
+			if (!__chained)
+			{
+				__entry = table.find(hash);
+				__chained = true;
+			}
+
+			const int64_t key = strings ? 0 : numericKey(*__keys, row);
+			const qtl::string* string = strings ? &stringKey(*__keys, row) : nullptr;
+			for (; __entry != QJoinHashTable::NONE; __entry = table.next(__entry))
+			{
+				if (count == QBatch::CAPACITY)
+				{
+					return count;
+				}
+				if (string ? table.matches(__entry, hash, *string) : table.matches(__entry, hash, key))
+				{
+					__probeRows[count] = row;
+					__buildRows[count] = table.getRow(__entry);
+					count++;
+				}
+			}
+		}
+		return count;
+	}
+
+	void QHashJoinOperator::__produce(const std::size_t count)
+	{
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			QVector& vector = __batch.getColumn(i);
+			uint64_t* nulls = nullptr;
+			if (__columns[i].build)
+			{
+				const QColumn& column = __table->getColumn(__columns[i].column);
+				vector.initialize(column.getType());
+				for (std::size_t row = 0; row < count; row++)
+				{
+					if (column.isNull(__buildRows[row]))
+					{
+						nulls = nulls ? nulls : vector.initializeNulls();
+						nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+						continue;
+					}
+					copyValue(column.getType(), column.at(__buildRows[row]), vector.getData(), row);
+				}
+				continue;
+			}
+
+			// probe columns keep their dictionary codes
+			const QVector& source = __input->getColumn(__columns[i].column);
+			const QDataType type = source.getType();
+			const std::size_t width = source.getDictionary() ? sizeof(uint32_t) : getDataTypeSize(type);
+			const char* data = static_cast<const char*>(source.getData());
+			if (source.getDictionary())
+			{
+				vector.initializeCodes(*source.getDictionary());
+			}
+			else
+			{
+				vector.initialize(type);
+			}
+			for (std::size_t row = 0; row < count; row++)
+			{
+				const uint16_t index = __probeRows[row];
+				if (source.isNull(index))
+				{
+					nulls = nulls ? nulls : vector.initializeNulls();
+					nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					continue;
+				}
+				if (source.getDictionary())
+				{
+					vector.getData<uint32_t>()[row] = source.getData<uint32_t>()[index];
+				}
+				else
+				{
+					copyValue(type, data + index * width, vector.getData(), row);
+				}
+			}
+		}
+
+		__batch.setSize(count);
+		__batch.setRowOffset(0);
+		__batch.clearSelection();
+	}
+
+	QHashAggregateOperator::QHashAggregateOperator(QOperator* child, const qtl::vector<QExpression*>& keys, const qtl::vector<QAggregate>& aggregates, const QAggregateMode mode, const std::size_t budget)
+		: __child(child), __keys(keys), __aggregates(aggregates), __mode(mode), __stateColumnCount(0), __maxGroups(0), __spilled(false), __partition(0),
+		__consumed(false), __exhausted(false), __position(0)
+	{
+		// the budget counts the fixed size of a group, strings are not followed
+		std::size_t groupSize = sizeof(uint64_t) + 2 * sizeof(uint32_t) + __aggregates.size() * 2 * sizeof(int64_t);
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			__keyTypes.push_back(__keys[i]->getType());
+			groupSize += getDataTypeSize(__keyTypes[i]);
+		}
+
+		std::size_t column = __keys.size();
+		for (std::size_t i = 0; i < __aggregates.size(); i++)
+		{
+			const QAggregateFunction function = __aggregates[i].function;
+			QDataType type = QDataType::LONG;
+			if (function == QAggregateFunction::MIN || function == QAggregateFunction::MAX)
+			{
+				type = __mode == QAggregateMode::FINAL ? __child->getColumnType(column) : __aggregates[i].argument->getType();
+				groupSize += getDataTypeSize(type);
+			}
+			__valueTypes.push_back(type);
+			__stateColumns.push_back(column);
+			column += function == QAggregateFunction::SUM || function == QAggregateFunction::AVG ? 2 : 1;
+		}
+		__stateColumnCount = column - __keys.size();
+		__maxGroups = budget / groupSize > 0 ? budget / groupSize : 1;
+
+		__keyVectors.resize(__keys.size());
+		__spillBatch.setColumnCount(column);
+		__batch.setColumnCount(getColumnCount());
+		__clear();
+	}
+
+	QHashAggregateOperator::~QHashAggregateOperator()
+	{
+		__closeSpill();
+		for (std::size_t i = 0; i < __keyColumns.size(); i++)
+		{
+			delete __keyColumns[i];
+		}
+		for (std::size_t i = 0; i < __values.size(); i++)
+		{
+			delete __values[i];
+		}
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			delete __keys[i];
+		}
+		for (std::size_t i = 0; i < __aggregates.size(); i++)
+		{
+			delete __aggregates[i].argument;
+		}
+		delete __child;
+	}
+
+	std::size_t QHashAggregateOperator::getColumnCount() const
+	{
+		return __keys.size() + (__mode == QAggregateMode::PARTIAL ? __stateColumnCount : __aggregates.size());
+	}
+
+	QDataType QHashAggregateOperator::getColumnType(const std::size_t column) const
+	{
+		if (column < __keys.size())
+		{
+			return __keyTypes[column];
+		}
+		if (__mode != QAggregateMode::PARTIAL)
+		{
+			return __valueTypes[column - __keys.size()];
+		}
+		return __stateType(column);
+	}
+
+	QBatch* QHashAggregateOperator::next()
+	{
+		for (;;)
+		{
+			if (!__consumed)
+			{
+				__consume();
+			}
+
+			const std::size_t groups = __hashes.size();
+			if (__position < groups)
+			{
+				__produce(groups - __position < QBatch::CAPACITY ? groups - __position : QBatch::CAPACITY);
+				return &__batch;
+			}
+
+			// a PARTIAL aggregation that ran out of memory starts over on the rest of
+			// its input, a spilled one goes on with the next partition
+			if (!__exhausted)
+			{
+				__clear();
+				__consumed = false;
+			}
+			else if (__spilled && __partition < SPILL_PARTITIONS)
+			{
+				__clear();
+				__load(__partition++);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+	}
+
+	void QHashAggregateOperator::reset()
+	{
+		__closeSpill();
+		__clear();
+		__spilled = false;
+		__partition = 0;
+		__consumed = false;
+		__exhausted = false;
+		__child->reset();
+	}
+
+	void QHashAggregateOperator::__consume()
+	{
+		__consumed = true;
+		QBatch* batch;
+		while ((batch = __child->next()) != nullptr)
+		{
+			__accumulate(*batch, __mode == QAggregateMode::FINAL);
+			if (__hashes.size() > __maxGroups)
+			{
+				if (__mode == QAggregateMode::PARTIAL)
+				{
+					return;
+				}
+				__spill();
+			}
+		}
+		__exhausted = true;
+
+		// the groups left in memory join the spilled ones, or if that fails the
+		// spilled ones are read back into memory
+		if (__spilled && !__spill())
+		{
+			for (std::size_t partition = 0; partition < SPILL_PARTITIONS; partition++)
+			{
+				__load(partition);
+			}
+			__closeSpill();
+			__spilled = false;
+		}
+		if (__keys.empty() && __hashes.empty() && __mode != QAggregateMode::PARTIAL)
+		{
+			__addGroup(0, 0);
+		}
+	}
+
+	void QHashAggregateOperator::__accumulate(const QBatch& batch, const bool states)
+	{
+		const uint16_t* selection = batch.getSelection();
+		const std::size_t count = batch.getActiveCount();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			__rows[i] = selection ? selection[i] : static_cast<uint16_t>(i);
+		}
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			__keyVectors[i] = states ? &batch.getColumn(i) : &__keys[i]->evaluate(batch);
+		}
+		__findGroups(count);
+
+		const std::size_t aggregates = __aggregates.size();
+		for (std::size_t i = 0; i < aggregates; i++)
+		{
+			if (states)
+			{
+				__merge(i, batch, count);
+			}
+			else if (__aggregates[i].argument)
+			{
+				__update(i, __aggregates[i].argument->evaluate(batch), count);
+			}
+			else
+			{
+				for (std::size_t row = 0; row < count; row++)
+				{
+					__counts[__groups[row] * aggregates + i]++;
+				}
+			}
+		}
+	}
+
+	void QHashAggregateOperator::__findGroups(const std::size_t count)
+	{
+		// the keys are hashed a column at a time, then each row finds its group
+		for (std::size_t i = 0; i < count; i++)
+		{
+			__rowHashes[i] = 0;
+		}
+		for (std::size_t key = 0; key < __keys.size(); key++)
+		{
+			const QVector& vector = *__keyVectors[key];
+			for (std::size_t i = 0; i < count; i++)
+			{
+				__rowHashes[i] = mixHash(__rowHashes[i] ^ hashValue(vector, __keyTypes[key], __rows[i]));
+			}
+		}
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const uint16_t row = __rows[i];
+			const uint64_t hash = __rowHashes[i];
+			const std::size_t mask = __slots.size() - 1;
+			std::size_t slot = hash & mask;
+			uint32_t group;
+			while ((group = __slots[slot]) != NONE)
+			{
+				bool equal = __hashes[group] == hash;
+				for (std::size_t key = 0; key < __keys.size() && equal; key++)
+				{
+					equal = equalValues(*__keyVectors[key], row, *__keyColumns[key], group);
+				}
+				if (equal)
+				{
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
+			__groups[i] = group != NONE ? group : __addGroup(row, hash);
+		}
+	}
+
+	uint32_t QHashAggregateOperator::__addGroup(const uint16_t row, const uint64_t hash)
+	{
+		const uint32_t group = static_cast<uint32_t>(__hashes.size());
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			appendValues(*__keyVectors[i], &row, 1, *__keyColumns[i]);
+		}
+		for (std::size_t i = 0; i < __aggregates.size(); i++)
+		{
+			__counts.push_back(0);
+			__sums.push_back(0);
+			if (__values[i])
+			{
+				__values[i]->append();
+				__values[i]->setNull(group, true);
+			}
+		}
+		__hashes.push_back(hash);
+
+		// the table is kept at most half full
+		if (__hashes.size() * 2 > __slots.size())
+		{
+			__slots.resize(__slots.size() * 2);
+			for (std::size_t slot = 0; slot < __slots.size(); slot++)
+			{
+				__slots[slot] = NONE;
+			}
+			for (uint32_t other = 0; other < __hashes.size(); other++)
+			{
+				std::size_t slot = __hashes[other] & (__slots.size() - 1);
+				while (__slots[slot] != NONE)
+				{
+					slot = (slot + 1) & (__slots.size() - 1);
+				}
+				__slots[slot] = other;
+			}
+			return group;
+		}
+
+		std::size_t slot = hash & (__slots.size() - 1);
+		while (__slots[slot] != NONE)
+		{
+			slot = (slot + 1) & (__slots.size() - 1);
+		}
+		__slots[slot] = group;
+		return group;
+	}
+
+	void QHashAggregateOperator::__update(const std::size_t aggregate, const QVector& argument, const std::size_t count)
+	{
+		const std::size_t aggregates = __aggregates.size();
+		switch (__aggregates[aggregate].function)
+		{
+		case QAggregateFunction::COUNT:
+			for (std::size_t i = 0; i < count; i++)
+			{
+				__counts[__groups[i] * aggregates + aggregate] += !argument.isNull(__rows[i]);
+			}
+			break;
+		case QAggregateFunction::SUM:
+		case QAggregateFunction::AVG:
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (!argument.isNull(__rows[i]))
+				{
+					const std::size_t state = __groups[i] * aggregates + aggregate;
+					__counts[state]++;
+					__sums[state] = addWrapping(__sums[state], numericKey(argument, __rows[i]));
+				}
+			}
+			break;
+		case QAggregateFunction::MIN:
+		case QAggregateFunction::MAX:
+		{
+			QColumn& values = *__values[aggregate];
+			const QDataType type = __valueTypes[aggregate];
+			const int sign = __aggregates[aggregate].function == QAggregateFunction::MIN ? -1 : 1;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (argument.isNull(__rows[i]))
+				{
+					continue;
+				}
+				const uint32_t group = __groups[i];
+				const void* value = valueAt(argument, type, __rows[i]);
+				if (values.isNull(group) || compareValues(type, value, values.at(group)) * sign > 0)
+				{
+					values.setNull(group, false);
+					copyValue(type, value, values.at(group), 0);
+				}
+			}
+			break;
+		}
+		}
+	}
+
+	void QHashAggregateOperator::__merge(const std::size_t aggregate, const QBatch& batch, const std::size_t count)
+	{
+		const QAggregateFunction function = __aggregates[aggregate].function;
+		const std::size_t column = __stateColumns[aggregate];
+		if (function == QAggregateFunction::MIN || function == QAggregateFunction::MAX)
+		{
+			__update(aggregate, batch.getColumn(column), count);
+			return;
+		}
+
+		const std::size_t aggregates = __aggregates.size();
+		const int64_t* counts = batch.getColumn(column).getData<int64_t>();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			__counts[__groups[i] * aggregates + aggregate] += counts[__rows[i]];
+		}
+		if (function != QAggregateFunction::COUNT)
+		{
+			const int64_t* sums = batch.getColumn(column + 1).getData<int64_t>();
+			for (std::size_t i = 0; i < count; i++)
+			{
+				int64_t& sum = __sums[__groups[i] * aggregates + aggregate];
+				sum = addWrapping(sum, sums[__rows[i]]);
+			}
+		}
+	}
+
+	void QHashAggregateOperator::__produce(const std::size_t count)
+	{
+		const std::size_t first = __position;
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			copyColumn(*__keyColumns[i], first, count, __batch.getColumn(i));
+		}
+
+		const std::size_t aggregates = __aggregates.size();
+		std::size_t column = __keys.size();
+		for (std::size_t i = 0; i < aggregates; i++)
+		{
+			const QAggregateFunction function = __aggregates[i].function;
+			if (__values[i])
+			{
+				copyColumn(*__values[i], first, count, __batch.getColumn(column++));
+				continue;
+			}
+
+			// states are produced as they are, SUM and AVG of no value are NULL
+			QVector& vector = __batch.getColumn(column++);
+			vector.initialize(QDataType::LONG);
+			int64_t* values = vector.getData<int64_t>();
+			uint64_t* nulls = nullptr;
+			for (std::size_t row = 0; row < count; row++)
+			{
+				const std::size_t state = (first + row) * aggregates + i;
+				if (__mode == QAggregateMode::PARTIAL || function == QAggregateFunction::COUNT)
+				{
+					values[row] = __counts[state];
+				}
+				else if (__counts[state] == 0)
+				{
+					nulls = nulls ? nulls : vector.initializeNulls();
+					nulls[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+				}
+				else
+				{
+					values[row] = function == QAggregateFunction::SUM ? __sums[state] : __sums[state] / __counts[state];
+				}
+			}
+			if (__mode == QAggregateMode::PARTIAL && function != QAggregateFunction::COUNT)
+			{
+				QVector& sums = __batch.getColumn(column++);
+				sums.initialize(QDataType::LONG);
+				for (std::size_t row = 0; row < count; row++)
+				{
+					sums.getData<int64_t>()[row] = __sums[(first + row) * aggregates + i];
+				}
+			}
+		}
+
+		__batch.setSize(count);
+		__batch.setRowOffset(first);
+		__batch.clearSelection();
+		__position += count;
+	}
+
+	bool QHashAggregateOperator::__spill()
+	{
+		// the files are opened by the first spill, without them the groups stay in memory
+		if (__spillFiles.empty())
+		{
+			for (std::size_t partition = 0; partition < SPILL_PARTITIONS; partition++)
+			{
+				FILE* file = tmpfile();
+				if (file == nullptr)
+				{
+					__closeSpill();
+					__maxGroups = SIZE_MAX;
+					return false;
+				}
+				__spillFiles.push_back(file);
+				__spillSizes.push_back(0);
+			}
+		}
+
+		// a row of states goes to the partition of its hash's top bits
+		bool written = true;
+		const std::size_t aggregates = __aggregates.size();
+		for (uint32_t group = 0; group < __hashes.size() && written; group++)
+		{
+			FILE* file = __spillFiles[static_cast<std::size_t>(__hashes[group] >> (64 - SPILL_BITS))];
+			for (std::size_t i = 0; i < __keys.size() && written; i++)
+			{
+				const QColumn& column = *__keyColumns[i];
+				written = writeValue(file, __keyTypes[i], column.isNull(group) ? nullptr : column.at(group));
+			}
+			for (std::size_t i = 0; i < aggregates && written; i++)
+			{
+				const std::size_t state = group * aggregates + i;
+				if (__values[i])
+				{
+					written = writeValue(file, __valueTypes[i], __values[i]->isNull(group) ? nullptr : __values[i]->at(group));
+					continue;
+				}
+				written = writeValue(file, QDataType::LONG, &__counts[state]);
+				if (written && __aggregates[i].function != QAggregateFunction::COUNT)
+				{
+					written = writeValue(file, QDataType::LONG, &__sums[state]);
+				}
+			}
+		}
+
+		// rows past the end of what was written before are ignored, the groups
+		// that could not be written stay in memory and no more are spilled
+		for (std::size_t partition = 0; partition < SPILL_PARTITIONS; partition++)
+		{
+			FILE* file = __spillFiles[partition];
+			if (written)
+			{
+				__spillSizes[partition] = ftell(file);
+			}
+			else
+			{
+				fseek(file, __spillSizes[partition], SEEK_SET);
+			}
+		}
+		if (!written)
+		{
+			__maxGroups = SIZE_MAX;
+			return false;
+		}
+		__spilled = true;
+		__clear();
+		return true;
+	}
+
+	void QHashAggregateOperator::__load(const std::size_t partition)
+	{
+		FILE* file = __spillFiles[partition];
+		const long size = __spillSizes[partition];
+		fseek(file, 0, SEEK_SET);
+
+		// rows of states are read back a batch at a time and merged like a FINAL
+		// aggregation's input, a partition is not spilled again
+		qtl::vector<char> buffer;
+		qtl::vector<uint64_t*> nulls;
+		nulls.resize(__spillBatch.getColumnCount());
+		long position = 0;
+		bool read = true;
+		while (position < size && read)
+		{
+			for (std::size_t column = 0; column < __spillBatch.getColumnCount(); column++)
+			{
+				__spillBatch.getColumn(column).initialize(__stateType(column));
+				nulls[column] = nullptr;
+			}
+
+			std::size_t count = 0;
+			for (; count < QBatch::CAPACITY && position < size && read; count++)
+			{
+				for (std::size_t column = 0; column < __spillBatch.getColumnCount() && read; column++)
+				{
+					QVector& vector = __spillBatch.getColumn(column);
+					const long length = readValue(file, vector.getType(), vector.getData(), count, buffer);
+					if (length == 1)
+					{
+						nulls[column] = nulls[column] ? nulls[column] : vector.initializeNulls();
+						nulls[column][count >> 6] |= static_cast<uint64_t>(1) << (count & 63);
+					}
+					read = length > 0;
+					position += length;
+				}
+			}
+			if (!read)
+			{
+				// a row cut short is left out
+				count--;
+			}
+			__spillBatch.setSize(count);
+			__spillBatch.clearSelection();
+			__accumulate(__spillBatch, true);
+		}
+	}
+
+	void QHashAggregateOperator::__clear()
+	{
+		for (std::size_t i = 0; i < __keyColumns.size(); i++)
+		{
+			delete __keyColumns[i];
+		}
+		for (std::size_t i = 0; i < __values.size(); i++)
+		{
+			delete __values[i];
+		}
+		__keyColumns.clear();
+		__values.clear();
+		for (std::size_t i = 0; i < __keys.size(); i++)
+		{
+			__keyColumns.push_back(new QColumn(__keyTypes[i], true));
+		}
+		for (std::size_t i = 0; i < __aggregates.size(); i++)
+		{
+			const QAggregateFunction function = __aggregates[i].function;
+			const bool value = function == QAggregateFunction::MIN || function == QAggregateFunction::MAX;
+			__values.push_back(value ? new QColumn(__valueTypes[i], true) : nullptr);
+		}
+
+		__hashes.clear();
+		__counts.clear();
+		__sums.clear();
+
+		// resize() does not shrink, the slots of a grown table are dropped first
+		__slots.clear();
+		__slots.resize(INITIAL_SLOTS);
+		for (std::size_t slot = 0; slot < INITIAL_SLOTS; slot++)
+		{
+			__slots[slot] = NONE;
+		}
+		__position = 0;
+	}
+
+	void QHashAggregateOperator::__closeSpill()
+	{
+		for (std::size_t i = 0; i < __spillFiles.size(); i++)
+		{
+			fclose(__spillFiles[i]);
+		}
+		__spillFiles.clear();
+		__spillSizes.clear();
+	}
+
+	QDataType QHashAggregateOperator::__stateType(const std::size_t column) const
+	{
+		if (column < __keys.size())
+		{
+			return __keyTypes[column];
+		}
+		for (std::size_t i = 0; i < __aggregates.size(); i++)
+		{
+			if (__stateColumns[i] == column)
+			{
+				return __valueTypes[i];
+			}
+		}
+		return QDataType::LONG;
+	}
+
+	QLimitOperator::QLimitOperator(QOperator* child, QExpression* limit, QExpression* offset)
+		: __child(child), __limit(limit), __offset(offset), __remaining(0), __skip(0), __initialized(false)
+	{
+	}
+
+	QLimitOperator::~QLimitOperator()
+	{
+		delete __limit;
+		delete __offset;
+		delete __child;
+	}
+
+	std::size_t QLimitOperator::getColumnCount() const
+	{
+		return __child->getColumnCount();
+	}
+
+	QDataType QLimitOperator::getColumnType(const std::size_t column) const
+	{
+		return __child->getColumnType(column);
+	}
+
+	QBatch* QLimitOperator::next()
+	{
+		if (!__initialized)
+		{
+			__initialize();
+		}
+
+		while (__remaining > 0)
+		{
+			QBatch* batch = __child->next();
+			if (batch == nullptr)
+			{
+				return nullptr;
+			}
+
+			const std::size_t count = batch->getActiveCount();
+			if (__skip >= count)
+			{
+				__skip -= count;
+				continue;
+			}
+
+			const std::size_t take = count - __skip < __remaining ? count - __skip : __remaining;
+			if (take != count)
+			{
+				// the kept rows move to the front of the selection, which never overwrites a row still to be copied
+				const uint16_t* selection = batch->getSelection();
+				uint16_t* buffer = batch->getSelectionBuffer();
+				for (std::size_t i = 0; i < take; i++)
+				{
+					buffer[i] = selection ? selection[__skip + i] : static_cast<uint16_t>(__skip + i);
+				}
+				batch->setSelection(take);
+			}
+
+			__skip = 0;
+			__remaining -= take;
+			return batch;
+		}
+		return nullptr;
+	}
+
+	void QLimitOperator::reset()
+	{
+		__initialized = false;
+		__child->reset();
+	}
+
+	void QLimitOperator::__initialize()
+	{
+		// a NULL or missing limit does not limit anything, negative values count as zero
+		__remaining = SIZE_MAX;
+		__skip = 0;
+		const QValue* limit = __limit ? __limit->getConstant() : nullptr;
+		const QValue* offset = __offset ? __offset->getConstant() : nullptr;
+		if (limit && !limit->isNull())
+		{
+			int64_t value = 0;
+			limit->store(QDataType::LONG, &value);
+			__remaining = value < 0 ? 0 : static_cast<std::size_t>(value);
+		}
+		if (offset && !offset->isNull())
+		{
+			int64_t value = 0;
+			offset->store(QDataType::LONG, &value);
+			__skip = value < 0 ? 0 : static_cast<std::size_t>(value);
+		}
+		__initialized = true;
+	}
+}
@@ -0,0 +1,757 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qparser.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	namespace
+	{
+		// Leaves the nesting levels a parse function entered once it returns
+		class QDepthScope
+		{
+		public:
+			explicit QDepthScope(std::size_t& depth)
+				: __depth(depth), __entered(depth)
+			{
+			}
+
+			~QDepthScope()
+			{
+				__depth = __entered;
+			}
+		private:
+			std::size_t& __depth;
+			const std::size_t __entered;
+		};
+	}
+
+	QParser::QParser(QArena& arena)
+		: __arena(arena), __text(nullptr), __lexer(nullptr, 0), __token(), __parameterCount(0), __depth(0), __failed(false), __errorPosition(0)
+	{
+		__error[0] = '\0';
+	}
+
+	QAstStatement* QParser::parse(const char* text, const std::size_t length)
+	{
+		__text = text;
+		__lexer = QLexer(text, length);
+		__parameterCount = 0;
+		__depth = 0;
+		__failed = false;
+		__error[0] = '\0';
+		__errorPosition = 0;
+		__advance();
+
+		QAstStatement* statement = nullptr;
+		switch (__token.type)
+		{
+		case QTokenType::KEYWORD_SELECT:
+			statement = __parseSelect();
+			break;
+		case QTokenType::KEYWORD_INSERT:
+			statement = __parseInsert();
+			break;
+		case QTokenType::KEYWORD_UPDATE:
+			statement = __parseUpdate();
+			break;
+		case QTokenType::KEYWORD_DELETE:
+			statement = __parseDelete();
+			break;
+		default:
+			__fail("expected SELECT, INSERT, UPDATE or DELETE");
+			return nullptr;
+		}
+
+		if (statement == nullptr)
+		{
+			return nullptr;
+		}
+		__accept(QTokenType::SEMICOLON);
+		if (!__expect(QTokenType::END, "unexpected text after the end of the statement"))
+		{
+			return nullptr;
+		}
+		statement->parameterCount = __parameterCount;
+		return statement;
+	}
+
+	QAstStatement* QParser::parse(const qtl::string& text)
+	{
+		return parse(text.c_str(), text.length());
+	}
+
+	const char* QParser::getError() const
+	{
+		return __error;
+	}
+
+	std::size_t QParser::getErrorPosition() const
+	{
+		return __errorPosition;
+	}
+
+	void QParser::__advance()
+	{
+		__token = __lexer.next();
+	}
+
+	bool QParser::__accept(const QTokenType type)
+	{
+		if (__token.type == type)
+		{
+			__advance();
+			return true;
+		}
+		return false;
+	}
+
+	bool QParser::__expect(const QTokenType type, const char* message)
+	{
+		if (__accept(type))
+		{
+			return true;
+		}
+		__fail(message);
+		return false;
+	}
+
+	void QParser::__fail(const char* message)
+	{
+		// the innermost failure is the most precise one, keep it
+		if (__failed)
+		{
+			return;
+		}
+		__failed = true;
+		__errorPosition = __token.position;
+		if (__token.type == QTokenType::END)
+		{
+			snprintf(__error, ERROR_LENGTH, "%s at the end of the statement", message);
+		}
+		else
+		{
+			const int length = __token.length > 32 ? 32 : static_cast<int>(__token.length);
+			snprintf(__error, ERROR_LENGTH, "%s near '%.*s' at position %zu", message, length, __text + __token.position, __token.position);
+		}
+	}
+
+	QAstStatement* QParser::__parseSelect()
+	{
+		__advance();
+		QAstStatement* statement = __arena.create<QAstStatement>();
+		statement->type = QAstStatementType::SELECT_STATEMENT;
+
+		QAstSelectItem** item = &statement->items;
+		do
+		{
+			QAstExpression* expression = nullptr;
+			if (__token.type == QTokenType::STAR)
+			{
+				expression = __node(QAstExpressionType::STAR, __token.position);
+				__advance();
+			}
+			else
+			{
+				expression = __parseExpression();
+				if (expression == nullptr)
+				{
+					return nullptr;
+				}
+			}
+
+			*item = __arena.create<QAstSelectItem>();
+			(*item)->expression = expression;
+			if (__accept(QTokenType::KEYWORD_AS) || __token.type == QTokenType::IDENTIFIER)
+			{
+				if (!__parseIdentifier((*item)->alias, "expected an alias"))
+				{
+					return nullptr;
+				}
+			}
+			item = &(*item)->next;
+		} while (__accept(QTokenType::COMMA));
+
+		if (__accept(QTokenType::KEYWORD_FROM) && !__parseIdentifier(statement->table, "expected a table name"))
+		{
+			return nullptr;
+		}
+
+		if (statement->table.length > 0 && (__token.type == QTokenType::KEYWORD_INNER || __token.type == QTokenType::KEYWORD_JOIN))
+		{
+			__accept(QTokenType::KEYWORD_INNER);
+			if (!__expect(QTokenType::KEYWORD_JOIN, "expected JOIN") || !__parseIdentifier(statement->joinTable, "expected a table name")
+				|| !__expect(QTokenType::KEYWORD_ON, "expected ON") || (statement->joinOn = __parseExpression()) == nullptr)
+			{
+				return nullptr;
+			}
+		}
+
+		if (__accept(QTokenType::KEYWORD_WHERE) && (statement->where = __parseExpression()) == nullptr)
+		{
+			return nullptr;
+		}
+
+		if (__accept(QTokenType::KEYWORD_GROUP))
+		{
+			if (!__expect(QTokenType::KEYWORD_BY, "expected BY") || (statement->groupBy = __parseList()) == nullptr)
+			{
+				return nullptr;
+			}
+			if (__accept(QTokenType::KEYWORD_HAVING) && (statement->having = __parseExpression()) == nullptr)
+			{
+				return nullptr;
+			}
+		}
+
+		if (__accept(QTokenType::KEYWORD_ORDER))
+		{
+			if (!__expect(QTokenType::KEYWORD_BY, "expected BY"))
+			{
+				return nullptr;
+			}
+			QAstOrderItem** order = &statement->orderBy;
+			do
+			{
+				QAstExpression* expression = __parseExpression();
+				if (expression == nullptr)
+				{
+					return nullptr;
+				}
+				*order = __arena.create<QAstOrderItem>();
+				(*order)->expression = expression;
+				if (!__accept(QTokenType::KEYWORD_ASC))
+				{
+					(*order)->descending = __accept(QTokenType::KEYWORD_DESC);
+				}
+				order = &(*order)->next;
+			} while (__accept(QTokenType::COMMA));
+		}
+
+		if (__accept(QTokenType::KEYWORD_LIMIT))
+		{
+			if ((statement->limit = __parseUnary()) == nullptr)
+			{
+				return nullptr;
+			}
+			if (__accept(QTokenType::KEYWORD_OFFSET) && (statement->offset = __parseUnary()) == nullptr)
+			{
+				return nullptr;
+			}
+		}
+		return statement;
+	}
+
+	QAstStatement* QParser::__parseInsert()
+	{
+		__advance();
+		QAstStatement* statement = __arena.create<QAstStatement>();
+		statement->type = QAstStatementType::INSERT_STATEMENT;
+		if (!__expect(QTokenType::KEYWORD_INTO, "expected INTO") || !__parseIdentifier(statement->table, "expected a table name"))
+		{
+			return nullptr;
+		}
+
+		if (__accept(QTokenType::LEFT_PAREN))
+		{
+			QAstName** column = &statement->columns;
+			do
+			{
+				*column = __arena.create<QAstName>();
+				if (!__parseIdentifier((*column)->name, "expected a column name"))
+				{
+					return nullptr;
+				}
+				column = &(*column)->next;
+			} while (__accept(QTokenType::COMMA));
+
+			if (!__expect(QTokenType::RIGHT_PAREN, "expected ')'"))
+			{
+				return nullptr;
+			}
+		}
+
+		if (!__expect(QTokenType::KEYWORD_VALUES, "expected VALUES"))
+		{
+			return nullptr;
+		}
+
+		QAstRow** row = &statement->rows;
+		do
+		{
+			if (!__expect(QTokenType::LEFT_PAREN, "expected '('"))
+			{
+				return nullptr;
+			}
+			*row = __arena.create<QAstRow>();
+			if (((*row)->values = __parseList()) == nullptr || !__expect(QTokenType::RIGHT_PAREN, "expected ')'"))
+			{
+				return nullptr;
+			}
+			row = &(*row)->next;
+		} while (__accept(QTokenType::COMMA));
+		return statement;
+	}
+
+	QAstStatement* QParser::__parseUpdate()
+	{
+		__advance();
+		QAstStatement* statement = __arena.create<QAstStatement>();
+		statement->type = QAstStatementType::UPDATE_STATEMENT;
+		if (!__parseIdentifier(statement->table, "expected a table name") || !__expect(QTokenType::KEYWORD_SET, "expected SET"))
+		{
+			return nullptr;
+		}
+
+		QAstAssignment** assignment = &statement->assignments;
+		do
+		{
+			*assignment = __arena.create<QAstAssignment>();
+			if (!__parseIdentifier((*assignment)->column, "expected a column name") || !__expect(QTokenType::EQUAL, "expected '='"))
+			{
+				return nullptr;
+			}
+			if (((*assignment)->value = __parseExpression()) == nullptr)
+			{
+				return nullptr;
+			}
+			assignment = &(*assignment)->next;
+		} while (__accept(QTokenType::COMMA));
+
+		if (__accept(QTokenType::KEYWORD_WHERE) && (statement->where = __parseExpression()) == nullptr)
+		{
+			return nullptr;
+		}
+		return statement;
+	}
+
+	QAstStatement* QParser::__parseDelete()
+	{
+		__advance();
+		QAstStatement* statement = __arena.create<QAstStatement>();
+		statement->type = QAstStatementType::DELETE_STATEMENT;
+		if (!__expect(QTokenType::KEYWORD_FROM, "expected FROM") || !__parseIdentifier(statement->table, "expected a table name"))
+		{
+			return nullptr;
+		}
+
+		if (__accept(QTokenType::KEYWORD_WHERE) && (statement->where = __parseExpression()) == nullptr)
+		{
+			return nullptr;
+		}
+		return statement;
+	}
+
+	bool QParser::__parseIdentifier(QAstText& name, const char* message)
+	{
+		if (__token.type != QTokenType::IDENTIFIER)
+		{
+			__fail(message);
+			return false;
+		}
+
+		// a quoted identifier starts after its opening quote
+		const bool quoted = __token.text != __text + __token.position;
+		name = quoted ? __unescape(__token, '"') : QAstText{ __token.text, __token.length };
+		__advance();
+		return true;
+	}
+
+	QAstExpression* QParser::__parseList()
+	{
+		QAstExpression* head = nullptr;
+		QAstExpression** tail = &head;
+		do
+		{
+			QAstExpression* expression = __parseExpression();
+			if (expression == nullptr)
+			{
+				return nullptr;
+			}
+			*tail = expression;
+			tail = &expression->next;
+		} while (__accept(QTokenType::COMMA));
+		return head;
+	}
+
+	QAstText QParser::__unescape(const QToken& token, const char quote)
+	{
+		std::size_t quotes = 0;
+		for (std::size_t i = 0; i < token.length; i++)
+		{
+			quotes += token.text[i] == quote;
+		}
+		if (quotes == 0)
+		{
+			return QAstText{ token.text, token.length };
+		}
+
+		// every quote inside the token is doubled, keep one of each pair
+		const std::size_t length = token.length - quotes / 2;
+		char* text = static_cast<char*>(__arena.allocate(length + 1, 1));
+		std::size_t out = 0;
+		for (std::size_t i = 0; i < token.length; i++)
+		{
+			text[out++] = token.text[i];
+			i += token.text[i] == quote;
+		}
+		text[out] = '\0';
+		return QAstText{ text, length };
+	}
+
+	// Enters a level of the syntax tree, every level costs a recursion when
+	// parsing and binding
+	bool QParser::__nest()
+	{
+		if (__depth == MAX_DEPTH)
+		{
+			__fail("expression nested too deeply");
+			return false;
+		}
+		__depth++;
+		return true;
+	}
+
+	QAstExpression* QParser::__parseExpression()
+	{
+		QDepthScope scope(__depth);
+		if (!__nest())
+		{
+			return nullptr;
+		}
+		QAstExpression* left = __parseAnd();
+		while (left && __token.type == QTokenType::KEYWORD_OR)
+		{
+			QAstExpression* node = __node(QAstExpressionType::LOGICAL, __token.position);
+			__advance();
+			node->logical = QLogical::OR;
+			node->left = left;
+			if (!__nest() || (node->right = __parseAnd()) == nullptr)
+			{
+				return nullptr;
+			}
+			left = node;
+		}
+		return left;
+	}
+
+	QAstExpression* QParser::__parseAnd()
+	{
+		QDepthScope scope(__depth);
+		QAstExpression* left = __parseNot();
+		while (left && __token.type == QTokenType::KEYWORD_AND)
+		{
+			QAstExpression* node = __node(QAstExpressionType::LOGICAL, __token.position);
+			__advance();
+			node->logical = QLogical::AND;
+			node->left = left;
+			if (!__nest() || (node->right = __parseNot()) == nullptr)
+			{
+				return nullptr;
+			}
+			left = node;
+		}
+		return left;
+	}
+
+	QAstExpression* QParser::__parseNot()
+	{
+		if (__token.type != QTokenType::KEYWORD_NOT)
+		{
+			return __parsePredicate();
+		}
+
+		QDepthScope scope(__depth);
+		QAstExpression* node = __node(QAstExpressionType::NOT, __token.position);
+		__advance();
+		if (!__nest() || (node->left = __parseNot()) == nullptr)
+		{
+			return nullptr;
+		}
+		return node;
+	}
+
+	QAstExpression* QParser::__parsePredicate()
+	{
+		QAstExpression* left = __parseAdditive();
+		if (left == nullptr)
+		{
+			return nullptr;
+		}
+
+		const std::size_t position = __token.position;
+		QComparison comparison;
+		switch (__token.type)
+		{
+		case QTokenType::EQUAL:
+			comparison = QComparison::EQUAL;
+			break;
+		case QTokenType::NOT_EQUAL:
+			comparison = QComparison::NOT_EQUAL;
+			break;
+		case QTokenType::LESS:
+			comparison = QComparison::LESS;
+			break;
+		case QTokenType::LESS_EQUAL:
+			comparison = QComparison::LESS_EQUAL;
+			break;
+		case QTokenType::GREATER:
+			comparison = QComparison::GREATER;
+			break;
+		case QTokenType::GREATER_EQUAL:
+			comparison = QComparison::GREATER_EQUAL;
+			break;
+		case QTokenType::KEYWORD_IS:
+		{
+			__advance();
+			QAstExpression* node = __node(QAstExpressionType::IS_NULL, position);
+			node->left = left;
+			node->negated = __accept(QTokenType::KEYWORD_NOT);
+			return __expect(QTokenType::KEYWORD_NULL, "expected NULL") ? node : nullptr;
+		}
+		case QTokenType::KEYWORD_NOT:
+		case QTokenType::KEYWORD_BETWEEN:
+		case QTokenType::KEYWORD_IN:
+		{
+			const bool negated = __accept(QTokenType::KEYWORD_NOT);
+			if (__accept(QTokenType::KEYWORD_BETWEEN))
+			{
+				QAstExpression* node = __node(QAstExpressionType::BETWEEN, position);
+				node->left = left;
+				node->negated = negated;
+				QAstExpression* low = __parseAdditive();
+				if (low == nullptr || !__expect(QTokenType::KEYWORD_AND, "expected AND"))
+				{
+					return nullptr;
+				}
+				if ((low->next = __parseAdditive()) == nullptr)
+				{
+					return nullptr;
+				}
+				node->arguments = low;
+				return node;
+			}
+			if (!__expect(QTokenType::KEYWORD_IN, "expected BETWEEN or IN") || !__expect(QTokenType::LEFT_PAREN, "expected '('"))
+			{
+				return nullptr;
+			}
+			QAstExpression* node = __node(QAstExpressionType::IN_LIST, position);
+			node->left = left;
+			node->negated = negated;
+			if ((node->arguments = __parseList()) == nullptr || !__expect(QTokenType::RIGHT_PAREN, "expected ')'"))
+			{
+				return nullptr;
+			}
+			return node;
+		}
+		default:
+			return left;
+		}
+
+		__advance();
+		QAstExpression* node = __node(QAstExpressionType::COMPARISON, position);
+		node->comparison = comparison;
+		node->left = left;
+		if ((node->right = __parseAdditive()) == nullptr)
+		{
+			return nullptr;
+		}
+		return node;
+	}
+
+	QAstExpression* QParser::__parseAdditive()
+	{
+		QDepthScope scope(__depth);
+		QAstExpression* left = __parseMultiplicative();
+		while (left && (__token.type == QTokenType::PLUS || __token.type == QTokenType::MINUS))
+		{
+			QAstExpression* node = __node(QAstExpressionType::ARITHMETIC, __token.position);
+			node->arithmetic = __token.type == QTokenType::PLUS ? QArithmetic::ADD : QArithmetic::SUBTRACT;
+			__advance();
+			node->left = left;
+			if (!__nest() || (node->right = __parseMultiplicative()) == nullptr)
+			{
+				return nullptr;
+			}
+			left = node;
+		}
+		return left;
+	}
+
+	QAstExpression* QParser::__parseMultiplicative()
+	{
+		QDepthScope scope(__depth);
+		QAstExpression* left = __parseUnary();
+		while (left && (__token.type == QTokenType::STAR || __token.type == QTokenType::SLASH || __token.type == QTokenType::PERCENT))
+		{
+			QAstExpression* node = __node(QAstExpressionType::ARITHMETIC, __token.position);
+			switch (__token.type)
+			{
+			case QTokenType::STAR:
+				node->arithmetic = QArithmetic::MULTIPLY;
+				break;
+			case QTokenType::SLASH:
+				node->arithmetic = QArithmetic::DIVIDE;
+				break;
+			default:
+				node->arithmetic = QArithmetic::MODULO;
+				break;
+			}
+			__advance();
+			node->left = left;
+			if (!__nest() || (node->right = __parseUnary()) == nullptr)
+			{
+				return nullptr;
+			}
+			left = node;
+		}
+		return left;
+	}
+
+	QAstExpression* QParser::__parseUnary()
+	{
+		QDepthScope scope(__depth);
+		if (__accept(QTokenType::PLUS))
+		{
+			return __nest() ? __parseUnary() : nullptr;
+		}
+		if (__token.type != QTokenType::MINUS)
+		{
+			return __parsePrimary();
+		}
+
+		const std::size_t position = __token.position;
+		__advance();
+
+		// a negative integer literal is folded so that the smallest INT and LONG can be written
+		if (__token.type == QTokenType::INTEGER)
+		{
+			return __parseInteger(true);
+		}
+
+		QAstExpression* node = __node(QAstExpressionType::NEGATE, position);
+		if (!__nest() || (node->left = __parseUnary()) == nullptr)
+		{
+			return nullptr;
+		}
+		return node;
+	}
+
+	QAstExpression* QParser::__parsePrimary()
+	{
+		const std::size_t position = __token.position;
+		switch (__token.type)
+		{
+		case QTokenType::INTEGER:
+			return __parseInteger(false);
+		case QTokenType::STRING:
+		{
+			QAstExpression* node = __node(QAstExpressionType::LITERAL, position);
+			node->literal.type = QDataType::STRING;
+			node->literal.string = __unescape(__token, '\'');
+			__advance();
+			return node;
+		}
+		case QTokenType::KEYWORD_TRUE:
+		case QTokenType::KEYWORD_FALSE:
+		{
+			QAstExpression* node = __node(QAstExpressionType::LITERAL, position);
+			node->literal.type = QDataType::BOOL;
+			node->literal.boolean = __token.type == QTokenType::KEYWORD_TRUE;
+			__advance();
+			return node;
+		}
+		case QTokenType::KEYWORD_NULL:
+		{
+			QAstExpression* node = __node(QAstExpressionType::LITERAL, position);
+			node->literal.type = QDataType::INT;
+			node->literal.isNull = true;
+			__advance();
+			return node;
+		}
+		case QTokenType::PARAMETER:
+		{
+			QAstExpression* node = __node(QAstExpressionType::PARAMETER, position);
+			node->parameter = __parameterCount++;
+			__advance();
+			return node;
+		}
+		case QTokenType::LEFT_PAREN:
+		{
+			__advance();
+			QAstExpression* node = __parseExpression();
+			if (node == nullptr || !__expect(QTokenType::RIGHT_PAREN, "expected ')'"))
+			{
+				return nullptr;
+			}
+			return node;
+		}
+		case QTokenType::IDENTIFIER:
+		{
+			QAstExpression* node = __node(QAstExpressionType::COLUMN, position);
+			__parseIdentifier(node->name, "expected a column name");
+			if (__accept(QTokenType::DOT))
+			{
+				node->table = node->name;
+				if (!__parseIdentifier(node->name, "expected a column name"))
+				{
+					return nullptr;
+				}
+				return node;
+			}
+
+			if (!__accept(QTokenType::LEFT_PAREN))
+			{
+				return node;
+			}
+
+			node->type = QAstExpressionType::FUNCTION;
+			if (__token.type == QTokenType::STAR)
+			{
+				node->arguments = __node(QAstExpressionType::STAR, __token.position);
+				__advance();
+			}
+			else if (__token.type != QTokenType::RIGHT_PAREN && (node->arguments = __parseList()) == nullptr)
+			{
+				return nullptr;
+			}
+			return __expect(QTokenType::RIGHT_PAREN, "expected ')'") ? node : nullptr;
+		}
+		default:
+			__fail("expected an expression");
+			return nullptr;
+		}
+	}
+
+	QAstExpression* QParser::__parseInteger(const bool negative)
+	{
+		// the magnitude of INT64_MIN does not fit an int64_t, accumulate it unsigned
+		const uint64_t limit = negative ? static_cast<uint64_t>(INT64_MAX) + 1 : static_cast<uint64_t>(INT64_MAX);
+		uint64_t magnitude = 0;
+		for (std::size_t i = 0; i < __token.length; i++)
+		{
+			const uint64_t digit = static_cast<uint64_t>(__token.text[i] - '0');
+			if (magnitude > (limit - digit) / 10)
+			{
+				__fail("integer literal out of range");
+				return nullptr;
+			}
+			magnitude = magnitude * 10 + digit;
+		}
+
+		QAstExpression* node = __node(QAstExpressionType::LITERAL, __token.position);
+		__advance();
+		node->literal.integer = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+		node->literal.type = (node->literal.integer >= INT32_MIN && node->literal.integer <= INT32_MAX) ? QDataType::INT : QDataType::LONG;
+		return node;
+	}
+
+	QAstExpression* QParser::__node(const QAstExpressionType type, const std::size_t position)
+	{
+		QAstExpression* node = __arena.create<QAstExpression>();
+		node->type = type;
+		node->position = position;
+		return node;
+	}
+}
@@ -0,0 +1,406 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qplan.h"
+
+#include <cstdio>
+
+namespace qsql
+{
+	QPlan::QPlan(const QPlanType type, QTable* table, const std::size_t parameterCount)
+		: __type(type), __table(table), __version(0), __parameters(new QValue[parameterCount]), __root(nullptr), __scratch(SCRATCH_CHUNK_SIZE), __snapshot(0), __reading(false),
+		__logPosition(0),
+		__affectedRows(0), __executed(false)
+	{
+		for (std::size_t i = 0; i < parameterCount; i++)
+		{
+			__parameterTypes.push_back(QDataType::LONG);
+			__bound.push_back(false);
+		}
+		__error[0] = '\0';
+	}
+
+	QPlan::~QPlan()
+	{
+		// workers of the plan may read the snapshot until the operators are gone
+		delete __root;
+		__release();
+		for (QValue* literal : __literals)
+		{
+			delete literal;
+		}
+		for (QExpression* value : __assignedValues)
+		{
+			delete value;
+		}
+		delete[] __parameters;
+	}
+
+	QPlanType QPlan::getType() const
+	{
+		return __type;
+	}
+
+	QTable* QPlan::getTable() const
+	{
+		return __table;
+	}
+
+	const qtl::string& QPlan::getKey() const
+	{
+		return __key;
+	}
+
+	void QPlan::setKey(const qtl::string& key, const uint64_t version)
+	{
+		__key = key;
+		__version = version;
+	}
+
+	uint64_t QPlan::getVersion() const
+	{
+		return __version;
+	}
+
+	std::size_t QPlan::getParameterCount() const
+	{
+		return __parameterTypes.size();
+	}
+
+	QDataType QPlan::getParameterType(const std::size_t parameter) const
+	{
+		return __parameterTypes[parameter];
+	}
+
+	bool QPlan::setParameter(const std::size_t parameter, const QValue& value)
+	{
+		if (parameter >= __parameterTypes.size() || (!value.isNull() && !value.canStore(__parameterTypes[parameter])))
+		{
+			return false;
+		}
+		__parameters[parameter] = value;
+		__bound[parameter] = true;
+		return true;
+	}
+
+	void QPlan::clearParameters()
+	{
+		for (std::size_t i = 0; i < __parameterTypes.size(); i++)
+		{
+			__parameters[i] = QValue();
+			__bound[i] = false;
+		}
+	}
+
+	std::size_t QPlan::getColumnCount() const
+	{
+		return __columnNames.size();
+	}
+
+	QDataType QPlan::getColumnType(const std::size_t column) const
+	{
+		return __root->getColumnType(column);
+	}
+
+	const qtl::string& QPlan::getColumnName(const std::size_t column) const
+	{
+		return __columnNames[column];
+	}
+
+	bool QPlan::execute(QWal* log, const bool synchronous)
+	{
+		__affectedRows = 0;
+		__logPosition = 0;
+		__executed = false;
+		__error[0] = '\0';
+		for (std::size_t i = 0; i < __bound.size(); i++)
+		{
+			if (!__bound[i])
+			{
+				__fail("parameter %zu is not bound", i + 1);
+				return false;
+			}
+		}
+
+		bool result = true;
+		switch (__type)
+		{
+		case QPlanType::SELECT_PLAN:
+			__rewind();
+			__acquire();
+			break;
+		case QPlanType::INSERT_PLAN:
+			result = __executeInsert(log, synchronous);
+			break;
+		case QPlanType::UPDATE_PLAN:
+			result = __executeUpdate(log, synchronous);
+			break;
+		case QPlanType::DELETE_PLAN:
+			result = __executeDelete(log, synchronous);
+			break;
+		}
+		__executed = result;
+		return result;
+	}
+
+	std::size_t QPlan::getAffectedRows() const
+	{
+		return __affectedRows;
+	}
+
+	uint64_t QPlan::getLogPosition() const
+	{
+		return __logPosition;
+	}
+
+	QBatch* QPlan::next()
+	{
+		if (__type != QPlanType::SELECT_PLAN || !__executed)
+		{
+			return nullptr;
+		}
+		QBatch* batch = __root->next();
+		if (__isScanFailed())
+		{
+			__executed = false;
+			batch = nullptr;
+		}
+		if (batch == nullptr)
+		{
+			__release();
+		}
+		return batch;
+	}
+
+	const char* QPlan::getError() const
+	{
+		return __error;
+	}
+
+	bool QPlan::__executeInsert(QWal* log, const bool synchronous)
+	{
+		// every value is checked before the first row is inserted so that a
+		// failing statement leaves the table as it was
+		const std::size_t columns = __table->getColumnCount();
+		const std::size_t rows = __insertValues.size() / columns;
+		for (std::size_t i = 0; i < __insertValues.size(); i++)
+		{
+			if (!__table->canStore(i % columns, *__insertValues[i]))
+			{
+				__fail("cannot store the value of row %zu", i / columns + 1);
+				return false;
+			}
+		}
+
+		// the write starts before logging so the log records writes of a table in the order they are made
+		__table->beginWrite();
+		__transaction.clear();
+		for (std::size_t row = 0; row < rows && log; row++)
+		{
+			__fillRow(row);
+			__transaction.insert(__tableName, __row);
+		}
+		if (!__writeLog(log, synchronous))
+		{
+			__table->commit();
+			return false;
+		}
+
+		for (std::size_t row = 0; row < rows; row++)
+		{
+			__fillRow(row);
+			__table->insert(__row);
+		}
+		__table->commit();
+		__affectedRows = rows;
+		return true;
+	}
+
+	bool QPlan::__executeUpdate(QWal* log, const bool synchronous)
+	{
+		// rows are read from the last commit, no other write can end them until this one commits
+		const std::size_t assignments = __assignedColumns.size();
+		__rows.clear();
+		__values.clear();
+		__table->beginWrite();
+		__rewind();
+		__acquire();
+		while (QBatch* batch = __root->next())
+		{
+			const uint16_t* selection = batch->getSelection();
+			const std::size_t count = batch->getActiveCount();
+			for (std::size_t i = 0; i < count; i++)
+			{
+				__rows.push_back(batch->getRowId(selection ? selection[i] : i));
+			}
+			__vectors.clear();
+			for (QExpression* value : __assignedValues)
+			{
+				__vectors.push_back(&value->evaluate(*batch));
+			}
+			for (std::size_t i = 0; i < count; i++)
+			{
+				for (const QVector* vector : __vectors)
+				{
+					__values.push_back(vector->getValue(selection ? selection[i] : i));
+				}
+			}
+		}
+		__release();
+		if (__isScanFailed())
+		{
+			__table->commit();
+			return false;
+		}
+
+		for (std::size_t i = 0; i < __values.size(); i++)
+		{
+			if (!__table->canStore(__assignedColumns[i % assignments], __values[i]))
+			{
+				__fail("cannot store the new value of column %zu", __assignedColumns[i % assignments] + 1);
+				__table->commit();
+				return false;
+			}
+		}
+
+		__transaction.clear();
+		for (std::size_t i = 0; i < __rows.size() && log; i++)
+		{
+			for (std::size_t j = 0; j < assignments; j++)
+			{
+				__transaction.update(__tableName, __rows[i], __assignedColumns[j], __values[i * assignments + j]);
+			}
+		}
+		if (!__writeLog(log, synchronous))
+		{
+			__table->commit();
+			return false;
+		}
+
+		for (std::size_t i = 0; i < __rows.size(); i++)
+		{
+			for (std::size_t j = 0; j < assignments; j++)
+			{
+				__table->update(__rows[i], __assignedColumns[j], __values[i * assignments + j]);
+			}
+		}
+		__table->commit();
+		__affectedRows = __rows.size();
+		return true;
+	}
+
+	bool QPlan::__executeDelete(QWal* log, const bool synchronous)
+	{
+		// the rows are erased after the scan, which reads the last commit like an update's
+		__rows.clear();
+		__table->beginWrite();
+		__rewind();
+		__acquire();
+		while (QBatch* batch = __root->next())
+		{
+			const uint16_t* selection = batch->getSelection();
+			const std::size_t count = batch->getActiveCount();
+			for (std::size_t i = 0; i < count; i++)
+			{
+				__rows.push_back(batch->getRowId(selection ? selection[i] : i));
+			}
+		}
+		__release();
+		if (__isScanFailed())
+		{
+			__table->commit();
+			return false;
+		}
+
+		__transaction.clear();
+		for (std::size_t i = 0; i < __rows.size() && log; i++)
+		{
+			__transaction.erase(__tableName, __rows[i]);
+		}
+		if (!__writeLog(log, synchronous))
+		{
+			__table->commit();
+			return false;
+		}
+
+		for (std::size_t row : __rows)
+		{
+			__table->erase(row);
+		}
+		__table->commit();
+		__affectedRows = __rows.size();
+		return true;
+	}
+
+	// A scan that ended early leaves whatever was made of its rows incomplete
+	bool QPlan::__isScanFailed()
+	{
+		for (const QScanOperator* scan : __scans)
+		{
+			if (const char* error = scan->getError())
+			{
+				snprintf(__error, ERROR_LENGTH, "cannot read the buffer pool: %s", error);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void QPlan::__fillRow(const std::size_t row)
+	{
+		const std::size_t columns = __table->getColumnCount();
+		__row.clear();
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			__row.push_back(*__insertValues[row * columns + column]);
+		}
+	}
+
+	bool QPlan::__writeLog(QWal* log, const bool synchronous)
+	{
+		if (log == nullptr || __transaction.isEmpty())
+		{
+			return true;
+		}
+
+		// nothing has been applied yet, a change that cannot be logged is not made
+		__logPosition = log->append(__transaction);
+		if (__logPosition == 0 || (synchronous && !log->flush(__logPosition)))
+		{
+			snprintf(__error, ERROR_LENGTH, "cannot write the log: %s", log->getError());
+			return false;
+		}
+		return true;
+	}
+
+	void QPlan::__acquire()
+	{
+		// a SELECT without FROM reads no table
+		__release();
+		if (__table)
+		{
+			__snapshot = __table->getClock().acquire();
+			__reading = true;
+		}
+	}
+
+	void QPlan::__release()
+	{
+		if (__reading)
+		{
+			__table->getClock().release(__snapshot);
+			__reading = false;
+		}
+	}
+
+	void QPlan::__rewind()
+	{
+		// operators drop what they hold from the last execution before its memory is reused
+		__root->reset();
+		__scratch.rewind();
+	}
+
+	void QPlan::__fail(const char* format, const std::size_t value)
+	{
+		snprintf(__error, ERROR_LENGTH, format, value);
+	}
+}
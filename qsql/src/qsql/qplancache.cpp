@@ -0,0 +1,202 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qplancache.h"
+#include "qsql/qlexer.h"
+
+#include <qtl/hash.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		bool isKeyword(const QTokenType type)
+		{
+			return type >= QTokenType::KEYWORD_AND && type <= QTokenType::KEYWORD_WHERE;
+		}
+	}
+
+	QPlanCache::QPlanCache(const std::size_t capacity)
+		: __entries(nullptr), __mask(0), __capacity(capacity), __size(0), __clock(0), __hits(0), __misses(0)
+	{
+		// at most half of the slots are used so that probe sequences stay short
+		std::size_t slots = 16;
+		while (slots < capacity * 2)
+		{
+			slots <<= 1;
+		}
+		__entries = static_cast<QEntry*>(calloc(slots, sizeof(QEntry)));
+		__mask = slots - 1;
+	}
+
+	QPlanCache::~QPlanCache()
+	{
+		clear();
+		free(__entries);
+	}
+
+	QPlan* QPlanCache::acquire(const qtl::string& key, const uint64_t version)
+	{
+		const std::size_t hash = qtl::hash<qtl::string>()(key);
+		const std::size_t slot = __find(key, hash);
+		if (slot == __mask + 1)
+		{
+			__misses++;
+			return nullptr;
+		}
+
+		QPlan* plan = __entries[slot].plan;
+		__remove(slot);
+		if (plan->getVersion() != version)
+		{
+			delete plan;
+			__misses++;
+			return nullptr;
+		}
+		__hits++;
+		return plan;
+	}
+
+	void QPlanCache::release(QPlan* plan, const uint64_t version)
+	{
+		const std::size_t hash = qtl::hash<qtl::string>()(plan->getKey());
+
+		// only one idle plan is kept per statement
+		if (plan->getVersion() != version || __capacity == 0 || __find(plan->getKey(), hash) != __mask + 1)
+		{
+			delete plan;
+			return;
+		}
+
+		if (__size == __capacity)
+		{
+			std::size_t oldest = __mask + 1;
+			for (std::size_t slot = 0; slot <= __mask; slot++)
+			{
+				if (__entries[slot].plan && (oldest > __mask || __entries[slot].lastUsed < __entries[oldest].lastUsed))
+				{
+					oldest = slot;
+				}
+			}
+			delete __entries[oldest].plan;
+			__remove(oldest);
+		}
+
+		std::size_t slot = hash & __mask;
+		while (__entries[slot].plan)
+		{
+			slot = (slot + 1) & __mask;
+		}
+		__entries[slot].plan = plan;
+		__entries[slot].hash = hash;
+		__entries[slot].lastUsed = ++__clock;
+		__size++;
+	}
+
+	void QPlanCache::clear()
+	{
+		for (std::size_t slot = 0; slot <= __mask; slot++)
+		{
+			delete __entries[slot].plan;
+			__entries[slot].plan = nullptr;
+		}
+		__size = 0;
+	}
+
+	std::size_t QPlanCache::size() const
+	{
+		return __size;
+	}
+
+	std::size_t QPlanCache::getCapacity() const
+	{
+		return __capacity;
+	}
+
+	std::size_t QPlanCache::getHits() const
+	{
+		return __hits;
+	}
+
+	std::size_t QPlanCache::getMisses() const
+	{
+		return __misses;
+	}
+
+	qtl::string QPlanCache::normalize(const qtl::string& text)
+	{
+		// each token is written once, separated by single spaces, so the result
+		// is at most twice as long as the input
+		const char* source = text.c_str();
+		char* buffer = static_cast<char*>(malloc(text.length() * 2 + 1));
+		std::size_t length = 0;
+
+		QLexer lexer(source, text.length());
+		for (QToken token = lexer.next(); token.type != QTokenType::END; token = lexer.next())
+		{
+			if (length > 0)
+			{
+				buffer[length++] = ' ';
+			}
+
+			// quoted tokens exclude their quotes, which keep them apart from keywords
+			const bool quoted = token.text != source + token.position;
+			if (quoted)
+			{
+				buffer[length++] = source[token.position];
+			}
+			for (std::size_t i = 0; i < token.length; i++)
+			{
+				const char c = token.text[i];
+				buffer[length++] = isKeyword(token.type) && c >= 'a' && c <= 'z' ? static_cast<char>(c - 32) : c;
+			}
+			if (quoted)
+			{
+				buffer[length++] = source[token.position];
+			}
+
+			if (token.type == QTokenType::INVALID)
+			{
+				break;
+			}
+		}
+
+		qtl::string result(buffer, length);
+		free(buffer);
+		return result;
+	}
+
+	std::size_t QPlanCache::__find(const qtl::string& key, const std::size_t hash) const
+	{
+		for (std::size_t slot = hash & __mask; __entries[slot].plan; slot = (slot + 1) & __mask)
+		{
+			if (__entries[slot].hash == hash && __entries[slot].plan->getKey() == key)
+			{
+				return slot;
+			}
+		}
+		return __mask + 1;
+	}
+
+	void QPlanCache::__remove(std::size_t slot)
+	{
+		// backward shift deletion, entries after the hole move up unless that
+		// would put them before their home slot
+		__entries[slot].plan = nullptr;
+		__size--;
+		std::size_t next = (slot + 1) & __mask;
+		while (__entries[next].plan)
+		{
+			const std::size_t home = __entries[next].hash & __mask;
+			if (((next - home) & __mask) >= ((next - slot) & __mask))
+			{
+				__entries[slot] = __entries[next];
+				__entries[next].plan = nullptr;
+				slot = next;
+			}
+			next = (next + 1) & __mask;
+		}
+	}
+}
@@ -0,0 +1,1783 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qplanner.h"
+#include "qsql/qdatabase.h"
+
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace qsql
+{
+	namespace
+	{
+		inline bool isNumeric(const QDataType type)
+		{
+			return type == QDataType::CHAR || type == QDataType::INT || type == QDataType::LONG;
+		}
+
+		inline int textLength(const QAstText& text)
+		{
+			return static_cast<int>(text.length > 64 ? 64 : text.length);
+		}
+
+		bool equalsIgnoreCase(const QAstText& left, const QAstText& right)
+		{
+			if (left.length != right.length)
+			{
+				return false;
+			}
+			for (std::size_t i = 0; i < left.length; i++)
+			{
+				const char a = left.text[i];
+				const char b = right.text[i];
+				if ((a >= 'A' && a <= 'Z' ? a + 32 : a) != (b >= 'A' && b <= 'Z' ? b + 32 : b))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool isLiteral(const QAstExpression* expression)
+		{
+			return expression->type == QAstExpressionType::LITERAL;
+		}
+
+		bool isParameter(const QAstExpression* expression)
+		{
+			return expression->type == QAstExpressionType::PARAMETER;
+		}
+
+		bool findAggregate(const QAstText& name, QAggregateFunction& function)
+		{
+			static const struct
+			{
+				QAstText name;
+				QAggregateFunction function;
+			} AGGREGATES[] = {
+				{ { "COUNT", 5 }, QAggregateFunction::COUNT },
+				{ { "SUM", 3 }, QAggregateFunction::SUM },
+				{ { "MIN", 3 }, QAggregateFunction::MIN },
+				{ { "MAX", 3 }, QAggregateFunction::MAX },
+				{ { "AVG", 3 }, QAggregateFunction::AVG },
+			};
+			for (const auto& aggregate : AGGREGATES)
+			{
+				if (equalsIgnoreCase(name, aggregate.name))
+				{
+					function = aggregate.function;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void deleteAll(qtl::vector<QExpression*>& expressions)
+		{
+			for (QExpression* expression : expressions)
+			{
+				delete expression;
+			}
+			expressions.clear();
+		}
+	}
+
+	QPlanner::QPlanner(QDatabase& database)
+		: __database(database), __plan(nullptr), __table(nullptr), __tableName(), __joinTable(nullptr), __joinName(), __binding(QBinding::TABLE),
+		__joinKeys(), __buildSide(0), __grouped(false), __aggregated(false), __ordered(false), __shared(false), __failed(false)
+	{
+		__error[0] = '\0';
+	}
+
+	QPlan* QPlanner::plan(const QAstStatement& statement)
+	{
+		__plan = nullptr;
+		__table = nullptr;
+		__tableName = statement.table;
+		__scanColumns.clear();
+		__joinTable = nullptr;
+		__joinName = statement.joinTable;
+		__joinScanColumns.clear();
+		__binding = QBinding::TABLE;
+		__joinSources.clear();
+		__joinFilters[0].clear();
+		__joinFilters[1].clear();
+		__joinResidual.clear();
+		__joinKeys[0] = nullptr;
+		__joinKeys[1] = nullptr;
+		__joinHash = qtl::shared_ptr<QJoinHashTable>();
+		__grouped = false;
+		__aggregated = false;
+		__groupKeys.clear();
+		__aggregateCalls.clear();
+		__groupTypes.clear();
+		__ordered = false;
+		__failed = false;
+		__error[0] = '\0';
+
+		if (statement.table.length > 0)
+		{
+			__table = __database.findTable(statement.table.text, statement.table.length);
+			if (__table == nullptr)
+			{
+				__fail("unknown table %.*s", textLength(statement.table), statement.table.text);
+				return nullptr;
+			}
+		}
+		if (statement.joinTable.length > 0)
+		{
+			// without aliases the columns of a table joined to itself could not be told apart
+			__joinTable = __database.findTable(statement.joinTable.text, statement.joinTable.length);
+			if (__joinTable == nullptr || __joinTable == __table)
+			{
+				__fail(__joinTable ? "cannot join table %.*s to itself" : "unknown table %.*s", textLength(statement.joinTable), statement.joinTable.text);
+				return nullptr;
+			}
+		}
+
+		switch (statement.type)
+		{
+		case QAstStatementType::SELECT_STATEMENT:
+			return __planSelect(statement);
+		case QAstStatementType::INSERT_STATEMENT:
+			return __planInsert(statement);
+		case QAstStatementType::UPDATE_STATEMENT:
+			return __planUpdate(statement);
+		case QAstStatementType::DELETE_STATEMENT:
+			return __planDelete(statement);
+		}
+		return nullptr;
+	}
+
+	const char* QPlanner::getError() const
+	{
+		return __error;
+	}
+
+	QPlan* QPlanner::__planSelect(const QAstStatement& statement)
+	{
+		__plan = new QPlan(QPlanType::SELECT_PLAN, __table, statement.parameterCount);
+
+		qtl::vector<QOutputColumn> outputs;
+		for (const QAstSelectItem* item = statement.items; item; item = item->next)
+		{
+			if (item->expression->type == QAstExpressionType::STAR)
+			{
+				if (__table == nullptr)
+				{
+					__fail("SELECT * needs a FROM clause");
+					break;
+				}
+				for (std::size_t column = 0; column < __table->getColumnCount(); column++)
+				{
+					outputs.push_back({ nullptr, column, __table->getSchema().getColumnName(column), 0 });
+				}
+				for (std::size_t column = 0; __joinTable && column < __joinTable->getColumnCount(); column++)
+				{
+					outputs.push_back({ nullptr, column, __joinTable->getSchema().getColumnName(column), 1 });
+				}
+				continue;
+			}
+
+			QOutputColumn output = { item->expression, 0, qtl::string(), 0 };
+			if (item->alias.length > 0)
+			{
+				output.name = qtl::string(item->alias.text, item->alias.length);
+			}
+			else if (item->expression->type == QAstExpressionType::COLUMN)
+			{
+				output.name = qtl::string(item->expression->name.text, item->expression->name.length);
+			}
+			else
+			{
+				char name[32];
+				snprintf(name, sizeof(name), "column%zu", outputs.size() + 1);
+				output.name = name;
+			}
+			outputs.push_back(output);
+		}
+
+		// a statement with an aggregate call anywhere above WHERE is grouped, into a
+		// single group without GROUP BY
+		for (const QAstSelectItem* item = statement.items; item; item = item->next)
+		{
+			__collectAggregates(item->expression);
+		}
+		if (statement.having)
+		{
+			__collectAggregates(statement.having);
+		}
+		for (const QAstOrderItem* item = statement.orderBy; item; item = item->next)
+		{
+			__collectAggregates(item->expression);
+		}
+		__grouped = statement.groupBy || statement.having || __aggregateCalls.size() > 0;
+		for (std::size_t i = 0; __grouped && i < outputs.size() && !__failed; i++)
+		{
+			if (outputs[i].expression == nullptr)
+			{
+				__fail("SELECT * cannot be grouped");
+			}
+		}
+
+		// every expression is bound before the scan is built, binding decides which columns it reads
+		QExpression* predicate = __failed ? nullptr : __joinTable ? __bindJoin(statement) : __bindPredicate(statement.where);
+
+		// group keys and aggregate arguments are bound here to be checked, the
+		// aggregations bind their own, and what follows is bound above them
+		for (const QAstExpression* key = statement.groupBy; key && !__failed; key = key->next)
+		{
+			QExpression* bound = __bind(key, QDataType::LONG);
+			__groupKeys.push_back(key);
+			__groupTypes.push_back(bound ? bound->getType() : QDataType::LONG);
+			delete bound;
+		}
+		for (std::size_t i = 0; i < __aggregateCalls.size() && !__failed; i++)
+		{
+			QAggregate aggregate = { QAggregateFunction::COUNT, nullptr };
+			const bool value = __bindAggregate(__aggregateCalls[i], aggregate) && (aggregate.function == QAggregateFunction::MIN || aggregate.function == QAggregateFunction::MAX);
+			__groupTypes.push_back(value ? aggregate.argument->getType() : QDataType::LONG);
+			delete aggregate.argument;
+		}
+		__aggregated = __grouped;
+		QExpression* having = statement.having && !__failed ? __bindHaving(statement.having) : nullptr;
+
+		qtl::vector<QExpression*> keys;
+		qtl::vector<bool> descending;
+		for (const QAstOrderItem* item = statement.orderBy; item && !__failed; item = item->next)
+		{
+			keys.push_back(__bindOrderKey(item->expression, outputs));
+			descending.push_back(item->descending);
+		}
+
+		qtl::vector<QExpression*> projections;
+		for (std::size_t i = 0; i < outputs.size() && !__failed; i++)
+		{
+			projections.push_back(__bindOutput(outputs[i]));
+		}
+
+		__aggregated = false;
+
+		QExpression* limit = statement.limit && !__failed ? __bindLimit(statement.limit, "LIMIT") : nullptr;
+		QExpression* offset = statement.offset && !__failed ? __bindLimit(statement.offset, "OFFSET") : nullptr;
+		__checkPool(__table, __scanColumns);
+		__checkPool(__joinTable, __joinScanColumns);
+
+		if (__failed)
+		{
+			delete predicate;
+			delete having;
+			deleteAll(keys);
+			deleteAll(projections);
+			delete limit;
+			delete offset;
+			delete __plan;
+			return nullptr;
+		}
+
+		// a scan of the whole table may be split across workers that each run a
+		// copy of the pipeline below the sort, a LIMIT without ORDER BY is served
+		// sooner by a single scan.  A join splits the scan of its probe table, and
+		// a grouped statement pre-aggregates each copy's rows.
+		qtl::thread_pool* pool = __database.getThreadPool();
+		const std::size_t workers = pool ? pool->size() : 1;
+		QTable* scanned = __joinTable && __buildSide == 0 ? __joinTable : __table;
+		QMorselCursor* morsels = nullptr;
+		if (scanned && workers > 1 && scanned->getBufferPool() == nullptr && (keys.size() > 0 || __grouped || !(limit || offset)))
+		{
+			morsels = new QMorselCursor();
+		}
+
+		// a single key on an indexed column may be satisfied by the scan itself
+		const bool single = keys.size() == 1;
+		const std::size_t order = single && __joinTable == nullptr && !__grouped ? __findOrderColumn(statement.orderBy->expression, outputs) : QSchema::npos;
+		QOperator* root = __joinTable ? __join(morsels) : __scan(statement.where, order, single && descending[0], morsels);
+		if (morsels && !__shared)
+		{
+			delete morsels;
+			morsels = nullptr;
+		}
+		if (predicate)
+		{
+			root = new QFilterOperator(root, predicate);
+		}
+		if (__grouped)
+		{
+			root = __aggregate(root, morsels ? QAggregateMode::PARTIAL : QAggregateMode::COMPLETE);
+		}
+
+		const bool sorted = !__ordered && keys.size() > 0;
+		const bool project = !sorted && !__grouped;
+		if (morsels)
+		{
+			if (project)
+			{
+				root = new QProjectionOperator(root, projections);
+			}
+			qtl::vector<QOperator*> pipelines;
+			pipelines.push_back(root);
+			for (std::size_t worker = 1; worker < workers; worker++)
+			{
+				pipelines.push_back(__copyPipeline(statement.where, outputs, morsels, project));
+			}
+			root = new QGatherOperator(*scanned, pipelines, morsels, *pool);
+			if (__grouped)
+			{
+				root = __aggregate(root, QAggregateMode::FINAL);
+			}
+		}
+		if (having)
+		{
+			root = new QFilterOperator(root, having);
+		}
+
+		if (__ordered)
+		{
+			deleteAll(keys);
+		}
+		else if (sorted)
+		{
+			root = new QSortOperator(root, keys, descending, __plan->__scratch);
+		}
+		if (morsels == nullptr || !project)
+		{
+			root = new QProjectionOperator(root, projections);
+		}
+		if (limit || offset)
+		{
+			root = new QLimitOperator(root, limit, offset);
+		}
+
+		__plan->__root = root;
+		__joinHash = qtl::shared_ptr<QJoinHashTable>();
+		for (const QOutputColumn& output : outputs)
+		{
+			__plan->__columnNames.push_back(output.name);
+		}
+		return __plan;
+	}
+
+	QPlan* QPlanner::__planInsert(const QAstStatement& statement)
+	{
+		const QSchema& schema = __table->getSchema();
+		const std::size_t columns = schema.getColumnCount();
+
+		// table column of each value of a row
+		qtl::vector<std::size_t> targets;
+		qtl::vector<bool> assigned;
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			assigned.push_back(statement.columns == nullptr);
+			if (statement.columns == nullptr)
+			{
+				targets.push_back(column);
+			}
+		}
+		for (const QAstName* name = statement.columns; name; name = name->next)
+		{
+			const std::size_t column = __findColumn(name->name);
+			if (column == QSchema::npos)
+			{
+				__fail("unknown column %.*s", textLength(name->name), name->name.text);
+				return nullptr;
+			}
+			if (assigned[column])
+			{
+				__fail("column %.*s is listed twice", textLength(name->name), name->name.text);
+				return nullptr;
+			}
+			assigned[column] = true;
+			targets.push_back(column);
+		}
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			if (!assigned[column] && !schema.isNullable(column))
+			{
+				__fail("column %s is not nullable and needs a value", schema.getColumnName(column).c_str());
+				return nullptr;
+			}
+		}
+
+		__plan = new QPlan(QPlanType::INSERT_PLAN, __table, statement.parameterCount);
+		__plan->__tableName = qtl::string(__tableName.text, __tableName.length);
+		std::size_t rowNumber = 1;
+		for (const QAstRow* row = statement.rows; row && !__failed; row = row->next, rowNumber++)
+		{
+			const std::size_t first = __plan->__insertValues.size();
+			for (std::size_t column = 0; column < columns; column++)
+			{
+				__plan->__insertValues.push_back(&__plan->__nullValue);
+			}
+
+			std::size_t count = 0;
+			for (const QAstExpression* value = row->values; value && !__failed; value = value->next, count++)
+			{
+				if (count >= targets.size())
+				{
+					continue;
+				}
+
+				const std::size_t column = targets[count];
+				if (isParameter(value))
+				{
+					__plan->__parameterTypes[value->parameter] = schema.getColumnType(column);
+					__plan->__insertValues[first + column] = &__plan->__parameters[value->parameter];
+				}
+				else if (isLiteral(value))
+				{
+					QValue* literal = new QValue(__literal(value->literal));
+					__plan->__literals.push_back(literal);
+					__plan->__insertValues[first + column] = literal;
+					if (!__table->canStore(column, *literal))
+					{
+						__fail("cannot store the value in column %s", schema.getColumnName(column).c_str());
+					}
+				}
+				else
+				{
+					__fail("INSERT values must be literals or parameters");
+				}
+			}
+			if (!__failed && count != targets.size())
+			{
+				__fail("row %zu has %zu values for %zu columns", rowNumber, count, targets.size());
+			}
+		}
+
+		if (__failed)
+		{
+			delete __plan;
+			return nullptr;
+		}
+		return __plan;
+	}
+
+	QPlan* QPlanner::__planUpdate(const QAstStatement& statement)
+	{
+		__plan = new QPlan(QPlanType::UPDATE_PLAN, __table, statement.parameterCount);
+		__plan->__tableName = qtl::string(__tableName.text, __tableName.length);
+
+		for (const QAstAssignment* assignment = statement.assignments; assignment && !__failed; assignment = assignment->next)
+		{
+			const std::size_t column = __findColumn(assignment->column);
+			if (column == QSchema::npos)
+			{
+				__fail("unknown column %.*s", textLength(assignment->column), assignment->column.text);
+				break;
+			}
+
+			const QDataType type = __table->getColumnType(column);
+			QExpression* value = __bind(assignment->value, type);
+			if (value == nullptr)
+			{
+				break;
+			}
+			__plan->__assignedColumns.push_back(column);
+			__plan->__assignedValues.push_back(value);
+			if (!__isAssignable(type, value))
+			{
+				__fail("cannot assign %s to column %.*s", getDataTypeName(value->getType()), textLength(assignment->column), assignment->column.text);
+			}
+		}
+
+		QExpression* predicate = __failed ? nullptr : __bindPredicate(statement.where);
+		__checkPool(__table, __scanColumns);
+		if (__failed)
+		{
+			delete __plan;
+			return nullptr;
+		}
+
+		QOperator* scan = __scan(statement.where);
+		__plan->__root = predicate ? new QFilterOperator(scan, predicate) : scan;
+		return __plan;
+	}
+
+	QPlan* QPlanner::__planDelete(const QAstStatement& statement)
+	{
+		__plan = new QPlan(QPlanType::DELETE_PLAN, __table, statement.parameterCount);
+		__plan->__tableName = qtl::string(__tableName.text, __tableName.length);
+
+		QExpression* predicate = __bindPredicate(statement.where);
+		__checkPool(__table, __scanColumns);
+		if (__failed)
+		{
+			delete __plan;
+			return nullptr;
+		}
+
+		QOperator* scan = __scan(statement.where);
+		__plan->__root = predicate ? new QFilterOperator(scan, predicate) : scan;
+		return __plan;
+	}
+
+	// A scan keeps a chunk of every column it reads pinned, which a buffer
+	// pool with fewer frames than their pages can never hold
+	void QPlanner::__checkPool(const QTable* table, const qtl::vector<std::size_t>& columns)
+	{
+		const QBufferPool* pool = table ? table->getBufferPool() : nullptr;
+		if (pool == nullptr)
+		{
+			return;
+		}
+		std::size_t pages = 0;
+		for (const std::size_t column : columns)
+		{
+			pages += table->getColumn(column).getChunkPages();
+		}
+		if (pages > pool->getFrameCount())
+		{
+			__fail("a chunk of the scanned columns needs %zu pages, the buffer pool has %zu frames", pages, pool->getFrameCount());
+		}
+	}
+
+	std::size_t QPlanner::__findColumn(const QAstText& name) const
+	{
+		return __findColumn(*__table, name);
+	}
+
+	std::size_t QPlanner::__findColumn(const QTable& table, const QAstText& name) const
+	{
+		const QSchema& schema = table.getSchema();
+		for (std::size_t column = 0; column < schema.getColumnCount(); column++)
+		{
+			if (equalsIgnoreCase(name, schema.getColumnName(column).c_str()))
+			{
+				return column;
+			}
+		}
+		return QSchema::npos;
+	}
+
+	QOperator* QPlanner::__scan(const QAstExpression* where, const std::size_t order, const bool descending, QMorselCursor* morsels)
+	{
+		__ordered = false;
+		__shared = false;
+		if (__table == nullptr)
+		{
+			return new QSingleRowOperator();
+		}
+
+		// an equality on a hash indexed column replaces the scan by a lookup,
+		// the filter above still checks the whole predicate
+		std::size_t column = 0;
+		const QAstExpression* key = where ? __findIndexKey(where, column) : nullptr;
+		QExpression* bound = key ? __bind(key, __table->getColumnType(column)) : nullptr;
+		if (bound)
+		{
+			return new QIndexScanOperator(*__table, __scanColumns, *__table->getHashIndex(column), bound, __plan->__snapshot);
+		}
+
+		// or predicates on bitmap indexed columns are combined into the rows to read
+		QBitmapCondition* condition = where && __joinTable == nullptr ? __bindBitmap(where, false) : nullptr;
+		if (condition)
+		{
+			return new QBitmapScanOperator(*__table, __scanColumns, condition, __plan->__snapshot);
+		}
+
+		// otherwise bounds on a column with an ordered index narrow the scan to a range,
+		// preferably on the ordered column so that the sort can be dropped
+		QIndexRange range = { nullptr, false, nullptr, false };
+		column = order;
+		if (where && order != QSchema::npos)
+		{
+			__findRange(where, column, range);
+		}
+		if (where && range.low == nullptr && range.high == nullptr)
+		{
+			column = QSchema::npos;
+			__findRange(where, column, range);
+		}
+		if (range.low || range.high)
+		{
+			const QDataType type = __table->getColumnType(column);
+			QExpression* low = range.low ? __bind(range.low, type) : nullptr;
+			QExpression* high = range.high ? __bind(range.high, type) : nullptr;
+			__ordered = column == order;
+			return __rangeScan(column, low, range.lowInclusive, high, range.highInclusive, __ordered && descending);
+		}
+
+		// an unbounded walk of the index leaves out NULLs, so it only orders a column without them
+		if (order != QSchema::npos && (__table->getArtIndex(order) || __table->getBTreeIndex(order)) && !__table->getSchema().isNullable(order))
+		{
+			__ordered = true;
+			return __rangeScan(order, nullptr, false, nullptr, false, descending);
+		}
+		__shared = morsels != nullptr;
+		QScanOperator* scan = new QScanOperator(*__table, __scanColumns, __plan->__snapshot, morsels);
+		__plan->__scans.push_back(scan);
+		if (where && __joinTable == nullptr)
+		{
+			__addRanges(*scan, where);
+		}
+		return scan;
+	}
+
+	QOperator* QPlanner::__rangeScan(const std::size_t column, QExpression* low, const bool lowInclusive, QExpression* high, const bool highInclusive, const bool descending)
+	{
+		// the radix tree is preferred where a column has both ordered indexes
+		if (const QArtIndex* index = __table->getArtIndex(column))
+		{
+			return new QIndexRangeScanOperator(*__table, __scanColumns, *index, low, lowInclusive, high, highInclusive, descending, __plan->__snapshot);
+		}
+		return new QIndexRangeScanOperator(*__table, __scanColumns, *__table->getBTreeIndex(column), low, lowInclusive, high, highInclusive, descending, __plan->__snapshot);
+	}
+
+	QOperator* QPlanner::__copyPipeline(const QAstExpression* where, const qtl::vector<QOutputColumn>& outputs, QMorselCursor* morsels, const bool project)
+	{
+		// the expressions bound again read the same scan columns as the first copy's
+		QOperator* root = __joinTable ? __join(morsels) : nullptr;
+		if (root == nullptr)
+		{
+			QScanOperator* scan = new QScanOperator(*__table, __scanColumns, __plan->__snapshot, morsels);
+			__plan->__scans.push_back(scan);
+			if (where)
+			{
+				__addRanges(*scan, where);
+			}
+			root = scan;
+		}
+		QExpression* predicate = __joinTable ? __bindConjuncts(__joinResidual) : __bindPredicate(where);
+		if (predicate)
+		{
+			root = new QFilterOperator(root, predicate);
+		}
+		if (__grouped)
+		{
+			root = __aggregate(root, QAggregateMode::PARTIAL);
+		}
+		if (project)
+		{
+			qtl::vector<QExpression*> projections;
+			for (std::size_t i = 0; i < outputs.size(); i++)
+			{
+				projections.push_back(__bindOutput(outputs[i]));
+			}
+			root = new QProjectionOperator(root, projections);
+		}
+		return root;
+	}
+
+	QOperator* QPlanner::__join(QMorselCursor* morsels)
+	{
+		__ordered = false;
+		__shared = morsels != nullptr;
+
+		// each side's scan is filtered by the conjuncts that read only its table,
+		// the build side is read once into the table every copy of the join shares
+		const std::size_t probeSide = 1 - __buildSide;
+		QOperator* inputs[2] = { nullptr, nullptr };
+		QScanOperator* probeScan = nullptr;
+		QExpression* keys[2] = { nullptr, nullptr };
+		for (std::size_t side = 0; side < 2; side++)
+		{
+			if (side == __buildSide && __joinHash.get())
+			{
+				continue;
+			}
+			__binding = side ? QBinding::JOINED_TABLE : QBinding::TABLE;
+			QTable& table = side ? *__joinTable : *__table;
+			QScanOperator* scan = new QScanOperator(table, side ? __joinScanColumns : __scanColumns, __plan->__snapshot, side == probeSide ? morsels : nullptr);
+			__plan->__scans.push_back(scan);
+			probeScan = side == probeSide ? scan : probeScan;
+			inputs[side] = scan;
+			QExpression* filter = __bindConjuncts(__joinFilters[side]);
+			if (filter)
+			{
+				inputs[side] = new QFilterOperator(inputs[side], filter);
+			}
+			keys[side] = __bind(__joinKeys[side], QDataType::LONG);
+		}
+		__binding = QBinding::JOIN_RESULT;
+
+		// result columns of the build side are kept in the table with its key
+		qtl::vector<std::size_t> kept;
+		qtl::vector<QHashJoinOperator::QJoinColumn> columns;
+		qtl::vector<std::size_t>& buildColumns = __buildSide ? __joinScanColumns : __scanColumns;
+		for (const QJoinSource& source : __joinSources)
+		{
+			if (source.side == __buildSide)
+			{
+				kept.push_back(__scanIndex(buildColumns, source.column));
+				columns.push_back({ true, kept.size() - 1 });
+			}
+			else
+			{
+				columns.push_back({ false, __scanIndex(probeSide ? __joinScanColumns : __scanColumns, source.column) });
+			}
+		}
+		if (__joinHash.get() == nullptr)
+		{
+			__joinHash = qtl::shared_ptr<QJoinHashTable>(new QJoinHashTable(inputs[__buildSide], keys[__buildSide], kept));
+		}
+
+		// a probe key read straight from a column is looked up in the filter of
+		// the build side's keys while the probe side is scanned
+		std::size_t side = 0;
+		std::size_t column = 0;
+		const QAstExpression* probeKey = __joinKeys[probeSide];
+		if (probeKey->type == QAstExpressionType::COLUMN && __resolveColumn(probeKey, side, column) && side == probeSide)
+		{
+			const QTable& table = side ? *__joinTable : *__table;
+			if (QHashIndex::isSupported(table.getColumnType(column)))
+			{
+				probeScan->addRuntimeFilter(__scanIndex(side ? __joinScanColumns : __scanColumns, column), __joinHash->getFilter());
+			}
+		}
+		return new QHashJoinOperator(inputs[probeSide], keys[probeSide], __joinHash, columns);
+	}
+
+	QOperator* QPlanner::__aggregate(QOperator* input, const QAggregateMode mode)
+	{
+		qtl::vector<QExpression*> keys;
+		qtl::vector<QAggregate> aggregates;
+		for (std::size_t i = 0; i < __groupKeys.size(); i++)
+		{
+			keys.push_back(mode == QAggregateMode::FINAL ? new QColumnExpression(i, __groupTypes[i]) : __bind(__groupKeys[i], QDataType::LONG));
+		}
+		for (const QAstExpression* call : __aggregateCalls)
+		{
+			QAggregate aggregate = { QAggregateFunction::COUNT, nullptr };
+			if (mode == QAggregateMode::FINAL)
+			{
+				findAggregate(call->name, aggregate.function);
+			}
+			else
+			{
+				__bindAggregate(call, aggregate);
+			}
+			aggregates.push_back(aggregate);
+		}
+		return new QHashAggregateOperator(input, keys, aggregates, mode);
+	}
+
+	const QAstExpression* QPlanner::__findIndexKey(const QAstExpression* expression, std::size_t& column) const
+	{
+		if (expression->type == QAstExpressionType::LOGICAL && expression->logical == QLogical::AND)
+		{
+			const QAstExpression* key = __findIndexKey(expression->left, column);
+			return key ? key : __findIndexKey(expression->right, column);
+		}
+		if (expression->type != QAstExpressionType::COMPARISON || expression->comparison != QComparison::EQUAL)
+		{
+			return nullptr;
+		}
+
+		for (int side = 0; side < 2; side++)
+		{
+			const QAstExpression* name = side ? expression->right : expression->left;
+			const QAstExpression* key = side ? expression->left : expression->right;
+			if (name->type != QAstExpressionType::COLUMN || !(isLiteral(key) || isParameter(key)))
+			{
+				continue;
+			}
+			column = __findColumn(name->name);
+			if (column != QSchema::npos && __table->getHashIndex(column))
+			{
+				return key;
+			}
+		}
+		return nullptr;
+	}
+
+	QBitmapCondition* QPlanner::__bindBitmap(const QAstExpression* expression, const bool negated)
+	{
+		switch (expression->type)
+		{
+		case QAstExpressionType::NOT:
+			return __bindBitmap(expression->left, !negated);
+		case QAstExpressionType::LOGICAL:
+		{
+			// NOT is pushed down to the leaves, turning AND into OR and back
+			const QLogical op = negated ? (expression->logical == QLogical::AND ? QLogical::OR : QLogical::AND) : expression->logical;
+			QBitmapCondition* left = __bindBitmap(expression->left, negated);
+			QBitmapCondition* right = __bindBitmap(expression->right, negated);
+			if (left && right)
+			{
+				return new QBitmapCondition(op, left, right);
+			}
+
+			// either side of an AND alone still holds for every row satisfying it
+			if (op == QLogical::AND)
+			{
+				return left ? left : right;
+			}
+			delete left;
+			delete right;
+			return nullptr;
+		}
+		case QAstExpressionType::COLUMN:
+		{
+			// a BOOL column on its own is true
+			const std::size_t column = __findColumn(expression->name);
+			if (column == QSchema::npos || !__table->getBitmapIndex(column) || __table->getColumnType(column) != QDataType::BOOL)
+			{
+				return nullptr;
+			}
+			return new QBitmapCondition(*__table->getBitmapIndex(column), new QConstantExpression(QValue(true)), negated);
+		}
+		case QAstExpressionType::COMPARISON:
+			if (expression->comparison != QComparison::EQUAL && expression->comparison != QComparison::NOT_EQUAL)
+			{
+				return nullptr;
+			}
+			for (int side = 0; side < 2; side++)
+			{
+				const QAstExpression* name = side ? expression->right : expression->left;
+				const QAstExpression* key = side ? expression->left : expression->right;
+				if (name->type != QAstExpressionType::COLUMN || !(isLiteral(key) || isParameter(key)))
+				{
+					continue;
+				}
+				const std::size_t column = __findColumn(name->name);
+				if (column == QSchema::npos || !__table->getBitmapIndex(column))
+				{
+					continue;
+				}
+				QExpression* bound = __bind(key, __table->getColumnType(column));
+				if (bound)
+				{
+					return new QBitmapCondition(*__table->getBitmapIndex(column), bound, negated != (expression->comparison == QComparison::NOT_EQUAL));
+				}
+			}
+			return nullptr;
+		default:
+			return nullptr;
+		}
+	}
+
+	void QPlanner::__findRange(const QAstExpression* expression, std::size_t& column, QIndexRange& range) const
+	{
+		// column is npos until a conjunct picks one, later conjuncts only narrow its range
+		if (expression->type == QAstExpressionType::LOGICAL && expression->logical == QLogical::AND)
+		{
+			__findRange(expression->left, column, range);
+			__findRange(expression->right, column, range);
+			return;
+		}
+
+		QIndexRange bounds = { nullptr, false, nullptr, false };
+		const QAstExpression* name = __findBounds(expression, bounds);
+		if (name == nullptr)
+		{
+			return;
+		}
+		const std::size_t bounded = __findColumn(name->name);
+		if (bounded == QSchema::npos || !(__table->getArtIndex(bounded) || __table->getBTreeIndex(bounded)) || (column != QSchema::npos && column != bounded))
+		{
+			return;
+		}
+
+		column = bounded;
+		if (range.low == nullptr && bounds.low)
+		{
+			range.low = bounds.low;
+			range.lowInclusive = bounds.lowInclusive;
+		}
+		if (range.high == nullptr && bounds.high)
+		{
+			range.high = bounds.high;
+			range.highInclusive = bounds.highInclusive;
+		}
+	}
+
+	const QAstExpression* QPlanner::__findBounds(const QAstExpression* expression, QIndexRange& bounds) const
+	{
+		const QAstExpression* name = nullptr;
+		if (expression->type == QAstExpressionType::BETWEEN && !expression->negated)
+		{
+			const QAstExpression* low = expression->arguments;
+			const QAstExpression* high = low->next;
+			if ((isLiteral(low) || isParameter(low)) && (isLiteral(high) || isParameter(high)))
+			{
+				name = expression->left;
+				bounds = { low, true, high, true };
+			}
+		}
+		else if (expression->type == QAstExpressionType::COMPARISON && expression->comparison != QComparison::NOT_EQUAL)
+		{
+			for (int side = 0; side < 2 && name == nullptr; side++)
+			{
+				const QAstExpression* value = side ? expression->left : expression->right;
+				if (!isLiteral(value) && !isParameter(value))
+				{
+					continue;
+				}
+
+				// 5 < x bounds x from below just like x > 5
+				QComparison op = expression->comparison;
+				if (side && op != QComparison::EQUAL)
+				{
+					op = op == QComparison::LESS ? QComparison::GREATER : op == QComparison::LESS_EQUAL ? QComparison::GREATER_EQUAL
+						: op == QComparison::GREATER ? QComparison::LESS : QComparison::LESS_EQUAL;
+				}
+				name = side ? expression->right : expression->left;
+
+				const bool inclusive = op == QComparison::EQUAL || op == QComparison::LESS_EQUAL || op == QComparison::GREATER_EQUAL;
+				if (op != QComparison::LESS && op != QComparison::LESS_EQUAL)
+				{
+					bounds.low = value;
+					bounds.lowInclusive = inclusive;
+				}
+				if (op != QComparison::GREATER && op != QComparison::GREATER_EQUAL)
+				{
+					bounds.high = value;
+					bounds.highInclusive = inclusive;
+				}
+			}
+		}
+
+		return name && name->type == QAstExpressionType::COLUMN ? name : nullptr;
+	}
+
+	void QPlanner::__addRanges(QScanOperator& scan, const QAstExpression* where)
+	{
+		if (where->type == QAstExpressionType::LOGICAL && where->logical == QLogical::AND)
+		{
+			__addRanges(scan, where->left);
+			__addRanges(scan, where->right);
+			return;
+		}
+
+		QIndexRange bounds = { nullptr, false, nullptr, false };
+		const QAstExpression* name = __findBounds(where, bounds);
+		const std::size_t column = name ? __findColumn(name->name) : QSchema::npos;
+		if (column == QSchema::npos)
+		{
+			return;
+		}
+		const QDataType type = __table->getColumnType(column);
+		if (type == QDataType::INT || type == QDataType::LONG)
+		{
+			QExpression* low = bounds.low ? __bind(bounds.low, type) : nullptr;
+			QExpression* high = bounds.high ? __bind(bounds.high, type) : nullptr;
+			scan.addRange(column, low, bounds.lowInclusive, high, bounds.highInclusive);
+		}
+		if (where->type == QAstExpressionType::COMPARISON && where->comparison == QComparison::EQUAL && __table->hasBloomFilter(column))
+		{
+			scan.addKey(column, __bind(bounds.low, type));
+		}
+	}
+
+	std::size_t QPlanner::__findOrderColumn(const QAstExpression* expression, const qtl::vector<QOutputColumn>& outputs) const
+	{
+		// resolves the key the way __bindOrderKey() does, but only to a plain table column
+		if (__table == nullptr)
+		{
+			return QSchema::npos;
+		}
+
+		const QAstExpression* column = expression;
+		if (isLiteral(expression) && !expression->literal.isNull && expression->literal.type != QDataType::STRING && expression->literal.type != QDataType::BOOL)
+		{
+			const int64_t position = expression->literal.integer;
+			if (position < 1 || static_cast<uint64_t>(position) > outputs.size())
+			{
+				return QSchema::npos;
+			}
+			const QOutputColumn& output = outputs[static_cast<std::size_t>(position - 1)];
+			if (output.expression == nullptr)
+			{
+				return output.column;
+			}
+			column = output.expression;
+		}
+		else if (expression->type == QAstExpressionType::COLUMN && expression->table.length == 0)
+		{
+			for (const QOutputColumn& output : outputs)
+			{
+				if (equalsIgnoreCase(expression->name, output.name.c_str()))
+				{
+					if (output.expression == nullptr)
+					{
+						return output.column;
+					}
+					column = output.expression;
+					break;
+				}
+			}
+		}
+
+		if (column->type != QAstExpressionType::COLUMN)
+		{
+			return QSchema::npos;
+		}
+		return __findColumn(column->name);
+	}
+
+	QExpression* QPlanner::__bindPredicate(const QAstExpression* where)
+	{
+		if (where == nullptr)
+		{
+			return nullptr;
+		}
+
+		QExpression* predicate = __bind(where, QDataType::BOOL);
+		if (predicate && predicate->getType() != QDataType::BOOL)
+		{
+			__fail("WHERE must be a boolean expression");
+			delete predicate;
+			return nullptr;
+		}
+		return predicate;
+	}
+
+	QExpression* QPlanner::__bindConjuncts(const qtl::vector<const QAstExpression*>& conjuncts)
+	{
+		QExpression* predicate = nullptr;
+		for (const QAstExpression* conjunct : conjuncts)
+		{
+			QExpression* bound = __bindPredicate(conjunct);
+			if (bound == nullptr)
+			{
+				delete predicate;
+				return nullptr;
+			}
+			predicate = predicate ? new QLogicalExpression(QLogical::AND, predicate, bound) : bound;
+		}
+		return predicate;
+	}
+
+	QExpression* QPlanner::__bindJoin(const QAstStatement& statement)
+	{
+		// ON and WHERE mean the same to an inner join, the first equality between
+		// the tables is its key
+		qtl::vector<const QAstExpression*> conjuncts;
+		__splitConjuncts(statement.joinOn, conjuncts);
+		if (statement.where)
+		{
+			__splitConjuncts(statement.where, conjuncts);
+		}
+		for (const QAstExpression* conjunct : conjuncts)
+		{
+			const unsigned sides = __findSides(conjunct);
+			if (__joinKeys[0] == nullptr && conjunct->type == QAstExpressionType::COMPARISON && conjunct->comparison == QComparison::EQUAL)
+			{
+				const unsigned left = __findSides(conjunct->left);
+				const unsigned right = __findSides(conjunct->right);
+				if ((left == 1 && right == 2) || (left == 2 && right == 1))
+				{
+					__joinKeys[left - 1] = conjunct->left;
+					__joinKeys[right - 1] = conjunct->right;
+					continue;
+				}
+			}
+			if (sides == 3)
+			{
+				__joinResidual.push_back(conjunct);
+			}
+			else
+			{
+				__joinFilters[sides == 2 ? 1 : 0].push_back(conjunct);
+			}
+		}
+		if (!__failed && __joinKeys[0] == nullptr)
+		{
+			__fail("JOIN needs an equality between columns of both tables");
+		}
+
+		// bound here to be checked and to pick the columns they read, the
+		// operators bind their own
+		QExpression* keys[2] = { nullptr, nullptr };
+		for (std::size_t side = 0; side < 2 && !__failed; side++)
+		{
+			__binding = side ? QBinding::JOINED_TABLE : QBinding::TABLE;
+			delete __bindConjuncts(__joinFilters[side]);
+			keys[side] = __failed ? nullptr : __bind(__joinKeys[side], QDataType::LONG);
+		}
+		if (keys[0] && keys[1])
+		{
+			const QDataType left = keys[0]->getType();
+			const QDataType right = keys[1]->getType();
+			if (!(isNumeric(left) && isNumeric(right)) && !(left == QDataType::STRING && right == QDataType::STRING))
+			{
+				__fail("cannot join %s with %s", getDataTypeName(left), getDataTypeName(right));
+			}
+		}
+		delete keys[0];
+		delete keys[1];
+
+		// the smaller table is built into the hash table and the larger probes it
+		__buildSide = __joinTable->getRowCount() < __table->getRowCount() ? 1 : 0;
+		__binding = QBinding::JOIN_RESULT;
+		return __failed ? nullptr : __bindConjuncts(__joinResidual);
+	}
+
+	void QPlanner::__splitConjuncts(const QAstExpression* expression, qtl::vector<const QAstExpression*>& conjuncts) const
+	{
+		if (expression->type == QAstExpressionType::LOGICAL && expression->logical == QLogical::AND)
+		{
+			__splitConjuncts(expression->left, conjuncts);
+			__splitConjuncts(expression->right, conjuncts);
+			return;
+		}
+		conjuncts.push_back(expression);
+	}
+
+	unsigned QPlanner::__findSides(const QAstExpression* expression)
+	{
+		// bit 0 for the table, bit 1 for the joined table
+		unsigned sides = 0;
+		std::size_t side = 0;
+		std::size_t column = 0;
+		if (expression->type == QAstExpressionType::COLUMN && __resolveColumn(expression, side, column))
+		{
+			sides = 1u << side;
+		}
+		if (expression->left)
+		{
+			sides |= __findSides(expression->left);
+		}
+		if (expression->right)
+		{
+			sides |= __findSides(expression->right);
+		}
+		for (const QAstExpression* argument = expression->arguments; argument; argument = argument->next)
+		{
+			sides |= __findSides(argument);
+		}
+		return sides;
+	}
+
+	bool QPlanner::__resolveColumn(const QAstExpression* expression, std::size_t& side, std::size_t& column)
+	{
+		if (__joinTable == nullptr)
+		{
+			if (expression->table.length > 0 && !equalsIgnoreCase(expression->table, __tableName))
+			{
+				__fail("unknown table %.*s", textLength(expression->table), expression->table.text);
+				return false;
+			}
+			side = 0;
+			column = __findColumn(expression->name);
+			if (column == QSchema::npos)
+			{
+				__fail("unknown column %.*s", textLength(expression->name), expression->name.text);
+				return false;
+			}
+			return true;
+		}
+
+		// a name without a table may belong to either table, but not to both
+		const bool qualified = expression->table.length > 0;
+		const bool first = !qualified || equalsIgnoreCase(expression->table, __tableName);
+		const bool second = !qualified || equalsIgnoreCase(expression->table, __joinName);
+		if (!first && !second)
+		{
+			__fail("unknown table %.*s", textLength(expression->table), expression->table.text);
+			return false;
+		}
+
+		const std::size_t columns[2] = { first ? __findColumn(*__table, expression->name) : QSchema::npos, second ? __findColumn(*__joinTable, expression->name) : QSchema::npos };
+		if (columns[0] != QSchema::npos && columns[1] != QSchema::npos)
+		{
+			__fail("column %.*s is ambiguous", textLength(expression->name), expression->name.text);
+			return false;
+		}
+		if (columns[0] == QSchema::npos && columns[1] == QSchema::npos)
+		{
+			__fail("unknown column %.*s", textLength(expression->name), expression->name.text);
+			return false;
+		}
+		side = columns[0] == QSchema::npos ? 1 : 0;
+		column = columns[side];
+		return true;
+	}
+
+	void QPlanner::__collectAggregates(const QAstExpression* expression)
+	{
+		// calls are not looked into, an aggregate of an aggregate fails to bind
+		QAggregateFunction function;
+		if (expression->type == QAstExpressionType::FUNCTION && findAggregate(expression->name, function))
+		{
+			for (const QAstExpression* call : __aggregateCalls)
+			{
+				if (__sameExpression(call, expression))
+				{
+					return;
+				}
+			}
+			__aggregateCalls.push_back(expression);
+			return;
+		}
+		if (expression->left)
+		{
+			__collectAggregates(expression->left);
+		}
+		if (expression->right)
+		{
+			__collectAggregates(expression->right);
+		}
+		for (const QAstExpression* argument = expression->arguments; argument; argument = argument->next)
+		{
+			__collectAggregates(argument);
+		}
+	}
+
+	bool QPlanner::__bindAggregate(const QAstExpression* call, QAggregate& aggregate)
+	{
+		findAggregate(call->name, aggregate.function);
+		const QAstExpression* argument = call->arguments;
+		if (argument == nullptr || argument->next)
+		{
+			__fail("%.*s takes a single argument", textLength(call->name), call->name.text);
+			return false;
+		}
+		if (argument->type == QAstExpressionType::STAR)
+		{
+			if (aggregate.function != QAggregateFunction::COUNT)
+			{
+				__fail("%.*s(*) is not allowed", textLength(call->name), call->name.text);
+				return false;
+			}
+			aggregate.argument = nullptr;
+			return true;
+		}
+
+		aggregate.argument = __bind(argument, QDataType::LONG);
+		if (aggregate.argument == nullptr)
+		{
+			return false;
+		}
+		const bool summed = aggregate.function == QAggregateFunction::SUM || aggregate.function == QAggregateFunction::AVG;
+		if (summed && !isNumeric(aggregate.argument->getType()))
+		{
+			__fail("%.*s needs a numeric argument, not %s", textLength(call->name), call->name.text, getDataTypeName(aggregate.argument->getType()));
+			delete aggregate.argument;
+			aggregate.argument = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	QExpression* QPlanner::__bindHaving(const QAstExpression* having)
+	{
+		QExpression* predicate = __bind(having, QDataType::BOOL);
+		if (predicate && predicate->getType() != QDataType::BOOL)
+		{
+			__fail("HAVING must be a boolean expression");
+			delete predicate;
+			return nullptr;
+		}
+		return predicate;
+	}
+
+	std::size_t QPlanner::__findGrouped(const QAstExpression* expression)
+	{
+		// literals and parameters are bound as they are, even where they are a key
+		if (isLiteral(expression) || isParameter(expression))
+		{
+			return QSchema::npos;
+		}
+		for (std::size_t i = 0; i < __groupKeys.size(); i++)
+		{
+			if (__sameExpression(expression, __groupKeys[i]))
+			{
+				return i;
+			}
+		}
+		for (std::size_t i = 0; i < __aggregateCalls.size(); i++)
+		{
+			if (__sameExpression(expression, __aggregateCalls[i]))
+			{
+				return __groupKeys.size() + i;
+			}
+		}
+		return QSchema::npos;
+	}
+
+	bool QPlanner::__sameExpression(const QAstExpression* left, const QAstExpression* right)
+	{
+		if (left == right)
+		{
+			return true;
+		}
+		if (left == nullptr || right == nullptr || left->type != right->type)
+		{
+			return false;
+		}
+
+		switch (left->type)
+		{
+		case QAstExpressionType::COLUMN:
+		{
+			// columns are the same if they resolve to the same table column
+			std::size_t sides[2] = { 0, 0 };
+			std::size_t columns[2] = { 0, 0 };
+			return __table && __resolveColumn(left, sides[0], columns[0]) && __resolveColumn(right, sides[1], columns[1]) && sides[0] == sides[1] && columns[0] == columns[1];
+		}
+		case QAstExpressionType::LITERAL:
+		{
+			const QAstLiteral& a = left->literal;
+			const QAstLiteral& b = right->literal;
+			if (a.type != b.type || a.isNull != b.isNull)
+			{
+				return false;
+			}
+			if (a.type == QDataType::STRING)
+			{
+				return a.string.length == b.string.length && memcmp(a.string.text, b.string.text, a.string.length) == 0;
+			}
+			return a.type == QDataType::BOOL ? a.boolean == b.boolean : a.integer == b.integer;
+		}
+		case QAstExpressionType::PARAMETER:
+			return left->parameter == right->parameter;
+		case QAstExpressionType::FUNCTION:
+			if (!equalsIgnoreCase(left->name, right->name))
+			{
+				return false;
+			}
+			break;
+		case QAstExpressionType::ARITHMETIC:
+			if (left->arithmetic != right->arithmetic)
+			{
+				return false;
+			}
+			break;
+		case QAstExpressionType::COMPARISON:
+			if (left->comparison != right->comparison)
+			{
+				return false;
+			}
+			break;
+		case QAstExpressionType::LOGICAL:
+			if (left->logical != right->logical)
+			{
+				return false;
+			}
+			break;
+		default:
+			if (left->negated != right->negated)
+			{
+				return false;
+			}
+			break;
+		}
+
+		const QAstExpression* a = left->arguments;
+		const QAstExpression* b = right->arguments;
+		for (; a && b; a = a->next, b = b->next)
+		{
+			if (!__sameExpression(a, b))
+			{
+				return false;
+			}
+		}
+		return a == b && __sameExpression(left->left, right->left) && __sameExpression(left->right, right->right);
+	}
+
+	QExpression* QPlanner::__bindOrderKey(const QAstExpression* expression, const qtl::vector<QOutputColumn>& outputs)
+	{
+		// ORDER BY 2 refers to the second result column
+		if (isLiteral(expression) && !expression->literal.isNull && expression->literal.type != QDataType::STRING && expression->literal.type != QDataType::BOOL)
+		{
+			const int64_t position = expression->literal.integer;
+			if (position < 1 || static_cast<uint64_t>(position) > outputs.size())
+			{
+				__fail("ORDER BY position %lld is out of range", static_cast<long long>(position));
+				return nullptr;
+			}
+			return __bindOutput(outputs[static_cast<std::size_t>(position - 1)]);
+		}
+
+		// a bare name refers to a result column before a table column
+		if (expression->type == QAstExpressionType::COLUMN && expression->table.length == 0)
+		{
+			for (const QOutputColumn& output : outputs)
+			{
+				if (equalsIgnoreCase(expression->name, output.name.c_str()))
+				{
+					return __bindOutput(output);
+				}
+			}
+		}
+		return __bind(expression, QDataType::LONG);
+	}
+
+	QExpression* QPlanner::__bindOutput(const QOutputColumn& output)
+	{
+		if (output.expression)
+		{
+			return __bind(output.expression, QDataType::LONG);
+		}
+		return __joinTable ? __bindJoinColumn(output.side, output.column) : __bindColumn(output.column);
+	}
+
+	QExpression* QPlanner::__bindLimit(const QAstExpression* expression, const char* clause)
+	{
+		if (!isLiteral(expression) && !isParameter(expression))
+		{
+			__fail("%s must be an integer literal or parameter", clause);
+			return nullptr;
+		}
+
+		QExpression* bound = __bind(expression, QDataType::LONG);
+		if (bound && (bound->getType() == QDataType::STRING || bound->getType() == QDataType::BOOL))
+		{
+			__fail("%s must be an integer literal or parameter", clause);
+			delete bound;
+			return nullptr;
+		}
+		return bound;
+	}
+
+	QExpression* QPlanner::__bind(const QAstExpression* expression, const QDataType hint)
+	{
+		// above an aggregation a group key or an aggregate call is its column,
+		// and table columns may only be read through them
+		if (__aggregated)
+		{
+			const std::size_t position = __findGrouped(expression);
+			if (position != QSchema::npos)
+			{
+				return new QColumnExpression(position, __groupTypes[position]);
+			}
+			if (!__failed && __table && expression->type == QAstExpressionType::COLUMN)
+			{
+				__fail("column %.*s must appear in GROUP BY or in an aggregate", textLength(expression->name), expression->name.text);
+			}
+			if (__failed)
+			{
+				return nullptr;
+			}
+		}
+
+		switch (expression->type)
+		{
+		case QAstExpressionType::COLUMN:
+		{
+			if (__table == nullptr)
+			{
+				__fail("column %.*s needs a FROM clause", textLength(expression->name), expression->name.text);
+				return nullptr;
+			}
+			std::size_t side = 0;
+			std::size_t column = 0;
+			if (!__resolveColumn(expression, side, column))
+			{
+				return nullptr;
+			}
+			return __joinTable ? __bindJoinColumn(side, column) : __bindColumn(column);
+		}
+		case QAstExpressionType::LITERAL:
+			return new QConstantExpression(__literal(expression->literal));
+		case QAstExpressionType::PARAMETER:
+			__plan->__parameterTypes[expression->parameter] = hint;
+			return new QParameterExpression(__plan->__parameters[expression->parameter], hint);
+		case QAstExpressionType::STAR:
+			__fail("* is only allowed as a select item");
+			return nullptr;
+		case QAstExpressionType::NEGATE:
+		{
+			QExpression* operand = __bind(expression->left, isNumeric(hint) ? hint : QDataType::LONG);
+			if (operand && !isNumeric(operand->getType()))
+			{
+				__fail("cannot negate %s", getDataTypeName(operand->getType()));
+				delete operand;
+				return nullptr;
+			}
+			return operand ? new QArithmeticExpression(QArithmetic::SUBTRACT, new QConstantExpression(QValue(static_cast<int32_t>(0))), operand) : nullptr;
+		}
+		case QAstExpressionType::NOT:
+		{
+			QExpression* operand = __bind(expression->left, QDataType::BOOL);
+			if (operand && operand->getType() != QDataType::BOOL)
+			{
+				__fail("NOT needs a boolean operand");
+				delete operand;
+				return nullptr;
+			}
+			return operand ? new QNotExpression(operand) : nullptr;
+		}
+		case QAstExpressionType::ARITHMETIC:
+		{
+			QExpression* left = __bind(expression->left, QDataType::LONG);
+			QExpression* right = left ? __bind(expression->right, QDataType::LONG) : nullptr;
+			if (right && (!isNumeric(left->getType()) || !isNumeric(right->getType())))
+			{
+				__fail("arithmetic on %s and %s", getDataTypeName(left->getType()), getDataTypeName(right->getType()));
+				delete right;
+				right = nullptr;
+			}
+			if (right == nullptr)
+			{
+				delete left;
+				return nullptr;
+			}
+			return new QArithmeticExpression(expression->arithmetic, left, right);
+		}
+		case QAstExpressionType::COMPARISON:
+			return __bindComparison(expression->comparison, expression->left, expression->right);
+		case QAstExpressionType::LOGICAL:
+		{
+			QExpression* left = __bind(expression->left, QDataType::BOOL);
+			QExpression* right = left ? __bind(expression->right, QDataType::BOOL) : nullptr;
+			if (right && (left->getType() != QDataType::BOOL || right->getType() != QDataType::BOOL))
+			{
+				__fail("%s needs boolean operands", expression->logical == QLogical::AND ? "AND" : "OR");
+				delete right;
+				right = nullptr;
+			}
+			if (right == nullptr)
+			{
+				delete left;
+				return nullptr;
+			}
+			return new QLogicalExpression(expression->logical, left, right);
+		}
+		case QAstExpressionType::BETWEEN:
+			return __negate(__bindBetween(expression), expression->negated);
+		case QAstExpressionType::IN_LIST:
+			return __negate(__bindIn(expression), expression->negated);
+		case QAstExpressionType::IS_NULL:
+		{
+			QExpression* operand = __bind(expression->left, QDataType::LONG);
+			return operand ? new QIsNullExpression(operand, expression->negated) : nullptr;
+		}
+		case QAstExpressionType::FUNCTION:
+		{
+			QAggregateFunction function;
+			__fail(findAggregate(expression->name, function) ? "aggregate %.*s is not allowed here" : "unknown function %.*s", textLength(expression->name), expression->name.text);
+			return nullptr;
+		}
+		}
+		return nullptr;
+	}
+
+	QExpression* QPlanner::__bindColumn(const std::size_t column)
+	{
+		return new QColumnExpression(__scanIndex(__scanColumns, column), __table->getColumnType(column));
+	}
+
+	QExpression* QPlanner::__bindJoinColumn(const std::size_t side, const std::size_t column)
+	{
+		const QDataType type = side ? __joinTable->getColumnType(column) : __table->getColumnType(column);
+		if (__binding != QBinding::JOIN_RESULT)
+		{
+			assert(side == (__binding == QBinding::JOINED_TABLE ? 1u : 0u));
+			return new QColumnExpression(__scanIndex(side ? __joinScanColumns : __scanColumns, column), type);
+		}
+
+		// a result column is read by the scan of its table as well
+		std::size_t index = 0;
+		while (index < __joinSources.size() && !(__joinSources[index].side == side && __joinSources[index].column == column))
+		{
+			index++;
+		}
+		if (index == __joinSources.size())
+		{
+			__joinSources.push_back({ side, column });
+			__scanIndex(side ? __joinScanColumns : __scanColumns, column);
+		}
+		return new QColumnExpression(index, type);
+	}
+
+	std::size_t QPlanner::__scanIndex(qtl::vector<std::size_t>& columns, const std::size_t column) const
+	{
+		std::size_t index = 0;
+		while (index < columns.size() && columns[index] != column)
+		{
+			index++;
+		}
+		if (index == columns.size())
+		{
+			columns.push_back(column);
+		}
+		return index;
+	}
+
+	QExpression* QPlanner::__bindComparison(const QComparison op, const QAstExpression* left, const QAstExpression* right)
+	{
+		// a parameter is bound after the other operand so that it can take its type
+		QExpression* boundLeft = nullptr;
+		QExpression* boundRight = nullptr;
+		if (isParameter(left) && !isParameter(right))
+		{
+			boundRight = __bind(right, QDataType::LONG);
+			boundLeft = boundRight ? __bind(left, boundRight->getType()) : nullptr;
+		}
+		else
+		{
+			boundLeft = __bind(left, QDataType::LONG);
+			boundRight = boundLeft ? __bind(right, boundLeft->getType()) : nullptr;
+		}
+
+		// a NULL literal compares with anything, the comparison is never true
+		const bool nullOperand = (isLiteral(left) && left->literal.isNull) || (isLiteral(right) && right->literal.isNull);
+		if (boundLeft && boundRight && !nullOperand && !__isComparable(boundLeft, boundRight))
+		{
+			__fail("cannot compare %s with %s", getDataTypeName(boundLeft->getType()), getDataTypeName(boundRight->getType()));
+		}
+		if (boundLeft == nullptr || boundRight == nullptr || __failed)
+		{
+			delete boundLeft;
+			delete boundRight;
+			return nullptr;
+		}
+		return new QComparisonExpression(op, boundLeft, boundRight);
+	}
+
+	QExpression* QPlanner::__bindBetween(const QAstExpression* expression)
+	{
+		const QAstExpression* low = expression->arguments;
+		const QAstExpression* high = low->next;
+
+		// literal bounds use the dedicated expression, anything else is rewritten
+		// to a pair of comparisons
+		if (!isParameter(expression->left) && isLiteral(low) && isLiteral(high) && !low->literal.isNull && !high->literal.isNull)
+		{
+			QExpression* child = __bind(expression->left, QDataType::LONG);
+			if (child == nullptr)
+			{
+				return nullptr;
+			}
+			const QValue lowValue = __literal(low->literal);
+			const QValue highValue = __literal(high->literal);
+			if (!__isComparable(child->getType(), lowValue) || !__isComparable(child->getType(), highValue))
+			{
+				__fail("cannot compare %s with the bounds of BETWEEN", getDataTypeName(child->getType()));
+				delete child;
+				return nullptr;
+			}
+			return new QBetweenExpression(child, lowValue, highValue);
+		}
+
+		QExpression* lower = __bindComparison(QComparison::GREATER_EQUAL, expression->left, low);
+		QExpression* upper = lower ? __bindComparison(QComparison::LESS_EQUAL, expression->left, high) : nullptr;
+		if (upper == nullptr)
+		{
+			delete lower;
+			return nullptr;
+		}
+		return new QLogicalExpression(QLogical::AND, lower, upper);
+	}
+
+	QExpression* QPlanner::__bindIn(const QAstExpression* expression)
+	{
+		bool literals = !isParameter(expression->left);
+		for (const QAstExpression* value = expression->arguments; value; value = value->next)
+		{
+			literals = literals && isLiteral(value);
+		}
+
+		if (literals)
+		{
+			QExpression* child = __bind(expression->left, QDataType::LONG);
+			if (child == nullptr)
+			{
+				return nullptr;
+			}
+			qtl::vector<QValue> values;
+			for (const QAstExpression* value = expression->arguments; value; value = value->next)
+			{
+				values.push_back(__literal(value->literal));
+				if (!__isComparable(child->getType(), values.back()))
+				{
+					__fail("cannot compare %s with the values of IN", getDataTypeName(child->getType()));
+					delete child;
+					return nullptr;
+				}
+			}
+			return new QInExpression(child, values);
+		}
+
+		// otherwise x IN (a, b) becomes x = a OR x = b
+		QExpression* result = nullptr;
+		for (const QAstExpression* value = expression->arguments; value; value = value->next)
+		{
+			QExpression* equal = __bindComparison(QComparison::EQUAL, expression->left, value);
+			if (equal == nullptr)
+			{
+				delete result;
+				return nullptr;
+			}
+			result = result ? new QLogicalExpression(QLogical::OR, result, equal) : equal;
+		}
+		return result;
+	}
+
+	QExpression* QPlanner::__negate(QExpression* expression, const bool negated)
+	{
+		return expression && negated ? new QNotExpression(expression) : expression;
+	}
+
+	bool QPlanner::__isComparable(const QExpression* left, const QExpression* right) const
+	{
+		const QValue* constant = right->getConstant();
+		if (constant && constant->getType() == QDataType::STRING)
+		{
+			return __isComparable(left->getType(), *constant);
+		}
+		constant = left->getConstant();
+		if (constant && constant->getType() == QDataType::STRING)
+		{
+			return __isComparable(right->getType(), *constant);
+		}
+
+		const QDataType l = left->getType();
+		const QDataType r = right->getType();
+		return l == r || (isNumeric(l) && isNumeric(r));
+	}
+
+	bool QPlanner::__isComparable(const QDataType type, const QValue& value) const
+	{
+		if (value.isNull())
+		{
+			return true;
+		}
+		if (value.getType() == QDataType::STRING)
+		{
+			// a single character string stands for a CHAR
+			return type == QDataType::STRING || (type == QDataType::CHAR && value.getString().length() == 1);
+		}
+		return value.getType() == type || (isNumeric(type) && isNumeric(value.getType()));
+	}
+
+	bool QPlanner::__isAssignable(const QDataType type, const QExpression* value) const
+	{
+		const QValue* constant = value->getConstant();
+		if (constant)
+		{
+			return __isComparable(type, *constant);
+		}
+		return value->getType() == type || (isNumeric(type) && isNumeric(value->getType()));
+	}
+
+	QValue QPlanner::__literal(const QAstLiteral& literal) const
+	{
+		if (literal.isNull)
+		{
+			return QValue();
+		}
+		switch (literal.type)
+		{
+		case QDataType::CHAR:
+			return QValue(static_cast<char>(literal.integer));
+		case QDataType::INT:
+			return QValue(static_cast<int32_t>(literal.integer));
+		case QDataType::LONG:
+			return QValue(static_cast<int64_t>(literal.integer));
+		case QDataType::BOOL:
+			return QValue(literal.boolean);
+		case QDataType::STRING:
+			return QValue(qtl::string(literal.string.text, literal.string.length));
+		}
+		return QValue();
+	}
+
+	void QPlanner::__fail(const char* format, ...)
+	{
+		// the first failure is reported, later ones usually follow from it
+		if (__failed)
+		{
+			return;
+		}
+		__failed = true;
+		va_list arguments;
+		va_start(arguments, format);
+		vsnprintf(__error, ERROR_LENGTH, format, arguments);
+		va_end(arguments);
+	}
+}
@@ -0,0 +1,740 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qroaringbitmap.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "qsql/qsimd.h"
+
+namespace qsql
+{
+	namespace
+	{
+		constexpr uint32_t CONTAINER_SIZE = 65536;
+		constexpr std::size_t CONTAINER_MASK = CONTAINER_SIZE - 1;
+
+		// Index of the first of count sorted values not less than value
+		uint32_t lowerBound(const uint16_t* values, const uint32_t count, const uint32_t value)
+		{
+			uint32_t low = 0;
+			uint32_t high = count;
+			while (low < high)
+			{
+				const uint32_t middle = (low + high) / 2;
+				if (values[middle] < value)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					high = middle;
+				}
+			}
+			return low;
+		}
+
+		// Sets bits first to last, both inclusive
+		void setRange(uint64_t* words, const uint32_t first, const uint32_t last)
+		{
+			const uint32_t firstWord = first >> 6;
+			const uint32_t lastWord = last >> 6;
+			const uint64_t firstMask = ~static_cast<uint64_t>(0) << (first & 63);
+			const uint64_t lastMask = ~static_cast<uint64_t>(0) >> (63 - (last & 63));
+			if (firstWord == lastWord)
+			{
+				words[firstWord] |= firstMask & lastMask;
+				return;
+			}
+			words[firstWord] |= firstMask;
+			for (uint32_t word = firstWord + 1; word < lastWord; word++)
+			{
+				words[word] = ~static_cast<uint64_t>(0);
+			}
+			words[lastWord] |= lastMask;
+		}
+
+		inline uint32_t countTrailingZeros(const uint64_t word)
+		{
+#if defined ( _MSC_VER )
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return index;
+#else
+			return static_cast<uint32_t>(__builtin_ctzll(word));
+#endif
+		}
+	}
+
+	QRoaringContainer::QRoaringContainer()
+		: __type(QType::ARRAY), __cardinality(0), __values(nullptr), __size(0), __capacity(0), __words(nullptr)
+	{
+	}
+
+	QRoaringContainer::QRoaringContainer(const QRoaringContainer& other)
+		: __type(other.__type), __cardinality(other.__cardinality), __values(nullptr), __size(other.__size), __capacity(other.__size), __words(nullptr)
+	{
+		if (__size)
+		{
+			__values = static_cast<uint16_t*>(malloc(__size * sizeof(uint16_t)));
+			memcpy(__values, other.__values, __size * sizeof(uint16_t));
+		}
+		if (other.__words)
+		{
+			__words = static_cast<uint64_t*>(malloc(WORDS * sizeof(uint64_t)));
+			memcpy(__words, other.__words, WORDS * sizeof(uint64_t));
+		}
+	}
+
+	QRoaringContainer::~QRoaringContainer()
+	{
+		free(__values);
+		free(__words);
+	}
+
+	QRoaringContainer::QType QRoaringContainer::getType() const
+	{
+		return __type;
+	}
+
+	std::size_t QRoaringContainer::getCardinality() const
+	{
+		return __cardinality;
+	}
+
+	std::size_t QRoaringContainer::getBytes() const
+	{
+		return __type == QType::BITMAP ? WORDS * sizeof(uint64_t) : __size * sizeof(uint16_t);
+	}
+
+	bool QRoaringContainer::add(const uint16_t value)
+	{
+		if (__type == QType::RUN)
+		{
+			__toBitmap();
+			__settle();
+		}
+		if (__type == QType::ARRAY)
+		{
+			const uint32_t index = lowerBound(__values, __size, value);
+			if (index < __size && __values[index] == value)
+			{
+				return false;
+			}
+			if (__size < ARRAY_LIMIT)
+			{
+				__reserve(__size + 1);
+				memmove(__values + index + 1, __values + index, (__size - index) * sizeof(uint16_t));
+				__values[index] = value;
+				__size++;
+				__cardinality++;
+				return true;
+			}
+			__toBitmap();
+		}
+
+		uint64_t& word = __words[value >> 6];
+		const uint64_t bit = static_cast<uint64_t>(1) << (value & 63);
+		if (word & bit)
+		{
+			return false;
+		}
+		word |= bit;
+		__cardinality++;
+		return true;
+	}
+
+	bool QRoaringContainer::remove(const uint16_t value)
+	{
+		if (__type == QType::RUN)
+		{
+			__toBitmap();
+			__settle();
+		}
+		if (__type == QType::ARRAY)
+		{
+			const uint32_t index = lowerBound(__values, __size, value);
+			if (index == __size || __values[index] != value)
+			{
+				return false;
+			}
+			memmove(__values + index, __values + index + 1, (__size - index - 1) * sizeof(uint16_t));
+			__size--;
+			__cardinality--;
+			return true;
+		}
+
+		uint64_t& word = __words[value >> 6];
+		const uint64_t bit = static_cast<uint64_t>(1) << (value & 63);
+		if (!(word & bit))
+		{
+			return false;
+		}
+		word &= ~bit;
+		__cardinality--;
+		if (__cardinality <= ARRAY_LIMIT)
+		{
+			__settle();
+		}
+		return true;
+	}
+
+	bool QRoaringContainer::contains(const uint16_t value) const
+	{
+		switch (__type)
+		{
+		case QType::ARRAY:
+		{
+			const uint32_t index = lowerBound(__values, __size, value);
+			return index < __size && __values[index] == value;
+		}
+		case QType::BITMAP:
+			return (__words[value >> 6] >> (value & 63)) & 1;
+		case QType::RUN:
+			break;
+		}
+		const uint32_t runs = __runsBefore(value);
+		return runs > 0 && value <= static_cast<uint32_t>(__values[runs * 2 - 2]) + __values[runs * 2 - 1];
+	}
+
+	void QRoaringContainer::intersect(const QRoaringContainer& other)
+	{
+		// the values of an array are tested one at a time, and only they can remain
+		if (__type == QType::ARRAY || other.__type == QType::ARRAY)
+		{
+			const QRoaringContainer& array = __type == QType::ARRAY ? *this : other;
+			const QRoaringContainer& test = __type == QType::ARRAY ? other : *this;
+			uint16_t* values = static_cast<uint16_t*>(malloc((array.__size ? array.__size : 1) * sizeof(uint16_t)));
+			uint32_t kept = 0;
+			for (uint32_t i = 0; i < array.__size; i++)
+			{
+				values[kept] = array.__values[i];
+				kept += test.contains(array.__values[i]);
+			}
+			__adopt(values, kept);
+			return;
+		}
+
+		__toBitmap();
+		uint64_t words[WORDS];
+		const uint64_t* source = other.__words;
+		if (source == nullptr)
+		{
+			memset(words, 0, sizeof(words));
+			other.setBits(words);
+			source = words;
+		}
+		bitmapAnd(__words, source, WORDS);
+		__settle();
+	}
+
+	void QRoaringContainer::unite(const QRoaringContainer& other)
+	{
+		if (__type == QType::ARRAY && other.__type == QType::ARRAY && __size + other.__size <= ARRAY_LIMIT)
+		{
+			uint16_t* values = static_cast<uint16_t*>(malloc((__size + other.__size ? __size + other.__size : 1) * sizeof(uint16_t)));
+			uint32_t left = 0;
+			uint32_t right = 0;
+			uint32_t size = 0;
+			while (left < __size || right < other.__size)
+			{
+				const bool fromLeft = right == other.__size || (left < __size && __values[left] <= other.__values[right]);
+				const uint16_t value = fromLeft ? __values[left] : other.__values[right];
+				left += fromLeft || (left < __size && __values[left] == value);
+				right += !fromLeft || (right < other.__size && other.__values[right] == value);
+				values[size++] = value;
+			}
+			__adopt(values, size);
+			return;
+		}
+
+		__toBitmap();
+		other.setBits(__words);
+		__settle();
+	}
+
+	void QRoaringContainer::subtract(const QRoaringContainer& other)
+	{
+		if (__type == QType::ARRAY)
+		{
+			uint32_t kept = 0;
+			for (uint32_t i = 0; i < __size; i++)
+			{
+				__values[kept] = __values[i];
+				kept += !other.contains(__values[i]);
+			}
+			__size = kept;
+			__cardinality = kept;
+			return;
+		}
+
+		__toBitmap();
+		uint64_t words[WORDS];
+		const uint64_t* source = other.__words;
+		if (source == nullptr)
+		{
+			memset(words, 0, sizeof(words));
+			other.setBits(words);
+			source = words;
+		}
+		bitmapAndNot(__words, source, WORDS);
+		__settle();
+	}
+
+	void QRoaringContainer::optimize()
+	{
+		if (__type == QType::RUN || __cardinality == 0)
+		{
+			return;
+		}
+
+		// a run starts at each value whose predecessor is missing
+		uint64_t bits[WORDS];
+		const uint64_t* words = __words;
+		if (words == nullptr)
+		{
+			memset(bits, 0, sizeof(bits));
+			setBits(bits);
+			words = bits;
+		}
+		uint32_t runs = 0;
+		for (std::size_t word = 0; word < WORDS; word++)
+		{
+			const uint64_t carry = word ? words[word - 1] >> 63 : 0;
+			const uint64_t starts = words[word] & ~((words[word] << 1) | carry);
+			runs += static_cast<uint32_t>(bitmapCount(&starts, 1));
+		}
+		if (runs * 2 * sizeof(uint16_t) >= getBytes())
+		{
+			return;
+		}
+
+		uint16_t* values = static_cast<uint16_t*>(malloc(runs * 2 * sizeof(uint16_t)));
+		uint32_t size = 0;
+		uint32_t value = 0;
+		while (value < CONTAINER_SIZE)
+		{
+			while (value < CONTAINER_SIZE && !((words[value >> 6] >> (value & 63)) & 1))
+			{
+				value = (value & 63) == 0 && words[value >> 6] == 0 ? value + 64 : value + 1;
+			}
+			if (value == CONTAINER_SIZE)
+			{
+				break;
+			}
+			const uint32_t start = value;
+			while (value < CONTAINER_SIZE && ((words[value >> 6] >> (value & 63)) & 1))
+			{
+				value = (value & 63) == 0 && words[value >> 6] == ~static_cast<uint64_t>(0) ? value + 64 : value + 1;
+			}
+			values[size++] = static_cast<uint16_t>(start);
+			values[size++] = static_cast<uint16_t>(value - start - 1);
+		}
+
+		const uint32_t cardinality = __cardinality;
+		__adopt(values, size);
+		__type = QType::RUN;
+		__cardinality = cardinality;
+	}
+
+	void QRoaringContainer::setBits(uint64_t* words, const std::size_t count) const
+	{
+		const uint32_t end = static_cast<uint32_t>(count * 64);
+		switch (__type)
+		{
+		case QType::ARRAY:
+			for (uint32_t i = 0; i < __size && __values[i] < end; i++)
+			{
+				words[__values[i] >> 6] |= static_cast<uint64_t>(1) << (__values[i] & 63);
+			}
+			break;
+		case QType::BITMAP:
+			bitmapOr(words, __words, count);
+			break;
+		case QType::RUN:
+			for (uint32_t i = 0; i < __size && __values[i] < end; i += 2)
+			{
+				const uint32_t last = static_cast<uint32_t>(__values[i]) + __values[i + 1];
+				setRange(words, __values[i], last < end ? last : end - 1);
+			}
+			break;
+		}
+	}
+
+	std::size_t QRoaringContainer::extract(uint32_t& first, const std::size_t base, std::size_t* rows, const std::size_t capacity) const
+	{
+		std::size_t count = 0;
+		uint32_t value = first;
+		switch (__type)
+		{
+		case QType::ARRAY:
+			for (uint32_t i = lowerBound(__values, __size, value); i < __size && count < capacity; i++)
+			{
+				rows[count++] = base + __values[i];
+				value = __values[i] + 1;
+			}
+			break;
+		case QType::BITMAP:
+			while (value < CONTAINER_SIZE && count < capacity)
+			{
+				const uint64_t bits = __words[value >> 6] & (~static_cast<uint64_t>(0) << (value & 63));
+				if (bits == 0)
+				{
+					value = (value | 63) + 1;
+					continue;
+				}
+				value = (value & ~static_cast<uint32_t>(63)) + countTrailingZeros(bits);
+				rows[count++] = base + value;
+				value++;
+			}
+			break;
+		case QType::RUN:
+		{
+			// resumes within the run holding value, if any
+			const uint32_t runs = __runsBefore(static_cast<uint16_t>(value < CONTAINER_SIZE ? value : CONTAINER_SIZE - 1));
+			for (uint32_t run = runs ? runs - 1 : 0; value < CONTAINER_SIZE && run * 2 < __size && count < capacity; run++)
+			{
+				const uint32_t start = __values[run * 2];
+				const uint32_t last = start + __values[run * 2 + 1];
+				for (value = value > start ? value : start; value <= last && count < capacity; value++)
+				{
+					rows[count++] = base + value;
+				}
+			}
+			break;
+		}
+		}
+
+		// whatever follows the last row written is left for the next call
+		if (count < capacity)
+		{
+			value = CONTAINER_SIZE;
+		}
+		first = value;
+		return count;
+	}
+
+	uint32_t QRoaringContainer::__runsBefore(const uint16_t value) const
+	{
+		// number of runs starting at or before value
+		uint32_t low = 0;
+		uint32_t high = __size / 2;
+		while (low < high)
+		{
+			const uint32_t middle = (low + high) / 2;
+			if (__values[middle * 2] <= value)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	void QRoaringContainer::__reserve(const uint32_t size)
+	{
+		if (size <= __capacity)
+		{
+			return;
+		}
+		uint32_t capacity = __capacity ? __capacity * 2 : 4;
+		capacity = capacity < size ? size : capacity;
+		__values = static_cast<uint16_t*>(realloc(__values, capacity * sizeof(uint16_t)));
+		__capacity = capacity;
+	}
+
+	void QRoaringContainer::__adopt(uint16_t* values, const uint32_t size)
+	{
+		// the container becomes an array of values, which it takes ownership of
+		free(__values);
+		free(__words);
+		__values = values;
+		__size = size;
+		__capacity = size;
+		__words = nullptr;
+		__type = QType::ARRAY;
+		__cardinality = size;
+	}
+
+	void QRoaringContainer::__toBitmap()
+	{
+		if (__type == QType::BITMAP)
+		{
+			return;
+		}
+		__words = static_cast<uint64_t*>(malloc(WORDS * sizeof(uint64_t)));
+		memset(__words, 0, WORDS * sizeof(uint64_t));
+		setBits(__words);
+		__size = 0;
+		__type = QType::BITMAP;
+	}
+
+	void QRoaringContainer::__settle()
+	{
+		// a bitmap of few values is smaller as an array
+		__cardinality = static_cast<uint32_t>(bitmapCount(__words, WORDS));
+		if (__cardinality > ARRAY_LIMIT)
+		{
+			return;
+		}
+		uint16_t* values = static_cast<uint16_t*>(malloc((__cardinality ? __cardinality : 1) * sizeof(uint16_t)));
+		uint32_t first = 0;
+		std::size_t rows[ARRAY_LIMIT];
+		const std::size_t count = extract(first, 0, rows, ARRAY_LIMIT);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			values[i] = static_cast<uint16_t>(rows[i]);
+		}
+		__adopt(values, static_cast<uint32_t>(count));
+	}
+
+	QRoaringBitmap::QRoaringBitmap()
+	{
+	}
+
+	QRoaringBitmap::QRoaringBitmap(const QRoaringBitmap& other)
+	{
+		*this = other;
+	}
+
+	QRoaringBitmap::QRoaringBitmap(QRoaringBitmap&& other) noexcept
+		: __entries(qtl::move(other.__entries))
+	{
+	}
+
+	QRoaringBitmap::~QRoaringBitmap()
+	{
+		clear();
+	}
+
+	QRoaringBitmap& QRoaringBitmap::operator=(const QRoaringBitmap& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			for (const QEntry& entry : other.__entries)
+			{
+				__entries.push_back({ entry.key, new QRoaringContainer(*entry.container) });
+			}
+		}
+		return *this;
+	}
+
+	QRoaringBitmap& QRoaringBitmap::operator=(QRoaringBitmap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			clear();
+			__entries = qtl::move(other.__entries);
+		}
+		return *this;
+	}
+
+	bool QRoaringBitmap::isEmpty() const
+	{
+		return __entries.empty();
+	}
+
+	std::size_t QRoaringBitmap::getCardinality() const
+	{
+		std::size_t cardinality = 0;
+		for (const QEntry& entry : __entries)
+		{
+			cardinality += entry.container->getCardinality();
+		}
+		return cardinality;
+	}
+
+	std::size_t QRoaringBitmap::getBytes() const
+	{
+		std::size_t bytes = __entries.size() * sizeof(QEntry);
+		for (const QEntry& entry : __entries)
+		{
+			bytes += sizeof(QRoaringContainer) + entry.container->getBytes();
+		}
+		return bytes;
+	}
+
+	void QRoaringBitmap::add(const std::size_t row)
+	{
+		const std::size_t key = row >> CONTAINER_SHIFT;
+		const std::size_t index = __find(key);
+		if (index == __entries.size() || __entries[index].key != key)
+		{
+			// rows are mostly added in order, so the new container is usually the last
+			__entries.push_back({ key, nullptr });
+			for (std::size_t i = __entries.size() - 1; i > index; i--)
+			{
+				__entries[i] = __entries[i - 1];
+			}
+			__entries[index] = { key, new QRoaringContainer() };
+		}
+		__entries[index].container->add(static_cast<uint16_t>(row & CONTAINER_MASK));
+	}
+
+	void QRoaringBitmap::remove(const std::size_t row)
+	{
+		const std::size_t key = row >> CONTAINER_SHIFT;
+		const std::size_t index = __find(key);
+		if (index < __entries.size() && __entries[index].key == key && __entries[index].container->remove(static_cast<uint16_t>(row & CONTAINER_MASK))
+			&& __entries[index].container->getCardinality() == 0)
+		{
+			__compact();
+		}
+	}
+
+	bool QRoaringBitmap::contains(const std::size_t row) const
+	{
+		const std::size_t key = row >> CONTAINER_SHIFT;
+		const std::size_t index = __find(key);
+		return index < __entries.size() && __entries[index].key == key && __entries[index].container->contains(static_cast<uint16_t>(row & CONTAINER_MASK));
+	}
+
+	void QRoaringBitmap::clear()
+	{
+		for (const QEntry& entry : __entries)
+		{
+			delete entry.container;
+		}
+		__entries.clear();
+	}
+
+	void QRoaringBitmap::intersect(const QRoaringBitmap& other)
+	{
+		std::size_t right = 0;
+		for (QEntry& entry : __entries)
+		{
+			while (right < other.__entries.size() && other.__entries[right].key < entry.key)
+			{
+				right++;
+			}
+			if (right < other.__entries.size() && other.__entries[right].key == entry.key)
+			{
+				entry.container->intersect(*other.__entries[right].container);
+			}
+			else
+			{
+				// no row of this container is in other
+				delete entry.container;
+				entry.container = new QRoaringContainer();
+			}
+		}
+		__compact();
+	}
+
+	void QRoaringBitmap::unite(const QRoaringBitmap& other)
+	{
+		qtl::vector<QEntry> entries;
+		std::size_t left = 0;
+		std::size_t right = 0;
+		while (left < __entries.size() || right < other.__entries.size())
+		{
+			if (right == other.__entries.size() || (left < __entries.size() && __entries[left].key < other.__entries[right].key))
+			{
+				entries.push_back(__entries[left++]);
+			}
+			else if (left == __entries.size() || other.__entries[right].key < __entries[left].key)
+			{
+				entries.push_back({ other.__entries[right].key, new QRoaringContainer(*other.__entries[right].container) });
+				right++;
+			}
+			else
+			{
+				__entries[left].container->unite(*other.__entries[right++].container);
+				entries.push_back(__entries[left++]);
+			}
+		}
+		__entries = qtl::move(entries);
+	}
+
+	void QRoaringBitmap::subtract(const QRoaringBitmap& other)
+	{
+		std::size_t right = 0;
+		for (QEntry& entry : __entries)
+		{
+			while (right < other.__entries.size() && other.__entries[right].key < entry.key)
+			{
+				right++;
+			}
+			if (right < other.__entries.size() && other.__entries[right].key == entry.key)
+			{
+				entry.container->subtract(*other.__entries[right].container);
+			}
+		}
+		__compact();
+	}
+
+	void QRoaringBitmap::optimize()
+	{
+		for (const QEntry& entry : __entries)
+		{
+			entry.container->optimize();
+		}
+	}
+
+	std::size_t QRoaringBitmap::extract(std::size_t& position, std::size_t* rows, const std::size_t capacity) const
+	{
+		std::size_t count = 0;
+		for (std::size_t index = __find(position >> CONTAINER_SHIFT); index < __entries.size() && count < capacity; index++)
+		{
+			const std::size_t base = __entries[index].key << CONTAINER_SHIFT;
+			uint32_t first = base < position ? static_cast<uint32_t>(position - base) : 0;
+			count += __entries[index].container->extract(first, base, rows + count, capacity - count);
+			position = base + first;
+		}
+		return count;
+	}
+
+	void QRoaringBitmap::setBits(uint64_t* bitmap, const std::size_t words) const
+	{
+		for (const QEntry& entry : __entries)
+		{
+			const std::size_t first = (entry.key << CONTAINER_SHIFT) / 64;
+			if (first >= words)
+			{
+				break;
+			}
+			const std::size_t count = words - first;
+			entry.container->setBits(bitmap + first, count < QRoaringContainer::WORDS ? count : QRoaringContainer::WORDS);
+		}
+	}
+
+	std::size_t QRoaringBitmap::__find(const std::size_t key) const
+	{
+		std::size_t low = 0;
+		std::size_t high = __entries.size();
+		while (low < high)
+		{
+			const std::size_t middle = (low + high) / 2;
+			if (__entries[middle].key < key)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	void QRoaringBitmap::__compact()
+	{
+		qtl::vector<QEntry> entries;
+		for (const QEntry& entry : __entries)
+		{
+			if (entry.container->getCardinality())
+			{
+				entries.push_back(entry);
+			}
+			else
+			{
+				delete entry.container;
+			}
+		}
+		__entries = qtl::move(entries);
+	}
+}
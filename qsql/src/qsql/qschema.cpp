@@ -0,0 +1,81 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qschema.h"
+
+#include <cstdint>
+
+namespace qsql
+{
+	QSchema::QSchema()
+		: __rowSize(0), __rowAlignment(1), __hasNullable(false)
+	{
+	}
+
+	std::size_t QSchema::addColumn(const qtl::string& name, const QDataType type, const bool nullable, const QEncoding encoding)
+	{
+		QColumnInfo info;
+		info.name = name;
+		info.type = type;
+		info.nullable = nullable;
+		const bool compressible = type == QDataType::INT || type == QDataType::LONG;
+		const bool applies = encoding == QEncoding::DICTIONARY ? type == QDataType::STRING : encoding != QEncoding::COMPRESSED || compressible;
+		info.encoding = applies ? encoding : QEncoding::PLAIN;
+		info.offset = 0;
+		__columns.push_back(qtl::move(info));
+		__computeLayout();
+		return __columns.size() - 1;
+	}
+
+	std::size_t QSchema::findColumn(const qtl::string& name) const
+	{
+		for (std::size_t column = 0; column < __columns.size(); column++)
+		{
+			if (__columns[column].name == name)
+			{
+				return column;
+			}
+		}
+		return npos;
+	}
+
+	const qtl::string& QSchema::getColumnName(const std::size_t column) const
+	{
+		return __columns[column].name;
+	}
+
+	void QSchema::__computeLayout()
+	{
+		__hasNullable = false;
+		for (std::size_t column = 0; column < __columns.size(); column++)
+		{
+			__hasNullable |= __columns[column].nullable;
+		}
+
+		std::size_t offset = __hasNullable ? (__columns.size() + 7) / 8 : 0;
+		__rowAlignment = 1;
+
+		// place the widest alignments first, every supported alignment is a power of two
+		for (std::size_t alignment = 16; alignment > 0; alignment >>= 1)
+		{
+			for (std::size_t column = 0; column < __columns.size(); column++)
+			{
+				// a dictionary encoded column stores its code
+				QColumnInfo& info = __columns[column];
+				const bool encoded = info.encoding == QEncoding::DICTIONARY;
+				if ((encoded ? alignof(uint32_t) : getDataTypeAlignment(info.type)) != alignment)
+				{
+					continue;
+				}
+				offset = (offset + alignment - 1) & ~(alignment - 1);
+				info.offset = offset;
+				offset += encoded ? sizeof(uint32_t) : getDataTypeSize(info.type);
+				if (alignment > __rowAlignment)
+				{
+					__rowAlignment = alignment;
+				}
+			}
+		}
+
+		__rowSize = (offset + __rowAlignment - 1) & ~(__rowAlignment - 1);
+	}
+}
@@ -0,0 +1,365 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qsegment.h"
+
+#include <cassert>
+
+namespace qsql
+{
+	namespace
+	{
+		unsigned bitWidth(uint64_t range)
+		{
+			unsigned width = 0;
+			for (; range; range >>= 1)
+			{
+				width++;
+			}
+			return width;
+		}
+
+		// Bytes taken by count values packed into width bits each, in whole words
+		std::size_t packedBytes(const std::size_t count, const unsigned width)
+		{
+			return (count * width + 63) / 64 * sizeof(uint64_t);
+		}
+
+		inline void storeValue(const QDataType type, const uint64_t value, void* values, const std::size_t index)
+		{
+			if (type == QDataType::INT)
+			{
+				static_cast<int32_t*>(values)[index] = static_cast<int32_t>(value);
+			}
+			else
+			{
+				static_cast<int64_t*>(values)[index] = static_cast<int64_t>(value);
+			}
+		}
+	}
+
+	QSegment::QSegment(const QDataType type, const QSegmentEncoding encoding, const std::size_t count)
+		: __type(type), __encoding(encoding), __count(count), __base(0), __width(0)
+	{
+	}
+
+	QSegment* QSegment::encode(const QDataType type, const void* values, const uint64_t* nulls, const std::size_t count)
+	{
+		assert((type == QDataType::INT || type == QDataType::LONG) && count > 0 && count <= UINT16_MAX);
+
+		// NULL rows repeat the value before them, leading ones the first value
+		qtl::vector<int64_t> filled;
+		filled.resize(count);
+		int64_t previous = 0;
+		bool found = false;
+		for (std::size_t pass = 0; pass < 2; pass++)
+		{
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (!nulls || !((nulls[i >> 6] >> (i & 63)) & 1))
+				{
+					previous = type == QDataType::INT ? static_cast<const int32_t*>(values)[i] : static_cast<const int64_t*>(values)[i];
+					found = true;
+				}
+				filled[i] = previous;
+				if (pass == 0 && found)
+				{
+					break;
+				}
+			}
+		}
+
+		// differences wrap around like the sums that undo them, so every range
+		// is taken over the values as unsigned
+		int64_t low = filled[0];
+		int64_t high = filled[0];
+		int64_t lowDelta = 0;
+		int64_t highDelta = 0;
+		std::size_t runs = 1;
+		for (std::size_t i = 1; i < count; i++)
+		{
+			const int64_t value = filled[i];
+			const int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(filled[i - 1]));
+			low = value < low ? value : low;
+			high = value > high ? value : high;
+			lowDelta = i == 1 || delta < lowDelta ? delta : lowDelta;
+			highDelta = i == 1 || delta > highDelta ? delta : highDelta;
+			runs += value != filled[i - 1];
+		}
+		const unsigned width = bitWidth(static_cast<uint64_t>(high) - static_cast<uint64_t>(low));
+		const unsigned deltaWidth = bitWidth(static_cast<uint64_t>(highDelta) - static_cast<uint64_t>(lowDelta));
+
+		// the smallest encoding wins, if it beats the plain values
+		const std::size_t sizes[3] = {
+			packedBytes(count, width),
+			packedBytes(count, deltaWidth) + (count + CHECKPOINT - 1) / CHECKPOINT * sizeof(int64_t),
+			packedBytes(runs, width) + runs * sizeof(uint16_t),
+		};
+		std::size_t best = 0;
+		for (std::size_t i = 1; i < 3; i++)
+		{
+			best = sizes[i] < sizes[best] ? i : best;
+		}
+		if (sizes[best] >= count * getDataTypeSize(type))
+		{
+			return nullptr;
+		}
+
+		const QSegmentEncoding encoding = static_cast<QSegmentEncoding>(best);
+		QSegment* segment = new QSegment(type, encoding, count);
+		segment->__base = static_cast<uint64_t>(encoding == QSegmentEncoding::DELTA ? lowDelta : low);
+		segment->__width = encoding == QSegmentEncoding::DELTA ? deltaWidth : width;
+		segment->__packed.resize(sizes[best] / sizeof(uint64_t));
+		switch (encoding)
+		{
+		case QSegmentEncoding::FRAME_OF_REFERENCE:
+			for (std::size_t i = 0; i < count; i++)
+			{
+				segment->__pack(i, static_cast<uint64_t>(filled[i]) - segment->__base);
+			}
+			break;
+		case QSegmentEncoding::DELTA:
+			segment->__packed.resize(packedBytes(count, deltaWidth) / sizeof(uint64_t));
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (i % CHECKPOINT == 0)
+				{
+					segment->__checkpoints.push_back(filled[i]);
+					continue;
+				}
+				segment->__pack(i, static_cast<uint64_t>(filled[i]) - static_cast<uint64_t>(filled[i - 1]) - segment->__base);
+			}
+			break;
+		case QSegmentEncoding::RUN_LENGTH:
+			segment->__packed.resize(packedBytes(runs, width) / sizeof(uint64_t));
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (i + 1 == count || filled[i + 1] != filled[i])
+				{
+					segment->__pack(segment->__runEnds.size(), static_cast<uint64_t>(filled[i]) - segment->__base);
+					segment->__runEnds.push_back(static_cast<uint16_t>(i + 1));
+				}
+			}
+			break;
+		}
+		return segment;
+	}
+
+	QDataType QSegment::getType() const
+	{
+		return __type;
+	}
+
+	QSegmentEncoding QSegment::getEncoding() const
+	{
+		return __encoding;
+	}
+
+	std::size_t QSegment::size() const
+	{
+		return __count;
+	}
+
+	std::size_t QSegment::getBytes() const
+	{
+		return __packed.size() * sizeof(uint64_t) + __checkpoints.size() * sizeof(int64_t) + __runEnds.size() * sizeof(uint16_t);
+	}
+
+	int64_t QSegment::get(const std::size_t row) const
+	{
+		assert(row < __count);
+		switch (__encoding)
+		{
+		case QSegmentEncoding::FRAME_OF_REFERENCE:
+			return static_cast<int64_t>(__base + __unpack(row));
+		case QSegmentEncoding::DELTA:
+		{
+			uint64_t value = static_cast<uint64_t>(__checkpoints[row / CHECKPOINT]);
+			for (std::size_t i = row - row % CHECKPOINT + 1; i <= row; i++)
+			{
+				value += __base + __unpack(i);
+			}
+			return static_cast<int64_t>(value);
+		}
+		case QSegmentEncoding::RUN_LENGTH:
+			return static_cast<int64_t>(__base + __unpack(__findRun(row)));
+		}
+		return 0;
+	}
+
+	void QSegment::decode(const std::size_t first, const std::size_t count, void* values) const
+	{
+		assert(first + count <= __count);
+		switch (__encoding)
+		{
+		case QSegmentEncoding::FRAME_OF_REFERENCE:
+			for (std::size_t i = 0; i < count; i++)
+			{
+				storeValue(__type, __base + __unpack(first + i), values, i);
+			}
+			break;
+		case QSegmentEncoding::DELTA:
+		{
+			// the first value is summed up from its checkpoint, the others from it
+			uint64_t value = count > 0 ? static_cast<uint64_t>(get(first)) : 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				const std::size_t row = first + i;
+				if (i > 0)
+				{
+					value = row % CHECKPOINT == 0 ? static_cast<uint64_t>(__checkpoints[row / CHECKPOINT]) : value + __base + __unpack(row);
+				}
+				storeValue(__type, value, values, i);
+			}
+			break;
+		}
+		case QSegmentEncoding::RUN_LENGTH:
+		{
+			std::size_t run = count > 0 ? __findRun(first) : 0;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				if (first + i >= __runEnds[run])
+				{
+					run++;
+				}
+				storeValue(__type, __base + __unpack(run), values, i);
+			}
+			break;
+		}
+		}
+	}
+
+	std::size_t QSegment::select(const int64_t low, const int64_t high, uint64_t* bits) const
+	{
+		if (low > high)
+		{
+			return 0;
+		}
+
+		std::size_t selected = 0;
+		switch (__encoding)
+		{
+		case QSegmentEncoding::FRAME_OF_REFERENCE:
+		{
+			// the bounds are moved into the frame, so each packed offset is compared as it is
+			const int64_t minimum = static_cast<int64_t>(__base);
+			if (high < minimum)
+			{
+				return 0;
+			}
+			const uint64_t from = low <= minimum ? 0 : static_cast<uint64_t>(low) - __base;
+			const uint64_t span = static_cast<uint64_t>(high) - __base - from;
+			for (std::size_t i = 0; i < __count; i++)
+			{
+				const uint64_t match = __unpack(i) - from <= span;
+				bits[i >> 6] |= match << (i & 63);
+				selected += match;
+			}
+			break;
+		}
+		case QSegmentEncoding::DELTA:
+		{
+			int64_t values[CHECKPOINT];
+			for (std::size_t first = 0; first < __count; first += CHECKPOINT)
+			{
+				const std::size_t count = __count - first < CHECKPOINT ? __count - first : CHECKPOINT;
+				uint64_t value = static_cast<uint64_t>(__checkpoints[first / CHECKPOINT]);
+				values[0] = static_cast<int64_t>(value);
+				for (std::size_t i = 1; i < count; i++)
+				{
+					value += __base + __unpack(first + i);
+					values[i] = static_cast<int64_t>(value);
+				}
+				for (std::size_t i = 0; i < count; i++)
+				{
+					const uint64_t match = values[i] >= low && values[i] <= high;
+					bits[(first + i) >> 6] |= match << ((first + i) & 63);
+					selected += match;
+				}
+			}
+			break;
+		}
+		case QSegmentEncoding::RUN_LENGTH:
+		{
+			// a run is matched once and its rows set together
+			std::size_t row = 0;
+			for (std::size_t run = 0; run < __runEnds.size(); run++)
+			{
+				const std::size_t end = __runEnds[run];
+				const int64_t value = static_cast<int64_t>(__base + __unpack(run));
+				if (value >= low && value <= high)
+				{
+					selected += end - row;
+					for (; row < end && (row & 63) != 0; row++)
+					{
+						bits[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					}
+					for (; row + 64 <= end; row += 64)
+					{
+						bits[row >> 6] = ~static_cast<uint64_t>(0);
+					}
+					for (; row < end; row++)
+					{
+						bits[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					}
+				}
+				row = end;
+			}
+			break;
+		}
+		}
+		return selected;
+	}
+
+	inline uint64_t QSegment::__unpack(const std::size_t index) const
+	{
+		if (__width == 0)
+		{
+			return 0;
+		}
+		const std::size_t bit = index * __width;
+		const std::size_t word = bit >> 6;
+		const unsigned shift = bit & 63;
+		uint64_t value = __packed[word] >> shift;
+		if (shift + __width > 64)
+		{
+			value |= __packed[word + 1] << (64 - shift);
+		}
+		return __width == 64 ? value : value & ((static_cast<uint64_t>(1) << __width) - 1);
+	}
+
+	void QSegment::__pack(const std::size_t index, const uint64_t value)
+	{
+		if (__width == 0)
+		{
+			return;
+		}
+		const std::size_t bit = index * __width;
+		const std::size_t word = bit >> 6;
+		const unsigned shift = bit & 63;
+		__packed[word] |= value << shift;
+		if (shift + __width > 64)
+		{
+			__packed[word + 1] |= value >> (64 - shift);
+		}
+	}
+
+	std::size_t QSegment::__findRun(const std::size_t row) const
+	{
+		// the first run ending after row
+		std::size_t low = 0;
+		std::size_t high = __runEnds.size();
+		while (low < high)
+		{
+			const std::size_t middle = (low + high) / 2;
+			if (__runEnds[middle] <= row)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return low;
+	}
+}
@@ -0,0 +1,899 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qsimd.h"
+
+#if defined ( __x86_64__ ) || defined ( _M_X64 ) || defined ( __i386__ ) || defined ( _M_IX86 )
+#define QSQL_X86 1
+#include <immintrin.h>
+#if defined ( _MSC_VER )
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#include <atomic>
+
+#if defined ( _MSC_VER )
+#define QSQL_TARGET_SSE2
+#define QSQL_TARGET_AVX2
+#else
+#define QSQL_TARGET_SSE2 __attribute__((target("sse2")))
+#define QSQL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace qsql
+{
+	namespace
+	{
+		QSimdLevel detectSimdLevel()
+		{
+#if defined ( QSQL_X86 )
+			unsigned int registers[4] = { 0, 0, 0, 0 };
+#if defined ( _MSC_VER )
+			int info[4];
+			__cpuid(info, 0);
+			const int leaves = info[0];
+			__cpuidex(info, 1, 0);
+			const bool sse2 = (info[3] & (1 << 26)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (leaves >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				registers[1] = static_cast<unsigned int>(info[1]);
+			}
+#else
+			const unsigned int leaves = __get_cpuid_max(0, nullptr);
+			__get_cpuid_count(1, 0, &registers[0], &registers[1], &registers[2], &registers[3]);
+			const bool sse2 = (registers[3] & (1u << 26)) != 0;
+			const bool osxsave = (registers[2] & (1u << 27)) != 0;
+			const bool avx = (registers[2] & (1u << 28)) != 0;
+			registers[1] = 0;
+			if (leaves >= 7)
+			{
+				__get_cpuid_count(7, 0, &registers[0], &registers[1], &registers[2], &registers[3]);
+			}
+#endif
+			const QSimdLevel fallback = sse2 ? QSimdLevel::SSE2 : QSimdLevel::SCALAR;
+			const bool avx2 = (registers[1] & (1u << 5)) != 0;
+			if (!osxsave || !avx || !avx2)
+			{
+				return fallback;
+			}
+
+			// the operating system has to save the upper halves of the ymm registers
+#if defined ( _MSC_VER )
+			const unsigned long long xcr0 = _xgetbv(0);
+#else
+			unsigned int eax;
+			unsigned int edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			const unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+			return (xcr0 & 0x6) == 0x6 ? QSimdLevel::AVX2 : fallback;
+#else
+			return QSimdLevel::SCALAR;
+#endif
+		}
+
+		QSimdLevel detectedLevel()
+		{
+			static const QSimdLevel level = detectSimdLevel();
+			return level;
+		}
+
+		// read by kernels on any thread, so it is atomic, though no other memory
+		// is ordered by it
+		std::atomic<QSimdLevel>& activeLevel()
+		{
+			static std::atomic<QSimdLevel> level(detectedLevel());
+			return level;
+		}
+
+		inline QSimdLevel currentLevel()
+		{
+			return activeLevel().load(std::memory_order_relaxed);
+		}
+
+		inline std::size_t countTrailingZeros(const uint64_t word)
+		{
+#if defined ( _MSC_VER )
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return index;
+#else
+			return static_cast<std::size_t>(__builtin_ctzll(word));
+#endif
+		}
+
+		inline std::size_t popCount(const uint64_t word)
+		{
+#if defined ( _MSC_VER )
+			return static_cast<std::size_t>(__popcnt64(word));
+#else
+			return static_cast<std::size_t>(__builtin_popcountll(word));
+#endif
+		}
+
+		template<typename T, typename Predicate>
+		void filterScalar(const T* values, const std::size_t count, Predicate predicate, uint64_t* bitmap)
+		{
+			const std::size_t words = (count + 63) / 64;
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const std::size_t first = word * 64;
+				const std::size_t last = count - first < 64 ? count - first : 64;
+				uint64_t bits = 0;
+				for (std::size_t i = 0; i < last; i++)
+				{
+					bits |= static_cast<uint64_t>(predicate(values[first + i])) << i;
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		template<typename T>
+		void filterCompareScalar(const QComparison op, const T* values, const std::size_t count, const T constant, uint64_t* bitmap)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				filterScalar(values, count, [constant](const T value) { return value == constant; }, bitmap);
+				break;
+			case QComparison::NOT_EQUAL:
+				filterScalar(values, count, [constant](const T value) { return value != constant; }, bitmap);
+				break;
+			case QComparison::LESS:
+				filterScalar(values, count, [constant](const T value) { return value < constant; }, bitmap);
+				break;
+			case QComparison::LESS_EQUAL:
+				filterScalar(values, count, [constant](const T value) { return value <= constant; }, bitmap);
+				break;
+			case QComparison::GREATER:
+				filterScalar(values, count, [constant](const T value) { return value > constant; }, bitmap);
+				break;
+			case QComparison::GREATER_EQUAL:
+				filterScalar(values, count, [constant](const T value) { return value >= constant; }, bitmap);
+				break;
+			}
+		}
+
+		template<typename T>
+		void filterBetweenScalar(const T* values, const std::size_t count, const T low, const T high, uint64_t* bitmap)
+		{
+			filterScalar(values, count, [low, high](const T value) { return (value >= low) & (value <= high); }, bitmap);
+		}
+
+		template<typename T>
+		void filterInScalar(const T* values, const std::size_t count, const T* list, const std::size_t listSize, uint64_t* bitmap)
+		{
+			filterScalar(values, count, [list, listSize](const T value)
+			{
+				bool found = false;
+				for (std::size_t i = 0; i < listSize; i++)
+				{
+					found |= value == list[i];
+				}
+				return found;
+			}, bitmap);
+		}
+
+		// Odd multipliers that spread the low 32 bits of a hash over the words of
+		// a Bloom filter block, the top 6 bits of each product pick a word's bit
+		constexpr uint32_t BLOOM_SALTS[BLOOM_BLOCK_WORDS] =
+		{
+			0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+			0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u,
+		};
+
+		inline const uint64_t* bloomBlock(const uint64_t* blocks, const std::size_t blockCount, const uint64_t hash)
+		{
+			return blocks + ((hash >> 32) * blockCount >> 32) * BLOOM_BLOCK_WORDS;
+		}
+
+		inline uint64_t bloomBit(const uint64_t hash, const std::size_t word)
+		{
+			return static_cast<uint64_t>(1) << ((static_cast<uint32_t>(hash) * BLOOM_SALTS[word]) >> 26);
+		}
+
+		void filterBloomScalar(const uint64_t* blocks, const std::size_t blockCount, const uint64_t* hashes, const std::size_t count, uint64_t* bitmap)
+		{
+			filterScalar(hashes, count, [blocks, blockCount](const uint64_t hash) { return bloomContains(blocks, blockCount, hash); }, bitmap);
+		}
+
+#if defined ( QSQL_X86 )
+		// EQUAL, LESS and GREATER map onto a single compare, the remaining
+		// comparisons are computed as the complement of one of them
+		inline bool isInverted(const QComparison op)
+		{
+			return op == QComparison::NOT_EQUAL || op == QComparison::LESS_EQUAL || op == QComparison::GREATER_EQUAL;
+		}
+
+		QSQL_TARGET_AVX2 inline __m256i compare32(const QComparison op, const __m256i values, const __m256i constant)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+			case QComparison::NOT_EQUAL:
+				return _mm256_cmpeq_epi32(values, constant);
+			case QComparison::LESS:
+			case QComparison::GREATER_EQUAL:
+				return _mm256_cmpgt_epi32(constant, values);
+			default:
+				return _mm256_cmpgt_epi32(values, constant);
+			}
+		}
+
+		QSQL_TARGET_AVX2 inline __m256i compare64(const QComparison op, const __m256i values, const __m256i constant)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+			case QComparison::NOT_EQUAL:
+				return _mm256_cmpeq_epi64(values, constant);
+			case QComparison::LESS:
+			case QComparison::GREATER_EQUAL:
+				return _mm256_cmpgt_epi64(constant, values);
+			default:
+				return _mm256_cmpgt_epi64(values, constant);
+			}
+		}
+
+		QSQL_TARGET_AVX2 inline uint64_t mask32(const __m256i mask)
+		{
+			return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+		}
+
+		QSQL_TARGET_AVX2 inline uint64_t mask64(const __m256i mask)
+		{
+			return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+		}
+
+		template<QComparison Op>
+		QSQL_TARGET_AVX2 void filterCompareAvx2(const int32_t* values, const std::size_t words, const int32_t constant, uint64_t* bitmap)
+		{
+			const __m256i broadcast = _mm256_set1_epi32(constant);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 8; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 8));
+					bits |= mask32(compare32(Op, block, broadcast)) << (lane * 8);
+				}
+				bitmap[word] = isInverted(Op) ? ~bits : bits;
+			}
+		}
+
+		template<QComparison Op>
+		QSQL_TARGET_AVX2 void filterCompareAvx2(const int64_t* values, const std::size_t words, const int64_t constant, uint64_t* bitmap)
+		{
+			const __m256i broadcast = _mm256_set1_epi64x(constant);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 4));
+					bits |= mask64(compare64(Op, block, broadcast)) << (lane * 4);
+				}
+				bitmap[word] = isInverted(Op) ? ~bits : bits;
+			}
+		}
+
+		template<typename T>
+		QSQL_TARGET_AVX2 void filterCompareAvx2(const QComparison op, const T* values, const std::size_t words, const T constant, uint64_t* bitmap)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				filterCompareAvx2<QComparison::EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::NOT_EQUAL:
+				filterCompareAvx2<QComparison::NOT_EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::LESS:
+				filterCompareAvx2<QComparison::LESS>(values, words, constant, bitmap);
+				break;
+			case QComparison::LESS_EQUAL:
+				filterCompareAvx2<QComparison::LESS_EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::GREATER:
+				filterCompareAvx2<QComparison::GREATER>(values, words, constant, bitmap);
+				break;
+			case QComparison::GREATER_EQUAL:
+				filterCompareAvx2<QComparison::GREATER_EQUAL>(values, words, constant, bitmap);
+				break;
+			}
+		}
+
+		QSQL_TARGET_AVX2 void filterBetweenAvx2(const int32_t* values, const std::size_t words, const int32_t low, const int32_t high, uint64_t* bitmap)
+		{
+			const __m256i lower = _mm256_set1_epi32(low);
+			const __m256i upper = _mm256_set1_epi32(high);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t outside = 0;
+				for (std::size_t lane = 0; lane < 8; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 8));
+					const __m256i mask = _mm256_or_si256(_mm256_cmpgt_epi32(lower, block), _mm256_cmpgt_epi32(block, upper));
+					outside |= mask32(mask) << (lane * 8);
+				}
+				bitmap[word] = ~outside;
+			}
+		}
+
+		QSQL_TARGET_AVX2 void filterBetweenAvx2(const int64_t* values, const std::size_t words, const int64_t low, const int64_t high, uint64_t* bitmap)
+		{
+			const __m256i lower = _mm256_set1_epi64x(low);
+			const __m256i upper = _mm256_set1_epi64x(high);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t outside = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 4));
+					const __m256i mask = _mm256_or_si256(_mm256_cmpgt_epi64(lower, block), _mm256_cmpgt_epi64(block, upper));
+					outside |= mask64(mask) << (lane * 4);
+				}
+				bitmap[word] = ~outside;
+			}
+		}
+
+		QSQL_TARGET_AVX2 void filterInAvx2(const int32_t* values, const std::size_t words, const int32_t* list, const std::size_t listSize, uint64_t* bitmap)
+		{
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 8; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 8));
+					__m256i mask = _mm256_setzero_si256();
+					for (std::size_t i = 0; i < listSize; i++)
+					{
+						mask = _mm256_or_si256(mask, _mm256_cmpeq_epi32(block, _mm256_set1_epi32(list[i])));
+					}
+					bits |= mask32(mask) << (lane * 8);
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		QSQL_TARGET_AVX2 void filterInAvx2(const int64_t* values, const std::size_t words, const int64_t* list, const std::size_t listSize, uint64_t* bitmap)
+		{
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + lane * 4));
+					__m256i mask = _mm256_setzero_si256();
+					for (std::size_t i = 0; i < listSize; i++)
+					{
+						mask = _mm256_or_si256(mask, _mm256_cmpeq_epi64(block, _mm256_set1_epi64x(list[i])));
+					}
+					bits |= mask64(mask) << (lane * 4);
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		QSQL_TARGET_AVX2 void filterBoolAvx2(const bool* values, const std::size_t words, const bool constant, uint64_t* bitmap)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const bool* base = values + word * 64;
+				const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base));
+				const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + 32));
+				const uint64_t falses = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, zero)))
+					| (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, zero)))) << 32);
+				bitmap[word] = constant ? ~falses : falses;
+			}
+		}
+
+		// The 8 products of a hash with the salts are shifted into bit indexes
+		// and widened to 64 bits, each half of the block is then tested against
+		// the bits it needs with one testc
+		QSQL_TARGET_AVX2 void filterBloomAvx2(const uint64_t* blocks, const std::size_t blockCount, const uint64_t* hashes, const std::size_t words, uint64_t* bitmap)
+		{
+			const __m256i salts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(BLOOM_SALTS));
+			const __m256i one = _mm256_set1_epi64x(1);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const uint64_t* base = hashes + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t i = 0; i < 64; i++)
+				{
+					const uint64_t hash = base[i];
+					const uint64_t* block = bloomBlock(blocks, blockCount, hash);
+					const __m256i product = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(hash)), salts);
+					const __m256i indexes = _mm256_srli_epi32(product, 26);
+					const __m256i low = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(indexes)));
+					const __m256i high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(indexes, 1)));
+					const int found = _mm256_testc_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), low)
+						& _mm256_testc_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 4)), high);
+					bits |= static_cast<uint64_t>(found) << i;
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		// SSE2 has no 64-bit compares, they are built from 32-bit ones.  Equal
+		// halves make equal values, and a value is greater if its high half is,
+		// or if the high halves are equal and the low half is as unsigned.
+		QSQL_TARGET_SSE2 inline __m128i equal64(const __m128i left, const __m128i right)
+		{
+			const __m128i halves = _mm_cmpeq_epi32(left, right);
+			return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+		}
+
+		QSQL_TARGET_SSE2 inline __m128i greater64(const __m128i left, const __m128i right)
+		{
+			const __m128i sign = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+			const __m128i high = _mm_cmpgt_epi32(left, right);
+			const __m128i low = _mm_cmpgt_epi32(_mm_xor_si128(left, sign), _mm_xor_si128(right, sign));
+			const __m128i equal = _mm_cmpeq_epi32(left, right);
+			const __m128i result = _mm_or_si128(high, _mm_and_si128(equal, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 2, 0, 0))));
+			return _mm_shuffle_epi32(result, _MM_SHUFFLE(3, 3, 1, 1));
+		}
+
+		QSQL_TARGET_SSE2 inline __m128i compare32(const QComparison op, const __m128i values, const __m128i constant)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+			case QComparison::NOT_EQUAL:
+				return _mm_cmpeq_epi32(values, constant);
+			case QComparison::LESS:
+			case QComparison::GREATER_EQUAL:
+				return _mm_cmpgt_epi32(constant, values);
+			default:
+				return _mm_cmpgt_epi32(values, constant);
+			}
+		}
+
+		QSQL_TARGET_SSE2 inline __m128i compare64(const QComparison op, const __m128i values, const __m128i constant)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+			case QComparison::NOT_EQUAL:
+				return equal64(values, constant);
+			case QComparison::LESS:
+			case QComparison::GREATER_EQUAL:
+				return greater64(constant, values);
+			default:
+				return greater64(values, constant);
+			}
+		}
+
+		QSQL_TARGET_SSE2 inline uint64_t mask32(const __m128i mask)
+		{
+			return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+		}
+
+		QSQL_TARGET_SSE2 inline uint64_t mask64(const __m128i mask)
+		{
+			return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+		}
+
+		template<QComparison Op>
+		QSQL_TARGET_SSE2 void filterCompareSse2(const int32_t* values, const std::size_t words, const int32_t constant, uint64_t* bitmap)
+		{
+			const __m128i broadcast = _mm_set1_epi32(constant);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 4));
+					bits |= mask32(compare32(Op, block, broadcast)) << (lane * 4);
+				}
+				bitmap[word] = isInverted(Op) ? ~bits : bits;
+			}
+		}
+
+		template<QComparison Op>
+		QSQL_TARGET_SSE2 void filterCompareSse2(const int64_t* values, const std::size_t words, const int64_t constant, uint64_t* bitmap)
+		{
+			const __m128i broadcast = _mm_set1_epi64x(constant);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 32; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 2));
+					bits |= mask64(compare64(Op, block, broadcast)) << (lane * 2);
+				}
+				bitmap[word] = isInverted(Op) ? ~bits : bits;
+			}
+		}
+
+		template<typename T>
+		QSQL_TARGET_SSE2 void filterCompareSse2(const QComparison op, const T* values, const std::size_t words, const T constant, uint64_t* bitmap)
+		{
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				filterCompareSse2<QComparison::EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::NOT_EQUAL:
+				filterCompareSse2<QComparison::NOT_EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::LESS:
+				filterCompareSse2<QComparison::LESS>(values, words, constant, bitmap);
+				break;
+			case QComparison::LESS_EQUAL:
+				filterCompareSse2<QComparison::LESS_EQUAL>(values, words, constant, bitmap);
+				break;
+			case QComparison::GREATER:
+				filterCompareSse2<QComparison::GREATER>(values, words, constant, bitmap);
+				break;
+			case QComparison::GREATER_EQUAL:
+				filterCompareSse2<QComparison::GREATER_EQUAL>(values, words, constant, bitmap);
+				break;
+			}
+		}
+
+		QSQL_TARGET_SSE2 void filterBetweenSse2(const int32_t* values, const std::size_t words, const int32_t low, const int32_t high, uint64_t* bitmap)
+		{
+			const __m128i lower = _mm_set1_epi32(low);
+			const __m128i upper = _mm_set1_epi32(high);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t outside = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 4));
+					const __m128i mask = _mm_or_si128(_mm_cmpgt_epi32(lower, block), _mm_cmpgt_epi32(block, upper));
+					outside |= mask32(mask) << (lane * 4);
+				}
+				bitmap[word] = ~outside;
+			}
+		}
+
+		QSQL_TARGET_SSE2 void filterBetweenSse2(const int64_t* values, const std::size_t words, const int64_t low, const int64_t high, uint64_t* bitmap)
+		{
+			const __m128i lower = _mm_set1_epi64x(low);
+			const __m128i upper = _mm_set1_epi64x(high);
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t outside = 0;
+				for (std::size_t lane = 0; lane < 32; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 2));
+					const __m128i mask = _mm_or_si128(greater64(lower, block), greater64(block, upper));
+					outside |= mask64(mask) << (lane * 2);
+				}
+				bitmap[word] = ~outside;
+			}
+		}
+
+		QSQL_TARGET_SSE2 void filterInSse2(const int32_t* values, const std::size_t words, const int32_t* list, const std::size_t listSize, uint64_t* bitmap)
+		{
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int32_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 16; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 4));
+					__m128i mask = _mm_setzero_si128();
+					for (std::size_t i = 0; i < listSize; i++)
+					{
+						mask = _mm_or_si128(mask, _mm_cmpeq_epi32(block, _mm_set1_epi32(list[i])));
+					}
+					bits |= mask32(mask) << (lane * 4);
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		QSQL_TARGET_SSE2 void filterInSse2(const int64_t* values, const std::size_t words, const int64_t* list, const std::size_t listSize, uint64_t* bitmap)
+		{
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const int64_t* base = values + word * 64;
+				uint64_t bits = 0;
+				for (std::size_t lane = 0; lane < 32; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 2));
+					__m128i mask = _mm_setzero_si128();
+					for (std::size_t i = 0; i < listSize; i++)
+					{
+						mask = _mm_or_si128(mask, equal64(block, _mm_set1_epi64x(list[i])));
+					}
+					bits |= mask64(mask) << (lane * 2);
+				}
+				bitmap[word] = bits;
+			}
+		}
+
+		QSQL_TARGET_SSE2 void filterBoolSse2(const bool* values, const std::size_t words, const bool constant, uint64_t* bitmap)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			for (std::size_t word = 0; word < words; word++)
+			{
+				const bool* base = values + word * 64;
+				uint64_t falses = 0;
+				for (std::size_t lane = 0; lane < 4; lane++)
+				{
+					const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + lane * 16));
+					falses |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)))) << (lane * 16);
+				}
+				bitmap[word] = constant ? ~falses : falses;
+			}
+		}
+#endif
+	}
+
+	QSimdLevel getSimdLevel()
+	{
+		return currentLevel();
+	}
+
+	void setSimdLevel(const QSimdLevel level)
+	{
+		if (static_cast<int>(level) <= static_cast<int>(detectedLevel()))
+		{
+			activeLevel().store(level, std::memory_order_relaxed);
+		}
+	}
+
+	void filterCompare(const QComparison op, const int32_t* values, const std::size_t count, const int32_t constant, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterCompareAvx2(op, values, done, constant, bitmap);
+			}
+			else
+			{
+				filterCompareSse2(op, values, done, constant, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterCompareScalar(op, values + done, count - done, constant, bitmap + done / 64);
+	}
+
+	void filterCompare(const QComparison op, const int64_t* values, const std::size_t count, const int64_t constant, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterCompareAvx2(op, values, done, constant, bitmap);
+			}
+			else
+			{
+				filterCompareSse2(op, values, done, constant, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterCompareScalar(op, values + done, count - done, constant, bitmap + done / 64);
+	}
+
+	void filterBetween(const int32_t* values, const std::size_t count, const int32_t low, const int32_t high, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterBetweenAvx2(values, done, low, high, bitmap);
+			}
+			else
+			{
+				filterBetweenSse2(values, done, low, high, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterBetweenScalar(values + done, count - done, low, high, bitmap + done / 64);
+	}
+
+	void filterBetween(const int64_t* values, const std::size_t count, const int64_t low, const int64_t high, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterBetweenAvx2(values, done, low, high, bitmap);
+			}
+			else
+			{
+				filterBetweenSse2(values, done, low, high, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterBetweenScalar(values + done, count - done, low, high, bitmap + done / 64);
+	}
+
+	void filterIn(const int32_t* values, const std::size_t count, const int32_t* list, const std::size_t listSize, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterInAvx2(values, done, list, listSize, bitmap);
+			}
+			else
+			{
+				filterInSse2(values, done, list, listSize, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterInScalar(values + done, count - done, list, listSize, bitmap + done / 64);
+	}
+
+	void filterIn(const int64_t* values, const std::size_t count, const int64_t* list, const std::size_t listSize, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterInAvx2(values, done, list, listSize, bitmap);
+			}
+			else
+			{
+				filterInSse2(values, done, list, listSize, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterInScalar(values + done, count - done, list, listSize, bitmap + done / 64);
+	}
+
+	void filterBool(const bool* values, const std::size_t count, const bool constant, uint64_t* bitmap)
+	{
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		const QSimdLevel level = currentLevel();
+		if (level != QSimdLevel::SCALAR)
+		{
+			done = count / 64;
+			if (level == QSimdLevel::AVX2)
+			{
+				filterBoolAvx2(values, done, constant, bitmap);
+			}
+			else
+			{
+				filterBoolSse2(values, done, constant, bitmap);
+			}
+			done *= 64;
+		}
+#endif
+		filterScalar(values + done, count - done, [constant](const bool value) { return value == constant; }, bitmap + done / 64);
+	}
+
+	void bloomInsert(uint64_t* blocks, const std::size_t blockCount, const uint64_t hash)
+	{
+		uint64_t* block = const_cast<uint64_t*>(bloomBlock(blocks, blockCount, hash));
+		for (std::size_t word = 0; word < BLOOM_BLOCK_WORDS; word++)
+		{
+			block[word] |= bloomBit(hash, word);
+		}
+	}
+
+	bool bloomContains(const uint64_t* blocks, const std::size_t blockCount, const uint64_t hash)
+	{
+		const uint64_t* block = bloomBlock(blocks, blockCount, hash);
+		uint64_t missing = 0;
+		for (std::size_t word = 0; word < BLOOM_BLOCK_WORDS; word++)
+		{
+			missing |= bloomBit(hash, word) & ~block[word];
+		}
+		return missing == 0;
+	}
+
+	void filterBloom(const uint64_t* blocks, const std::size_t blockCount, const uint64_t* hashes, const std::size_t count, uint64_t* bitmap)
+	{
+		// SSE2 has neither 32-bit multiplies nor variable shifts, the scalar
+		// probe serves it
+		std::size_t done = 0;
+#if defined ( QSQL_X86 )
+		if (currentLevel() == QSimdLevel::AVX2)
+		{
+			done = count / 64;
+			filterBloomAvx2(blocks, blockCount, hashes, done, bitmap);
+			done *= 64;
+		}
+#endif
+		filterBloomScalar(blocks, blockCount, hashes + done, count - done, bitmap + done / 64);
+	}
+
+	void bitmapAnd(uint64_t* destination, const uint64_t* source, const std::size_t words)
+	{
+		for (std::size_t i = 0; i < words; i++)
+		{
+			destination[i] &= source[i];
+		}
+	}
+
+	void bitmapOr(uint64_t* destination, const uint64_t* source, const std::size_t words)
+	{
+		for (std::size_t i = 0; i < words; i++)
+		{
+			destination[i] |= source[i];
+		}
+	}
+
+	void bitmapAndNot(uint64_t* destination, const uint64_t* source, const std::size_t words)
+	{
+		for (std::size_t i = 0; i < words; i++)
+		{
+			destination[i] &= ~source[i];
+		}
+	}
+
+	std::size_t bitmapCount(const uint64_t* bitmap, const std::size_t words)
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < words; i++)
+		{
+			count += popCount(bitmap[i]);
+		}
+		return count;
+	}
+
+	std::size_t bitmapToSelection(const uint64_t* bitmap, const std::size_t count, uint16_t* selection)
+	{
+		std::size_t selected = 0;
+		const std::size_t words = (count + 63) / 64;
+		for (std::size_t word = 0; word < words; word++)
+		{
+			uint64_t bits = bitmap[word];
+			if (word == words - 1 && (count & 63) != 0)
+			{
+				bits &= (static_cast<uint64_t>(1) << (count & 63)) - 1;
+			}
+			while (bits)
+			{
+				selection[selected++] = static_cast<uint16_t>(word * 64 + countTrailingZeros(bits));
+				bits &= bits - 1;
+			}
+		}
+		return selected;
+	}
+}
@@ -0,0 +1,164 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qstatement.h"
+#include "qsql/qdatabase.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace qsql
+{
+	QStatement::QStatement()
+		: __database(nullptr), __plan(nullptr)
+	{
+		snprintf(__error, ERROR_LENGTH, "statement was not prepared");
+	}
+
+	QStatement::QStatement(QDatabase* database, QPlan* plan, const char* error)
+		: __database(database), __plan(plan)
+	{
+		snprintf(__error, ERROR_LENGTH, "%s", error ? error : "");
+	}
+
+	QStatement::QStatement(QStatement&& other) noexcept
+		: __database(other.__database), __plan(other.__plan)
+	{
+		memcpy(__error, other.__error, ERROR_LENGTH);
+		other.__plan = nullptr;
+	}
+
+	QStatement::~QStatement()
+	{
+		__release();
+	}
+
+	QStatement& QStatement::operator=(QStatement&& other) noexcept
+	{
+		if (this != &other)
+		{
+			__release();
+			__database = other.__database;
+			__plan = other.__plan;
+			memcpy(__error, other.__error, ERROR_LENGTH);
+			other.__plan = nullptr;
+		}
+		return *this;
+	}
+
+	bool QStatement::isValid() const
+	{
+		return __plan != nullptr;
+	}
+
+	const char* QStatement::getError() const
+	{
+		return (__error[0] == '\0' && __plan) ? __plan->getError() : __error;
+	}
+
+	std::size_t QStatement::getParameterCount() const
+	{
+		return __plan ? __plan->getParameterCount() : 0;
+	}
+
+	QDataType QStatement::getParameterType(const std::size_t parameter) const
+	{
+		return __plan->getParameterType(parameter);
+	}
+
+	bool QStatement::setNull(const std::size_t parameter)
+	{
+		return __set(parameter, QValue());
+	}
+
+	bool QStatement::setChar(const std::size_t parameter, const char value)
+	{
+		return __set(parameter, QValue(value));
+	}
+
+	bool QStatement::setInt(const std::size_t parameter, const int32_t value)
+	{
+		return __set(parameter, QValue(value));
+	}
+
+	bool QStatement::setLong(const std::size_t parameter, const int64_t value)
+	{
+		return __set(parameter, QValue(value));
+	}
+
+	bool QStatement::setBool(const std::size_t parameter, const bool value)
+	{
+		return __set(parameter, QValue(value));
+	}
+
+	bool QStatement::setString(const std::size_t parameter, const qtl::string& value)
+	{
+		return __set(parameter, QValue(value));
+	}
+
+	void QStatement::clearParameters()
+	{
+		if (__plan)
+		{
+			__plan->clearParameters();
+		}
+	}
+
+	bool QStatement::execute()
+	{
+		if (__plan == nullptr)
+		{
+			return false;
+		}
+		if (__plan->getVersion() != __database->getVersion())
+		{
+			snprintf(__error, ERROR_LENGTH, "a table was dropped since the statement was prepared");
+			return false;
+		}
+		__error[0] = '\0';
+		return __plan->execute(__database->getLog(), __database->isLogSynchronous());
+	}
+
+	std::size_t QStatement::getAffectedRows() const
+	{
+		return __plan ? __plan->getAffectedRows() : 0;
+	}
+
+	uint64_t QStatement::getLogPosition() const
+	{
+		return __plan ? __plan->getLogPosition() : 0;
+	}
+
+	std::size_t QStatement::getColumnCount() const
+	{
+		return __plan ? __plan->getColumnCount() : 0;
+	}
+
+	QDataType QStatement::getColumnType(const std::size_t column) const
+	{
+		return __plan->getColumnType(column);
+	}
+
+	const qtl::string& QStatement::getColumnName(const std::size_t column) const
+	{
+		return __plan->getColumnName(column);
+	}
+
+	QBatch* QStatement::next()
+	{
+		return __plan ? __plan->next() : nullptr;
+	}
+
+	bool QStatement::__set(const std::size_t parameter, const QValue& value)
+	{
+		return __plan && __plan->setParameter(parameter, value);
+	}
+
+	void QStatement::__release()
+	{
+		if (__plan)
+		{
+			__database->__release(__plan);
+			__plan = nullptr;
+		}
+	}
+}
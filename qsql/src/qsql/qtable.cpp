@@ -1,24 +1,1490 @@
+#include "qsql/qsql.h"
+
 #include "qsql/qtable.h"
+#include "qsql/qsimd.h"
+#include "qsql/qtablefile.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 namespace qsql
 {
+	namespace
+	{
+		QValue fieldValue(QField field)
+		{
+			if (field.isNull())
+			{
+				return QValue();
+			}
+			switch (field.getType())
+			{
+			case QDataType::CHAR:
+				return QValue(field.get<char>());
+			case QDataType::INT:
+				return QValue(field.get<int32_t>());
+			case QDataType::LONG:
+				return QValue(field.get<int64_t>());
+			case QDataType::BOOL:
+				return QValue(field.get<bool>());
+			case QDataType::STRING:
+				return QValue(field.get<qtl::string>());
+			}
+			return QValue();
+		}
+
+		// Value of a column of type as a zone map bounds it, false for a STRING
+		bool zoneKey(const QDataType type, const QValue& value, int64_t& key)
+		{
+			switch (type)
+			{
+			case QDataType::CHAR:
+			{
+				char stored = 0;
+				value.store(type, &stored);
+				key = stored;
+				return true;
+			}
+			case QDataType::INT:
+			{
+				int32_t stored = 0;
+				value.store(type, &stored);
+				key = stored;
+				return true;
+			}
+			case QDataType::LONG:
+				value.store(type, &key);
+				return true;
+			case QDataType::BOOL:
+			{
+				bool stored = false;
+				value.store(type, &stored);
+				key = stored;
+				return true;
+			}
+			case QDataType::STRING:
+				break;
+			}
+			return false;
+		}
+
+		inline bool isBounded(const QDataType type)
+		{
+			return type == QDataType::INT || type == QDataType::LONG;
+		}
+
+		// Values of an INT or LONG column that satisfy op against value, from low
+		// to high.  False if value is not an integer or op is not a range.
+		bool rangeOf(const QComparison op, const QValue& value, int64_t& low, int64_t& high)
+		{
+			if (value.isNull() || (value.getType() != QDataType::INT && value.getType() != QDataType::LONG) || op == QComparison::NOT_EQUAL)
+			{
+				return false;
+			}
+			const int64_t bound = value.getType() == QDataType::INT ? value.getInt() : value.getLong();
+			low = INT64_MIN;
+			high = INT64_MAX;
+			switch (op)
+			{
+			case QComparison::EQUAL:
+				low = bound;
+				high = bound;
+				break;
+			case QComparison::LESS:
+				// nothing lies below INT64_MIN, an empty range is low above high
+				low = bound == INT64_MIN ? INT64_MAX : low;
+				high = bound == INT64_MIN ? INT64_MIN : bound - 1;
+				break;
+			case QComparison::LESS_EQUAL:
+				high = bound;
+				break;
+			case QComparison::GREATER:
+				low = bound == INT64_MAX ? INT64_MAX : bound + 1;
+				high = bound == INT64_MAX ? INT64_MIN : high;
+				break;
+			case QComparison::GREATER_EQUAL:
+				low = bound;
+				break;
+			case QComparison::NOT_EQUAL:
+				break;
+			}
+			return true;
+		}
+	}
+
 	QField::QField(const QDataType type, void* value)
-		: __type(type), __value(value)
+		: __type(type), __value(value), __decoded(0), __held(false)
 	{
 	}
 
+	QField::QField(const QDataType type, const int64_t value)
+		: __type(type), __value(nullptr), __decoded(value), __held(true)
+	{
+		if (type == QDataType::INT)
+		{
+			const int32_t narrow = static_cast<int32_t>(value);
+			memcpy(&__decoded, &narrow, sizeof(narrow));
+		}
+	}
+
 	QDataType QField::getType() const
 	{
 		return __type;
 	}
 
-	QRow::QRow(const qtl::vector<QField>& fields, void* data)
-		: __fields(fields), __data(data)
+	bool QField::isNull() const
+	{
+		return __value == nullptr && !__held;
+	}
+
+	std::size_t QRow::getIndex() const
+	{
+		return __index;
+	}
+
+	QTable::QTable(const QSchema& schema, const QTableLayout layout, QVersionClock* clock)
+		: __schema(schema), __layout(layout), __rowCount(0), __storage(STORAGE_CHUNK_SIZE), __clock(clock), __ownClock(nullptr), __writing(false),
+		__committedRows(0), __mapping(nullptr), __mappingSize(0), __pool(nullptr), __poolFile(0), __erasedCount(0), __compressedChunks(0)
+	{
+		if (__clock == nullptr)
+		{
+			__ownClock = new QVersionClock();
+			__clock = __ownClock;
+		}
+
+		for (std::size_t i = 0; i < __schema.getColumnCount(); i++)
+		{
+			__hashIndexes.push_back(nullptr);
+			__btreeIndexes.push_back(nullptr);
+			__artIndexes.push_back(nullptr);
+			__bitmapIndexes.push_back(nullptr);
+			__bloomBits.push_back(0);
+			__dictionaries.push_back(__schema.getColumnEncoding(i) == QEncoding::DICTIONARY ? new QDictionary() : nullptr);
+		}
+
+		if (__layout == QTableLayout::COLUMN)
+		{
+			for (std::size_t i = 0; i < __schema.getColumnCount(); i++)
+			{
+				// compressed chunks release their plain values, so they cannot come from the arena
+				QArena* arena = __schema.getColumnEncoding(i) == QEncoding::COMPRESSED ? nullptr : &__storage;
+				__columns.push_back(new QColumn(__schema.getColumnType(i), __schema.isNullable(i), __dictionaries[i], arena));
+			}
+		}
+	}
+
+	QTable::~QTable()
+	{
+		for (std::size_t i = 0; i < __hashIndexes.size(); i++)
+		{
+			delete __hashIndexes[i];
+			delete __btreeIndexes[i];
+			delete __artIndexes[i];
+			delete __bitmapIndexes[i];
+		}
+		for (std::size_t i = 0; i < __blooms.size(); i++)
+		{
+			delete __blooms[i];
+		}
+
+		for (std::size_t column = 0; column < __schema.getColumnCount(); column++)
+		{
+			if (__layout != QTableLayout::ROW || __schema.getColumnType(column) != QDataType::STRING || __dictionaries[column])
+			{
+				continue;
+			}
+			const std::size_t offset = __schema.getColumnOffset(column);
+			for (std::size_t row = 0; row < __rowCount; row++)
+			{
+				reinterpret_cast<qtl::string*>(__rowData(row) + offset)->~string();
+			}
+		}
+
+		for (std::size_t i = 0; i < __columns.size(); i++)
+		{
+			delete __columns[i];
+		}
+
+		for (std::size_t i = 0; i < __dictionaries.size(); i++)
+		{
+			delete __dictionaries[i];
+		}
+
+		if (__mapping)
+		{
+			QTableFile::unmap(__mapping, __mappingSize);
+		}
+		if (__pool)
+		{
+			__pool->removeFile(__poolFile);
+		}
+
+		for (std::size_t i = 0; i < __versions.size(); i++)
+		{
+			free(__versions[i]);
+		}
+		for (const QStaleChunk& chunk : __staleChunks)
+		{
+			free(chunk.values);
+		}
+		delete __ownClock;
+	}
+
+	const QSchema& QTable::getSchema() const
+	{
+		return __schema;
+	}
+
+	QTableLayout QTable::getLayout() const
 	{
+		return __layout;
 	}
 
-	QField QRow::get(const size_t column) const
+	std::size_t QTable::getColumnCount() const
 	{
-		return __fields[column];
+		return __schema.getColumnCount();
+	}
+
+	std::size_t QTable::getRowCount() const
+	{
+		return __rowCount;
+	}
+
+	QDataType QTable::getColumnType(const std::size_t column) const
+	{
+		return __schema.getColumnType(column);
+	}
+
+	const QColumn& QTable::getColumn(const std::size_t column) const
+	{
+		assert(__layout == QTableLayout::COLUMN);
+		return *__columns[column];
+	}
+
+	QVersionClock& QTable::getClock() const
+	{
+		return *__clock;
+	}
+
+	void QTable::setClock(QVersionClock& clock)
+	{
+		assert(!__writing);
+		delete __ownClock;
+		__ownClock = nullptr;
+		__clock = &clock;
+	}
+
+	void QTable::beginWrite()
+	{
+		__writer.lock();
+		__writing = true;
+	}
+
+	void QTable::commit()
+	{
+		assert(__writing);
+		{
+			qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+			bool read = false;
+			const uint64_t timestamp = __clock->begin(read);
+
+			// without a snapshot in use only rows that already carry timestamps need them
+			for (std::size_t row = __committedRows; row < __rowCount; row++)
+			{
+				QVersion* version = __version(row, read);
+				if (version)
+				{
+					version->begin = timestamp;
+				}
+			}
+			for (const QRetired& retired : __retired)
+			{
+				const std::size_t row = retired.row;
+				QVersion* version = __version(row, read);
+				if (version)
+				{
+					version->end = timestamp;
+				}
+				__retiring[row >> 6] &= ~(static_cast<uint64_t>(1) << (row & 63));
+				__erased[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+				__erasedCount++;
+				if (read)
+				{
+					__garbage.push_back(row);
+				}
+				else
+				{
+					__unindexRow(row);
+				}
+			}
+			__committedRows = __rowCount;
+			__compress(timestamp, read);
+			__clock->end(timestamp);
+		}
+		__retired.clear();
+
+		if (__garbage.size() >= COLLECT_THRESHOLD)
+		{
+			__collect(__clock->getHorizon());
+		}
+		else if (!__staleChunks.empty())
+		{
+			__releaseChunks(__clock->getHorizon());
+		}
+		__writing = false;
+		__writer.unlock();
+	}
+
+	void QTable::abort()
+	{
+		assert(__writing);
+		{
+			qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+			for (std::size_t row = __committedRows; row < __rowCount; row++)
+			{
+				QVersion* version = __version(row, false);
+				if (version)
+				{
+					version->end = 0;
+				}
+				__erased[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+				__erasedCount++;
+				__unindexRow(row);
+			}
+			for (const QRetired& retired : __retired)
+			{
+				__retiring[retired.row >> 6] &= ~(static_cast<uint64_t>(1) << (retired.row & 63));
+			}
+			__committedRows = __rowCount;
+		}
+		__retired.clear();
+		__writing = false;
+		__writer.unlock();
+	}
+
+	std::size_t QTable::insert(const qtl::vector<QValue>& values)
+	{
+		if (!__validate(values))
+		{
+			return __rowCount;
+		}
+
+		const bool single = !__writing;
+		if (single)
+		{
+			beginWrite();
+		}
+		std::size_t row;
+		{
+			qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+			row = __append(values);
+		}
+		if (single)
+		{
+			commit();
+		}
+		return row;
+	}
+
+	bool QTable::canStore(const std::size_t column, const QValue& value) const
+	{
+		return __validate(column, value);
+	}
+
+	std::size_t QTable::update(const std::size_t row, const std::size_t column, const QValue& value)
+	{
+		assert(row < __rowCount);
+		if (!__validate(column, value))
+		{
+			return __rowCount;
+		}
+
+		const bool single = !__writing;
+		if (single)
+		{
+			beginWrite();
+		}
+		std::size_t target = __rowCount;
+		{
+			qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+			if (row >= __committedRows && !__isRetiring(row))
+			{
+				// no snapshot sees the write's own rows, they are changed in place
+				target = row;
+			}
+			else if (__isRetiring(row))
+			{
+				for (std::size_t i = __retired.size(); i-- > 0;)
+				{
+					if (__retired[i].row == row)
+					{
+						target = __retired[i].successor == row ? __rowCount : __retired[i].successor;
+						break;
+					}
+				}
+			}
+			else if (!isErased(row))
+			{
+				qtl::vector<QValue> values;
+				const QRow source = getRow(row);
+				for (std::size_t i = 0; i < __schema.getColumnCount(); i++)
+				{
+					values.push_back(fieldValue(source.get(i)));
+				}
+				target = __append(values);
+				__retire(row, target);
+			}
+
+			if (target < __rowCount)
+			{
+				__assign(target, column, value);
+			}
+		}
+		if (single)
+		{
+			commit();
+		}
+		return target;
+	}
+
+	bool QTable::erase(const std::size_t row)
+	{
+		assert(row < __rowCount);
+		const bool single = !__writing;
+		if (single)
+		{
+			beginWrite();
+		}
+		bool erased = false;
+		{
+			qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+			std::size_t target = row;
+			for (std::size_t i = __retired.size(); i-- > 0 && __isRetiring(row);)
+			{
+				if (__retired[i].row == row)
+				{
+					target = __retired[i].successor;
+					break;
+				}
+			}
+			if (!isErased(target) && !__isRetiring(target))
+			{
+				__retire(target, target);
+				erased = true;
+			}
+		}
+		if (single)
+		{
+			commit();
+		}
+		return erased;
+	}
+
+	bool QTable::isErased(const std::size_t row) const
+	{
+		return (__erased[row >> 6] >> (row & 63)) & 1;
+	}
+
+	std::size_t QTable::getErasedCount() const
+	{
+		return __erasedCount;
+	}
+
+	const uint64_t* QTable::getErased() const
+	{
+		return __erasedCount ? __erased.data() : nullptr;
+	}
+
+	bool QTable::isVisible(const std::size_t row, const uint64_t snapshot) const
+	{
+		if (row >= __committedRows)
+		{
+			return false;
+		}
+		const std::size_t page = row >> PAGE_SHIFT;
+		const QVersion* versions = page < __versions.size() ? __versions[page] : nullptr;
+		if (versions == nullptr)
+		{
+			return !isErased(row);
+		}
+		const QVersion& version = versions[row & (PAGE_ROWS - 1)];
+		return version.begin <= snapshot && version.end > snapshot;
+	}
+
+	bool QTable::getVisible(const std::size_t first, const std::size_t count, const uint64_t snapshot, uint64_t* live) const
+	{
+		assert((first & 63) == 0 && (first >> PAGE_SHIFT) == ((first + count - 1) >> PAGE_SHIFT));
+		const std::size_t page = first >> PAGE_SHIFT;
+		const QVersion* versions = page < __versions.size() ? __versions[page] : nullptr;
+		const std::size_t committed = __committedRows > first ? __committedRows - first : 0;
+		if (versions == nullptr && __erasedCount == 0 && committed >= count)
+		{
+			return false;
+		}
+
+		const std::size_t words = (count + 63) / 64;
+		for (std::size_t word = 0; word < words; word++)
+		{
+			uint64_t bits = 0;
+			if (versions == nullptr)
+			{
+				bits = ~__erased[(first >> 6) + word];
+			}
+			else
+			{
+				const QVersion* version = versions + ((first + word * 64) & (PAGE_ROWS - 1));
+				for (std::size_t i = 0; i < 64; i++)
+				{
+					bits |= static_cast<uint64_t>(version[i].begin <= snapshot && version[i].end > snapshot) << i;
+				}
+			}
+
+			// the rows of the write in progress are not visible to anyone else yet
+			const std::size_t begin = word * 64;
+			if (committed <= begin)
+			{
+				bits = 0;
+			}
+			else if (committed - begin < 64)
+			{
+				bits &= (static_cast<uint64_t>(1) << (committed - begin)) - 1;
+			}
+			live[word] = bits;
+		}
+		return true;
+	}
+
+	bool QTable::isOutside(const std::size_t page, const std::size_t column, const int64_t low, const int64_t high) const
+	{
+		const std::size_t columns = __schema.getColumnCount();
+		if (!isBounded(__schema.getColumnType(column)) || (page + 1) * columns > __zones.size())
+		{
+			return false;
+		}
+		const QZone& zone = __zones[page * columns + column];
+		const std::size_t first = page << PAGE_SHIFT;
+		const std::size_t rows = __rowCount - first < PAGE_ROWS ? __rowCount - first : PAGE_ROWS;
+		return low > high || zone.nulls == rows || zone.max < low || zone.min > high;
+	}
+
+	bool QTable::isAbsent(const std::size_t page, const std::size_t column, const uint64_t hash) const
+	{
+		const std::size_t slot = page * __schema.getColumnCount() + column;
+		return slot < __blooms.size() && __blooms[slot] && !__blooms[slot]->contains(hash);
+	}
+
+	qtl::shared_mutex& QTable::getLatch() const
+	{
+		return __latch;
+	}
+
+	void QTable::collect()
+	{
+		const uint64_t horizon = __clock->getHorizon();
+		qtl::unique_lock<qtl::mutex> lock(__writer);
+		__collect(horizon);
+	}
+
+	QRow QTable::getRow(const std::size_t row) const
+	{
+		if (__layout == QTableLayout::ROW)
+		{
+			return QRow(this, __rowData(row), row);
+		}
+		return QRow(this, nullptr, row);
+	}
+
+	bool QTable::isMapped() const
+	{
+		return __mapping != nullptr || __pool != nullptr;
+	}
+
+	QBufferPool* QTable::getBufferPool() const
+	{
+		return __pool;
+	}
+
+	const QDictionary* QTable::getDictionary(const std::size_t column) const
+	{
+		return __dictionaries[column];
+	}
+
+	uint32_t QTable::getCode(const std::size_t row, const std::size_t column) const
+	{
+		assert(__dictionaries[column]);
+		if (__layout == QTableLayout::COLUMN)
+		{
+			uint32_t code = 0;
+			const bool read = __columns[column]->read(row, &code);
+			assert(read);
+			(void)read;
+			return code;
+		}
+		return *reinterpret_cast<const uint32_t*>(__rowData(row) + __schema.getColumnOffset(column));
+	}
+
+	bool QTable::createHashIndex(const std::size_t column)
+	{
+		if (__hashIndexes[column] || !QHashIndex::isSupported(__schema.getColumnType(column)))
+		{
+			return false;
+		}
+
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		QHashIndex* index = new QHashIndex(*this, column);
+		for (std::size_t row = 0; row < __rowCount; row++)
+		{
+			if (!isErased(row))
+			{
+				index->insert(row);
+			}
+		}
+		__hashIndexes[column] = index;
+		return true;
+	}
+
+	const QHashIndex* QTable::getHashIndex(const std::size_t column) const
+	{
+		return __hashIndexes[column];
+	}
+
+	bool QTable::createBTreeIndex(const std::size_t column)
+	{
+		if (__btreeIndexes[column] || !QBTreeIndex::isSupported(__schema.getColumnType(column)))
+		{
+			return false;
+		}
+
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		QBTreeIndex* index = new QBTreeIndex(*this, column);
+		for (std::size_t row = 0; row < __rowCount; row++)
+		{
+			if (!isErased(row))
+			{
+				index->insert(row);
+			}
+		}
+		__btreeIndexes[column] = index;
+		return true;
+	}
+
+	const QBTreeIndex* QTable::getBTreeIndex(const std::size_t column) const
+	{
+		return __btreeIndexes[column];
+	}
+
+	bool QTable::createArtIndex(const std::size_t column)
+	{
+		if (__artIndexes[column] || !QArtIndex::isSupported(__schema.getColumnType(column)))
+		{
+			return false;
+		}
+
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		QArtIndex* index = new QArtIndex(*this, column);
+		for (std::size_t row = 0; row < __rowCount; row++)
+		{
+			if (!isErased(row))
+			{
+				index->insert(row);
+			}
+		}
+		__artIndexes[column] = index;
+		return true;
+	}
+
+	const QArtIndex* QTable::getArtIndex(const std::size_t column) const
+	{
+		return __artIndexes[column];
+	}
+
+	bool QTable::createBitmapIndex(const std::size_t column)
+	{
+		if (__bitmapIndexes[column] || !QBitmapIndex::isSupported(__schema.getColumnType(column)))
+		{
+			return false;
+		}
+
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		QBitmapIndex* index = new QBitmapIndex(*this, column);
+		for (std::size_t row = 0; row < __rowCount; row++)
+		{
+			if (!isErased(row))
+			{
+				index->insert(row);
+			}
+		}
+		index->optimize();
+		__bitmapIndexes[column] = index;
+		return true;
+	}
+
+	const QBitmapIndex* QTable::getBitmapIndex(const std::size_t column) const
+	{
+		return __bitmapIndexes[column];
+	}
+
+	bool QTable::createBloomFilter(const std::size_t column, const std::size_t bitsPerKey)
+	{
+		if (__bloomBits[column] || bitsPerKey == 0 || !QHashIndex::isSupported(__schema.getColumnType(column)))
+		{
+			return false;
+		}
+
+		// erased rows are added too, snapshots that still see them may look for them
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		__bloomBits[column] = bitsPerKey;
+		for (std::size_t row = 0; row < __rowCount; row++)
+		{
+			__addToBloom(row, column);
+		}
+		return true;
+	}
+
+	bool QTable::hasBloomFilter(const std::size_t column) const
+	{
+		return __bloomBits[column] != 0;
+	}
+
+	std::size_t QTable::filter(const std::size_t column, const QComparison op, const QValue& value, qtl::vector<uint64_t>& bitmap) const
+	{
+		if (op == QComparison::EQUAL && __hashIndexes[column])
+		{
+			bitmap.clear();
+			for (std::size_t i = 0; i < __erased.size(); i++)
+			{
+				bitmap.push_back(0);
+			}
+
+			qtl::vector<std::size_t> rows;
+			__hashIndexes[column]->find(value, rows);
+			std::size_t count = 0;
+			for (std::size_t row : rows)
+			{
+				if (__isCurrent(row))
+				{
+					bitmap[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+					count++;
+				}
+			}
+			return count;
+		}
+
+		const QBitmapIndex* rows = __bitmapIndexes[column];
+		if ((op == QComparison::EQUAL || op == QComparison::NOT_EQUAL) && rows && rows->canFind(value))
+		{
+			const QRoaringBitmap* found = rows->find(value);
+			if (op == QComparison::EQUAL || value.isNull())
+			{
+				return __filterBitmap(found && op == QComparison::EQUAL ? *found : QRoaringBitmap(), bitmap);
+			}
+
+			// inequality holds for the non-NULL rows without the value
+			QRoaringBitmap matches = rows->getRows();
+			if (found)
+			{
+				matches.subtract(*found);
+			}
+			return __filterBitmap(matches, bitmap);
+		}
+
+		if (op != QComparison::NOT_EQUAL && (__artIndexes[column] || __btreeIndexes[column]))
+		{
+			const bool below = op == QComparison::LESS || op == QComparison::LESS_EQUAL;
+			const bool above = op == QComparison::GREATER || op == QComparison::GREATER_EQUAL;
+			const bool inclusive = op != QComparison::LESS && op != QComparison::GREATER;
+			return __filterRange(column, below ? nullptr : &value, inclusive, above ? nullptr : &value, inclusive, bitmap);
+		}
+
+		int64_t bounds[2];
+		const bool ranged = isBounded(getColumnType(column)) && rangeOf(op, value, bounds[0], bounds[1]);
+		if (ranged && __schema.getColumnEncoding(column) == QEncoding::COMPRESSED && __layout == QTableLayout::COLUMN && __pool == nullptr)
+		{
+			return __filterCompressed(column, bounds[0], bounds[1], bitmap);
+		}
+
+		QComparisonExpression predicate(op, new QColumnExpression(0, getColumnType(column)), new QConstantExpression(value));
+		const bool probed = op == QComparison::EQUAL && __bloomBits[column] && !value.isNull();
+		return __filter(column, predicate, bitmap, ranged ? bounds : nullptr, probed ? &value : nullptr);
+	}
+
+	std::size_t QTable::filterBetween(const std::size_t column, const QValue& low, const QValue& high, qtl::vector<uint64_t>& bitmap) const
+	{
+		if (__artIndexes[column] || __btreeIndexes[column])
+		{
+			return __filterRange(column, &low, true, &high, true, bitmap);
+		}
+
+		int64_t bounds[2];
+		int64_t unused;
+		const bool ranged = isBounded(getColumnType(column)) && rangeOf(QComparison::GREATER_EQUAL, low, bounds[0], unused) && rangeOf(QComparison::LESS_EQUAL, high, unused, bounds[1]);
+		if (ranged && __schema.getColumnEncoding(column) == QEncoding::COMPRESSED && __layout == QTableLayout::COLUMN && __pool == nullptr)
+		{
+			return __filterCompressed(column, bounds[0], bounds[1], bitmap);
+		}
+
+		QBetweenExpression predicate(new QColumnExpression(0, getColumnType(column)), low, high);
+		return __filter(column, predicate, bitmap, ranged ? bounds : nullptr);
+	}
+
+	std::size_t QTable::filterIn(const std::size_t column, const qtl::vector<QValue>& values, qtl::vector<uint64_t>& bitmap) const
+	{
+		const QBitmapIndex* index = __bitmapIndexes[column];
+		bool indexed = index != nullptr;
+		for (std::size_t i = 0; indexed && i < values.size(); i++)
+		{
+			indexed = index->canFind(values[i]);
+		}
+		if (indexed)
+		{
+			QRoaringBitmap matches;
+			for (const QValue& value : values)
+			{
+				if (const QRoaringBitmap* found = index->find(value))
+				{
+					matches.unite(*found);
+				}
+			}
+			return __filterBitmap(matches, bitmap);
+		}
+
+		QInExpression predicate(new QColumnExpression(0, getColumnType(column)), values);
+		return __filter(column, predicate, bitmap);
+	}
+
+	void QTable::__assign(const std::size_t row, const std::size_t column, const QValue& value)
+	{
+		// the indexes find the row's entries by its old value
+		QHashIndex* index = __hashIndexes[column];
+		QBTreeIndex* btree = __btreeIndexes[column];
+		QArtIndex* art = __artIndexes[column];
+		QBitmapIndex* bitmap = __bitmapIndexes[column];
+		if (index)
+		{
+			index->erase(row);
+		}
+		if (btree)
+		{
+			btree->erase(row);
+		}
+		if (art)
+		{
+			art->erase(row);
+		}
+		if (bitmap)
+		{
+			bitmap->erase(row);
+		}
+
+		// the zone counts the value's NULL again if it stays NULL
+		QZone& zone = __zonesOf(row)[column];
+		if (getRow(row).get(column).isNull() && zone.nulls > 0)
+		{
+			zone.nulls--;
+		}
+		__widen(zone, column, value);
+
+		if (__layout == QTableLayout::COLUMN)
+		{
+			QColumn& data = *__columns[column];
+			if (data.isNullable())
+			{
+				data.setNull(row, value.isNull());
+			}
+			if (!value.isNull())
+			{
+				__store(column, value, data.modify(row));
+			}
+		}
+		else
+		{
+			char* data = __rowData(row);
+			if (__schema.isNullable(column))
+			{
+				const char bit = static_cast<char>(1 << (column & 7));
+				data[column >> 3] = value.isNull() ? (data[column >> 3] | bit) : (data[column >> 3] & ~bit);
+			}
+			if (!value.isNull())
+			{
+				__store(column, value, data + __schema.getColumnOffset(column));
+			}
+		}
+		if (__bloomBits[column])
+		{
+			__addToBloom(row, column);
+		}
+
+		if (index)
+		{
+			index->insert(row);
+		}
+		if (btree)
+		{
+			btree->insert(row);
+		}
+		if (art)
+		{
+			art->insert(row);
+		}
+		if (bitmap)
+		{
+			bitmap->insert(row);
+		}
+	}
+
+	void QTable::__retire(const std::size_t row, const std::size_t successor)
+	{
+		while (__retiring.size() <= row >> 6)
+		{
+			__retiring.push_back(0);
+		}
+		__retiring[row >> 6] |= static_cast<uint64_t>(1) << (row & 63);
+		QRetired retired = { row, successor };
+		__retired.push_back(retired);
+	}
+
+	bool QTable::__isRetiring(const std::size_t row) const
+	{
+		return (row >> 6) < __retiring.size() && ((__retiring[row >> 6] >> (row & 63)) & 1);
+	}
+
+	bool QTable::__isCurrent(const std::size_t row) const
+	{
+		return row < __committedRows && !isErased(row);
+	}
+
+	QTable::QVersion* QTable::__version(const std::size_t row, const bool allocate)
+	{
+		const std::size_t page = row >> PAGE_SHIFT;
+		while (__versions.size() <= page)
+		{
+			__versions.push_back(nullptr);
+		}
+		if (__versions[page] == nullptr && allocate)
+		{
+			// rows without timestamps are visible to every snapshot until erased
+			QVersion* versions = static_cast<QVersion*>(malloc(PAGE_ROWS * sizeof(QVersion)));
+			const std::size_t first = page << PAGE_SHIFT;
+			for (std::size_t i = 0; i < PAGE_ROWS; i++)
+			{
+				versions[i].begin = 0;
+				versions[i].end = first + i < __rowCount && isErased(first + i) ? 0 : NEVER;
+			}
+			__versions[page] = versions;
+		}
+		return __versions[page] ? __versions[page] + (row & (PAGE_ROWS - 1)) : nullptr;
+	}
+
+	void QTable::__collect(const uint64_t horizon)
+	{
+		qtl::unique_lock<qtl::shared_mutex> latch(__latch);
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < __garbage.size(); i++)
+		{
+			const std::size_t row = __garbage[i];
+			const QVersion* version = __version(row, false);
+			if (version == nullptr || version->end <= horizon)
+			{
+				__unindexRow(row);
+			}
+			else
+			{
+				__garbage[kept++] = row;
+			}
+		}
+		while (__garbage.size() > kept)
+		{
+			__garbage.erase(--__garbage.end());
+		}
+
+		// timestamps at or before the horizon no longer tell snapshots apart
+		for (std::size_t page = 0; page < __versions.size(); page++)
+		{
+			const QVersion* versions = __versions[page];
+			bool needed = false;
+			for (std::size_t i = 0; versions && i < PAGE_ROWS && !needed; i++)
+			{
+				needed = versions[i].begin > horizon || (versions[i].end != NEVER && versions[i].end > horizon);
+			}
+			if (versions && !needed)
+			{
+				free(__versions[page]);
+				__versions[page] = nullptr;
+			}
+		}
+		__releaseChunks(horizon);
+	}
+
+	void QTable::__compress(const uint64_t timestamp, const bool read)
+	{
+		// a chunk no longer changes once it is full and its rows are committed
+		if (__layout != QTableLayout::COLUMN)
+		{
+			return;
+		}
+		for (; __compressedChunks < (__committedRows >> QColumn::CHUNK_SHIFT); __compressedChunks++)
+		{
+			for (std::size_t column = 0; column < __columns.size(); column++)
+			{
+				if (__schema.getColumnEncoding(column) != QEncoding::COMPRESSED)
+				{
+					continue;
+				}
+				void* values = __columns[column]->compress(__compressedChunks);
+				if (values && read)
+				{
+					__staleChunks.push_back({ values, timestamp });
+				}
+				else
+				{
+					free(values);
+				}
+			}
+		}
+	}
+
+	void QTable::__releaseChunks(const uint64_t horizon)
+	{
+		qtl::vector<QStaleChunk> kept;
+		for (const QStaleChunk& chunk : __staleChunks)
+		{
+			if (chunk.timestamp <= horizon)
+			{
+				free(chunk.values);
+			}
+			else
+			{
+				kept.push_back(chunk);
+			}
+		}
+		__staleChunks = qtl::move(kept);
+	}
+
+	std::size_t QTable::__append(const qtl::vector<QValue>& values)
+	{
+		if ((__rowCount & 63) == 0)
+		{
+			__erased.push_back(0);
+		}
+
+		const std::size_t columns = __schema.getColumnCount();
+		QZone* zones = __zonesOf(__rowCount);
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			__widen(zones[column], column, values[column]);
+		}
+
+		if (__layout == QTableLayout::COLUMN)
+		{
+			for (std::size_t column = 0; column < columns; column++)
+			{
+				void* value = __columns[column]->append();
+				if (values[column].isNull())
+				{
+					__columns[column]->setNull(__rowCount, true);
+				}
+				else
+				{
+					__store(column, values[column], value);
+				}
+			}
+			__indexRow(__rowCount);
+			return __rowCount++;
+		}
+
+		if ((__rowCount & (PAGE_ROWS - 1)) == 0)
+		{
+			__pages.push_back(static_cast<char*>(__storage.allocate(PAGE_ROWS * __schema.getRowSize())));
+		}
+
+		char* row = __rowData(__rowCount);
+		memset(row, 0, __schema.getRowSize());
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			const QDataType type = __schema.getColumnType(column);
+			void* value = row + __schema.getColumnOffset(column);
+			if (type == QDataType::STRING && __dictionaries[column] == nullptr)
+			{
+				::new (value) qtl::string();
+			}
+
+			if (values[column].isNull())
+			{
+				row[column >> 3] |= static_cast<char>(1 << (column & 7));
+			}
+			else
+			{
+				__store(column, values[column], value);
+			}
+		}
+		__indexRow(__rowCount);
+		return __rowCount++;
+	}
+
+	QTable::QZone* QTable::__zonesOf(const std::size_t row)
+	{
+		// pages that held rows before the table wrote to them, such as pages
+		// opened from a file, are not bounded
+		const std::size_t columns = __schema.getColumnCount();
+		const std::size_t page = row >> PAGE_SHIFT;
+		while (__zones.size() < (page + 1) * columns)
+		{
+			const std::size_t first = __zones.size() / columns << PAGE_SHIFT;
+			const QZone zone = first >= __rowCount ? QZone{ INT64_MAX, INT64_MIN, 0 } : QZone{ INT64_MIN, INT64_MAX, 0 };
+			for (std::size_t column = 0; column < columns; column++)
+			{
+				__zones.push_back(zone);
+			}
+		}
+		return __zones.data() + page * columns;
+	}
+
+	void QTable::__widen(QZone& zone, const std::size_t column, const QValue& value) const
+	{
+		if (value.isNull())
+		{
+			zone.nulls++;
+			return;
+		}
+		int64_t key = 0;
+		if (!zoneKey(__schema.getColumnType(column), value, key))
+		{
+			zone.min = INT64_MIN;
+			zone.max = INT64_MAX;
+			return;
+		}
+		zone.min = key < zone.min ? key : zone.min;
+		zone.max = key > zone.max ? key : zone.max;
+	}
+
+	void QTable::__indexRow(const std::size_t row)
+	{
+		for (std::size_t i = 0; i < __hashIndexes.size(); i++)
+		{
+			if (__hashIndexes[i])
+			{
+				__hashIndexes[i]->insert(row);
+			}
+			if (__btreeIndexes[i])
+			{
+				__btreeIndexes[i]->insert(row);
+			}
+			if (__artIndexes[i])
+			{
+				__artIndexes[i]->insert(row);
+			}
+			if (__bitmapIndexes[i])
+			{
+				__bitmapIndexes[i]->insert(row);
+			}
+			if (__bloomBits[i])
+			{
+				__addToBloom(row, i);
+			}
+		}
+	}
+
+	void QTable::__addToBloom(const std::size_t row, const std::size_t column)
+	{
+		QField field = getRow(row).get(column);
+		if (field.isNull())
+		{
+			return;
+		}
+
+		const std::size_t columns = __schema.getColumnCount();
+		const std::size_t slot = (row >> PAGE_SHIFT) * columns + column;
+		while (__blooms.size() <= slot)
+		{
+			__blooms.push_back(nullptr);
+		}
+		if (__blooms[slot] == nullptr)
+		{
+			__blooms[slot] = new QBloomFilter(PAGE_ROWS, __bloomBits[column]);
+		}
+
+		switch (__schema.getColumnType(column))
+		{
+		case QDataType::CHAR:
+			__blooms[slot]->insert(QBloomFilter::hashKey(field.get<char>()));
+			break;
+		case QDataType::INT:
+			__blooms[slot]->insert(QBloomFilter::hashKey(field.get<int32_t>()));
+			break;
+		case QDataType::LONG:
+			__blooms[slot]->insert(QBloomFilter::hashKey(field.get<int64_t>()));
+			break;
+		case QDataType::STRING:
+			__blooms[slot]->insert(QBloomFilter::hashString(field.get<qtl::string>()));
+			break;
+		case QDataType::BOOL:
+			break;
+		}
+	}
+
+	void QTable::__unindexRow(const std::size_t row)
+	{
+		for (std::size_t i = 0; i < __hashIndexes.size(); i++)
+		{
+			if (__hashIndexes[i])
+			{
+				__hashIndexes[i]->erase(row);
+			}
+			if (__btreeIndexes[i])
+			{
+				__btreeIndexes[i]->erase(row);
+			}
+			if (__artIndexes[i])
+			{
+				__artIndexes[i]->erase(row);
+			}
+			if (__bitmapIndexes[i])
+			{
+				__bitmapIndexes[i]->erase(row);
+			}
+		}
+	}
+
+	QField QTable::__getColumnField(const std::size_t row, const std::size_t column) const
+	{
+		const QColumn& data = *__columns[column];
+		if (data.isNull(row))
+		{
+			return QField(data.getType(), nullptr);
+		}
+		if (__dictionaries[column])
+		{
+			return QField(data.getType(), const_cast<qtl::string*>(&__dictionaries[column]->decode(getCode(row, column))));
+		}
+		if (const QSegment* segment = data.getSegment(row >> QColumn::CHUNK_SHIFT))
+		{
+			return QField(data.getType(), segment->get(row & (QColumn::CHUNK_SIZE - 1)));
+		}
+		if (data.isPooled(row >> QColumn::CHUNK_SHIFT))
+		{
+			// the field holds a copy, the frame may hold another page once the copy is made
+			QField field(data.getType(), static_cast<int64_t>(0));
+			const bool read = data.read(row, &field.__decoded);
+			assert(read);
+			(void)read;
+			return field;
+		}
+		return QField(data.getType(), data.at(row));
+	}
+
+	void QTable::__store(const std::size_t column, const QValue& value, void* data)
+	{
+		if (__dictionaries[column])
+		{
+			*static_cast<uint32_t*>(data) = __dictionaries[column]->encode(value.getString());
+			return;
+		}
+		value.store(__schema.getColumnType(column), data);
+	}
+
+	bool QTable::__validate(const qtl::vector<QValue>& values) const
+	{
+		if (values.size() != __schema.getColumnCount())
+		{
+			return false;
+		}
+		for (std::size_t column = 0; column < values.size(); column++)
+		{
+			if (!__validate(column, values[column]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool QTable::__validate(const std::size_t column, const QValue& value) const
+	{
+		if (value.isNull())
+		{
+			return __schema.isNullable(column);
+		}
+		return value.canStore(__schema.getColumnType(column));
+	}
+
+	std::size_t QTable::__filterBitmap(const QRoaringBitmap& rows, qtl::vector<uint64_t>& bitmap) const
+	{
+		bitmap.clear();
+		for (std::size_t i = 0; i < __erased.size(); i++)
+		{
+			bitmap.push_back(0);
+		}
+
+		// the index holds every version, only the current ones match
+		std::size_t count = 0;
+		std::size_t position = 0;
+		std::size_t found[QBatch::CAPACITY];
+		while (const std::size_t extracted = rows.extract(position, found, QBatch::CAPACITY))
+		{
+			for (std::size_t i = 0; i < extracted; i++)
+			{
+				if (__isCurrent(found[i]))
+				{
+					bitmap[found[i] >> 6] |= static_cast<uint64_t>(1) << (found[i] & 63);
+					count++;
+				}
+			}
+		}
+		return count;
+	}
+
+	template<typename Range, typename Index>
+	std::size_t QTable::__filterRange(const Index& index, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, qtl::vector<uint64_t>& bitmap) const
+	{
+		bitmap.clear();
+		for (std::size_t i = 0; i < __erased.size(); i++)
+		{
+			bitmap.push_back(0);
+		}
+
+		Range range;
+		index.open(range, low, lowInclusive, high, highInclusive, false);
+		std::size_t rows[QBatch::CAPACITY];
+		std::size_t count = 0;
+		while (const std::size_t found = range.next(rows, QBatch::CAPACITY))
+		{
+			for (std::size_t i = 0; i < found; i++)
+			{
+				if (__isCurrent(rows[i]))
+				{
+					bitmap[rows[i] >> 6] |= static_cast<uint64_t>(1) << (rows[i] & 63);
+					count++;
+				}
+			}
+		}
+		return count;
+	}
+
+	std::size_t QTable::__filterRange(const std::size_t column, const QValue* low, const bool lowInclusive, const QValue* high, const bool highInclusive, qtl::vector<uint64_t>& bitmap) const
+	{
+		if (__artIndexes[column])
+		{
+			return __filterRange<QArtRange>(*__artIndexes[column], low, lowInclusive, high, highInclusive, bitmap);
+		}
+		return __filterRange<QBTreeRange>(*__btreeIndexes[column], low, lowInclusive, high, highInclusive, bitmap);
+	}
+
+	std::size_t QTable::__filter(const std::size_t column, QExpression& predicate, qtl::vector<uint64_t>& bitmap, const int64_t* bounds, const QValue* key) const
+	{
+		const std::size_t words = (__rowCount + 63) / 64;
+		bitmap.clear();
+		bitmap.reserve(words);
+		for (std::size_t i = 0; i < words; i++)
+		{
+			bitmap.push_back(0);
+		}
+
+		// batches start on a multiple of QBatch::CAPACITY, so each one fills whole words
+		qtl::vector<std::size_t> columns;
+		columns.push_back(column);
+		const uint64_t snapshot = __clock->acquire();
+		QScanOperator scan(*this, columns, snapshot);
+		if (bounds)
+		{
+			scan.addRange(column, new QConstantExpression(QValue(bounds[0])), true, new QConstantExpression(QValue(bounds[1])), true);
+		}
+		if (key)
+		{
+			scan.addKey(column, new QConstantExpression(*key));
+		}
+		uint16_t selection[QBatch::CAPACITY];
+		std::size_t count = 0;
+		while (QBatch* batch = scan.next())
+		{
+			const std::size_t selected = predicate.select(*batch, batch->getSelection(), batch->getActiveCount(), selection);
+			uint64_t* out = bitmap.data() + batch->getRowOffset() / 64;
+			for (std::size_t i = 0; i < selected; i++)
+			{
+				out[selection[i] >> 6] |= static_cast<uint64_t>(1) << (selection[i] & 63);
+			}
+			count += selected;
+		}
+		__clock->release(snapshot);
+
+		// what the scan matched before it could not pin a chunk is incomplete
+		if (scan.getError())
+		{
+			memset(bitmap.data(), 0, words * sizeof(uint64_t));
+			count = 0;
+		}
+		return count;
+	}
+
+	std::size_t QTable::__filterCompressed(const std::size_t column, const int64_t low, const int64_t high, qtl::vector<uint64_t>& bitmap) const
+	{
+		// rows appended after the snapshot is taken are not visible to it
+		const uint64_t snapshot = __clock->acquire();
+		__latch.lock_shared();
+		const std::size_t rows = __rowCount;
+		__latch.unlock_shared();
+		const std::size_t words = (rows + 63) / 64;
+		bitmap.clear();
+		bitmap.reserve(words);
+		for (std::size_t i = 0; i < words; i++)
+		{
+			bitmap.push_back(0);
+		}
+
+		const QColumn& data = *__columns[column];
+		uint64_t matches[QColumn::CHUNK_SIZE / 64];
+		uint64_t live[QColumn::CHUNK_SIZE / 64];
+		std::size_t count = 0;
+		for (std::size_t first = 0; first < rows; first += QColumn::CHUNK_SIZE)
+		{
+			const std::size_t chunk = first >> QColumn::CHUNK_SHIFT;
+			const std::size_t size = rows - first < QColumn::CHUNK_SIZE ? rows - first : QColumn::CHUNK_SIZE;
+			const std::size_t chunkWords = (size + 63) / 64;
+			__latch.lock_shared();
+			if (isOutside(chunk, column, low, high))
+			{
+				// no row of the chunk can match, the bitmap keeps its zeros
+				__latch.unlock_shared();
+				continue;
+			}
+			memset(matches, 0, sizeof(matches));
+			if (const QSegment* segment = data.getSegment(chunk))
+			{
+				segment->select(low, high, matches);
+			}
+			else if (data.getType() == QDataType::INT)
+			{
+				// bounds outside the range of INT either match every value or none
+				if (low <= INT32_MAX && high >= INT32_MIN && low <= high)
+				{
+					const int32_t from = low < INT32_MIN ? INT32_MIN : static_cast<int32_t>(low);
+					const int32_t to = high > INT32_MAX ? INT32_MAX : static_cast<int32_t>(high);
+					qsql::filterBetween(data.getChunk<int32_t>(chunk), size, from, to, matches);
+				}
+			}
+			else if (low <= high)
+			{
+				qsql::filterBetween(data.getChunk<int64_t>(chunk), size, low, high, matches);
+			}
+
+			if (const uint64_t* nulls = data.getNulls(chunk))
+			{
+				bitmapAndNot(matches, nulls, chunkWords);
+			}
+			if (getVisible(first, size, snapshot, live))
+			{
+				bitmapAnd(matches, live, chunkWords);
+			}
+			__latch.unlock_shared();
+			if ((size & 63) != 0)
+			{
+				matches[chunkWords - 1] &= (static_cast<uint64_t>(1) << (size & 63)) - 1;
+			}
+			memcpy(bitmap.data() + first / 64, matches, chunkWords * sizeof(uint64_t));
+			count += bitmapCount(matches, chunkWords);
+		}
+		__clock->release(snapshot);
+		return count;
 	}
-}
\ No newline at end of file
+}
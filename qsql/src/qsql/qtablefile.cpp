@@ -0,0 +1,552 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qtablefile.h"
+#include "qsql/qbufferpool.h"
+#include "qsql/qcolumn.h"
+#include "qsql/qdictionary.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined ( _WIN32 )
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qsql
+{
+	namespace
+	{
+		struct QFileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t rowCount;
+			uint32_t columnCount;
+			uint32_t headerSize;
+		};
+
+		struct QColumnHeader
+		{
+			uint8_t type;
+			uint8_t nullable;
+			uint16_t nameLength;
+		};
+
+		// offsets of a column's segments, 0 when the column has no such segment
+		struct QColumnSegments
+		{
+			uint64_t values;
+			uint64_t nulls;
+			uint64_t dictionary;
+		};
+
+		struct QFileTrailer
+		{
+			uint64_t footer;
+			uint32_t magic;
+			uint32_t version;
+		};
+
+		// Bytes a stored value takes, STRING values are stored as codes
+		std::size_t storedWidth(const QDataType type)
+		{
+			return type == QDataType::STRING ? sizeof(uint32_t) : getDataTypeSize(type);
+		}
+
+		void copyField(const QDataType type, QField field, void* destination)
+		{
+			switch (type)
+			{
+			case QDataType::CHAR:
+				*static_cast<char*>(destination) = field.get<char>();
+				break;
+			case QDataType::INT:
+				*static_cast<int32_t*>(destination) = field.get<int32_t>();
+				break;
+			case QDataType::LONG:
+				*static_cast<int64_t*>(destination) = field.get<int64_t>();
+				break;
+			case QDataType::BOOL:
+				*static_cast<bool*>(destination) = field.get<bool>();
+				break;
+			case QDataType::STRING:
+				break;
+			}
+		}
+
+		bool inFile(const uint64_t offset, const uint64_t size, const std::size_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	QTableFile::QTableFile()
+		: __file(nullptr), __offset(0), __failed(false)
+	{
+		__error[0] = '\0';
+	}
+
+	bool QTableFile::save(const QTable& table, const qtl::string& path)
+	{
+		__error[0] = '\0';
+		__failed = false;
+		__offset = 0;
+		__file = fopen(path.c_str(), "wb");
+		if (__file == nullptr)
+		{
+			__fail("cannot create %s", path.c_str());
+			return false;
+		}
+
+		const QSchema& schema = table.getSchema();
+		const std::size_t columns = schema.getColumnCount();
+		const std::size_t rows = table.getRowCount();
+		const std::size_t chunks = (rows + QColumn::CHUNK_SIZE - 1) >> QColumn::CHUNK_SHIFT;
+
+		QFileHeader header = { MAGIC, VERSION, rows, static_cast<uint32_t>(columns), 0 };
+		header.headerSize = sizeof(QFileHeader);
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			header.headerSize += static_cast<uint32_t>(sizeof(QColumnHeader) + schema.getColumnName(column).length());
+		}
+		__write(&header, sizeof(header));
+		for (std::size_t column = 0; column < columns; column++)
+		{
+			const qtl::string& name = schema.getColumnName(column);
+			const QColumnHeader info = { static_cast<uint8_t>(schema.getColumnType(column)), static_cast<uint8_t>(schema.isNullable(column)), static_cast<uint16_t>(name.length()) };
+			__write(&info, sizeof(info));
+			__write(name.c_str(), name.length());
+		}
+		__pad();
+
+		// every chunk is written whole so that the table can append to a mapped chunk
+		char* values = static_cast<char*>(malloc(QColumn::CHUNK_SIZE * sizeof(int64_t)));
+		uint64_t* nulls = static_cast<uint64_t*>(malloc(chunks * QColumn::CHUNK_SIZE / 8 + 8));
+		qtl::vector<QColumnSegments> segments;
+		for (std::size_t column = 0; column < columns && !__failed; column++)
+		{
+			const QDataType type = schema.getColumnType(column);
+			const std::size_t width = storedWidth(type);
+			const bool nullable = schema.isNullable(column);
+			const QDictionary* dictionary = table.getDictionary(column);
+			QDictionary* strings = type == QDataType::STRING && dictionary == nullptr ? new QDictionary() : nullptr;
+			const QColumn* source = table.getLayout() == QTableLayout::COLUMN && type != QDataType::STRING ? &table.getColumn(column) : nullptr;
+			memset(nulls, 0, chunks * QColumn::CHUNK_SIZE / 8);
+
+			QColumnSegments segment = { __offset, 0, 0 };
+			for (std::size_t chunk = 0; chunk < chunks; chunk++)
+			{
+				const std::size_t first = chunk << QColumn::CHUNK_SHIFT;
+				const std::size_t count = rows - first < QColumn::CHUNK_SIZE ? rows - first : QColumn::CHUNK_SIZE;
+				memset(values, 0, QColumn::CHUNK_SIZE * width);
+				if (source)
+				{
+					// a chunk read through a buffer pool is pinned while it is copied
+					if (!source->pinChunk(chunk))
+					{
+						__fail("cannot read the buffer pool: %s", table.getBufferPool()->getError());
+						break;
+					}
+
+					// the file keeps plain values, compressed chunks are decoded into them
+					if (const QSegment* compressed = source->getSegment(chunk))
+					{
+						compressed->decode(0, count, values);
+					}
+					else
+					{
+						memcpy(values, source->getChunk(chunk), count * width);
+					}
+					if (nullable)
+					{
+						memcpy(nulls + chunk * QColumn::CHUNK_SIZE / 64, source->getNulls(chunk), (count + 63) / 64 * sizeof(uint64_t));
+					}
+					source->unpinChunk(chunk);
+				}
+				else
+				{
+					for (std::size_t i = 0; i < count; i++)
+					{
+						QField field = table.getRow(first + i).get(column);
+						if (field.isNull())
+						{
+							nulls[(first + i) >> 6] |= static_cast<uint64_t>(1) << ((first + i) & 63);
+						}
+						else if (type != QDataType::STRING)
+						{
+							copyField(type, field, values + i * width);
+						}
+						else
+						{
+							const uint32_t code = strings ? strings->encode(field.get<qtl::string>()) : table.getCode(first + i, column);
+							memcpy(values + i * width, &code, sizeof(code));
+						}
+					}
+				}
+				__write(values, QColumn::CHUNK_SIZE * width);
+			}
+			__pad();
+
+			if (nullable)
+			{
+				segment.nulls = __offset;
+				__write(nulls, chunks * QColumn::CHUNK_SIZE / 8);
+				__pad();
+			}
+
+			// the strings of the dictionary by code, as a count, end offsets and the characters
+			if (type == QDataType::STRING)
+			{
+				const QDictionary& written = strings ? *strings : *dictionary;
+				const uint64_t count = written.size();
+				uint64_t end = 0;
+				segment.dictionary = __offset;
+				__write(&count, sizeof(count));
+				for (uint32_t code = 0; code < count; code++)
+				{
+					end += written.decode(code).length();
+					__write(&end, sizeof(end));
+				}
+				for (uint32_t code = 0; code < count; code++)
+				{
+					__write(written.decode(code).c_str(), written.decode(code).length());
+				}
+				__pad();
+			}
+			delete strings;
+			segments.push_back(segment);
+		}
+		free(values);
+		free(nulls);
+
+		const uint64_t erased = table.getErasedCount() > 0 ? __offset : 0;
+		if (erased)
+		{
+			__write(table.getErased(), (rows + 63) / 64 * sizeof(uint64_t));
+		}
+
+		const QFileTrailer trailer = { __offset, MAGIC, VERSION };
+		__write(segments.data(), segments.size() * sizeof(QColumnSegments));
+		__write(&erased, sizeof(erased));
+		__write(&trailer, sizeof(trailer));
+
+		if (fclose(__file) != 0 && !__failed)
+		{
+			__fail("cannot write %s", path.c_str());
+		}
+		__file = nullptr;
+		if (__failed)
+		{
+			remove(path.c_str());
+		}
+		return !__failed;
+	}
+
+	// A table file is read through the mapping or, without one, through a buffer pool
+	struct QTableFile::QSource
+	{
+		char* mapping;
+		std::size_t size;
+		QBufferPool* pool;
+		uint32_t file;
+
+		bool read(const uint64_t offset, void* data, const std::size_t length) const
+		{
+			if (!inFile(offset, length, size))
+			{
+				return false;
+			}
+			if (mapping)
+			{
+				memcpy(data, mapping + offset, length);
+				return true;
+			}
+			for (std::size_t done = 0; done < length;)
+			{
+				const uint64_t position = offset + done;
+				const char* page = pool->pin(file, position / QBufferPool::PAGE_SIZE);
+				if (page == nullptr)
+				{
+					return false;
+				}
+				const std::size_t within = static_cast<std::size_t>(position % QBufferPool::PAGE_SIZE);
+				const std::size_t count = length - done < QBufferPool::PAGE_SIZE - within ? length - done : QBufferPool::PAGE_SIZE - within;
+				memcpy(static_cast<char*>(data) + done, page + within, count);
+				pool->unpin(page, false);
+				done += count;
+			}
+			return true;
+		}
+
+		void release() const
+		{
+			if (mapping)
+			{
+				unmap(mapping, size);
+			}
+			else
+			{
+				pool->removeFile(file);
+			}
+		}
+	};
+
+	QTable* QTableFile::open(const qtl::string& path)
+	{
+		__error[0] = '\0';
+		void* mapping = nullptr;
+		std::size_t size = 0;
+#if defined ( _WIN32 )
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER fileSize;
+		if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			size = static_cast<std::size_t>(fileSize.QuadPart);
+			HANDLE view = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (view)
+			{
+				mapping = MapViewOfFile(view, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(view);
+			}
+		}
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file);
+		}
+#else
+		const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat status;
+		if (file >= 0 && fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			size = static_cast<std::size_t>(status.st_size);
+			mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			mapping = mapping == MAP_FAILED ? nullptr : mapping;
+		}
+		if (file >= 0)
+		{
+			::close(file);
+		}
+#endif
+		if (mapping == nullptr)
+		{
+			__fail("cannot map %s", path.c_str());
+			return nullptr;
+		}
+
+		const QSource source = { static_cast<char*>(mapping), size, nullptr, 0 };
+		return __load(source, path);
+	}
+
+	QTable* QTableFile::open(const qtl::string& path, QBufferPool& pool)
+	{
+		__error[0] = '\0';
+		const uint32_t file = pool.addFile(path);
+		if (file == QBufferPool::NONE)
+		{
+			__fail("cannot open %s", path.c_str());
+			return nullptr;
+		}
+
+		const QSource source = { nullptr, static_cast<std::size_t>(pool.getFileSize(file)), &pool, file };
+		return __load(source, path);
+	}
+
+	QTable* QTableFile::__load(const QSource& source, const qtl::string& path)
+	{
+		const std::size_t size = source.size;
+		QFileHeader header;
+		QFileTrailer trailer;
+		bool valid = source.read(0, &header, sizeof(header)) && size >= sizeof(header) + sizeof(trailer) &&
+			source.read(size - sizeof(trailer), &trailer, sizeof(trailer));
+		if (valid)
+		{
+			valid = header.magic == MAGIC && header.version == VERSION && trailer.magic == MAGIC && trailer.version == VERSION &&
+				inFile(0, header.headerSize, size) && inFile(trailer.footer, header.columnCount * sizeof(QColumnSegments) + sizeof(uint64_t), size - sizeof(trailer));
+		}
+
+		// the schema, every STRING column becomes dictionary encoded
+		QSchema schema;
+		qtl::vector<char> buffer;
+		std::size_t position = sizeof(header);
+		for (uint32_t column = 0; valid && column < header.columnCount; column++)
+		{
+			QColumnHeader info;
+			valid = inFile(position, sizeof(info), header.headerSize) && source.read(position, &info, sizeof(info));
+			if (valid)
+			{
+				position += sizeof(info);
+				buffer.resize(info.nameLength + 1);
+				valid = info.type <= static_cast<uint8_t>(QDataType::STRING) && inFile(position, info.nameLength, header.headerSize) &&
+					source.read(position, buffer.data(), info.nameLength);
+			}
+			if (valid)
+			{
+				const QDataType type = static_cast<QDataType>(info.type);
+				schema.addColumn(qtl::string(buffer.data(), info.nameLength), type, info.nullable != 0, type == QDataType::STRING ? QEncoding::DICTIONARY : QEncoding::PLAIN);
+				position += info.nameLength;
+			}
+		}
+
+		// every row takes its stored width in the file, which bounds the row count
+		// before it sizes anything
+		std::size_t rowWidth = 0;
+		for (uint32_t column = 0; valid && column < header.columnCount; column++)
+		{
+			rowWidth += storedWidth(schema.getColumnType(column));
+		}
+		valid = valid && header.rowCount <= size / (rowWidth > 0 ? rowWidth : 1);
+		if (!valid)
+		{
+			source.release();
+			__fail("%s is not a table file", path.c_str());
+			return nullptr;
+		}
+
+		// from here on the table owns the mapping or the pool's file
+		QTable* table = new QTable(schema, QTableLayout::COLUMN);
+		if (source.mapping)
+		{
+			table->__mapping = source.mapping;
+			table->__mappingSize = size;
+		}
+		else
+		{
+			table->__pool = source.pool;
+			table->__poolFile = source.file;
+		}
+
+		const std::size_t rows = static_cast<std::size_t>(header.rowCount);
+		const std::size_t chunks = (rows + QColumn::CHUNK_SIZE - 1) >> QColumn::CHUNK_SHIFT;
+		qtl::vector<QColumnSegments> segments;
+		segments.resize(header.columnCount);
+		bool pooled = true;
+		valid = source.read(trailer.footer, segments.data(), header.columnCount * sizeof(QColumnSegments));
+		for (uint32_t column = 0; valid && column < header.columnCount; column++)
+		{
+			const QColumnSegments& segment = segments[column];
+			const QDataType type = schema.getColumnType(column);
+			const std::size_t width = storedWidth(type);
+			const bool nullable = schema.isNullable(column);
+			valid = inFile(segment.values, chunks * QColumn::CHUNK_SIZE * width, size) && segment.values % PAGE_SIZE == 0 &&
+				(!nullable || (inFile(segment.nulls, chunks * QColumn::CHUNK_SIZE / 8, size) && segment.nulls % PAGE_SIZE == 0));
+
+			// codes are given in order, so encoding the strings again gives every string its code
+			if (valid && type == QDataType::STRING)
+			{
+				uint64_t count = 0;
+				valid = source.read(segment.dictionary, &count, sizeof(count)) && count < QDictionary::NONE &&
+					inFile(segment.dictionary + sizeof(count), count * sizeof(uint64_t), size);
+				qtl::vector<uint64_t> ends;
+				if (valid)
+				{
+					ends.resize(static_cast<std::size_t>(count));
+					valid = source.read(segment.dictionary + sizeof(count), ends.data(), ends.size() * sizeof(uint64_t));
+				}
+				const uint64_t strings = segment.dictionary + sizeof(count) + count * sizeof(uint64_t);
+				if (valid && count > 0)
+				{
+					buffer.resize(static_cast<std::size_t>(ends[ends.size() - 1]) + 1);
+					valid = source.read(strings, buffer.data(), static_cast<std::size_t>(ends[ends.size() - 1]));
+				}
+				uint64_t begin = 0;
+				QDictionary* dictionary = table->__dictionaries[column];
+				for (uint64_t code = 0; valid && code < count; code++)
+				{
+					const uint64_t end = ends[static_cast<std::size_t>(code)];
+					valid = end >= begin && dictionary->encode(qtl::string(buffer.data() + begin, static_cast<std::size_t>(end - begin))) == code;
+					begin = end;
+				}
+			}
+
+			for (std::size_t chunk = 0; valid && chunk < chunks; chunk++)
+			{
+				const std::size_t first = chunk << QColumn::CHUNK_SHIFT;
+				const std::size_t count = rows - first < QColumn::CHUNK_SIZE ? rows - first : QColumn::CHUNK_SIZE;
+				const uint64_t values = segment.values + chunk * QColumn::CHUNK_SIZE * width;
+				const uint64_t nulls = nullable ? segment.nulls + chunk * QColumn::CHUNK_SIZE / 8 : 0;
+				if (source.mapping)
+				{
+					table->__columns[column]->attach(source.mapping + values, nullable ? reinterpret_cast<uint64_t*>(source.mapping + nulls) : nullptr, count);
+				}
+				else if (!table->__columns[column]->attach(*source.pool, source.file, values, nulls, count))
+				{
+					pooled = false;
+					valid = false;
+				}
+			}
+		}
+
+		uint64_t erased = 0;
+		const std::size_t words = (rows + 63) / 64;
+		valid = valid && source.read(trailer.footer + header.columnCount * sizeof(QColumnSegments), &erased, sizeof(erased));
+		if (valid)
+		{
+			table->__erased.resize(words);
+			valid = erased == 0 || source.read(erased, table->__erased.data(), words * sizeof(uint64_t));
+		}
+		for (std::size_t word = 0; valid && erased && word < words; word++)
+		{
+			for (uint64_t bits = table->__erased[word]; bits; bits &= bits - 1)
+			{
+				table->__erasedCount++;
+			}
+		}
+		table->__rowCount = rows;
+		table->__committedRows = rows;
+
+		if (!valid)
+		{
+			delete table;
+			if (pooled)
+			{
+				__fail("%s is not a table file", path.c_str());
+			}
+			else
+			{
+				__fail("cannot read the buffer pool: %s", source.pool->getError());
+			}
+			return nullptr;
+		}
+		return table;
+	}
+
+	const char* QTableFile::getError() const
+	{
+		return __error;
+	}
+
+	void QTableFile::unmap(void* mapping, const std::size_t size)
+	{
+#if defined ( _WIN32 )
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, size);
+#endif
+	}
+
+	void QTableFile::__write(const void* data, const std::size_t size)
+	{
+		if (!__failed && size > 0 && fwrite(data, 1, size, __file) != size)
+		{
+			__fail("%s", "cannot write the table file");
+		}
+		__offset += size;
+	}
+
+	void QTableFile::__pad()
+	{
+		static const char zeroes[PAGE_SIZE] = {};
+		__write(zeroes, (PAGE_SIZE - __offset % PAGE_SIZE) % PAGE_SIZE);
+	}
+
+	void QTableFile::__fail(const char* format, const char* detail)
+	{
+		__failed = true;
+		snprintf(__error, ERROR_LENGTH, format, detail);
+	}
+}
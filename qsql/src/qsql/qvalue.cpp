@@ -0,0 +1,148 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qvalue.h"
+
+namespace qsql
+{
+	QValue::QValue()
+		: __type(QDataType::INT), __isNull(true), __long(0)
+	{
+	}
+
+	QValue::QValue(const char value)
+		: __type(QDataType::CHAR), __isNull(false), __long(0)
+	{
+		__char = value;
+	}
+
+	QValue::QValue(const int32_t value)
+		: __type(QDataType::INT), __isNull(false), __long(0)
+	{
+		__int = value;
+	}
+
+	QValue::QValue(const int64_t value)
+		: __type(QDataType::LONG), __isNull(false), __long(value)
+	{
+	}
+
+	QValue::QValue(const bool value)
+		: __type(QDataType::BOOL), __isNull(false), __long(0)
+	{
+		__bool = value;
+	}
+
+	QValue::QValue(const char* value)
+		: __type(QDataType::STRING), __isNull(false), __long(0), __string(value)
+	{
+	}
+
+	QValue::QValue(const qtl::string& value)
+		: __type(QDataType::STRING), __isNull(false), __long(0), __string(value)
+	{
+	}
+
+	QDataType QValue::getType() const
+	{
+		return __type;
+	}
+
+	bool QValue::isNull() const
+	{
+		return __isNull;
+	}
+
+	char QValue::getChar() const
+	{
+		return __char;
+	}
+
+	int32_t QValue::getInt() const
+	{
+		return __int;
+	}
+
+	int64_t QValue::getLong() const
+	{
+		return __long;
+	}
+
+	bool QValue::getBool() const
+	{
+		return __bool;
+	}
+
+	const qtl::string& QValue::getString() const
+	{
+		return __string;
+	}
+
+	bool QValue::canStore(const QDataType type) const
+	{
+		if (__isNull)
+		{
+			return false;
+		}
+		if (__type == QDataType::STRING)
+		{
+			return type == QDataType::STRING || (type == QDataType::CHAR && __string.size() == 1);
+		}
+		return type != QDataType::STRING;
+	}
+
+	bool QValue::store(const QDataType type, void* destination) const
+	{
+		if (__isNull)
+		{
+			return false;
+		}
+
+		int64_t integral = 0;
+		switch (__type)
+		{
+		case QDataType::CHAR:
+			integral = __char;
+			break;
+		case QDataType::INT:
+			integral = __int;
+			break;
+		case QDataType::LONG:
+			integral = __long;
+			break;
+		case QDataType::BOOL:
+			integral = __bool ? 1 : 0;
+			break;
+		case QDataType::STRING:
+			if (type == QDataType::STRING)
+			{
+				*static_cast<qtl::string*>(destination) = __string;
+				return true;
+			}
+			if (type == QDataType::CHAR && __string.size() == 1)
+			{
+				*static_cast<char*>(destination) = __string[0];
+				return true;
+			}
+			return false;
+		}
+
+		switch (type)
+		{
+		case QDataType::CHAR:
+			*static_cast<char*>(destination) = static_cast<char>(integral);
+			return true;
+		case QDataType::INT:
+			*static_cast<int32_t*>(destination) = static_cast<int32_t>(integral);
+			return true;
+		case QDataType::LONG:
+			*static_cast<int64_t*>(destination) = integral;
+			return true;
+		case QDataType::BOOL:
+			*static_cast<bool*>(destination) = integral != 0;
+			return true;
+		case QDataType::STRING:
+			return false;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,70 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qversion.h"
+
+#include <cassert>
+
+namespace qsql
+{
+	QVersionClock::QVersionClock()
+		: __now(0)
+	{
+	}
+
+	uint64_t QVersionClock::now() const
+	{
+		return __now.load(std::memory_order_acquire);
+	}
+
+	uint64_t QVersionClock::acquire()
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		const uint64_t snapshot = __now.load(std::memory_order_relaxed);
+		__snapshots.push_back(snapshot);
+		return snapshot;
+	}
+
+	void QVersionClock::release(const uint64_t snapshot)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		for (std::size_t i = 0; i < __snapshots.size(); i++)
+		{
+			if (__snapshots[i] == snapshot)
+			{
+				__snapshots[i] = __snapshots.back();
+				__snapshots.erase(--__snapshots.end());
+				return;
+			}
+		}
+		assert(false && "snapshot was not acquired");
+	}
+
+	uint64_t QVersionClock::getHorizon()
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		return __horizon();
+	}
+
+	uint64_t QVersionClock::begin(bool& read)
+	{
+		__mutex.lock();
+		read = __snapshots.size() > 0;
+		return __now.load(std::memory_order_relaxed) + 1;
+	}
+
+	void QVersionClock::end(const uint64_t timestamp)
+	{
+		__now.store(timestamp, std::memory_order_release);
+		__mutex.unlock();
+	}
+
+	uint64_t QVersionClock::__horizon() const
+	{
+		uint64_t horizon = __now.load(std::memory_order_relaxed);
+		for (std::size_t i = 0; i < __snapshots.size(); i++)
+		{
+			horizon = __snapshots[i] < horizon ? __snapshots[i] : horizon;
+		}
+		return horizon;
+	}
+}
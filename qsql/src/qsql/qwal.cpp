@@ -0,0 +1,883 @@
+#include "qsql/qsql.h"
+
+#include "qsql/qwal.h"
+#include "qsql/qdatabase.h"
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if defined ( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace qsql
+{
+	namespace
+	{
+		const uint8_t NULL_TAG = 0xFF;
+		const std::size_t READ_SIZE = static_cast<std::size_t>(1) << 20;
+
+		// CRC-32C (Castagnoli) tables, table[k][b] is the remainder of byte b followed by k zero bytes
+		struct QCrcTables
+		{
+			uint32_t table[8][256];
+
+			QCrcTables()
+			{
+				for (uint32_t byte = 0; byte < 256; byte++)
+				{
+					uint32_t crc = byte;
+					for (int bit = 0; bit < 8; bit++)
+					{
+						crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+					}
+					table[0][byte] = crc;
+				}
+				for (int k = 1; k < 8; k++)
+				{
+					for (uint32_t byte = 0; byte < 256; byte++)
+					{
+						table[k][byte] = (table[k - 1][byte] >> 8) ^ table[0][table[k - 1][byte] & 0xFF];
+					}
+				}
+			}
+		};
+
+		uint32_t crc32c(const void* data, std::size_t size)
+		{
+			static const QCrcTables tables;
+			const uint32_t (*table)[256] = tables.table;
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			uint32_t crc = 0xFFFFFFFF;
+
+			// eight bytes per step, the words are read little endian
+			while (size >= 8)
+			{
+				uint64_t word;
+				memcpy(&word, bytes, sizeof(word));
+				word ^= crc;
+				crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^ table[5][(word >> 16) & 0xFF] ^ table[4][(word >> 24) & 0xFF] ^
+					table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^ table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+				bytes += 8;
+				size -= 8;
+			}
+			while (size-- > 0)
+			{
+				crc = table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		int openFile(const char* path)
+		{
+#if defined ( _WIN32 )
+			int file = -1;
+			_sopen_s(&file, path, _O_RDWR | _O_CREAT | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+			return file;
+#else
+			return ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+		}
+
+		int64_t seekFile(const int file, const int64_t offset, const int origin)
+		{
+#if defined ( _WIN32 )
+			return _lseeki64(file, offset, origin);
+#else
+			return ::lseek(file, offset, origin);
+#endif
+		}
+
+		// Returns the number of bytes read, less than size only at the end of the file or on an error
+		std::size_t readFile(const int file, void* data, const std::size_t size)
+		{
+			std::size_t done = 0;
+			while (done < size)
+			{
+#if defined ( _WIN32 )
+				const int result = _read(file, static_cast<char*>(data) + done, static_cast<unsigned int>(size - done));
+#else
+				const ssize_t result = ::read(file, static_cast<char*>(data) + done, size - done);
+				if (result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (result <= 0)
+				{
+					break;
+				}
+				done += static_cast<std::size_t>(result);
+			}
+			return done;
+		}
+
+		bool writeFile(const int file, const void* data, const std::size_t size)
+		{
+			std::size_t done = 0;
+			while (done < size)
+			{
+#if defined ( _WIN32 )
+				const int result = _write(file, static_cast<const char*>(data) + done, static_cast<unsigned int>(size - done));
+#else
+				const ssize_t result = ::write(file, static_cast<const char*>(data) + done, size - done);
+				if (result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+#endif
+				if (result <= 0)
+				{
+					return false;
+				}
+				done += static_cast<std::size_t>(result);
+			}
+			return true;
+		}
+
+		bool syncFile(const int file)
+		{
+#if defined ( _WIN32 )
+			return _commit(file) == 0;
+#elif defined ( __linux__ )
+			return ::fdatasync(file) == 0;
+#else
+			return ::fsync(file) == 0;
+#endif
+		}
+
+		bool truncateFile(const int file, const int64_t size)
+		{
+#if defined ( _WIN32 )
+			return _chsize_s(file, size) == 0;
+#else
+			return ::ftruncate(file, size) == 0;
+#endif
+		}
+
+		void closeFile(const int file)
+		{
+#if defined ( _WIN32 )
+			_close(file);
+#else
+			::close(file);
+#endif
+		}
+
+		template<typename T>
+		void put(QWalBuffer& buffer, const T value)
+		{
+			buffer.append(&value, sizeof(T));
+		}
+
+		// Changes of a replayed frame.  A frame is one write of each table, as it
+		// was when logged, so that rows updated twice within it are versioned the
+		// same way and the rows of later frames keep their logged numbers.  Unless
+		// the whole frame is committed its writes are aborted and the tables it
+		// created dropped again.  Tables it drops are only dropped by commit(),
+		// until then the frame no longer finds them.
+		class QReplayFrame
+		{
+		public:
+			explicit QReplayFrame(QDatabase& database)
+				: __database(database), __committed(false)
+			{
+			}
+
+			~QReplayFrame()
+			{
+				if (__committed)
+				{
+					return;
+				}
+				for (std::size_t i = 0; i < __tables.size(); i++)
+				{
+					__tables[i]->abort();
+				}
+				for (std::size_t i = 0; i < __created.size(); i++)
+				{
+					__database.dropTable(__created[i]);
+				}
+			}
+
+			QTable* find(const qtl::string& name) const
+			{
+				QTable* table = __database.getTable(name);
+				for (std::size_t i = 0; table && i < __dropped.size(); i++)
+				{
+					if (__database.getTable(__dropped[i]) == table)
+					{
+						return nullptr;
+					}
+				}
+				return table;
+			}
+
+			void begin(QTable* table)
+			{
+				for (std::size_t i = 0; i < __tables.size(); i++)
+				{
+					if (__tables[i] == table)
+					{
+						return;
+					}
+				}
+				table->beginWrite();
+				__tables.push_back(table);
+			}
+
+			bool create(const qtl::string& name, const QSchema& schema, const QTableLayout layout)
+			{
+				if (__database.createTable(name, schema, layout) == nullptr)
+				{
+					return false;
+				}
+				__created.push_back(name);
+				return true;
+			}
+
+			bool drop(const qtl::string& name)
+			{
+				if (find(name) == nullptr)
+				{
+					return false;
+				}
+				__dropped.push_back(name);
+				return true;
+			}
+
+			void commit()
+			{
+				for (std::size_t i = 0; i < __tables.size(); i++)
+				{
+					__tables[i]->commit();
+				}
+				for (std::size_t i = 0; i < __dropped.size(); i++)
+				{
+					__database.dropTable(__dropped[i]);
+				}
+				__committed = true;
+			}
+		private:
+			QDatabase& __database;
+			qtl::vector<QTable*> __tables;
+			qtl::vector<qtl::string> __created;
+			qtl::vector<qtl::string> __dropped;
+			bool __committed;
+		};
+
+		// Reads a log front to back through a buffer that grows to hold the largest frame
+		class QLogReader
+		{
+		public:
+			explicit QLogReader(const int file)
+				: __file(file), __buffer(static_cast<char*>(malloc(READ_SIZE))), __capacity(READ_SIZE), __begin(0), __end(0)
+			{
+			}
+
+			~QLogReader()
+			{
+				free(__buffer);
+			}
+
+			// Points data at the next size bytes, false if the file ends first
+			bool read(const char*& data, const std::size_t size)
+			{
+				if (__end - __begin < size)
+				{
+					memmove(__buffer, __buffer + __begin, __end - __begin);
+					__end -= __begin;
+					__begin = 0;
+					if (size > __capacity)
+					{
+						__capacity = size;
+						__buffer = static_cast<char*>(realloc(__buffer, __capacity));
+					}
+					__end += readFile(__file, __buffer + __end, __capacity - __end);
+					if (__end < size)
+					{
+						return false;
+					}
+				}
+				data = __buffer + __begin;
+				__begin += size;
+				return true;
+			}
+		private:
+			int __file;
+			char* __buffer;
+			std::size_t __capacity;
+			std::size_t __begin;
+			std::size_t __end;
+		};
+
+		// Decodes the records of a frame, any read past its end marks it failed
+		class QRecordReader
+		{
+		public:
+			QRecordReader(const char* data, const std::size_t size)
+				: __data(data), __end(data + size), __failed(false)
+			{
+			}
+
+			bool isDone() const
+			{
+				return __data == __end;
+			}
+
+			bool isFailed() const
+			{
+				return __failed;
+			}
+
+			template<typename T>
+			T get()
+			{
+				T value = T();
+				if (static_cast<std::size_t>(__end - __data) < sizeof(T))
+				{
+					__failed = true;
+					__data = __end;
+					return value;
+				}
+				memcpy(&value, __data, sizeof(T));
+				__data += sizeof(T);
+				return value;
+			}
+
+			qtl::string getString()
+			{
+				const uint32_t length = get<uint32_t>();
+				if (static_cast<std::size_t>(__end - __data) < length)
+				{
+					__failed = true;
+					__data = __end;
+					return qtl::string();
+				}
+				qtl::string value(__data, length);
+				__data += length;
+				return value;
+			}
+
+			QValue getValue()
+			{
+				const uint8_t tag = get<uint8_t>();
+				switch (tag)
+				{
+				case NULL_TAG:
+					return QValue();
+				case static_cast<uint8_t>(QDataType::CHAR):
+					return QValue(get<char>());
+				case static_cast<uint8_t>(QDataType::INT):
+					return QValue(get<int32_t>());
+				case static_cast<uint8_t>(QDataType::LONG):
+					return QValue(get<int64_t>());
+				case static_cast<uint8_t>(QDataType::BOOL):
+					return QValue(get<uint8_t>() != 0);
+				case static_cast<uint8_t>(QDataType::STRING):
+					return QValue(getString());
+				}
+				__failed = true;
+				return QValue();
+			}
+		private:
+			const char* __data;
+			const char* __end;
+			bool __failed;
+		};
+	}
+
+	QWalBuffer::QWalBuffer()
+		: __data(nullptr), __size(0), __capacity(0)
+	{
+	}
+
+	QWalBuffer::~QWalBuffer()
+	{
+		free(__data);
+	}
+
+	const char* QWalBuffer::getData() const
+	{
+		return __data;
+	}
+
+	std::size_t QWalBuffer::size() const
+	{
+		return __size;
+	}
+
+	void QWalBuffer::append(const void* data, const std::size_t size)
+	{
+		if (__size + size > __capacity)
+		{
+			std::size_t capacity = __capacity ? __capacity * 2 : 4096;
+			while (capacity < __size + size)
+			{
+				capacity *= 2;
+			}
+			__data = static_cast<char*>(realloc(__data, capacity));
+			__capacity = capacity;
+		}
+		memcpy(__data + __size, data, size);
+		__size += size;
+	}
+
+	void QWalBuffer::clear()
+	{
+		__size = 0;
+	}
+
+	void QWalBuffer::swap(QWalBuffer& other)
+	{
+		char* data = __data;
+		const std::size_t size = __size;
+		const std::size_t capacity = __capacity;
+		__data = other.__data;
+		__size = other.__size;
+		__capacity = other.__capacity;
+		other.__data = data;
+		other.__size = size;
+		other.__capacity = capacity;
+	}
+
+	void QWalTransaction::createTable(const qtl::string& name, const QSchema& schema, const QTableLayout layout)
+	{
+		__putType(QWalRecordType::CREATE_TABLE);
+		__putString(name);
+		put<uint8_t>(__records, static_cast<uint8_t>(layout));
+		put<uint16_t>(__records, static_cast<uint16_t>(schema.getColumnCount()));
+		for (std::size_t column = 0; column < schema.getColumnCount(); column++)
+		{
+			__putString(schema.getColumnName(column));
+			put<uint8_t>(__records, static_cast<uint8_t>(schema.getColumnType(column)));
+			put<uint8_t>(__records, schema.isNullable(column) ? 1 : 0);
+			put<uint8_t>(__records, static_cast<uint8_t>(schema.getColumnEncoding(column)));
+		}
+	}
+
+	void QWalTransaction::dropTable(const qtl::string& name)
+	{
+		__putType(QWalRecordType::DROP_TABLE);
+		__putString(name);
+	}
+
+	void QWalTransaction::insert(const qtl::string& table, const qtl::vector<QValue>& values)
+	{
+		__putType(QWalRecordType::INSERT_ROW);
+		__putString(table);
+		put<uint16_t>(__records, static_cast<uint16_t>(values.size()));
+		for (const QValue& value : values)
+		{
+			__putValue(value);
+		}
+	}
+
+	void QWalTransaction::update(const qtl::string& table, const std::size_t row, const std::size_t column, const QValue& value)
+	{
+		__putType(QWalRecordType::UPDATE_VALUE);
+		__putString(table);
+		put<uint64_t>(__records, row);
+		put<uint16_t>(__records, static_cast<uint16_t>(column));
+		__putValue(value);
+	}
+
+	void QWalTransaction::erase(const qtl::string& table, const std::size_t row)
+	{
+		__putType(QWalRecordType::ERASE_ROW);
+		__putString(table);
+		put<uint64_t>(__records, row);
+	}
+
+	bool QWalTransaction::isEmpty() const
+	{
+		return __records.size() == 0;
+	}
+
+	void QWalTransaction::clear()
+	{
+		__records.clear();
+	}
+
+	void QWalTransaction::__putType(const QWalRecordType type)
+	{
+		put<uint8_t>(__records, static_cast<uint8_t>(type));
+	}
+
+	void QWalTransaction::__putString(const qtl::string& value)
+	{
+		put<uint32_t>(__records, static_cast<uint32_t>(value.length()));
+		__records.append(value.c_str(), value.length());
+	}
+
+	void QWalTransaction::__putValue(const QValue& value)
+	{
+		if (value.isNull())
+		{
+			put<uint8_t>(__records, NULL_TAG);
+			return;
+		}
+
+		put<uint8_t>(__records, static_cast<uint8_t>(value.getType()));
+		switch (value.getType())
+		{
+		case QDataType::CHAR:
+			put<char>(__records, value.getChar());
+			break;
+		case QDataType::INT:
+			put<int32_t>(__records, value.getInt());
+			break;
+		case QDataType::LONG:
+			put<int64_t>(__records, value.getLong());
+			break;
+		case QDataType::BOOL:
+			put<uint8_t>(__records, value.getBool() ? 1 : 0);
+			break;
+		case QDataType::STRING:
+			__putString(value.getString());
+			break;
+		}
+	}
+
+	QWal::QWal()
+		: __file(-1), __commitDelay(0), __appendedPosition(0), __syncedPosition(0), __flushing(false), __failed(false), __committers(0),
+		__commitCount(0), __syncCount(0)
+	{
+		__error[0] = '\0';
+	}
+
+	QWal::~QWal()
+	{
+		close();
+	}
+
+	bool QWal::open(const qtl::string& path)
+	{
+		close();
+		__error[0] = '\0';
+		__failed = false;
+		__commitCount = 0;
+		__syncCount = 0;
+
+		__file = openFile(path.c_str());
+		if (__file < 0)
+		{
+			__fail("cannot open the log: %s", strerror(errno));
+			return false;
+		}
+
+		const int64_t size = seekFile(__file, 0, SEEK_END);
+		uint32_t header[2] = { MAGIC, VERSION };
+		bool valid;
+		if (size == 0)
+		{
+			valid = writeFile(__file, header, sizeof(header)) && syncFile(__file);
+		}
+		else
+		{
+			valid = seekFile(__file, 0, SEEK_SET) == 0 && readFile(__file, header, sizeof(header)) == sizeof(header) && header[0] == MAGIC && header[1] == VERSION;
+		}
+		if (!valid)
+		{
+			__fail("%s is not a log", path.c_str());
+			closeFile(__file);
+			__file = -1;
+			return false;
+		}
+
+		// whatever follows the last complete frame was torn by a crash
+		const uint64_t end = __scan();
+		if (size > 0 && end < static_cast<uint64_t>(size) && (!truncateFile(__file, static_cast<int64_t>(end)) || !syncFile(__file)))
+		{
+			__fail("cannot truncate the log: %s", strerror(errno));
+			closeFile(__file);
+			__file = -1;
+			return false;
+		}
+		seekFile(__file, static_cast<int64_t>(end), SEEK_SET);
+		__appendedPosition = end;
+		__syncedPosition = end;
+		return true;
+	}
+
+	void QWal::close()
+	{
+		if (__file < 0)
+		{
+			return;
+		}
+		flush(__appendedPosition);
+		closeFile(__file);
+		__file = -1;
+	}
+
+	bool QWal::isOpen() const
+	{
+		return __file >= 0;
+	}
+
+	bool QWal::replay(QDatabase& database)
+	{
+		assert(database.getLog() != this && __commitCount == 0);
+		if (__file < 0)
+		{
+			__fail("%s", "the log is not open");
+			return false;
+		}
+
+		seekFile(__file, HEADER_SIZE, SEEK_SET);
+		QLogReader reader(__file);
+		uint64_t position = HEADER_SIZE;
+		bool result = true;
+		while (result && position < __syncedPosition)
+		{
+			const char* frame;
+			const char* payload;
+			uint32_t length = 0;
+			result = reader.read(frame, FRAME_HEADER_SIZE);
+			if (result)
+			{
+				memcpy(&length, frame, sizeof(length));
+				result = reader.read(payload, length) && __apply(database, payload, length);
+			}
+			position += FRAME_HEADER_SIZE + length;
+		}
+		seekFile(__file, static_cast<int64_t>(__syncedPosition), SEEK_SET);
+		return result;
+	}
+
+	void QWal::setCommitDelay(const uint32_t microseconds)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		__commitDelay = microseconds;
+	}
+
+	uint32_t QWal::getCommitDelay() const
+	{
+		return __commitDelay;
+	}
+
+	uint64_t QWal::append(const QWalTransaction& transaction)
+	{
+		// the checksum is computed before taking the lock
+		const QWalBuffer& records = transaction.__records;
+		const uint32_t header[2] = { static_cast<uint32_t>(records.size()), crc32c(records.getData(), records.size()) };
+
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		if (__file < 0 || __failed)
+		{
+			return 0;
+		}
+		if (records.size() == 0)
+		{
+			return __appendedPosition;
+		}
+		__pending.append(header, sizeof(header));
+		__pending.append(records.getData(), records.size());
+		__appendedPosition += sizeof(header) + records.size();
+		__commitCount++;
+		return __appendedPosition;
+	}
+
+	bool QWal::flush(const uint64_t position)
+	{
+		qtl::unique_lock<qtl::mutex> lock(__mutex);
+		__committers++;
+		while (!__failed && __syncedPosition < position)
+		{
+			if (__flushing)
+			{
+				__flushed.wait(lock);
+				continue;
+			}
+
+			// this thread leads the next group, anything appended while it waits is
+			// written with it.  The mutex is released directly, qtl::unique_lock does
+			// not track an unlock() and lock() pair.
+			__flushing = true;
+			if (__commitDelay > 0 && __committers > 1)
+			{
+				__mutex.unlock();
+				std::this_thread::sleep_for(std::chrono::microseconds(__commitDelay));
+				__mutex.lock();
+			}
+			__pending.swap(__writing);
+			const uint64_t target = __appendedPosition;
+			__mutex.unlock();
+
+			const bool written = writeFile(__file, __writing.getData(), __writing.size()) && syncFile(__file);
+			const int error = errno;
+			__writing.clear();
+
+			__mutex.lock();
+			__flushing = false;
+			__syncCount++;
+			if (written)
+			{
+				__syncedPosition = target;
+			}
+			else
+			{
+				__failed = true;
+				__fail("cannot write the log: %s", strerror(error));
+			}
+			__flushed.notify_all();
+		}
+		__committers--;
+		return !__failed;
+	}
+
+	bool QWal::commit(const QWalTransaction& transaction)
+	{
+		const uint64_t position = append(transaction);
+		return position != 0 && flush(position);
+	}
+
+	uint64_t QWal::getCommitCount() const
+	{
+		return __commitCount;
+	}
+
+	uint64_t QWal::getSyncCount() const
+	{
+		return __syncCount;
+	}
+
+	const char* QWal::getError() const
+	{
+		return __error;
+	}
+
+	uint64_t QWal::__scan()
+	{
+		// a frame is complete when its payload is all there and matches its checksum,
+		// an empty frame is not, zeroes past the end of a file are not a transaction
+		const int64_t size = seekFile(__file, 0, SEEK_END);
+		seekFile(__file, HEADER_SIZE, SEEK_SET);
+		QLogReader reader(__file);
+		uint64_t position = HEADER_SIZE;
+		const char* frame;
+		while (reader.read(frame, FRAME_HEADER_SIZE))
+		{
+			uint32_t header[2];
+			memcpy(header, frame, sizeof(header));
+			const char* payload;
+			if (header[0] == 0 || header[0] > static_cast<uint64_t>(size) - position - FRAME_HEADER_SIZE ||
+				!reader.read(payload, header[0]) || crc32c(payload, header[0]) != header[1])
+			{
+				break;
+			}
+			position += FRAME_HEADER_SIZE + header[0];
+		}
+		return position;
+	}
+
+	bool QWal::__apply(QDatabase& database, const char* data, const std::size_t size)
+	{
+		QRecordReader reader(data, size);
+		qtl::vector<QValue> values;
+		QReplayFrame frame(database);
+		while (!reader.isDone())
+		{
+			const uint8_t type = reader.get<uint8_t>();
+			const qtl::string name = reader.getString();
+			QTable* table = type == static_cast<uint8_t>(QWalRecordType::CREATE_TABLE) ? nullptr : frame.find(name);
+			if (type != static_cast<uint8_t>(QWalRecordType::CREATE_TABLE) && table == nullptr)
+			{
+				__fail("the log refers to an unknown table %s", name.c_str());
+				return false;
+			}
+
+			// creating and dropping tables is not part of a write
+			const bool dml = type == static_cast<uint8_t>(QWalRecordType::INSERT_ROW) || type == static_cast<uint8_t>(QWalRecordType::UPDATE_VALUE) ||
+				type == static_cast<uint8_t>(QWalRecordType::ERASE_ROW);
+			if (dml)
+			{
+				frame.begin(table);
+			}
+
+			bool applied = false;
+			const std::size_t rows = table ? table->getRowCount() : 0;
+			switch (type)
+			{
+			case static_cast<uint8_t>(QWalRecordType::CREATE_TABLE):
+			{
+				const uint8_t layout = reader.get<uint8_t>();
+				const uint16_t columns = reader.get<uint16_t>();
+				QSchema schema;
+				for (uint16_t column = 0; column < columns; column++)
+				{
+					const qtl::string columnName = reader.getString();
+					const uint8_t columnType = reader.get<uint8_t>();
+					const uint8_t nullable = reader.get<uint8_t>();
+					const uint8_t encoding = reader.get<uint8_t>();
+					if (columnType > static_cast<uint8_t>(QDataType::STRING) || encoding > static_cast<uint8_t>(QEncoding::COMPRESSED))
+					{
+						break;
+					}
+					schema.addColumn(columnName, static_cast<QDataType>(columnType), nullable != 0, static_cast<QEncoding>(encoding));
+				}
+				applied = schema.getColumnCount() == columns && layout <= static_cast<uint8_t>(QTableLayout::COLUMN) &&
+					frame.create(name, schema, static_cast<QTableLayout>(layout));
+				break;
+			}
+			case static_cast<uint8_t>(QWalRecordType::DROP_TABLE):
+				applied = frame.drop(name);
+				break;
+			case static_cast<uint8_t>(QWalRecordType::INSERT_ROW):
+			{
+				const uint16_t count = reader.get<uint16_t>();
+				values.clear();
+				for (uint16_t i = 0; i < count; i++)
+				{
+					values.push_back(reader.getValue());
+				}
+				applied = count == table->getColumnCount() && table->insert(values) == rows;
+				break;
+			}
+			case static_cast<uint8_t>(QWalRecordType::UPDATE_VALUE):
+			{
+				const uint64_t row = reader.get<uint64_t>();
+				const uint16_t column = reader.get<uint16_t>();
+				const QValue value = reader.getValue();
+				if (row < rows && column < table->getColumnCount())
+				{
+					const std::size_t version = table->update(row, column, value);
+					applied = version < table->getRowCount();
+				}
+				break;
+			}
+			case static_cast<uint8_t>(QWalRecordType::ERASE_ROW):
+			{
+				const uint64_t row = reader.get<uint64_t>();
+				applied = row < table->getRowCount() && table->erase(row);
+				break;
+			}
+			}
+
+			if (!applied || reader.isFailed())
+			{
+				__fail("cannot apply a logged change to table %s", name.c_str());
+				return false;
+			}
+		}
+		frame.commit();
+		return true;
+	}
+
+	void QWal::__fail(const char* format, const char* detail)
+	{
+		snprintf(__error, ERROR_LENGTH, format, detail);
+	}
+}